@@ -88,6 +88,11 @@ ctkCLModuleExplorerMainWindow::ctkCLModuleExplorerMainWindow(QWidget *parent) :
                        ).toInt() * 1000);
 
   // Frontends
+  #if (QT_VERSION < QT_VERSION_CHECK(5,0,0))
+  ctkCmdLineModuleFrontendQtGui::setUiFormCacheDirectory(QDesktopServices::storageLocation(QDesktopServices::CacheLocation) + "/ui");
+  #else
+  ctkCmdLineModuleFrontendQtGui::setUiFormCacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/ui");
+  #endif
   moduleFrontendFactories << new ctkCmdLineModuleFrontendFactoryQtGui;
   moduleFrontendFactories << new ctkCmdLineModuleFrontendFactoryQtWebKit;
   defaultModuleFrontendFactory = moduleFrontendFactories.front();
@@ -115,6 +120,8 @@ ctkCLModuleExplorerMainWindow::ctkCLModuleExplorerMainWindow(QWidget *parent) :
   // If a module is registered via the ModuleManager, add it to the tree
   connect(&moduleManager, SIGNAL(moduleRegistered(ctkCmdLineModuleReference)), ui->modulesTreeWidget, SLOT(addModuleItem(ctkCmdLineModuleReference)));
   connect(&moduleManager, SIGNAL(moduleUnregistered(ctkCmdLineModuleReference)), ui->modulesTreeWidget, SLOT(removeModuleItem(ctkCmdLineModuleReference)));
+  // Generate the Qt GUI of registered modules in the background, so that opening them is fast
+  connect(&moduleManager, SIGNAL(moduleRegistered(ctkCmdLineModuleReference)), SLOT(precomputeModuleFrontends(ctkCmdLineModuleReference)));
   // React to specific frontend creations
   connect(ui->modulesTreeWidget, SIGNAL(moduleFrontendCreated(ctkCmdLineModuleFrontend*)), tabList.data(), SLOT(addTab(ctkCmdLineModuleFrontend*)));
   // React to tab-changes
@@ -166,6 +173,13 @@ ctkCLModuleExplorerMainWindow::ctkCLModuleExplorerMainWindow(QWidget *parent) :
 //-----------------------------------------------------------------------------
 ctkCLModuleExplorerMainWindow::~ctkCLModuleExplorerMainWindow()
 {
+  // The precomputations use the front-end factories
+  foreach(QFuture<void> future, uiFormPrecomputations)
+  {
+    future.waitForFinished();
+  }
+  uiFormPrecomputations.clear();
+
   qDeleteAll(moduleBackends);
   qDeleteAll(moduleFrontendFactories);
 
@@ -319,6 +333,34 @@ void ctkCLModuleExplorerMainWindow::on_actionReset_triggered()
 void ctkCLModuleExplorerMainWindow::on_actionClear_Cache_triggered()
 {
   moduleManager.clearCache();
+  ctkCmdLineModuleFrontendQtGui::clearUiFormCache();
+}
+
+//-----------------------------------------------------------------------------
+void ctkCLModuleExplorerMainWindow::precomputeModuleFrontends(const ctkCmdLineModuleReference& moduleRef)
+{
+  // Forget about the finished precomputations
+  QList<QFuture<void> >::iterator it = uiFormPrecomputations.begin();
+  while (it != uiFormPrecomputations.end())
+  {
+    if (it->isFinished())
+    {
+      it = uiFormPrecomputations.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  foreach(ctkCmdLineModuleFrontendFactory* factory, moduleFrontendFactories)
+  {
+    if (ctkCmdLineModuleFrontendFactoryQtGui* qtGuiFactory =
+        dynamic_cast<ctkCmdLineModuleFrontendFactoryQtGui*>(factory))
+    {
+      uiFormPrecomputations.push_back(qtGuiFactory->precomputeUiForm(moduleRef));
+    }
+  }
 }
 
 
@@ -80,6 +80,8 @@ protected Q_SLOTS:
   void moduleTabActivated(ctkCmdLineModuleFrontend* module);
   void checkXMLPressed();
 
+  void precomputeModuleFrontends(const ctkCmdLineModuleReference& moduleRef);
+
 private:
 
   QScopedPointer<Ui::ctkCmdLineModuleExplorerMainWindow> ui;
@@ -100,6 +102,9 @@ private:
   ctkSettings settings;
   ctkSettingsDialog* settingsDialog;
   ctkCmdLineModuleBackendXMLChecker* xmlCheckerBackEnd;
+
+  // Running .ui form precomputations, which use the front-end factories
+  QList<QFuture<void> > uiFormPrecomputations;
 };
 
 #endif // CTKCLIPLUGINEXPLORERMAINWINDOW_H
@@ -0,0 +1,114 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+// Run the benchmark on a tiny dataset and check the results are written
+int ctkDICOMBenchmarkAppTest1(int argc, char * argv [])
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 2)
+    {
+    std::cerr << "Must specify path to ctkDICOMBenchmark on command line\n";
+    return EXIT_FAILURE;
+    }
+  std::cout << "Testing ctkDICOMBenchmark: " << argv[1] << "\n";
+  QString command = QString(argv[1]);
+
+  QString output = QDir::temp().absoluteFilePath("ctkDICOMBenchmarkAppTest1.json");
+  QFile::remove(output);
+
+  // A non-empty directory that was not created by the benchmark is refused
+  // and left untouched
+  QDir userDirectory(QDir::temp().absoluteFilePath("ctkDICOMBenchmarkAppTest1-user"));
+  QDir().mkpath(userDirectory.absolutePath());
+  QFile userFile(userDirectory.absoluteFilePath("user.txt"));
+  if (!userFile.open(QIODevice::WriteOnly))
+    {
+    std::cerr << "Could not write " << qPrintable(userFile.fileName()) << std::endl;
+    return EXIT_FAILURE;
+    }
+  userFile.close();
+  QStringList userParameters;
+  userParameters << "--patients" << "1" << "--studies" << "1" << "--series" << "1"
+                 << "--instances" << "1" << "--repetitions" << "1"
+                 << "--working-directory" << userDirectory.absolutePath();
+#if QT_VERSION >= 0x050000
+  userParameters << "-platform" << "offscreen";
+#endif
+  int userRes = QProcess::execute(command, userParameters);
+  bool userFileKept = userFile.exists();
+  userFile.remove();
+  userDirectory.rmdir(userDirectory.absolutePath());
+  if (userRes == EXIT_SUCCESS || !userFileKept)
+    {
+    std::cerr << "ctkDICOMBenchmark used a non-empty directory it did not create"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QString workingDirectory = QDir::temp().absoluteFilePath("ctkDICOMBenchmarkAppTest1");
+  QStringList parameters;
+  parameters << "--patients" << "2" << "--studies" << "1" << "--series" << "2"
+             << "--instances" << "2" << "--frames" << "3" << "--repetitions" << "1"
+             << "--working-directory" << workingDirectory
+             << "--output" << output;
+#if QT_VERSION >= 0x050000
+  parameters << "-platform" << "offscreen";
+#endif
+  int res = QProcess::execute(command, parameters);
+  if (res != EXIT_SUCCESS)
+    {
+    std::cerr << '\"' << qPrintable(command + " " + parameters.join(" ")) << '\"'
+              << " returned " << res << std::endl;
+    return res;
+    }
+
+  QFile results(output);
+  if (!results.open(QIODevice::ReadOnly))
+    {
+    std::cerr << "Results file " << qPrintable(output) << " was not written" << std::endl;
+    return EXIT_FAILURE;
+    }
+  QByteArray content = results.readAll();
+  if (!content.contains("\"index.addDirectory\"") || !content.contains("\"table.series\""))
+    {
+    std::cerr << "Unexpected results file content:\n" << content.constData() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The working directory is removed without --keep
+  if (QDir(workingDirectory).exists())
+    {
+    std::cerr << "Working directory " << qPrintable(workingDirectory)
+              << " was not removed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,582 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QApplication>
+#include <QDate>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlQuery>
+#include <QTableView>
+#include <QTextStream>
+#include <QVector>
+
+// CTK includes
+#include <ctkCommandLineParser.h>
+
+// ctkDICOMCore includes
+#include <ctkDICOMDatabase.h>
+#include <ctkDICOMIndexer.h>
+#include <ctkDICOMModel.h>
+
+// ctkDICOMWidgets includes
+#include <ctkDICOMTableView.h>
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcuid.h>
+
+// STD includes
+#include <cstdlib>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct ctkDICOMBenchmarkOptions
+{
+  int Patients;
+  int StudiesPerPatient;
+  int SeriesPerStudy;
+  int InstancesPerSeries;
+  int Frames;
+  int Rows;
+  int Columns;
+  int QueryRepetitions;
+  QString WorkingDirectory;
+};
+
+//----------------------------------------------------------------------------
+struct ctkDICOMBenchmarkResult
+{
+  QString Name;
+  int Count;
+  double Milliseconds;
+};
+
+//----------------------------------------------------------------------------
+class ctkDICOMBenchmarkResults
+{
+public:
+  void add(const QString& name, int count, qint64 nanoseconds)
+  {
+    ctkDICOMBenchmarkResult result;
+    result.Name = name;
+    result.Count = count;
+    result.Milliseconds = nanoseconds / 1000000.0;
+    this->Results << result;
+
+    QTextStream out(stdout);
+    out << qSetFieldWidth(32) << left << name << qSetFieldWidth(0)
+        << QString::number(result.Milliseconds, 'f', 3) << " ms for "
+        << count << " (" << QString::number(perSecond(result), 'f', 1) << "/s)\n";
+  }
+
+  static double perSecond(const ctkDICOMBenchmarkResult& result)
+  {
+    return result.Milliseconds > 0. ? result.Count * 1000. / result.Milliseconds : 0.;
+  }
+
+  /// Write the results as JSON. The format is versioned so that scripts
+  /// comparing runs of different CTK versions can detect changes.
+  bool writeJSON(const QString& fileName, const ctkDICOMBenchmarkOptions& options) const
+  {
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+      {
+      return false;
+      }
+    QTextStream out(&file);
+    out << "{\n";
+    out << "  \"format\": \"ctkDICOMBenchmark\",\n";
+    out << "  \"formatVersion\": 1,\n";
+    out << "  \"date\": \"" << QDateTime::currentDateTime().toString(Qt::ISODate) << "\",\n";
+    out << "  \"qtVersion\": \"" << qVersion() << "\",\n";
+    out << "  \"dcmtkVersion\": \"" << OFFIS_DCMTK_VERSION_STRING << "\",\n";
+    out << "  \"dataset\": {\n";
+    out << "    \"patients\": " << options.Patients << ",\n";
+    out << "    \"studiesPerPatient\": " << options.StudiesPerPatient << ",\n";
+    out << "    \"seriesPerStudy\": " << options.SeriesPerStudy << ",\n";
+    out << "    \"instancesPerSeries\": " << options.InstancesPerSeries << ",\n";
+    out << "    \"frames\": " << options.Frames << ",\n";
+    out << "    \"rows\": " << options.Rows << ",\n";
+    out << "    \"columns\": " << options.Columns << "\n";
+    out << "  },\n";
+    out << "  \"results\": [\n";
+    for (int i = 0; i < this->Results.count(); ++i)
+      {
+      const ctkDICOMBenchmarkResult& result = this->Results[i];
+      out << "    { \"name\": \"" << result.Name << "\""
+          << ", \"count\": " << result.Count
+          << ", \"totalMs\": " << QString::number(result.Milliseconds, 'f', 3)
+          << ", \"perItemMs\": "
+          << QString::number(result.Count ? result.Milliseconds / result.Count : 0., 'f', 6)
+          << ", \"perSecond\": " << QString::number(perSecond(result), 'f', 3)
+          << " }" << (i + 1 < this->Results.count() ? ",\n" : "\n");
+      }
+    out << "  ]\n";
+    out << "}\n";
+    return true;
+  }
+
+private:
+  QList<ctkDICOMBenchmarkResult> Results;
+};
+
+//----------------------------------------------------------------------------
+// UIDs are derived from the object indices (instead of being random) so that
+// two runs with the same options index exactly the same dataset.
+QString syntheticUID(int patient, int study = -1, int series = -1, int instance = -1)
+{
+  QString uid = QString("%1.999.%2").arg(SITE_UID_ROOT).arg(patient + 1);
+  if (study >= 0)
+    {
+    uid += QString(".%1").arg(study + 1);
+    }
+  if (series >= 0)
+    {
+    uid += QString(".%1").arg(series + 1);
+    }
+  if (instance >= 0)
+    {
+    uid += QString(".%1").arg(instance + 1);
+    }
+  return uid;
+}
+
+//----------------------------------------------------------------------------
+bool writeSyntheticInstance(const QString& fileName,
+                            const ctkDICOMBenchmarkOptions& options,
+                            int patient, int study, int series, int instance)
+{
+  static const char* modalities[] = { "CT", "MR", "US", "CR" };
+  const bool multiFrame = options.Frames > 1;
+  const QDate studyDate = QDate(2000, 1, 1).addDays(patient * 31 + study);
+
+  DcmFileFormat fileFormat;
+  DcmDataset* dataset = fileFormat.getDataset();
+  dataset->putAndInsertString(DCM_SOPClassUID, multiFrame ?
+    UID_MultiframeGrayscaleWordSecondaryCaptureImageStorage : UID_SecondaryCaptureImageStorage);
+  dataset->putAndInsertString(DCM_SOPInstanceUID,
+    syntheticUID(patient, study, series, instance).toLatin1().data());
+  dataset->putAndInsertString(DCM_PatientName,
+    QString("BENCHMARK^PATIENT%1").arg(patient + 1, 5, 10, QChar('0')).toLatin1().data());
+  dataset->putAndInsertString(DCM_PatientID,
+    QString("BENCH%1").arg(patient + 1, 5, 10, QChar('0')).toLatin1().data());
+  dataset->putAndInsertString(DCM_PatientBirthDate, "19700101");
+  dataset->putAndInsertString(DCM_PatientSex, patient % 2 ? "F" : "M");
+  dataset->putAndInsertString(DCM_StudyInstanceUID, syntheticUID(patient, study).toLatin1().data());
+  dataset->putAndInsertString(DCM_StudyID, QString::number(study + 1).toLatin1().data());
+  dataset->putAndInsertString(DCM_StudyDate, studyDate.toString("yyyyMMdd").toLatin1().data());
+  dataset->putAndInsertString(DCM_StudyTime, "120000");
+  dataset->putAndInsertString(DCM_AccessionNumber,
+    QString("A%1%2").arg(patient + 1).arg(study + 1).toLatin1().data());
+  dataset->putAndInsertString(DCM_StudyDescription, "CTK benchmark study");
+  dataset->putAndInsertString(DCM_SeriesInstanceUID,
+    syntheticUID(patient, study, series).toLatin1().data());
+  dataset->putAndInsertString(DCM_SeriesNumber, QString::number(series + 1).toLatin1().data());
+  dataset->putAndInsertString(DCM_SeriesDescription,
+    QString("Series %1").arg(series + 1).toLatin1().data());
+  dataset->putAndInsertString(DCM_Modality, modalities[series % 4]);
+  dataset->putAndInsertString(DCM_InstanceNumber, QString::number(instance + 1).toLatin1().data());
+
+  dataset->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+  dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+  dataset->putAndInsertUint16(DCM_Rows, options.Rows);
+  dataset->putAndInsertUint16(DCM_Columns, options.Columns);
+  dataset->putAndInsertUint16(DCM_BitsAllocated, 16);
+  dataset->putAndInsertUint16(DCM_BitsStored, 12);
+  dataset->putAndInsertUint16(DCM_HighBit, 11);
+  dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+  if (multiFrame)
+    {
+    dataset->putAndInsertString(DCM_NumberOfFrames, QString::number(options.Frames).toLatin1().data());
+    }
+
+  const unsigned long pixelCount =
+    static_cast<unsigned long>(options.Rows) * options.Columns * options.Frames;
+  QVector<Uint16> pixels(pixelCount);
+  for (unsigned long i = 0; i < pixelCount; ++i)
+    {
+    pixels[i] = static_cast<Uint16>((i + instance) & 0x0fff);
+    }
+  dataset->putAndInsertUint16Array(DCM_PixelData, pixels.constData(), pixelCount);
+
+  OFCondition status = fileFormat.saveFile(fileName.toLatin1().data(), EXS_LittleEndianExplicit);
+  if (status.bad())
+    {
+    QTextStream(stderr) << "Failed to write " << fileName << ": " << status.text() << "\n";
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool generateDataset(const ctkDICOMBenchmarkOptions& options, const QString& dataDirectory,
+                     QStringList& files)
+{
+  for (int patient = 0; patient < options.Patients; ++patient)
+    {
+    for (int study = 0; study < options.StudiesPerPatient; ++study)
+      {
+      for (int series = 0; series < options.SeriesPerStudy; ++series)
+        {
+        QString seriesDirectory = QString("%1/P%2/ST%3/SE%4").arg(dataDirectory)
+          .arg(patient + 1).arg(study + 1).arg(series + 1);
+        QDir().mkpath(seriesDirectory);
+        for (int instance = 0; instance < options.InstancesPerSeries; ++instance)
+          {
+          QString fileName = QString("%1/IM%2.dcm").arg(seriesDirectory).arg(instance + 1);
+          if (!writeSyntheticInstance(fileName, options, patient, study, series, instance))
+            {
+            return false;
+            }
+          files << fileName;
+          }
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int populateModel(QAbstractItemModel* model, const QModelIndex& parent)
+{
+  while (model->canFetchMore(parent))
+    {
+    model->fetchMore(parent);
+    }
+  int rows = model->rowCount(parent);
+  int count = rows;
+  for (int row = 0; row < rows; ++row)
+    {
+    count += populateModel(model, model->index(row, 0, parent));
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------------
+/// Marks a working directory as created by ctkDICOMBenchmark
+const char* const ownerMarker = ".ctkDICOMBenchmark";
+
+//----------------------------------------------------------------------------
+void removeDirectory(const QString& path)
+{
+  QDir dir(path);
+  foreach(const QFileInfo& info, dir.entryInfoList(
+            QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot))
+    {
+    // Links are removed, never followed
+    if (info.isDir() && !info.isSymLink())
+      {
+      removeDirectory(info.absoluteFilePath());
+      }
+    else
+      {
+      dir.remove(info.fileName());
+      }
+    }
+  dir.rmdir(path);
+}
+
+//----------------------------------------------------------------------------
+/// Removes what the benchmark created in \a workingDirectory. Other files
+/// are left untouched, the directory itself is only removed if it is empty.
+void removeWorkingDirectory(const QString& workingDirectory)
+{
+  QDir dir(workingDirectory);
+  if (!dir.exists(ownerMarker))
+    {
+    return;
+    }
+  removeDirectory(dir.absoluteFilePath("data"));
+  removeDirectory(dir.absoluteFilePath("database"));
+  dir.remove(ownerMarker);
+  dir.rmdir(dir.absolutePath());
+}
+
+//----------------------------------------------------------------------------
+/// Prepares \a workingDirectory for a run. The directory is created if it
+/// doesn't exist. An existing directory is only used if it is empty or if
+/// it was created by a previous run, whose data is removed then.
+bool prepareWorkingDirectory(const QString& workingDirectory, QString& errorString)
+{
+  QDir dir(workingDirectory);
+  if (dir.exists())
+    {
+    if (dir.exists(ownerMarker))
+      {
+      removeWorkingDirectory(workingDirectory);
+      }
+    else if (!dir.entryList(QDir::AllEntries | QDir::Hidden | QDir::System |
+                            QDir::NoDotAndDotDot).isEmpty())
+      {
+      errorString = QString("%1 is not empty and was not created by ctkDICOMBenchmark")
+        .arg(QDir::toNativeSeparators(dir.absolutePath()));
+      return false;
+      }
+    }
+  if (!QDir().mkpath(dir.absolutePath()))
+    {
+    errorString = QString("Could not create %1")
+      .arg(QDir::toNativeSeparators(dir.absolutePath()));
+    return false;
+    }
+  QFile marker(dir.absoluteFilePath(ownerMarker));
+  if (!marker.open(QIODevice::WriteOnly))
+    {
+    errorString = QString("Could not write %1")
+      .arg(QDir::toNativeSeparators(marker.fileName()));
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  // The table view benchmarks need a GUI application, use
+  // "-platform offscreen" (Qt5) to run without a display.
+  QApplication app(argc, argv);
+
+  ctkCommandLineParser parser;
+  parser.setArgumentPrefix("--", "-");
+  parser.setStrictModeEnabled(true);
+  parser.addArgument("patients", "", QVariant::Int, "Number of patients.", 10);
+  parser.addArgument("studies", "", QVariant::Int, "Number of studies per patient.", 2);
+  parser.addArgument("series", "", QVariant::Int, "Number of series per study.", 3);
+  parser.addArgument("instances", "", QVariant::Int, "Number of instances per series.", 20);
+  parser.addArgument("frames", "", QVariant::Int,
+                     "Number of frames per instance. Multi-frame objects are "
+                     "generated when greater than 1.", 1);
+  parser.addArgument("rows", "", QVariant::Int, "Number of rows per frame.", 64);
+  parser.addArgument("columns", "", QVariant::Int, "Number of columns per frame.", 64);
+  parser.addArgument("repetitions", "", QVariant::Int,
+                     "Number of times each query benchmark is repeated.", 3);
+  parser.addArgument("working-directory", "w", QVariant::String,
+                     "Directory where the dataset and the database are created. "
+                     "It must be empty or created by a previous run. Its content "
+                     "is removed at the end unless --keep is given.",
+                     QDir::temp().absoluteFilePath("ctkDICOMBenchmark"));
+  parser.addArgument("output", "o", QVariant::String,
+                     "JSON file the results are written to.");
+  parser.addArgument("keep", "", QVariant::Bool, "Keep the working directory.");
+  parser.addArgument("help", "h", QVariant::Bool, "Print this help text.");
+
+  QTextStream out(stdout);
+  bool ok = false;
+  QHash<QString, QVariant> args = parser.parseArguments(app.arguments(), &ok);
+  if (!ok)
+    {
+    out << "Error parsing command line arguments: " << parser.errorString() << "\n";
+    return EXIT_FAILURE;
+    }
+  if (args.contains("help"))
+    {
+    out << "Usage:\n" << parser.helpText();
+    return EXIT_SUCCESS;
+    }
+
+  ctkDICOMBenchmarkOptions options;
+  options.Patients = qMax(1, args.value("patients", 10).toInt());
+  options.StudiesPerPatient = qMax(1, args.value("studies", 2).toInt());
+  options.SeriesPerStudy = qMax(1, args.value("series", 3).toInt());
+  options.InstancesPerSeries = qMax(1, args.value("instances", 20).toInt());
+  options.Frames = qMax(1, args.value("frames", 1).toInt());
+  options.Rows = qMax(1, args.value("rows", 64).toInt());
+  options.Columns = qMax(1, args.value("columns", 64).toInt());
+  options.QueryRepetitions = qMax(1, args.value("repetitions", 3).toInt());
+  options.WorkingDirectory = args.value("working-directory",
+    QDir::temp().absoluteFilePath("ctkDICOMBenchmark")).toString();
+
+  QString errorString;
+  if (!prepareWorkingDirectory(options.WorkingDirectory, errorString))
+    {
+    QTextStream(stderr) << errorString << "\n";
+    return EXIT_FAILURE;
+    }
+  const QString dataDirectory = options.WorkingDirectory + "/data";
+  const QString databaseDirectory = options.WorkingDirectory + "/database";
+  QDir().mkpath(dataDirectory);
+  QDir().mkpath(databaseDirectory);
+
+  ctkDICOMBenchmarkResults results;
+  QElapsedTimer timer;
+
+  //
+  // Dataset generation (not a CTK benchmark, reported for reference)
+  //
+  QStringList files;
+  timer.start();
+  if (!generateDataset(options, dataDirectory, files))
+    {
+    return EXIT_FAILURE;
+    }
+  results.add("generate", files.count(), timer.nsecsElapsed());
+
+  ctkDICOMDatabase database;
+  database.openDatabase(databaseDirectory + "/ctkDICOM.sql");
+  if (!database.isOpen())
+    {
+    QTextStream(stderr) << "Failed to open database: " << database.lastError() << "\n";
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Indexing throughput
+  //
+  {
+  ctkDICOMIndexer indexer;
+  timer.start();
+  indexer.addDirectory(database, dataDirectory);
+  results.add("index.addDirectory", files.count(), timer.nsecsElapsed());
+  }
+  if (database.allFiles().count() != files.count())
+    {
+    QTextStream(stderr) << "Indexed " << database.allFiles().count()
+                        << " files instead of " << files.count() << "\n";
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Tag cache: the first lookup reads the file, the second one is cached
+  //
+  const QString seriesDescriptionTag("0008,103e");
+  timer.start();
+  foreach(const QString& file, database.allFiles())
+    {
+    database.fileValue(file, seriesDescriptionTag);
+    }
+  results.add("tagCache.cold", files.count(), timer.nsecsElapsed());
+  timer.start();
+  foreach(const QString& file, database.allFiles())
+    {
+    database.fileValue(file, seriesDescriptionTag);
+    }
+  results.add("tagCache.warm", files.count(), timer.nsecsElapsed());
+
+  //
+  // Query latencies, walking the whole hierarchy
+  //
+  int queries = 0;
+  timer.start();
+  for (int i = 0; i < options.QueryRepetitions; ++i)
+    {
+    QStringList patients = database.patients();
+    ++queries;
+    foreach(const QString& patient, patients)
+      {
+      foreach(const QString& study, database.studiesForPatient(patient))
+        {
+        ++queries;
+        foreach(const QString& series, database.seriesForStudy(study))
+          {
+          ++queries;
+          database.filesForSeries(series);
+          ++queries;
+          }
+        }
+      }
+    }
+  results.add("query.hierarchy", queries, timer.nsecsElapsed());
+
+  QSqlQuery query(database.database());
+  timer.start();
+  for (int i = 0; i < options.QueryRepetitions; ++i)
+    {
+    query.exec("SELECT StudyInstanceUID FROM Studies ORDER BY StudyDate DESC");
+    while (query.next()) {}
+    }
+  results.add("query.studiesByDate", options.QueryRepetitions, timer.nsecsElapsed());
+  timer.start();
+  for (int i = 0; i < options.QueryRepetitions; ++i)
+    {
+    query.exec("SELECT SeriesInstanceUID FROM Series WHERE Modality = 'MR'");
+    while (query.next()) {}
+    }
+  results.add("query.seriesByModality", options.QueryRepetitions, timer.nsecsElapsed());
+  timer.start();
+  for (int i = 0; i < options.QueryRepetitions; ++i)
+    {
+    query.exec("SELECT Patients.PatientsName, COUNT(Images.SOPInstanceUID) FROM Patients "
+               "JOIN Studies ON Studies.PatientsUID = Patients.UID "
+               "JOIN Series ON Series.StudyInstanceUID = Studies.StudyInstanceUID "
+               "JOIN Images ON Images.SeriesInstanceUID = Series.SeriesInstanceUID "
+               "GROUP BY Patients.UID ORDER BY Patients.PatientsName");
+    while (query.next()) {}
+    }
+  results.add("query.imagesPerPatient", options.QueryRepetitions, timer.nsecsElapsed());
+
+  //
+  // Model and table population
+  //
+  {
+  int items = 0;
+  timer.start();
+  for (int i = 0; i < options.QueryRepetitions; ++i)
+    {
+    ctkDICOMModel model;
+    model.setEndLevel(ctkDICOMModel::SeriesType);
+    model.setDatabase(database.database());
+    items = populateModel(&model, QModelIndex());
+    }
+  results.add("model.populate", items * options.QueryRepetitions, timer.nsecsElapsed());
+  }
+
+  const char* tables[] = { "Patients", "Studies", "Series" };
+  for (int t = 0; t < 3; ++t)
+    {
+    int rows = 0;
+    timer.start();
+    for (int i = 0; i < options.QueryRepetitions; ++i)
+      {
+      ctkDICOMTableView tableView(&database, tables[t]);
+      tableView.setQuery();
+      QAbstractItemModel* model = tableView.tableView()->model();
+      while (model->canFetchMore(QModelIndex()))
+        {
+        model->fetchMore(QModelIndex());
+        }
+      rows = model->rowCount();
+      }
+    results.add(QString("table.%1").arg(QString(tables[t]).toLower()),
+                rows * options.QueryRepetitions, timer.nsecsElapsed());
+    }
+
+  database.closeDatabase();
+
+  int status = EXIT_SUCCESS;
+  if (args.contains("output") &&
+      !results.writeJSON(args.value("output").toString(), options))
+    {
+    QTextStream(stderr) << "Failed to write " << args.value("output").toString() << "\n";
+    status = EXIT_FAILURE;
+    }
+  if (!args.contains("keep"))
+    {
+    removeWorkingDirectory(options.WorkingDirectory);
+    }
+  return status;
+}
@@ -45,7 +45,7 @@ macro(ctkMacroSetupQt)
       endif()
     endif()
     if(CTK_LIB_XNAT/Core OR CTK_BUILD_ALL OR CTK_BUILD_ALL_LIBRARIES)
-      list(APPEND CTK_QT5_COMPONENTS Script)
+      list(APPEND CTK_QT5_COMPONENTS Script Network)
     endif()
     find_package(Qt5 COMPONENTS ${CTK_QT5_COMPONENTS} REQUIRED)
 
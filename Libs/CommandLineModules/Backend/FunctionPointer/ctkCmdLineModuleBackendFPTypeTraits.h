@@ -84,6 +84,9 @@ public:
 
   typedef typename Select<isPointer, typename UnConst<PointeeType>::Result,
                                      typename Select<isReference, typename UnConst<ReferenceType>::Result, typename UnConst<T>::Result>::Result >::Result RawType;
+
+  // T without reference and top-level const qualifiers, suitable for storing an argument
+  typedef typename Select<isReference, typename UnConst<ReferenceType>::Result, typename UnConst<T>::Result>::Result ValueType;
 };
 
 template<bool C, typename T = void>
@@ -25,6 +25,33 @@
 namespace ctk {
 namespace CmdLineModuleBackendFunctionPointer {
 
+//----------------------------------------------------------------------------
+FunctionPointerBatchBase::~FunctionPointerBatchBase()
+{
+}
+
+//----------------------------------------------------------------------------
+QString FunctionPointerBatchBase::error(int index) const
+{
+  return Errors.value(index);
+}
+
+//----------------------------------------------------------------------------
+bool FunctionPointerBatchBase::checkArgumentCount(int index, const QList<QVariant>& args, int count)
+{
+  if (args.size() >= count) return true;
+  Errors.insert(index, QString("Invalid parameter set: %1 argument(s) expected, got %2.")
+                .arg(count).arg(args.size()));
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void FunctionPointerBatchBase::setConversionError(int index, int argIndex)
+{
+  Errors.insert(index, QString("Invalid parameter set: argument %1 cannot be converted to the parameter type.")
+                .arg(argIndex + 1));
+}
+
 //----------------------------------------------------------------------------
 FunctionPointerHolderBase::~FunctionPointerHolderBase()
 {
@@ -61,5 +88,11 @@ void FunctionPointerProxy::call(const QList<QVariant> &args)
   FpHolder->call(args);
 }
 
+//----------------------------------------------------------------------------
+FunctionPointerBatchBase* FunctionPointerProxy::createBatch(const QList<QList<QVariant> >& argsList) const
+{
+  return FpHolder->createBatch(argsList);
+}
+
 }
 }
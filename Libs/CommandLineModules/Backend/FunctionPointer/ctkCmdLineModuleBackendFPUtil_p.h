@@ -23,14 +23,139 @@
 #define CTKCMDLINEMODULEBACKENDFPUTIL_P_H
 
 #include "ctkCommandLineModulesBackendFunctionPointerExport.h"
+#include "ctkCmdLineModuleBackendFPTypeTraits.h"
 
+#include <QHash>
+#include <QString>
 #include <QVariant>
+#include <QVector>
 
 class ctkCmdLineModuleBackendFunctionPointer;
 
 namespace ctk {
 namespace CmdLineModuleBackendFunctionPointer {
 
+/**
+ * Holds the arguments of a batch of calls to the same function pointer,
+ * converted once from QVariant to the function parameter types.
+ *
+ * Parameter sets with missing or inconvertible arguments are kept in the
+ * batch, but must not be called. error() returns the reason for them.
+ */
+struct CTK_CMDLINEMODULEBACKENDFP_EXPORT FunctionPointerBatchBase
+{
+  virtual ~FunctionPointerBatchBase();
+
+  virtual int size() const = 0;
+
+  // a null string if the parameter set at index can be called
+  QString error(int index) const;
+
+  // may be called concurrently for different indices
+  virtual void call(int index) const = 0;
+
+protected:
+
+  // checks the number of arguments of the parameter set at index
+  bool checkArgumentCount(int index, const QList<QVariant>& args, int count);
+
+  // records that an argument of the parameter set at index cannot be converted
+  void setConversionError(int index, int argIndex);
+
+private:
+
+  QHash<int, QString> Errors;
+};
+
+template<typename A>
+struct FunctionPointerBatch : public FunctionPointerBatchBase
+{
+  typedef void (*FunctionPointerType)(A);
+  typedef typename TypeTraits<A>::ValueType ValueTypeA;
+
+  FunctionPointerBatch(FunctionPointerType fp, const QList<QList<QVariant> >& argsList)
+    : Fp(fp)
+  {
+    ArgsA.reserve(argsList.size());
+    for (int i = 0; i < argsList.size(); ++i)
+    {
+      const QList<QVariant>& args = argsList.at(i);
+      if (!this->checkArgumentCount(i, args, 1))
+      {
+        ArgsA.push_back(ValueTypeA());
+        continue;
+      }
+      if (!args.at(0).canConvert<ValueTypeA>())
+      {
+        this->setConversionError(i, 0);
+      }
+      ArgsA.push_back(args.at(0).value<ValueTypeA>());
+    }
+  }
+
+  int size() const
+  {
+    return ArgsA.size();
+  }
+
+  void call(int index) const
+  {
+    Fp(ArgsA.at(index));
+  }
+
+  FunctionPointerType Fp;
+  QVector<ValueTypeA> ArgsA;
+};
+
+template<typename A, typename B>
+struct FunctionPointerBatch2 : public FunctionPointerBatchBase
+{
+  typedef void (*FunctionPointerType)(A,B);
+  typedef typename TypeTraits<A>::ValueType ValueTypeA;
+  typedef typename TypeTraits<B>::ValueType ValueTypeB;
+
+  FunctionPointerBatch2(FunctionPointerType fp, const QList<QList<QVariant> >& argsList)
+    : Fp(fp)
+  {
+    ArgsA.reserve(argsList.size());
+    ArgsB.reserve(argsList.size());
+    for (int i = 0; i < argsList.size(); ++i)
+    {
+      const QList<QVariant>& args = argsList.at(i);
+      if (!this->checkArgumentCount(i, args, 2))
+      {
+        ArgsA.push_back(ValueTypeA());
+        ArgsB.push_back(ValueTypeB());
+        continue;
+      }
+      if (!args.at(0).canConvert<ValueTypeA>())
+      {
+        this->setConversionError(i, 0);
+      }
+      else if (!args.at(1).canConvert<ValueTypeB>())
+      {
+        this->setConversionError(i, 1);
+      }
+      ArgsA.push_back(args.at(0).value<ValueTypeA>());
+      ArgsB.push_back(args.at(1).value<ValueTypeB>());
+    }
+  }
+
+  int size() const
+  {
+    return ArgsA.size();
+  }
+
+  void call(int index) const
+  {
+    Fp(ArgsA.at(index), ArgsB.at(index));
+  }
+
+  FunctionPointerType Fp;
+  QVector<ValueTypeA> ArgsA;
+  QVector<ValueTypeB> ArgsB;
+};
+
 struct CTK_CMDLINEMODULEBACKENDFP_EXPORT FunctionPointerHolderBase
 {
   virtual ~FunctionPointerHolderBase();
@@ -38,6 +163,8 @@ struct CTK_CMDLINEMODULEBACKENDFP_EXPORT FunctionPointerHolderBase
   virtual FunctionPointerHolderBase* clone() const = 0;
 
   virtual void call(const QList<QVariant>& args) = 0;
+
+  virtual FunctionPointerBatchBase* createBatch(const QList<QList<QVariant> >& argsList) const = 0;
 };
 
 
@@ -60,6 +187,11 @@ struct FunctionPointerHolder : public FunctionPointerHolderBase
     Fp(args.at(0).value<A>());
   }
 
+  FunctionPointerBatchBase* createBatch(const QList<QList<QVariant> >& argsList) const
+  {
+    return new FunctionPointerBatch<A>(Fp, argsList);
+  }
+
   FunctionPointerType Fp;
 };
 
@@ -83,6 +215,11 @@ struct FunctionPointerHolder2 : public FunctionPointerHolderBase
     Fp(args.at(0).value<A>(), args.at(1).value<B>());
   }
 
+  FunctionPointerBatchBase* createBatch(const QList<QList<QVariant> >& argsList) const
+  {
+    return new FunctionPointerBatch2<A,B>(Fp, argsList);
+  }
+
   FunctionPointerType Fp;
 };
 
@@ -104,6 +241,9 @@ struct CTK_CMDLINEMODULEBACKENDFP_EXPORT FunctionPointerProxy
 
   void call(const QList<QVariant>& args);
 
+  // The caller takes ownership of the returned batch
+  FunctionPointerBatchBase* createBatch(const QList<QList<QVariant> >& argsList) const;
+
 private:
 
   friend class ::ctkCmdLineModuleBackendFunctionPointer;
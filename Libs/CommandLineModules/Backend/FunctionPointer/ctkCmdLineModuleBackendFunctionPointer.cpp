@@ -24,14 +24,17 @@
 #include "ctkCmdLineModuleBackendFPUtil_p.h"
 #include "ctkCmdLineModuleBackendFPDescriptionPrivate.h"
 #include "ctkCmdLineModuleFunctionPointerTask_p.h"
+#include "ctkCmdLineModuleFunctionPointerBatchTask_p.h"
 
 #include "ctkCmdLineModuleFuture.h"
 #include "ctkCmdLineModuleFrontend.h"
+#include "ctkCmdLineModuleRunException.h"
 
 #include <QByteArray>
 #include <QString>
 #include <QList>
 #include <QHash>
+#include <QThreadPool>
 #include <QUrl>
 
 
@@ -189,6 +192,9 @@ ctkCmdLineModuleBackendFunctionPointer::Description::Description(const QUrl &loc
 struct ctkCmdLineModuleBackendFunctionPointerPrivate
 {
   QHash<QUrl, ctkCmdLineModuleBackendFunctionPointer::Description> UrlToFpDescription;
+
+  // Waits for running batches when the back-end is destroyed
+  mutable QThreadPool BatchThreadPool;
 };
 
 //----------------------------------------------------------------------------
@@ -263,6 +269,34 @@ QList<QUrl> ctkCmdLineModuleBackendFunctionPointer::registeredFunctionPointers()
   return d->UrlToFpDescription.keys();
 }
 
+//----------------------------------------------------------------------------
+ctkCmdLineModuleFuture ctkCmdLineModuleBackendFunctionPointer::runBatch(const QUrl& location,
+                                                                      const QList<QList<QVariant> >& parameterSets,
+                                                                      int chunkSize)
+{
+  if (!d->UrlToFpDescription.contains(location))
+  {
+    ctkCmdLineModuleFutureInterface futureInterface;
+    futureInterface.reportStarted();
+    futureInterface.reportException(ctkCmdLineModuleRunException(location, 0, "No function pointer registered."));
+    futureInterface.reportFinished();
+    return futureInterface.future();
+  }
+
+  // Convert the arguments of all calls up-front, the calls themselves
+  // only pass the stored values
+  const Description& descr = d->UrlToFpDescription[location];
+  ctkCmdLineModuleFunctionPointerBatchTask* batchTask =
+      new ctkCmdLineModuleFunctionPointerBatchTask(location, descr.d->FpProxy.createBatch(parameterSets));
+  return batchTask->start(&d->BatchThreadPool, chunkSize);
+}
+
+//----------------------------------------------------------------------------
+QThreadPool* ctkCmdLineModuleBackendFunctionPointer::batchThreadPool() const
+{
+  return &d->BatchThreadPool;
+}
+
 //----------------------------------------------------------------------------
 ctkCmdLineModuleBackendFunctionPointer::Description*
 ctkCmdLineModuleBackendFunctionPointer::registerFunctionPointerProxy(const QString& title,
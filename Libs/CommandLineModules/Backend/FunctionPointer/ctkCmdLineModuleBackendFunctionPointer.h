@@ -36,6 +36,7 @@
 
 #include <QDebug>
 
+class QThreadPool;
 
 namespace ctk {
 namespace CmdLineModuleBackendFunctionPointer {
@@ -154,6 +155,46 @@ public:
 
   QList<QUrl> registeredFunctionPointers() const;
 
+  /**
+   * \brief Calls the function pointer registered for \a location once for each
+   * parameter set in \a parameterSets.
+   *
+   * The parameter sets are converted to the function parameter types once, before
+   * the calls are distributed in chunks of \a chunkSize consecutive parameter sets
+   * over the batchThreadPool(). A \a chunkSize smaller than one selects a chunk size
+   * based on the number of parameter sets and the maximum thread count of the pool.
+   *
+   * The progress range of the returned future is the number of parameter sets, and
+   * the progress value the number of completed calls. For each parameter set, a
+   * ctkCmdLineModuleResult is reported at the index of the parameter set. Its
+   * parameter name is "exception" and its value the message of the exception
+   * thrown by the call, or an invalid QVariant if the call succeeded. A parameter
+   * set with too few arguments, or with an argument which cannot be converted to
+   * the function parameter type, is not called. Its result holds the reason instead.
+   *
+   * The returned future can be canceled and paused between calls.
+   *
+   * \param location The URL of a registered function pointer.
+   * \param parameterSets The arguments of each call, in the same order as the
+   *        function parameters.
+   * \param chunkSize The number of calls run by a thread pool task.
+   * \return A future for the whole batch. If no function pointer is registered for
+   *         \a location, the future reports a ctkCmdLineModuleRunException.
+   */
+  ctkCmdLineModuleFuture runBatch(const QUrl& location, const QList<QList<QVariant> >& parameterSets,
+                                  int chunkSize = 0);
+
+  /**
+   * \brief The thread pool used by runBatch().
+   *
+   * Batches do not share QThreadPool::globalInstance() with single runs and other
+   * concurrent tasks. Use QThreadPool::setMaxThreadCount() to configure the number
+   * of threads, it defaults to QThread::idealThreadCount().
+   *
+   * \return The thread pool owned by this back-end.
+   */
+  QThreadPool* batchThreadPool() const;
+
   template<typename A>
   Description* registerFunctionPointer(const QString& title, void (*fp)(A),
                                        const QString& paramLabel = QString(), const QString& paramDescr = QString())
@@ -0,0 +1,155 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "ctkCmdLineModuleFunctionPointerBatchTask_p.h"
+
+#include "ctkCmdLineModuleFuture.h"
+
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+
+#include <exception>
+
+//----------------------------------------------------------------------------
+class ctkCmdLineModuleFunctionPointerBatchChunk : public QRunnable
+{
+public:
+
+  ctkCmdLineModuleFunctionPointerBatchChunk(ctkCmdLineModuleFunctionPointerBatchTask* task, int begin, int end)
+    : Task(task)
+    , Begin(begin)
+    , End(end)
+  {
+  }
+
+  void run()
+  {
+    Task->runChunk(Begin, End);
+  }
+
+private:
+
+  ctkCmdLineModuleFunctionPointerBatchTask* Task;
+  int Begin;
+  int End;
+};
+
+//----------------------------------------------------------------------------
+ctkCmdLineModuleFunctionPointerBatchTask::ctkCmdLineModuleFunctionPointerBatchTask(
+    const QUrl& location, ctk::CmdLineModuleBackendFunctionPointer::FunctionPointerBatchBase* batch)
+  : Location(location)
+  , Batch(batch)
+  , CompletedCalls(0)
+  , PendingChunks(0)
+{
+}
+
+//----------------------------------------------------------------------------
+ctkCmdLineModuleFuture ctkCmdLineModuleFunctionPointerBatchTask::start(QThreadPool* threadPool, int chunkSize)
+{
+  const int size = Batch->size();
+
+  this->setCanCancel(true);
+  this->setCanPause(true);
+  this->setProgressRange(0, size);
+  this->reportStarted();
+  ctkCmdLineModuleFuture future = this->future();
+
+  if (size == 0)
+  {
+    this->reportFinished();
+    delete this;
+    return future;
+  }
+
+  if (chunkSize < 1)
+  {
+    // a few chunks per thread balance the load without paying the
+    // scheduling overhead for every call
+    const int threadCount = qMax(1, threadPool->maxThreadCount());
+    chunkSize = qMax(1, size / (4 * threadCount));
+  }
+
+  // All chunks must be counted before the first one can finish
+  const int chunkCount = (size + chunkSize - 1) / chunkSize;
+  PendingChunks.fetchAndStoreOrdered(chunkCount);
+
+  for (int begin = 0; begin < size; begin += chunkSize)
+  {
+    // Instances of ctkCmdLineModuleFunctionPointerBatchChunk are auto-deleted
+    // by the thread pool
+    threadPool->start(new ctkCmdLineModuleFunctionPointerBatchChunk(this, begin, qMin(size, begin + chunkSize)));
+  }
+  return future;
+}
+
+//----------------------------------------------------------------------------
+void ctkCmdLineModuleFunctionPointerBatchTask::runChunk(int begin, int end)
+{
+  QVector<ctkCmdLineModuleResult> results;
+  results.reserve(end - begin);
+
+  for (int i = begin; i < end; ++i)
+  {
+    this->waitForResume();
+    if (this->isCanceled())
+    {
+      break;
+    }
+
+    // invalid parameter sets are reported like a failed call
+    QString excMsg = Batch->error(i);
+    if (!excMsg.isNull())
+    {
+      results.push_back(ctkCmdLineModuleResult("exception", excMsg));
+      continue;
+    }
+
+    // call the function pointer and catch any exceptions
+    try
+    {
+      Batch->call(i);
+    }
+    catch (const std::exception& e)
+    {
+      excMsg = e.what();
+    }
+    catch (...)
+    {
+      excMsg = "Unknown exception.";
+    }
+
+    results.push_back(ctkCmdLineModuleResult("exception", excMsg.isNull() ? QVariant() : QVariant(excMsg)));
+  }
+
+  if (!results.isEmpty())
+  {
+    this->reportResults(results, begin, results.size());
+    this->setProgressValue(CompletedCalls.fetchAndAddOrdered(results.size()) + results.size());
+  }
+
+  if (!PendingChunks.deref())
+  {
+    this->reportFinished();
+    delete this;
+  }
+}
@@ -0,0 +1,69 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CTKCMDLINEMODULEFUNCTIONPOINTERBATCHTASK_P_H
+#define CTKCMDLINEMODULEFUNCTIONPOINTERBATCHTASK_P_H
+
+#include "ctkCmdLineModuleFutureInterface.h"
+
+#include "ctkCmdLineModuleBackendFPUtil_p.h"
+
+#include <QAtomicInt>
+#include <QScopedPointer>
+#include <QUrl>
+
+class QThreadPool;
+
+/**
+ * \class ctkCmdLineModuleFunctionPointerBatchTask
+ * \brief Provides a ctkCmdLineModuleFutureInterface implementation which calls
+ * a function pointer for each parameter set of a batch, in chunks of consecutive
+ * parameter sets run concurrently by a thread pool.
+ * \ingroup CommandLineModulesBackendFunctionPointer_API
+ *
+ * The task deletes itself after the last chunk finished.
+ */
+class ctkCmdLineModuleFunctionPointerBatchTask : public ctkCmdLineModuleFutureInterface
+{
+public:
+
+  /**
+   * Takes ownership of \a batch.
+   */
+  ctkCmdLineModuleFunctionPointerBatchTask(const QUrl& location,
+                                           ctk::CmdLineModuleBackendFunctionPointer::FunctionPointerBatchBase* batch);
+
+  ctkCmdLineModuleFuture start(QThreadPool* threadPool, int chunkSize);
+
+private:
+
+  friend class ctkCmdLineModuleFunctionPointerBatchChunk;
+
+  void runChunk(int begin, int end);
+
+  QUrl Location;
+  QScopedPointer<ctk::CmdLineModuleBackendFunctionPointer::FunctionPointerBatchBase> Batch;
+
+  QAtomicInt CompletedCalls;
+  QAtomicInt PendingChunks;
+};
+
+#endif // CTKCMDLINEMODULEFUNCTIONPOINTERBATCHTASK_P_H
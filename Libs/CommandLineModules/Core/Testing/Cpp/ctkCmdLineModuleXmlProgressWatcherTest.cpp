@@ -29,6 +29,7 @@
 #include <QCoreApplication>
 #include <QBuffer>
 #include <QDataStream>
+#include <QSignalSpy>
 #include <QDebug>
 
 
@@ -95,6 +96,9 @@ private Q_SLOTS:
 
   void testSignalsAndValues();
   void testMalformedXml();
+  void testPlainOutput();
+  void testOutputEndsWithSplitTag();
+  void testOutputEndsInElement();
 };
 
 //-----------------------------------------------------------------------------
@@ -193,6 +197,106 @@ void ctkCmdLineModuleXmlProgressWatcherTester::testMalformedXml()
 }
 
 
+//-----------------------------------------------------------------------------
+void ctkCmdLineModuleXmlProgressWatcherTester::testPlainOutput()
+{
+  QBuffer buffer;
+  buffer.open(QIODevice::ReadWrite);
+  ctkCmdLineModuleXmlProgressWatcher progressWatcher(&buffer);
+
+  SignalTester signalTester;
+  signalTester.connect(&progressWatcher, SIGNAL(filterProgress(float,QString)), &signalTester, SLOT(filterProgress(float,QString)));
+  signalTester.connect(&progressWatcher, SIGNAL(filterXmlError(QString)), &signalTester, SLOT(filterXmlError(QString)));
+  QSignalSpy outputSpy(&progressWatcher, SIGNAL(outputDataAvailable(QByteArray)));
+
+  // plain output is forwarded unchanged, also if it is not well-formed XML,
+  // and progress elements may be split across several reads
+  buffer.write("plain <output> with a <tag> & an entity &amp;\n<filter-");
+  QCoreApplication::processEvents();
+  buffer.write("progress>0.5</filter-");
+  QCoreApplication::processEvents();
+  buffer.write("progress>\n<filter-progress-text progress=\"0.7\">Almost done</filter-progress-text>\nvalue < 3\n");
+  QCoreApplication::processEvents();
+
+  QByteArray output;
+  for (int i = 0; i < outputSpy.size(); ++i)
+  {
+    output.append(outputSpy.at(i).at(0).toByteArray());
+  }
+  QCOMPARE(output, QByteArray("plain <output> with a <tag> & an entity &amp;\nvalue < 3\n"));
+
+  QList<QString> expectedSignals;
+  expectedSignals << "filter.progress";
+  expectedSignals << "filter.progress";
+
+  QVERIFY(signalTester.error.isEmpty());
+  QVERIFY(signalTester.checkSignals(expectedSignals));
+  QCOMPARE(signalTester.accumulatedProgress, 1.2f);
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModuleXmlProgressWatcherTester::testOutputEndsWithSplitTag()
+{
+  QBuffer buffer;
+  buffer.open(QIODevice::ReadWrite);
+  ctkCmdLineModuleXmlProgressWatcher progressWatcher(&buffer);
+
+  SignalTester signalTester;
+  signalTester.connect(&progressWatcher, SIGNAL(filterProgress(float,QString)), &signalTester, SLOT(filterProgress(float,QString)));
+  signalTester.connect(&progressWatcher, SIGNAL(filterXmlError(QString)), &signalTester, SLOT(filterXmlError(QString)));
+  QSignalSpy outputSpy(&progressWatcher, SIGNAL(outputDataAvailable(QByteArray)));
+
+  // the start of a tag at the end of a read is held back ...
+  buffer.write("<filter-progress>0.5</filter-progress>\nlast words <filter-");
+  QCoreApplication::processEvents();
+  QByteArray output;
+  for (int i = 0; i < outputSpy.size(); ++i)
+  {
+    output.append(outputSpy.at(i).at(0).toByteArray());
+  }
+  QCOMPARE(output, QByteArray("last words "));
+
+  // ... and forwarded when the output ends
+  buffer.close();
+  output.clear();
+  for (int i = 0; i < outputSpy.size(); ++i)
+  {
+    output.append(outputSpy.at(i).at(0).toByteArray());
+  }
+  QCOMPARE(output, QByteArray("last words <filter-"));
+
+  QList<QString> expectedSignals;
+  expectedSignals << "filter.progress";
+
+  QVERIFY(signalTester.error.isEmpty());
+  QVERIFY(signalTester.checkSignals(expectedSignals));
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModuleXmlProgressWatcherTester::testOutputEndsInElement()
+{
+  QBuffer buffer;
+  buffer.open(QIODevice::ReadWrite);
+  ctkCmdLineModuleXmlProgressWatcher progressWatcher(&buffer);
+
+  SignalTester signalTester;
+  signalTester.connect(&progressWatcher, SIGNAL(filterProgress(float,QString)), &signalTester, SLOT(filterProgress(float,QString)));
+  QSignalSpy outputSpy(&progressWatcher, SIGNAL(outputDataAvailable(QByteArray)));
+
+  // an element which is never closed is plain output
+  buffer.write("plain text\n<filter-progress>0.5 and no end tag\n");
+  QCoreApplication::processEvents();
+  buffer.close();
+
+  QByteArray output;
+  for (int i = 0; i < outputSpy.size(); ++i)
+  {
+    output.append(outputSpy.at(i).at(0).toByteArray());
+  }
+  QCOMPARE(output, QByteArray("plain text\n<filter-progress>0.5 and no end tag\n"));
+  QVERIFY(signalTester.checkSignals(QList<QString>()));
+}
+
 // ----------------------------------------------------------------------------
 CTK_TEST_MAIN(ctkCmdLineModuleXmlProgressWatcherTest)
 #include "moc_ctkCmdLineModuleXmlProgressWatcherTest.cpp"
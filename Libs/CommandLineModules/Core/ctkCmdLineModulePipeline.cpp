@@ -0,0 +1,679 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "ctkCmdLineModulePipeline.h"
+
+#include "ctkCmdLineModuleDescription.h"
+#include "ctkCmdLineModuleFrontend.h"
+#include "ctkCmdLineModuleFuture.h"
+#include "ctkCmdLineModuleFutureWatcher.h"
+#include "ctkCmdLineModuleManager.h"
+#include "ctkCmdLineModuleParameter.h"
+#include "ctkCmdLineModuleReference.h"
+#include "ctkCmdLineModuleResult.h"
+#include "ctkCmdLineModuleRunException.h"
+
+#include "ctkException.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include <QUuid>
+
+namespace {
+
+// The progress range of a single step
+static const int STEP_PROGRESS_MAXIMUM = 1000;
+
+struct Binding
+{
+  int SourceStep;
+  QString OutputParameter;
+  int TargetStep;
+  QString InputParameter;
+};
+
+//----------------------------------------------------------------------------
+bool removeDirectory(const QString& path)
+{
+  QDir dir(path);
+  foreach(const QFileInfo& info, dir.entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot))
+  {
+    if (info.isDir() && !info.isSymLink())
+    {
+      removeDirectory(info.absoluteFilePath());
+    }
+    else
+    {
+      QFile::remove(info.absoluteFilePath());
+    }
+  }
+  return dir.rmdir(path);
+}
+
+}
+
+//----------------------------------------------------------------------------
+class ctkCmdLineModulePipelinePrivate
+{
+public:
+
+  struct Step
+  {
+    Step()
+      : Frontend(NULL), State(ctkCmdLineModulePipeline::StepPending), Watcher(NULL), Progress(0)
+    {}
+
+    ctkCmdLineModuleFrontend* Frontend;
+    QList<int> Prerequisites;
+    ctkCmdLineModulePipeline::StepState State;
+    ctkCmdLineModuleFuture Future;
+    ctkCmdLineModuleFutureWatcher* Watcher;
+    int Progress;
+    QHash<QString, QVariant> Results;
+  };
+
+  ctkCmdLineModulePipelinePrivate(ctkCmdLineModuleManager* moduleManager, ctkCmdLineModulePipeline* qq)
+    : q(qq)
+    , ModuleManager(moduleManager)
+    , MaximumConcurrentSteps(qMax(1, QThread::idealThreadCount()))
+    , ScratchDirectory(QDir::tempPath())
+    , AutoRemoveIntermediates(true)
+    , Running(false)
+    , Canceled(false)
+    , Stopping(false)
+    , RunningSteps(0)
+    , ProgressValue(0)
+  {
+  }
+
+  void checkStep(int step) const
+  {
+    if (step < 0 || step >= Steps.size())
+    {
+      throw ctkInvalidArgumentException(QString("Invalid pipeline step %1.").arg(step));
+    }
+  }
+
+  void checkNotRunning() const
+  {
+    if (Running)
+    {
+      throw ctkIllegalStateException("The pipeline is running.");
+    }
+  }
+
+  void addPrerequisite(int step, int prerequisiteStep)
+  {
+    if (!Steps[step].Prerequisites.contains(prerequisiteStep))
+    {
+      Steps[step].Prerequisites.push_back(prerequisiteStep);
+    }
+  }
+
+  bool hasCycle() const
+  {
+    // Kahn's algorithm: repeatedly remove steps without remaining prerequisites
+    QVector<int> remainingPrerequisites(Steps.size());
+    QVector<QList<int> > dependents(Steps.size());
+    QList<int> ready;
+    for (int i = 0; i < Steps.size(); ++i)
+    {
+      remainingPrerequisites[i] = Steps[i].Prerequisites.size();
+      foreach(int prerequisite, Steps[i].Prerequisites)
+      {
+        dependents[prerequisite].push_back(i);
+      }
+      if (remainingPrerequisites[i] == 0) ready.push_back(i);
+    }
+
+    int sortedSteps = 0;
+    while (!ready.isEmpty())
+    {
+      int step = ready.takeLast();
+      ++sortedSteps;
+      foreach(int dependent, dependents[step])
+      {
+        if (--remainingPrerequisites[dependent] == 0) ready.push_back(dependent);
+      }
+    }
+    return sortedSteps != Steps.size();
+  }
+
+  void createIntermediates()
+  {
+    static QSet<QString> fileTags = QSet<QString>() << "file" << "image" << "geometry"
+                                                    << "transform" << "table" << "measurement";
+
+    QSet<QString> created;
+    foreach(const Binding& binding, Bindings)
+    {
+      ctkCmdLineModuleFrontend* frontend = Steps[binding.SourceStep].Frontend;
+      ctkCmdLineModuleParameter parameter =
+          frontend->moduleReference().description().parameter(binding.OutputParameter);
+      const bool isDirectory = parameter.tag() == "directory";
+      if (!isDirectory && !fileTags.contains(parameter.tag()))
+      {
+        // passed by value
+        continue;
+      }
+
+      QString name = QString("step%1-%2").arg(binding.SourceStep).arg(binding.OutputParameter);
+      if (created.contains(name)) continue;
+      created.insert(name);
+
+      if (RunDirectory.isEmpty())
+      {
+        QString runDirectory = QString("ctkCmdLineModulePipeline-%1").arg(QUuid::createUuid().toString().mid(1, 36));
+        QDir scratchDir(ScratchDirectory);
+        if (!scratchDir.mkpath(runDirectory))
+        {
+          throw ctkRuntimeException(QString("Could not create the directory \"%1\" for intermediates.")
+                                    .arg(scratchDir.absoluteFilePath(runDirectory)));
+        }
+        RunDirectory = scratchDir.absoluteFilePath(runDirectory);
+      }
+
+      QString path = RunDirectory + "/" + name;
+      if (isDirectory)
+      {
+        QDir().mkpath(path);
+      }
+      else
+      {
+        QString extension = parameter.fileExtensions().value(0);
+        if (!extension.isEmpty() && !extension.startsWith('.')) extension.prepend('.');
+        path += extension;
+      }
+      frontend->setValue(binding.OutputParameter, path);
+    }
+  }
+
+  void removeIntermediates()
+  {
+    if (!RunDirectory.isEmpty())
+    {
+      removeDirectory(RunDirectory);
+      RunDirectory.clear();
+    }
+  }
+
+  int stepIndex(QObject* watcher) const
+  {
+    for (int i = 0; i < Steps.size(); ++i)
+    {
+      if (Steps[i].Watcher == watcher) return i;
+    }
+    return -1;
+  }
+
+  void schedule()
+  {
+    for (int i = 0; i < Steps.size() && !Stopping && RunningSteps < MaximumConcurrentSteps; ++i)
+    {
+      if (Steps[i].State != ctkCmdLineModulePipeline::StepPending) continue;
+
+      bool ready = true;
+      foreach(int prerequisite, Steps[i].Prerequisites)
+      {
+        ready = ready && Steps[prerequisite].State == ctkCmdLineModulePipeline::StepFinished;
+      }
+      if (ready)
+      {
+        runStep(i);
+      }
+    }
+
+    if (RunningSteps == 0)
+    {
+      finish();
+    }
+  }
+
+  void runStep(int i)
+  {
+    Step& step = Steps[i];
+
+    foreach(const Binding& binding, Bindings)
+    {
+      if (binding.TargetStep != i) continue;
+
+      // prefer the value reported by the module over the front-end value
+      const Step& source = Steps[binding.SourceStep];
+      QVariant value = source.Results.value(binding.OutputParameter);
+      if (!value.isValid())
+      {
+        value = source.Frontend->value(binding.OutputParameter, ctkCmdLineModuleFrontend::LocalResourceRole);
+      }
+      step.Frontend->setValue(binding.InputParameter, value);
+    }
+
+    try
+    {
+      step.Future = ModuleManager->run(step.Frontend);
+    }
+    catch (const ctkException& e)
+    {
+      failStep(i, e.message());
+      return;
+    }
+
+    step.State = ctkCmdLineModulePipeline::StepRunning;
+    ++RunningSteps;
+
+    step.Watcher = new ctkCmdLineModuleFutureWatcher(q);
+    QObject::connect(step.Watcher, SIGNAL(finished()), q, SLOT(_q_stepFinished()));
+    QObject::connect(step.Watcher, SIGNAL(progressRangeChanged(int,int)), q, SLOT(_q_stepProgressChanged()));
+    QObject::connect(step.Watcher, SIGNAL(progressValueChanged(int)), q, SLOT(_q_stepProgressChanged()));
+    step.Watcher->setFuture(step.Future);
+
+    emit q->stepStarted(i);
+  }
+
+  void failStep(int i, const QString& error)
+  {
+    Steps[i].State = ctkCmdLineModulePipeline::StepFailed;
+    if (ErrorString.isEmpty())
+    {
+      ErrorString = error;
+    }
+    emit q->stepFailed(i, error);
+    stop();
+  }
+
+  void stop()
+  {
+    Stopping = true;
+    foreach(const Step& step, Steps)
+    {
+      if (step.State == ctkCmdLineModulePipeline::StepRunning)
+      {
+        ctkCmdLineModuleFuture future = step.Future;
+        future.cancel();
+      }
+    }
+  }
+
+  void finish()
+  {
+    if (!Running) return;
+
+    for (int i = 0; i < Steps.size(); ++i)
+    {
+      if (Steps[i].State == ctkCmdLineModulePipeline::StepPending)
+      {
+        Steps[i].State = ctkCmdLineModulePipeline::StepCanceled;
+      }
+    }
+    if (AutoRemoveIntermediates)
+    {
+      removeIntermediates();
+    }
+    Running = false;
+    emit q->finished();
+  }
+
+  void updateProgress()
+  {
+    int progressValue = 0;
+    foreach(const Step& step, Steps)
+    {
+      progressValue += step.Progress;
+    }
+    if (progressValue != ProgressValue)
+    {
+      ProgressValue = progressValue;
+      emit q->progressValueChanged(ProgressValue);
+    }
+  }
+
+  void _q_stepFinished()
+  {
+    const int i = stepIndex(q->sender());
+    if (i < 0) return;
+
+    Step& step = Steps[i];
+    step.Watcher->deleteLater();
+    step.Watcher = NULL;
+    --RunningSteps;
+
+    const bool canceled = step.Future.isCanceled();
+    QString error;
+    try
+    {
+      // throws the exception reported by the back-end, if any
+      step.Future.waitForFinished();
+      if (!canceled)
+      {
+        foreach(const ctkCmdLineModuleResult& result, step.Future.results())
+        {
+          step.Results.insert(result.parameter(), result.value());
+        }
+      }
+    }
+    catch (const ctkCmdLineModuleRunException& e)
+    {
+      error = e.errorString();
+    }
+    catch (const ctkException& e)
+    {
+      error = e.message();
+    }
+    catch (...)
+    {
+      error = "Unknown error.";
+    }
+
+    if (!error.isEmpty())
+    {
+      failStep(i, error);
+    }
+    else if (canceled)
+    {
+      step.State = ctkCmdLineModulePipeline::StepCanceled;
+      // a step canceled via its front-end cancels the whole pipeline
+      Canceled = true;
+      stop();
+    }
+    else
+    {
+      step.State = ctkCmdLineModulePipeline::StepFinished;
+      step.Progress = STEP_PROGRESS_MAXIMUM;
+      updateProgress();
+      emit q->stepFinished(i);
+    }
+
+    schedule();
+  }
+
+  void _q_stepProgressChanged()
+  {
+    const int i = stepIndex(q->sender());
+    if (i < 0) return;
+
+    ctkCmdLineModuleFutureWatcher* watcher = Steps[i].Watcher;
+    const int minimum = watcher->progressMinimum();
+    const int maximum = watcher->progressMaximum();
+    int progress = 0;
+    if (maximum > minimum)
+    {
+      progress = static_cast<int>(static_cast<qint64>(watcher->progressValue() - minimum) *
+                                  STEP_PROGRESS_MAXIMUM / (maximum - minimum));
+      progress = qBound(0, progress, STEP_PROGRESS_MAXIMUM);
+    }
+    if (progress != Steps[i].Progress)
+    {
+      Steps[i].Progress = progress;
+      updateProgress();
+    }
+  }
+
+  ctkCmdLineModulePipeline* q;
+  ctkCmdLineModuleManager* ModuleManager;
+
+  QList<Step> Steps;
+  QList<Binding> Bindings;
+
+  int MaximumConcurrentSteps;
+  QString ScratchDirectory;
+  bool AutoRemoveIntermediates;
+
+  bool Running;
+  bool Canceled;
+  // set if the pipeline was canceled or a step failed
+  bool Stopping;
+  int RunningSteps;
+  QString ErrorString;
+  // the directory for the intermediates of the current run
+  QString RunDirectory;
+  int ProgressValue;
+};
+
+//----------------------------------------------------------------------------
+ctkCmdLineModulePipeline::ctkCmdLineModulePipeline(ctkCmdLineModuleManager* moduleManager, QObject* parent)
+  : QObject(parent)
+  , d(new ctkCmdLineModulePipelinePrivate(moduleManager, this))
+{
+  Q_ASSERT(moduleManager);
+}
+
+//----------------------------------------------------------------------------
+ctkCmdLineModulePipeline::~ctkCmdLineModulePipeline()
+{
+  if (d->Running)
+  {
+    d->Canceled = true;
+    d->stop();
+    // the intermediates must not be removed while modules use them
+    foreach(const ctkCmdLineModulePipelinePrivate::Step& step, d->Steps)
+    {
+      if (step.State != StepRunning) continue;
+      try
+      {
+        ctkCmdLineModuleFuture future = step.Future;
+        future.waitForFinished();
+      }
+      catch (...)
+      {
+      }
+    }
+    if (d->AutoRemoveIntermediates)
+    {
+      d->removeIntermediates();
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+int ctkCmdLineModulePipeline::addStep(ctkCmdLineModuleFrontend* frontend)
+{
+  d->checkNotRunning();
+  if (frontend == NULL)
+  {
+    throw ctkInvalidArgumentException("The front-end must not be NULL.");
+  }
+
+  ctkCmdLineModulePipelinePrivate::Step step;
+  step.Frontend = frontend;
+  d->Steps.push_back(step);
+  return d->Steps.size() - 1;
+}
+
+//----------------------------------------------------------------------------
+int ctkCmdLineModulePipeline::stepCount() const
+{
+  return d->Steps.size();
+}
+
+//----------------------------------------------------------------------------
+ctkCmdLineModuleFrontend* ctkCmdLineModulePipeline::step(int step) const
+{
+  d->checkStep(step);
+  return d->Steps[step].Frontend;
+}
+
+//----------------------------------------------------------------------------
+ctkCmdLineModulePipeline::StepState ctkCmdLineModulePipeline::stepState(int step) const
+{
+  d->checkStep(step);
+  return d->Steps[step].State;
+}
+
+//----------------------------------------------------------------------------
+void ctkCmdLineModulePipeline::bind(int sourceStep, const QString& outputParameter,
+                                    int targetStep, const QString& inputParameter)
+{
+  d->checkNotRunning();
+  d->checkStep(sourceStep);
+  d->checkStep(targetStep);
+  if (sourceStep == targetStep)
+  {
+    throw ctkInvalidArgumentException("A step cannot be bound to itself.");
+  }
+
+  // throw for unknown parameter names
+  d->Steps[sourceStep].Frontend->moduleReference().description().parameter(outputParameter);
+  d->Steps[targetStep].Frontend->moduleReference().description().parameter(inputParameter);
+
+  Binding binding;
+  binding.SourceStep = sourceStep;
+  binding.OutputParameter = outputParameter;
+  binding.TargetStep = targetStep;
+  binding.InputParameter = inputParameter;
+  d->Bindings.push_back(binding);
+  d->addPrerequisite(targetStep, sourceStep);
+}
+
+//----------------------------------------------------------------------------
+void ctkCmdLineModulePipeline::addDependency(int step, int prerequisiteStep)
+{
+  d->checkNotRunning();
+  d->checkStep(step);
+  d->checkStep(prerequisiteStep);
+  if (step == prerequisiteStep)
+  {
+    throw ctkInvalidArgumentException("A step cannot depend on itself.");
+  }
+  d->addPrerequisite(step, prerequisiteStep);
+}
+
+//----------------------------------------------------------------------------
+int ctkCmdLineModulePipeline::maximumConcurrentSteps() const
+{
+  return d->MaximumConcurrentSteps;
+}
+
+//----------------------------------------------------------------------------
+void ctkCmdLineModulePipeline::setMaximumConcurrentSteps(int count)
+{
+  d->MaximumConcurrentSteps = qMax(1, count);
+  if (d->Running)
+  {
+    d->schedule();
+  }
+}
+
+//----------------------------------------------------------------------------
+QString ctkCmdLineModulePipeline::scratchDirectory() const
+{
+  return d->ScratchDirectory;
+}
+
+//----------------------------------------------------------------------------
+void ctkCmdLineModulePipeline::setScratchDirectory(const QString& path)
+{
+  d->ScratchDirectory = path;
+}
+
+//----------------------------------------------------------------------------
+bool ctkCmdLineModulePipeline::autoRemoveIntermediates() const
+{
+  return d->AutoRemoveIntermediates;
+}
+
+//----------------------------------------------------------------------------
+void ctkCmdLineModulePipeline::setAutoRemoveIntermediates(bool autoRemove)
+{
+  d->AutoRemoveIntermediates = autoRemove;
+}
+
+//----------------------------------------------------------------------------
+void ctkCmdLineModulePipeline::start()
+{
+  d->checkNotRunning();
+  if (d->hasCycle())
+  {
+    throw ctkInvalidArgumentException("The pipeline steps contain a dependency cycle.");
+  }
+
+  for (int i = 0; i < d->Steps.size(); ++i)
+  {
+    ctkCmdLineModulePipelinePrivate::Step& step = d->Steps[i];
+    step.State = StepPending;
+    step.Future = ctkCmdLineModuleFuture();
+    step.Progress = 0;
+    step.Results.clear();
+  }
+  d->ErrorString.clear();
+  d->Canceled = false;
+  d->Stopping = false;
+  d->RunningSteps = 0;
+  d->ProgressValue = 0;
+
+  // intermediates of a previous run are kept if they are not removed automatically
+  d->RunDirectory.clear();
+  d->createIntermediates();
+
+  d->Running = true;
+  emit started();
+  emit progressRangeChanged(0, this->progressMaximum());
+  emit progressValueChanged(0);
+
+  d->schedule();
+}
+
+//----------------------------------------------------------------------------
+bool ctkCmdLineModulePipeline::isRunning() const
+{
+  return d->Running;
+}
+
+//----------------------------------------------------------------------------
+bool ctkCmdLineModulePipeline::isCanceled() const
+{
+  return d->Canceled;
+}
+
+//----------------------------------------------------------------------------
+QString ctkCmdLineModulePipeline::errorString() const
+{
+  return d->ErrorString;
+}
+
+//----------------------------------------------------------------------------
+int ctkCmdLineModulePipeline::progressMaximum() const
+{
+  return d->Steps.size() * STEP_PROGRESS_MAXIMUM;
+}
+
+//----------------------------------------------------------------------------
+int ctkCmdLineModulePipeline::progressValue() const
+{
+  return d->ProgressValue;
+}
+
+//----------------------------------------------------------------------------
+void ctkCmdLineModulePipeline::cancel()
+{
+  if (!d->Running || d->Canceled) return;
+
+  d->Canceled = true;
+  d->stop();
+  if (d->RunningSteps == 0)
+  {
+    d->finish();
+  }
+}
+
+#include "moc_ctkCmdLineModulePipeline.cpp"
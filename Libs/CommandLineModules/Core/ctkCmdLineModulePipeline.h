@@ -0,0 +1,178 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CTKCMDLINEMODULEPIPELINE_H
+#define CTKCMDLINEMODULEPIPELINE_H
+
+#include "ctkCommandLineModulesCoreExport.h"
+
+#include <QObject>
+#include <QScopedPointer>
+
+class ctkCmdLineModuleFrontend;
+class ctkCmdLineModuleManager;
+class ctkCmdLineModulePipelinePrivate;
+
+/**
+ * \class ctkCmdLineModulePipeline
+ * \brief Runs a directed acyclic graph of module front-ends, passing outputs
+ * of modules to inputs of other modules.
+ * \ingroup CommandLineModulesCore_API
+ *
+ * Each step of a pipeline is a module front-end added via addStep(). Steps
+ * are connected by binding an output parameter of one step to an input parameter
+ * of another step, see bind(). A step is run by the ctkCmdLineModuleManager as
+ * soon as all steps it depends on finished successfully, and independent steps
+ * run concurrently up to maximumConcurrentSteps().
+ *
+ * Bound file-like output parameters (file, image, geometry, transform, table and
+ * measurement parameters, and directories) are intermediates: their values are
+ * set to unique paths in scratchDirectory() when the pipeline is started, and
+ * these paths are removed when the pipeline finished unless
+ * autoRemoveIntermediates() is \c false. Other output parameters are passed
+ * by the value the module reported as a result, or the front-end value if it
+ * did not report one.
+ *
+ * The progress of the pipeline is the sum of the progress of all steps, each
+ * normalized to the range [0, 1000]. If a step fails or the pipeline is canceled,
+ * all running steps are canceled and no further steps are started.
+ *
+ * The pipeline does not take ownership of the front-ends, which must stay valid
+ * while the pipeline is running. It needs a running event loop.
+ */
+class CTK_CMDLINEMODULECORE_EXPORT ctkCmdLineModulePipeline : public QObject
+{
+  Q_OBJECT
+
+public:
+
+  enum StepState {
+    StepPending,
+    StepRunning,
+    StepFinished,
+    StepFailed,
+    StepCanceled
+  };
+
+  ctkCmdLineModulePipeline(ctkCmdLineModuleManager* moduleManager, QObject* parent = 0);
+  ~ctkCmdLineModulePipeline();
+
+  /**
+   * \brief Adds a step running \a frontend.
+   * \return The index of the new step.
+   * \throws ctkIllegalStateException if the pipeline is running.
+   */
+  int addStep(ctkCmdLineModuleFrontend* frontend);
+
+  int stepCount() const;
+  ctkCmdLineModuleFrontend* step(int step) const;
+  StepState stepState(int step) const;
+
+  /**
+   * \brief Passes the value of \a outputParameter of \a sourceStep to \a inputParameter
+   * of \a targetStep, which will run after \a sourceStep finished.
+   * \throws ctkInvalidArgumentException if a step index or parameter name is invalid.
+   * \throws ctkIllegalStateException if the pipeline is running.
+   */
+  void bind(int sourceStep, const QString& outputParameter, int targetStep, const QString& inputParameter);
+
+  /**
+   * \brief Runs \a step after \a prerequisiteStep finished, without passing values.
+   * \throws ctkInvalidArgumentException if a step index is invalid.
+   * \throws ctkIllegalStateException if the pipeline is running.
+   */
+  void addDependency(int step, int prerequisiteStep);
+
+  /**
+   * \brief The maximum number of steps running at the same time, defaults
+   * to QThread::idealThreadCount().
+   */
+  int maximumConcurrentSteps() const;
+  void setMaximumConcurrentSteps(int count);
+
+  /**
+   * \brief The directory in which a sub-directory for the intermediates of each
+   * run is created, defaults to QDir::tempPath().
+   *
+   * A memory backed file system (like tmpfs) avoids writing intermediates to disk.
+   */
+  QString scratchDirectory() const;
+  void setScratchDirectory(const QString& path);
+
+  bool autoRemoveIntermediates() const;
+  void setAutoRemoveIntermediates(bool autoRemove);
+
+  /**
+   * \brief Runs all steps of the pipeline.
+   *
+   * Returns immediately, finished() is emitted after the last step finished.
+   * Errors of the steps are reported by stepFailed() and errorString(); the
+   * exceptions below are thrown before any step is started, the pipeline
+   * is not running then.
+   *
+   * \throws ctkInvalidArgumentException if the steps contain a dependency cycle.
+   * \throws ctkIllegalStateException if the pipeline is running.
+   * \throws ctkRuntimeException if the directory for the intermediates cannot
+   *         be created in scratchDirectory().
+   */
+  void start();
+
+  bool isRunning() const;
+  bool isCanceled() const;
+
+  /**
+   * \return The error of the first step which failed in the last run, or
+   * an empty string.
+   */
+  QString errorString() const;
+
+  int progressMaximum() const;
+  int progressValue() const;
+
+public Q_SLOTS:
+
+  /**
+   * \brief Cancels all running steps and skips the remaining ones.
+   */
+  void cancel();
+
+Q_SIGNALS:
+
+  void started();
+  void stepStarted(int step);
+  void stepFinished(int step);
+  void stepFailed(int step, const QString& error);
+  void progressRangeChanged(int minimum, int maximum);
+  void progressValueChanged(int progressValue);
+  void finished();
+
+private:
+
+  friend class ctkCmdLineModulePipelinePrivate;
+
+  Q_PRIVATE_SLOT(d, void _q_stepFinished())
+  Q_PRIVATE_SLOT(d, void _q_stepProgressChanged())
+
+  QScopedPointer<ctkCmdLineModulePipelinePrivate> d;
+  Q_DISABLE_COPY(ctkCmdLineModulePipeline)
+};
+
+#endif // CTKCMDLINEMODULEPIPELINE_H
@@ -27,6 +27,10 @@
 
 #include <QDebug>
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
 namespace {
 
 static QString FILTER_START = "filter-start";
@@ -37,6 +41,37 @@ static QString FILTER_PROGRESS_TEXT = "filter-progress-text";
 static QString FILTER_RESULT = "filter-result";
 static QString FILTER_END = "filter-end";
 
+// The number of bytes read from the device at once
+static const qint64 READ_CHUNK_SIZE = 64 * 1024;
+
+// The longest tag name which is held back at the end of a chunk
+// to decide if it starts a progress element
+static const int MAX_TAG_NAME_LENGTH = 32;
+
+// Progress elements larger than this are treated as plain output
+static const int MAX_ELEMENT_SIZE = 1024 * 1024;
+
+bool isTagNameChar(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == ':';
+}
+
+bool isProgressElement(const char* tagName, int length)
+{
+  // cheap check before converting the name, "filter-end" is the shortest one
+  if (length < 10 || qstrnicmp(tagName, "filter-", 7) != 0)
+  {
+    return false;
+  }
+  const QString name = QString::fromLatin1(tagName, length);
+  return name.compare(FILTER_START, Qt::CaseInsensitive) == 0 ||
+         name.compare(FILTER_PROGRESS, Qt::CaseInsensitive) == 0 ||
+         name.compare(FILTER_PROGRESS_TEXT, Qt::CaseInsensitive) == 0 ||
+         name.compare(FILTER_RESULT, Qt::CaseInsensitive) == 0 ||
+         name.compare(FILTER_END, Qt::CaseInsensitive) == 0;
+}
+
 }
 
 //----------------------------------------------------------------------------
@@ -46,30 +81,223 @@ public:
 
   ctkCmdLineModuleXmlProgressWatcherPrivate(QIODevice* input, ctkCmdLineModuleXmlProgressWatcher* qq)
     : input(input), process(NULL), readPos(0), q(qq), error(false), currentProgress(0)
+    , lineNumber(1), inElement(false), closeTagSearchPos(0), skipNewline(false)
   {
-    // wrap the content in an artifical root element
-    reader.addData("<module-root>");
   }
 
   ctkCmdLineModuleXmlProgressWatcherPrivate(QProcess* input, ctkCmdLineModuleXmlProgressWatcher* qq)
     : input(input), process(input), readPos(0), q(qq), error(false), currentProgress(0)
+    , lineNumber(1), inElement(false), closeTagSearchPos(0), skipNewline(false)
   {
-    // wrap the content in an artifical root element
-    reader.addData("<module-root>");
   }
 
   void _q_readyRead()
   {
-    input->seek(readPos);
+    // Random access devices might be written to by someone else which
+    // moves the current position. Sequential devices (like QProcess) are
+    // never seeked.
+    if (!input->isSequential())
+    {
+      input->seek(readPos);
+    }
+
+    if (readBuffer.isEmpty())
+    {
+      // room for a chunk and the bytes held back from the previous one
+      readBuffer.resize(READ_CHUNK_SIZE + MAX_TAG_NAME_LENGTH);
+    }
+
+    qint64 bytesRead = 0;
+    while ((bytesRead = input->read(readBuffer.data() + pending.size(), READ_CHUNK_SIZE)) > 0)
+    {
+      // prepend the bytes held back from the previous chunk
+      if (!pending.isEmpty())
+      {
+        memcpy(readBuffer.data(), pending.constData(), pending.size());
+      }
+      const int size = pending.size() + static_cast<int>(bytesRead);
+      pending.clear();
+      scan(readBuffer.constData(), readBuffer.constData() + size);
+    }
+
+    if (!input->isSequential())
+    {
+      readPos = input->pos();
+    }
+  }
+
+  /**
+   * Called when no more output will arrive. The bytes held back at the end
+   * of the last chunk and an unterminated progress element are plain output.
+   */
+  void _q_readChannelFinished()
+  {
+    // the device might not have signaled its last bytes yet
+    _q_readyRead();
+
+    if (!pending.isEmpty())
+    {
+      const QByteArray output = pending;
+      pending.clear();
+      emitOutput(output.constData(), output.constData() + output.size());
+    }
+    if (inElement)
+    {
+      inElement = false;
+      const QByteArray output = element;
+      element.clear();
+      emitOutput(output.constData(), output.constData() + output.size());
+    }
+  }
+
+  /**
+   * Forwards plain output and collects progress elements, which are
+   * parsed one by one.
+   */
+  void scan(const char* begin, const char* end)
+  {
+    const char* outputBegin = begin;
+    const char* pos = begin;
+    while (pos < end)
+    {
+      if (inElement)
+      {
+        pos = collectElement(pos, end);
+        outputBegin = pos;
+        continue;
+      }
+
+      if (skipNewline)
+      {
+        // get rid of a possible newline after the last xml end tag
+        skipNewline = false;
+        if (*pos == '\n')
+        {
+          ++lineNumber;
+          outputBegin = ++pos;
+          continue;
+        }
+      }
+
+      const char* tag = static_cast<const char*>(memchr(pos, '<', end - pos));
+      if (tag == NULL)
+      {
+        break;
+      }
+
+      // read the tag name
+      const char* nameEnd = tag + 1;
+      while (nameEnd < end && nameEnd - tag <= MAX_TAG_NAME_LENGTH && isTagNameChar(*nameEnd))
+      {
+        ++nameEnd;
+      }
+      if (nameEnd == end && nameEnd - tag <= MAX_TAG_NAME_LENGTH)
+      {
+        // the tag name might continue in the next chunk
+        emitOutput(outputBegin, tag);
+        pending = QByteArray(tag, static_cast<int>(end - tag));
+        return;
+      }
+
+      if (nameEnd - tag > MAX_TAG_NAME_LENGTH ||
+          !(*nameEnd == '>' || *nameEnd == '/' || isspace(static_cast<unsigned char>(*nameEnd))) ||
+          !isProgressElement(tag + 1, static_cast<int>(nameEnd - tag - 1)))
+      {
+        // not a progress element, the '<' is plain output
+        pos = tag + 1;
+        continue;
+      }
+
+      emitOutput(outputBegin, tag);
+      inElement = true;
+      element.clear();
+      closeTag = "</" + QByteArray(tag + 1, static_cast<int>(nameEnd - tag - 1));
+      closeTagSearchPos = 0;
+      pos = tag;
+    }
+
+    emitOutput(outputBegin, end);
+  }
+
+  /**
+   * Appends bytes to the current progress element until its end tag is found.
+   * Returns the position after the consumed bytes.
+   */
+  const char* collectElement(const char* begin, const char* end)
+  {
+    const int previousSize = element.size();
+    element.append(begin, static_cast<int>(end - begin));
+
+    // an empty element ends with its start tag
+    int elementEnd = -1;
+    const int startTagEnd = element.indexOf('>');
+    if (startTagEnd > 0 && element.at(startTagEnd - 1) == '/')
+    {
+      elementEnd = startTagEnd + 1;
+    }
+    while (elementEnd < 0)
+    {
+      const int closeTagPos = element.indexOf(closeTag, closeTagSearchPos);
+      if (closeTagPos < 0)
+      {
+        closeTagSearchPos = qMax(0, element.size() - closeTag.size());
+        break;
+      }
+      const int closeTagEnd = element.indexOf('>', closeTagPos + closeTag.size());
+      if (closeTagEnd < 0)
+      {
+        closeTagSearchPos = closeTagPos;
+        break;
+      }
+      bool onlySpaces = true;
+      for (int i = closeTagPos + closeTag.size(); i < closeTagEnd && onlySpaces; ++i)
+      {
+        onlySpaces = isspace(static_cast<unsigned char>(element.at(i)));
+      }
+      if (onlySpaces)
+      {
+        elementEnd = closeTagEnd + 1;
+      }
+      else
+      {
+        // a longer tag name, like </filter-progress-text> for </filter-progress
+        closeTagSearchPos = closeTagPos + 1;
+      }
+    }
 
-    QByteArray buffer = input->readAll();
+    if (elementEnd < 0)
+    {
+      if (element.size() > MAX_ELEMENT_SIZE)
+      {
+        if (!error)
+        {
+          error = true;
+          emit q->filterXmlError(QString("Element \"%1\" starting at line %2 exceeds %3 bytes.")
+                                 .arg(QString::fromLatin1(closeTag.mid(2))).arg(lineNumber).arg(MAX_ELEMENT_SIZE));
+        }
+        inElement = false;
+        const QByteArray output = element;
+        element.clear();
+        emitOutput(output.constData(), output.constData() + output.size());
+      }
+      return end;
+    }
 
-    buffer.prepend("<module-snippet>");
-    buffer.append("</module-snippet>");
+    const int consumed = elementEnd - previousSize;
+    element.truncate(elementEnd);
+    inElement = false;
+    skipNewline = true;
+    parseProgressXml(element);
+    lineNumber += static_cast<int>(std::count(element.constBegin(), element.constEnd(), '\n'));
+    element.clear();
+    return begin + consumed;
+  }
 
-    reader.addData(buffer);
-    readPos = input->pos();
-    parseProgressXml();
+  void emitOutput(const char* begin, const char* end)
+  {
+    if (begin == end) return;
+    lineNumber += static_cast<int>(std::count(begin, end, '\n'));
+    emit q->outputDataAvailable(QByteArray(begin, static_cast<int>(end - begin)));
   }
 
   void _q_readyReadError()
@@ -77,26 +305,20 @@ public:
     emit q->errorDataAvailable(process->readAllStandardError());
   }
 
-  void parseProgressXml()
+  void parseProgressXml(const QByteArray& xml)
   {
+    reader.clear();
+    reader.addData(xml);
+    stack.clear();
+
     QXmlStreamReader::TokenType type = reader.readNext();
-    QByteArray outputData;
-    while(type != QXmlStreamReader::Invalid)
+    while(type != QXmlStreamReader::Invalid && type != QXmlStreamReader::EndDocument)
     {
       switch(type)
       {
       case QXmlStreamReader::NoToken: break;
       case QXmlStreamReader::Characters:
       {
-        if (stack.empty())
-        {
-          QByteArray output(reader.text().toString().toLatin1());
-          // get rid of a possible newline after the last xml end tag
-          if (output.startsWith('\n')) output = output.remove(0,1);
-          outputData.append(output);
-          break;
-        }
-
         if (stack.size() == 2 &&
             (stack.front() == FILTER_START || stack.front() == FILTER_END))
         {
@@ -129,10 +351,7 @@ public:
         QString parent;
         if (!stack.empty()) parent = stack.back();
 
-        if (name.compare(QLatin1String("module-root")) != 0 && name.compare(QLatin1String("module-snippet")) != 0)
-        {
-          stack.push_back(name.toString());
-        }
+        stack.push_back(name.toString());
 
         if (name.compare(FILTER_START, Qt::CaseInsensitive) == 0 ||
             name.compare(FILTER_PROGRESS, Qt::CaseInsensitive) == 0 ||
@@ -177,7 +396,7 @@ public:
           if (!stack.empty()) parent = stack.back();
         }
 
-        if (parent.isEmpty() && name.compare(QLatin1String("module-snippet")) != 0)
+        if (parent.isEmpty())
         {
           if (name.compare(FILTER_START, Qt::CaseInsensitive) == 0)
           {
@@ -210,32 +429,28 @@ public:
         break;
       }
 
-      if (!outputData.isEmpty())
-      {
-        emit q->outputDataAvailable(outputData);
-        outputData.clear();
-      }
       type = reader.readNext();
     }
 
+    // the reader does not know that the element is complete
     if (type == QXmlStreamReader::Invalid && reader.error() != QXmlStreamReader::PrematureEndOfDocumentError)
     {
       if (!error)
       {
         error = true;
         emit q->filterXmlError(QString("Error parsing XML at line %1, column %2: ")
-                               .arg(reader.lineNumber()).arg(reader.columnNumber()) + reader.errorString());
+                               .arg(lineNumber + reader.lineNumber() - 1).arg(reader.columnNumber()) + reader.errorString());
       }
     }
   }
 
-  void unexpectedNestedElement(const QString& element)
+  void unexpectedNestedElement(const QString& name)
   {
     if (!error)
     {
       error = true;
       emit q->filterXmlError(QString("\"%1\" must be a top-level element, found at line %2.")
-                             .arg(element).arg(reader.lineNumber()));
+                             .arg(name).arg(lineNumber + reader.lineNumber() - 1));
     }
   }
 
@@ -251,6 +466,18 @@ public:
   float currentProgress;
   QString currentResultParameter;
   QString currentResultValue;
+
+  // the line of the scan position, for error messages
+  int lineNumber;
+  // bytes of the previous chunk which might start a progress element
+  QByteArray pending;
+  QByteArray readBuffer;
+  // the progress element being collected
+  bool inElement;
+  QByteArray element;
+  QByteArray closeTag;
+  int closeTagSearchPos;
+  bool skipNewline;
 };
 
 
@@ -265,6 +492,8 @@ ctkCmdLineModuleXmlProgressWatcher::ctkCmdLineModuleXmlProgressWatcher(QIODevice
     input->open(QIODevice::ReadOnly);
   }
   connect(d->input, SIGNAL(readyRead()), SLOT(_q_readyRead()));
+  connect(d->input, SIGNAL(readChannelFinished()), SLOT(_q_readChannelFinished()));
+  connect(d->input, SIGNAL(aboutToClose()), SLOT(_q_readChannelFinished()));
 }
 
 //----------------------------------------------------------------------------
@@ -275,6 +504,8 @@ ctkCmdLineModuleXmlProgressWatcher::ctkCmdLineModuleXmlProgressWatcher(QProcess*
 
   connect(input, SIGNAL(readyReadStandardOutput()), SLOT(_q_readyRead()));
   connect(input, SIGNAL(readyReadStandardError()), SLOT(_q_readyReadError()));
+  connect(input, SIGNAL(readChannelFinished()), SLOT(_q_readChannelFinished()));
+  connect(input, SIGNAL(finished(int,QProcess::ExitStatus)), SLOT(_q_readChannelFinished()));
 }
 
 //----------------------------------------------------------------------------
@@ -39,6 +39,11 @@ class QProcess;
  * This class is usually only used by back-end implementators for modules
  * which can report progress and results in the form of XML fragments written
  * to a QIODevice.
+ *
+ * Output which might still belong to a progress element is held back until
+ * more data arrives. It is forwarded as plain output when the device is
+ * closed or its read channel finishes (for a QProcess, also when the
+ * process finishes).
  */
 class CTK_CMDLINEMODULECORE_EXPORT ctkCmdLineModuleXmlProgressWatcher : public QObject
 {
@@ -67,6 +72,7 @@ private:
 
   Q_PRIVATE_SLOT(d, void _q_readyRead())
   Q_PRIVATE_SLOT(d, void _q_readyReadError())
+  Q_PRIVATE_SLOT(d, void _q_readChannelFinished())
 
   QScopedPointer<ctkCmdLineModuleXmlProgressWatcherPrivate> d;
 };
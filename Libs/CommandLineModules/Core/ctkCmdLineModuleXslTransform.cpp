@@ -21,8 +21,11 @@
 
 // Qt includes
 #include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDebug>
 #include <QFile>
+#include <QMap>
 #include <QXmlQuery>
 #include <QXmlSchema>
 #include <QXmlSchemaValidator>
@@ -50,6 +53,9 @@ public:
 
   bool validateOutput();
 
+  /// Reads the whole device, leaving it open at its start.
+  static QByteArray readAll(QIODevice* device);
+
   bool Validate;
   bool Format;
 
@@ -59,6 +65,8 @@ public:
 
   QXmlQuery XslTransform;
   QList<QIODevice*> ExtraTransformations;
+  // QXmlQuery does not give access to the bound variables
+  QMap<QString, QVariant> Variables;
   ctkCmdLineModuleXmlMsgHandler MsgHandler;
 
   QString ErrorStr;
@@ -110,6 +118,19 @@ bool ctkCmdLineModuleXslTransformPrivate::validateOutput()
   return true;
 }
 
+//----------------------------------------------------------------------------
+QByteArray ctkCmdLineModuleXslTransformPrivate::readAll(QIODevice* device)
+{
+  if (!(device->openMode() & QIODevice::ReadOnly))
+  {
+    device->open(QIODevice::ReadOnly);
+  }
+  device->reset();
+  QByteArray content = device->readAll();
+  device->reset();
+  return content;
+}
+
 //----------------------------------------------------------------------------
 ctkCmdLineModuleXslTransform::ctkCmdLineModuleXslTransform(QIODevice *input, QIODevice *output)
   : ctkCmdLineModuleXmlValidator(input)
@@ -188,13 +209,11 @@ bool ctkCmdLineModuleXslTransform::transform()
     return false;
   }
 
-  d->Transformation->open(QIODevice::ReadOnly);
-  QString query(d->Transformation->readAll());
+  QString query(d->readAll(d->Transformation));
   QString extra;
   foreach(QIODevice* extraIODevice, d->ExtraTransformations)
   {
-    extraIODevice->open(QIODevice::ReadOnly);
-    extra += extraIODevice->readAll();
+    extra += d->readAll(extraIODevice);
   }
   query.replace("<!-- EXTRA TRANSFORMATIONS -->", extra);
 #if 0
@@ -257,6 +276,30 @@ void ctkCmdLineModuleXslTransform::setXslTransformation(QIODevice *transformatio
 void ctkCmdLineModuleXslTransform::bindVariable(const QString& name, const QVariant& value)
 {
   d->XslTransform.bindVariable(name, value);
+  d->Variables[name] = value;
+}
+
+//----------------------------------------------------------------------------
+QByteArray ctkCmdLineModuleXslTransform::transformationHash() const
+{
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  if (d->Transformation)
+  {
+    hash.addData(d->readAll(d->Transformation));
+  }
+  foreach(QIODevice* extraIODevice, d->ExtraTransformations)
+  {
+    hash.addData(d->readAll(extraIODevice));
+  }
+
+  QByteArray options;
+  {
+    QDataStream stream(&options, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << d->Variables << d->Format;
+  }
+  hash.addData(options);
+  return hash.result().toHex();
 }
 
 //----------------------------------------------------------------------------
@@ -129,6 +129,19 @@ public:
    */
   void bindVariable(const QString& name, const QVariant& value);
 
+  /**
+   * @brief Returns a hash of everything except the input which determines
+   *        the output of transform().
+   *
+   * The hash covers the XSL transformation, the extra transformations, the
+   * bound variables and the output formatting option. Two transforms with
+   * the same hash produce the same output for the same input, which allows
+   * callers to cache transformation results.
+   *
+   * @return The SHA-1 hash of the transformation, in hex encoding.
+   */
+  QByteArray transformationHash() const;
+
   /**
    * @brief Sets the output validation mode.
    * @param validate If \c true, the output will be validated against the XML schema
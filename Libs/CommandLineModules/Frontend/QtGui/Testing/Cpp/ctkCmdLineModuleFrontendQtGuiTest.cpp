@@ -22,6 +22,7 @@
 // Qt includes
 #include <QSpinBox>
 #include <QComboBox>
+#include <QDir>
 #include <QVariant>
 
 #if (QT_VERSION < QT_VERSION_CHECK(4,7,0))
@@ -31,10 +32,12 @@ Q_DECLARE_METATYPE(QVariant)
 // CTK includes
 #include "ctkCmdLineModuleManager.h"
 #include "ctkCmdLineModuleBackend.h"
+#include "ctkCmdLineModuleFrontendFactoryQtGui.h"
 #include "ctkCmdLineModuleFrontendQtGui.h"
 #include "ctkCmdLineModuleFuture.h"
 #include "ctkCmdLineModuleDescription.h"
 #include "ctkCmdLineModuleParameter.h"
+#include "ctkCmdLineModuleXslTransform.h"
 
 #include "ctkTest.h"
 
@@ -75,6 +78,30 @@ private:
   QHash<QUrl, QByteArray> UrlToXml;
 };
 
+class FrontendWithBoundVariable : public ctkCmdLineModuleFrontendQtGui
+{
+
+public:
+
+  FrontendWithBoundVariable(const ctkCmdLineModuleReference& moduleRef)
+    : ctkCmdLineModuleFrontendQtGui(moduleRef)
+  {}
+
+protected:
+
+  virtual ctkCmdLineModuleXslTransform* xslTransform() const
+  {
+    ctkCmdLineModuleXslTransform* transform = ctkCmdLineModuleFrontendQtGui::xslTransform();
+    transform->bindVariable("integerWidget", QVariant(QString("ctkSliderWidget")));
+    return transform;
+  }
+};
+
+int uiFormFileCount(const QString& cacheDir)
+{
+  return QDir(cacheDir).entryList(QStringList() << "*.ui", QDir::Files).count();
+}
+
 }
 
 // ----------------------------------------------------------------------------
@@ -105,6 +132,10 @@ private Q_SLOTS:
   void testValueSetterAndGetter();
   void testValueSetterAndGetter_data();
 
+  void testUiFormCache();
+
+  void testRecreatedGui();
+
 };
 
 // ----------------------------------------------------------------------------
@@ -237,6 +268,66 @@ void ctkCmdLineModuleFrontendQtGuiTester::testValueSetterAndGetter_data()
   QTest::newRow("intOutputParamLRRole") << "intOutputParam" << QVariant(0) << QVariant(3) << QVariant(3) << static_cast<int>(ctkCmdLineModuleFrontend::LocalResourceRole);
 }
 
+// ----------------------------------------------------------------------------
+void ctkCmdLineModuleFrontendQtGuiTester::testUiFormCache()
+{
+  QString cacheDir = QDir::tempPath() + "/ctkCmdLineModuleFrontendQtGuiTest-"
+      + QString::number(QCoreApplication::applicationPid());
+  ctkCmdLineModuleFrontendQtGui::setUiFormCacheDirectory(cacheDir);
+  ctkCmdLineModuleFrontendQtGui::clearUiFormCache();
+  QCOMPARE(uiFormFileCount(cacheDir), 0);
+
+  QScopedPointer<ctkCmdLineModuleFrontendQtGui> frontend1(new ctkCmdLineModuleFrontendQtGui(this->ModuleRef));
+  QByteArray uiForm = frontend1->uiForm();
+  QVERIFY(!uiForm.isEmpty());
+  QCOMPARE(uiFormFileCount(cacheDir), 1);
+
+  // front-ends with the same transformation share the form
+  QScopedPointer<ctkCmdLineModuleFrontendQtGui> frontend2(new ctkCmdLineModuleFrontendQtGui(this->ModuleRef));
+  QCOMPARE(frontend2->uiForm(), uiForm);
+  QCOMPARE(uiFormFileCount(cacheDir), 1);
+
+  // bound variables are part of the cache key
+  QScopedPointer<ctkCmdLineModuleFrontendQtGui> frontend3(new FrontendWithBoundVariable(this->ModuleRef));
+  QByteArray customUiForm = frontend3->uiForm();
+  QVERIFY(!customUiForm.isEmpty());
+  QVERIFY(customUiForm != uiForm);
+  QCOMPARE(uiFormFileCount(cacheDir), 2);
+
+  // precomputed forms are used to create the GUI
+  ctkCmdLineModuleFrontendQtGui::clearUiFormCache();
+  QCOMPARE(uiFormFileCount(cacheDir), 0);
+  ctkCmdLineModuleFrontendFactoryQtGui factory;
+  factory.precomputeUiForm(this->ModuleRef).waitForFinished();
+  QCOMPARE(uiFormFileCount(cacheDir), 1);
+  QScopedPointer<ctkCmdLineModuleFrontend> frontend4(factory.create(this->ModuleRef));
+  QVERIFY(frontend4->guiHandle() != NULL);
+  QCOMPARE(frontend4->value("intParam"), QVariant(1));
+
+  ctkCmdLineModuleFrontendQtGui::clearUiFormCache();
+  ctkCmdLineModuleFrontendQtGui::setUiFormCacheDirectory(QString());
+  QVERIFY(QDir().rmdir(cacheDir));
+}
+
+// ----------------------------------------------------------------------------
+void ctkCmdLineModuleFrontendQtGuiTester::testRecreatedGui()
+{
+  QScopedPointer<ctkCmdLineModuleFrontend> frontend(new ctkCmdLineModuleFrontendQtGui(this->ModuleRef));
+  delete frontend->guiHandle();
+  QCOMPARE(frontend->value("intParam"), QVariant());
+
+  // the parameter index must refer to the widgets of the new GUI
+  QObject* gui = frontend->guiHandle();
+  QVERIFY(gui != NULL);
+  QVERIFY(frontend->parameterNames().contains("intParam"));
+  QCOMPARE(frontend->value("intParam"), QVariant(1));
+  frontend->setValue("intParam", 5);
+  QCOMPARE(frontend->value("intParam"), QVariant(5));
+  QSpinBox* spinBox = gui->findChild<QSpinBox*>("parameter:intParam");
+  QVERIFY(spinBox != NULL);
+  QCOMPARE(spinBox->value(), 5);
+  delete gui;
+}
 
 // ----------------------------------------------------------------------------
 CTK_TEST_MAIN(ctkCmdLineModuleFrontendQtGuiTest)
@@ -23,12 +23,32 @@
 
 #include "ctkCmdLineModuleFrontendQtGui.h"
 
+#include <QtConcurrentRun>
+
+namespace {
+
+//----------------------------------------------------------------------------
+void ctkCmdLineModulePrecomputeUiForm(ctkCmdLineModuleFrontendFactoryQtGui* factory,
+                                      const ctkCmdLineModuleReference& moduleRef)
+{
+  QScopedPointer<ctkCmdLineModuleFrontendQtGui> frontend(factory->create(moduleRef));
+  frontend->uiForm();
+}
+
+}
+
 //----------------------------------------------------------------------------
 ctkCmdLineModuleFrontendQtGui *ctkCmdLineModuleFrontendFactoryQtGui::create(const ctkCmdLineModuleReference &moduleRef)
 {
   return new ctkCmdLineModuleFrontendQtGui(moduleRef);
 }
 
+//----------------------------------------------------------------------------
+QFuture<void> ctkCmdLineModuleFrontendFactoryQtGui::precomputeUiForm(const ctkCmdLineModuleReference& moduleRef)
+{
+  return QtConcurrent::run(ctkCmdLineModulePrecomputeUiForm, this, moduleRef);
+}
+
 //----------------------------------------------------------------------------
 QString ctkCmdLineModuleFrontendFactoryQtGui::name() const
 {
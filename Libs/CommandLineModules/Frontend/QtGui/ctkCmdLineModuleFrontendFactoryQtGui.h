@@ -27,6 +27,8 @@
 #include "ctkCmdLineModuleFrontendFactory.h"
 #include "ctkCmdLineModuleFrontendQtGui.h"
 
+#include <QFuture>
+
 /**
  * \class ctkCmdLineModuleFrontendFactoryQtGui
  * \brief Factory class to instantiate Qt widget based front-ends.
@@ -46,6 +48,24 @@ public:
   virtual QString description() const;
 
   virtual ctkCmdLineModuleFrontendQtGui* create(const ctkCmdLineModuleReference& moduleRef);
+
+  /**
+   * @brief Generates the Qt .ui form of the module in a background thread.
+   * @param moduleRef The module, usually one which has just been registered.
+   * @return A future which finishes when the form has been cached.
+   *
+   * The form is generated by a front-end created with create() in a thread of
+   * the global QThreadPool and stored in the .ui form cache, so that front-ends
+   * created later for the module do not need to run the XSL transformation.
+   * Sub-classes overriding create() must therefore create front-ends which can
+   * be used in a non-GUI thread until their guiHandle() method is called.
+   *
+   * The factory is used by the background thread: it must not be deleted
+   * before the returned future has finished.
+   *
+   * @see ctkCmdLineModuleFrontendQtGui::uiForm()
+   */
+  QFuture<void> precomputeUiForm(const ctkCmdLineModuleReference& moduleRef);
 };
 
 #endif // CTKCMDLINEMODULEFRONTENDFACTORYQTGUI_H
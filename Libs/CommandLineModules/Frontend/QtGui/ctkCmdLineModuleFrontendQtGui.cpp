@@ -24,10 +24,14 @@
 #include "ctkCmdLineModuleReference.h"
 #include "ctkCmdLineModuleXslTransform.h"
 #include "ctkCmdLineModuleObjectTreeWalker_p.h"
+#include "ctkCmdLineModuleQtUiFormCache_p.h"
 #include "ctkCmdLineModuleQtUiLoader.h"
 
 #include <QBuffer>
+#include <QCryptographicHash>
 #include <QFile>
+#include <QHash>
+#include <QPointer>
 #include <QUiLoader>
 #include <QWidget>
 #include <QVariant>
@@ -45,12 +49,44 @@ struct ctkCmdLineModuleFrontendQtGuiPrivate
   mutable QScopedPointer<QUiLoader> Loader;
   mutable QScopedPointer<QIODevice> xslFile;
   mutable QScopedPointer<ctkCmdLineModuleXslTransform> Transform;
-  mutable QWidget* Widget;
+  mutable QPointer<QWidget> Widget;
 
-  // Cache the list of parameter names
+  // Index of the widget tree, built when the widget is created
   mutable QList<QString> ParameterNames;
+  mutable QHash<QString, QPointer<QObject> > ParameterObjects;
+  mutable QList<QPointer<QObject> > ParameterContainers;
+
+  void indexWidget() const;
 };
 
+//-----------------------------------------------------------------------------
+void ctkCmdLineModuleFrontendQtGuiPrivate::indexWidget() const
+{
+  this->ParameterNames.clear();
+  this->ParameterObjects.clear();
+  this->ParameterContainers.clear();
+
+  ctkCmdLineModuleObjectTreeWalker walker(this->Widget);
+  while(!walker.atEnd())
+  {
+    switch(walker.readNext())
+    {
+    case ctkCmdLineModuleObjectTreeWalker::Parameter:
+      if (!this->ParameterObjects.contains(walker.name()))
+      {
+        this->ParameterNames.push_back(walker.name());
+        this->ParameterObjects.insert(walker.name(), walker.currentObject());
+      }
+      break;
+    case ctkCmdLineModuleObjectTreeWalker::ParameterContainer:
+      this->ParameterContainers.push_back(walker.currentObject());
+      break;
+    default:
+      break;
+    }
+  }
+}
+
 //-----------------------------------------------------------------------------
 ctkCmdLineModuleFrontendQtGui::ctkCmdLineModuleFrontendQtGui(const ctkCmdLineModuleReference& moduleRef)
   : ctkCmdLineModuleFrontend(moduleRef),
@@ -94,15 +130,13 @@ QVariant ctkCmdLineModuleFrontendQtGui::customValue(const QString& parameter, co
 {
   if (!d->Widget) return QVariant();
 
-  ctkCmdLineModuleObjectTreeWalker reader(d->Widget);
-  while(reader.readNextParameter())
-  {
-    if(reader.name() == parameter)
-    {
-      return reader.value(propertyName);
-    }
-  }
-  return QVariant();
+  QObject* parameterObject = d->ParameterObjects.value(parameter);
+  if (!parameterObject) return QVariant();
+
+  // position the reader on the parameter widget
+  ctkCmdLineModuleObjectTreeWalker reader(parameterObject);
+  reader.readNext();
+  return reader.value(propertyName);
 }
 
 //-----------------------------------------------------------------------------
@@ -111,14 +145,15 @@ void ctkCmdLineModuleFrontendQtGui::setCustomValue(const QString& parameter, con
 {
   if (!d->Widget) return;
 
-  ctkCmdLineModuleObjectTreeWalker walker(d->Widget);
-  while(walker.readNextParameter())
+  QObject* parameterObject = d->ParameterObjects.value(parameter);
+  if (!parameterObject) return;
+
+  // position the walker on the parameter widget
+  ctkCmdLineModuleObjectTreeWalker walker(parameterObject);
+  walker.readNext();
+  if (walker.value(propertyName) != value)
   {
-    if(walker.name() == parameter && walker.value(propertyName) != value)
-    {
-      walker.setValue(value, propertyName);
-      break;
-    }
+    walker.setValue(value, propertyName);
   }
 }
 
@@ -127,22 +162,12 @@ QObject* ctkCmdLineModuleFrontendQtGui::guiHandle() const
 {
   if (d->Widget) return d->Widget;
 
-  QBuffer input;
-  input.setData(moduleReference().rawXmlDescription());
+  QByteArray uiFormData = this->uiForm();
+  if (uiFormData.isEmpty()) return 0;
 
   QBuffer uiForm;
-  uiForm.open(QIODevice::ReadWrite);
-
-  ctkCmdLineModuleXslTransform* xslTransform = this->xslTransform();
-  xslTransform->setInput(&input);
-  xslTransform->setOutput(&uiForm);
-
-  if (!xslTransform->transform())
-  {
-    // maybe throw an exception
-    qCritical() << xslTransform->errorString();
-    return 0;
-  }
+  uiForm.setData(uiFormData);
+  uiForm.open(QIODevice::ReadOnly);
 
   QUiLoader* uiLoader = this->uiLoader();
 #ifdef CMAKE_INTDIR
@@ -153,10 +178,70 @@ QObject* ctkCmdLineModuleFrontendQtGui::guiHandle() const
   }
 #endif
   d->Widget = uiLoader->load(&uiForm);
+  d->indexWidget();
   return d->Widget;
 }
 
 
+//-----------------------------------------------------------------------------
+QByteArray ctkCmdLineModuleFrontendQtGui::uiForm() const
+{
+  QByteArray xmlDescription = moduleReference().rawXmlDescription();
+  ctkCmdLineModuleXslTransform* xslTransform = this->xslTransform();
+
+  // The XSL transformation dominates the creation of the GUI, it is only
+  // done once for a given description and transformation
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(xmlDescription);
+  hash.addData(xslTransform->transformationHash());
+  QByteArray key = hash.result().toHex();
+
+  ctkCmdLineModuleQtUiFormCache* cache = ctkCmdLineModuleQtUiFormCache::instance();
+  QByteArray uiFormData = cache->uiForm(key);
+  if (!uiFormData.isEmpty()) return uiFormData;
+
+  QBuffer input;
+  input.setData(xmlDescription);
+
+  QBuffer uiForm;
+  uiForm.open(QIODevice::ReadWrite);
+
+  xslTransform->setInput(&input);
+  xslTransform->setOutput(&uiForm);
+
+  bool transformed = xslTransform->transform();
+  xslTransform->setInput(0);
+  xslTransform->setOutput(0);
+  if (!transformed)
+  {
+    // maybe throw an exception
+    qCritical() << xslTransform->errorString();
+    return QByteArray();
+  }
+
+  uiFormData = uiForm.data();
+  cache->cacheUiForm(key, uiFormData);
+  return uiFormData;
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModuleFrontendQtGui::setUiFormCacheDirectory(const QString& cacheDir)
+{
+  ctkCmdLineModuleQtUiFormCache::instance()->setCacheDir(cacheDir);
+}
+
+//-----------------------------------------------------------------------------
+QString ctkCmdLineModuleFrontendQtGui::uiFormCacheDirectory()
+{
+  return ctkCmdLineModuleQtUiFormCache::instance()->cacheDir();
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModuleFrontendQtGui::clearUiFormCache()
+{
+  ctkCmdLineModuleQtUiFormCache::instance()->clearCache();
+}
+
 //-----------------------------------------------------------------------------
 QVariant ctkCmdLineModuleFrontendQtGui::value(const QString &parameter, int role) const
 {
@@ -191,19 +276,12 @@ void ctkCmdLineModuleFrontendQtGui::setValue(const QString &parameter, const QVa
 //-----------------------------------------------------------------------------
 QList<QString> ctkCmdLineModuleFrontendQtGui::parameterNames() const
 {
-  if (!d->ParameterNames.empty()) return d->ParameterNames;
-
-  // Compute the list of parameter names using the widget hierarchy
-  // if it has already created (otherwise fall back to the superclass
-  // implementation.
+  // Use the list of parameter names from the widget hierarchy
+  // if it has already been created (otherwise fall back to the superclass
+  // implementation).
   // This avoids creating a ctkCmdLineModuleDescription instance.
-  if (d->Widget == 0) return ctkCmdLineModuleFrontend::parameterNames();
+  if (!d->Widget) return ctkCmdLineModuleFrontend::parameterNames();
 
-  ctkCmdLineModuleObjectTreeWalker walker(d->Widget);
-  while(walker.readNextParameter())
-  {
-    d->ParameterNames.push_back(walker.name());
-  }
   return d->ParameterNames;
 }
 
@@ -211,11 +289,14 @@ QList<QString> ctkCmdLineModuleFrontendQtGui::parameterNames() const
 //-----------------------------------------------------------------------------
 void ctkCmdLineModuleFrontendQtGui::setParameterContainerEnabled(const bool& enabled)
 {
-  if (d->Widget == 0) return;
+  if (!d->Widget) return;
 
-  ctkCmdLineModuleObjectTreeWalker walker(d->Widget);
-  while(walker.readNextParameterContainer())
+  foreach(QObject* parameterContainer, d->ParameterContainers)
   {
+    if (!parameterContainer) continue;
+
+    ctkCmdLineModuleObjectTreeWalker walker(parameterContainer);
+    walker.readNext();
     QVariant value(enabled);
     walker.setValue(value, "enabled");
   }
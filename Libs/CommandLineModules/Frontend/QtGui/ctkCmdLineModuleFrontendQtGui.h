@@ -177,6 +177,36 @@ public:
    */
   virtual void setParameterContainerEnabled(const bool& enabled);
 
+  /**
+   * @brief Get the Qt .ui form generated from the module XML description.
+   * @return The .ui form, or an empty QByteArray if the XSL transformation failed.
+   *
+   * The form is generated by the transformation returned by xslTransform()
+   * and cached in memory and, if a cache directory is set, on disk. The cache
+   * key is a hash of the XML description and of the XSL transformation
+   * including extra transformations and bound variables, so that front-ends
+   * of the same module with the same transformation share the form.
+   *
+   * This method is called by guiHandle(). It does not create any widgets and
+   * can be called from any thread for a front-end created in that thread.
+   *
+   * @see ctkCmdLineModuleFrontendFactoryQtGui::precomputeUiForm()
+   */
+  QByteArray uiForm() const;
+
+  /**
+   * @brief Set the directory where generated .ui forms are cached.
+   * @param cacheDir The cache directory. An empty string (the default)
+   *        disables the disk cache, forms are then only cached in memory.
+   */
+  static void setUiFormCacheDirectory(const QString& cacheDir);
+  static QString uiFormCacheDirectory();
+
+  /**
+   * @brief Clears the memory and disk cache of generated .ui forms.
+   */
+  static void clearUiFormCache();
+
 protected:
 
   /**
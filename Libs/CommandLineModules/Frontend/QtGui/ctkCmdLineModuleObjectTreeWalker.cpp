@@ -268,6 +268,12 @@ ctkCmdLineModuleObjectTreeWalker::TokenType ctkCmdLineModuleObjectTreeWalker::to
   return CurrentToken;
 }
 
+//----------------------------------------------------------------------------
+QObject* ctkCmdLineModuleObjectTreeWalker::currentObject() const
+{
+  return CurrentObject;
+}
+
 //----------------------------------------------------------------------------
 QVariant ctkCmdLineModuleObjectTreeWalker::prefixedProperty(const QString& propName) const
 {
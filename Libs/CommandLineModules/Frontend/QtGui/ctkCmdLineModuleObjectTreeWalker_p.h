@@ -80,6 +80,7 @@ public:
   bool readNextParameter();
 
   TokenType tokenType() const;
+  QObject* currentObject() const;
 
 private:
 
@@ -0,0 +1,163 @@
+/*=============================================================================
+  
+  Library: CTK
+  
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+    
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+    http://www.apache.org/licenses/LICENSE-2.0
+    
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+  
+=============================================================================*/
+
+#include "ctkCmdLineModuleQtUiFormCache_p.h"
+
+#include <QCache>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QMutex>
+
+//-----------------------------------------------------------------------------
+struct ctkCmdLineModuleQtUiFormCachePrivate
+{
+  ctkCmdLineModuleQtUiFormCachePrivate()
+    // forms are about 10 to 100 kB, the cost is their size
+    : Forms(32 * 1024 * 1024)
+  {}
+
+  QString fileName(const QByteArray& key) const
+  {
+    return this->CacheDir + "/" + QString::fromLatin1(key) + ".ui";
+  }
+
+  QString CacheDir;
+  QCache<QByteArray, QByteArray> Forms;
+
+  mutable QMutex Mutex;
+};
+
+//-----------------------------------------------------------------------------
+ctkCmdLineModuleQtUiFormCache* ctkCmdLineModuleQtUiFormCache::instance()
+{
+  static ctkCmdLineModuleQtUiFormCache cache;
+  return &cache;
+}
+
+//-----------------------------------------------------------------------------
+ctkCmdLineModuleQtUiFormCache::ctkCmdLineModuleQtUiFormCache()
+  : d(new ctkCmdLineModuleQtUiFormCachePrivate)
+{
+}
+
+//-----------------------------------------------------------------------------
+ctkCmdLineModuleQtUiFormCache::~ctkCmdLineModuleQtUiFormCache()
+{
+}
+
+//-----------------------------------------------------------------------------
+QString ctkCmdLineModuleQtUiFormCache::cacheDir() const
+{
+  QMutexLocker lock(&d->Mutex);
+  return d->CacheDir;
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModuleQtUiFormCache::setCacheDir(const QString& cacheDir)
+{
+  QString dir = cacheDir;
+  if (!dir.isEmpty() && !QDir().mkpath(dir))
+  {
+    qWarning() << "Qt .ui form disk cache disabled. Directory" << dir << "could not be created.";
+    dir.clear();
+  }
+  QMutexLocker lock(&d->Mutex);
+  d->CacheDir = dir;
+}
+
+//-----------------------------------------------------------------------------
+QByteArray ctkCmdLineModuleQtUiFormCache::uiForm(const QByteArray& key) const
+{
+  QMutexLocker lock(&d->Mutex);
+
+  if (QByteArray* form = d->Forms.object(key))
+  {
+    return *form;
+  }
+  if (d->CacheDir.isEmpty())
+  {
+    return QByteArray();
+  }
+
+  // lazily load the form from the file system
+  QFile formFile(d->fileName(key));
+  if (!formFile.open(QIODevice::ReadOnly))
+  {
+    return QByteArray();
+  }
+  QByteArray form = formFile.readAll();
+  if (form.isEmpty())
+  {
+    return QByteArray();
+  }
+  d->Forms.insert(key, new QByteArray(form), form.size());
+  return form;
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModuleQtUiFormCache::cacheUiForm(const QByteArray& key, const QByteArray& uiForm)
+{
+  QMutexLocker lock(&d->Mutex);
+
+  d->Forms.insert(key, new QByteArray(uiForm), uiForm.size());
+  if (d->CacheDir.isEmpty())
+  {
+    return;
+  }
+
+  // Write to a temporary file first, so that other processes sharing the
+  // cache directory never read a partially written form
+  QString fileName = d->fileName(key);
+  QString partFileName = fileName + "." + QString::number(QCoreApplication::applicationPid());
+  QFile partFile(partFileName);
+  if (!partFile.open(QIODevice::WriteOnly) || partFile.write(uiForm) != uiForm.size())
+  {
+    partFile.close();
+    partFile.remove();
+    return;
+  }
+  partFile.close();
+  QFile::remove(fileName);
+  if (!QFile::rename(partFileName, fileName))
+  {
+    QFile::remove(partFileName);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModuleQtUiFormCache::clearCache()
+{
+  QMutexLocker lock(&d->Mutex);
+
+  d->Forms.clear();
+  if (d->CacheDir.isEmpty())
+  {
+    return;
+  }
+  QDirIterator dirIter(d->CacheDir, QStringList() << "*.ui", QDir::Files);
+  while(dirIter.hasNext())
+  {
+    QFile::remove(dirIter.next());
+  }
+}
@@ -0,0 +1,85 @@
+/*=============================================================================
+  
+  Library: CTK
+  
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+    
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+    http://www.apache.org/licenses/LICENSE-2.0
+    
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+  
+=============================================================================*/
+
+#ifndef CTKCMDLINEMODULEQTUIFORMCACHE_P_H
+#define CTKCMDLINEMODULEQTUIFORMCACHE_P_H
+
+#include <QScopedPointer>
+
+struct ctkCmdLineModuleQtUiFormCachePrivate;
+
+class QByteArray;
+class QString;
+
+/**
+ * \class ctkCmdLineModuleQtUiFormCache
+ * \brief Private non-exported, process wide cache of the Qt .ui forms
+ * generated from module XML descriptions.
+ *
+ * Forms are identified by a key computed from the XML description and the
+ * XSL transformation. They are kept in memory and, if a cache directory
+ * is set, in <key>.ui files in this directory so that they survive
+ * application restarts.
+ *
+ * All methods are thread-safe.
+ *
+ * \ingroup CommandLineModulesFrontendQtGui_API
+ */
+class ctkCmdLineModuleQtUiFormCache
+{
+
+public:
+
+  static ctkCmdLineModuleQtUiFormCache* instance();
+
+  ~ctkCmdLineModuleQtUiFormCache();
+
+  QString cacheDir() const;
+
+  /**
+   * @brief Sets the directory of the disk cache, creating it if needed.
+   * @param cacheDir The directory path. The empty string disables the
+   *        disk cache.
+   */
+  void setCacheDir(const QString& cacheDir);
+
+  /**
+   * @brief Returns the cached form for the given key.
+   * @param key The key of the form.
+   * @return The form, or a null QByteArray if there is no such form.
+   */
+  QByteArray uiForm(const QByteArray& key) const;
+
+  void cacheUiForm(const QByteArray& key, const QByteArray& uiForm);
+
+  /**
+   * @brief Clears all entries from the memory and the disk cache.
+   */
+  void clearCache();
+
+private:
+
+  ctkCmdLineModuleQtUiFormCache();
+
+  QScopedPointer<ctkCmdLineModuleQtUiFormCachePrivate> d;
+};
+
+#endif // CTKCMDLINEMODULEQTUIFORMCACHE_P_H
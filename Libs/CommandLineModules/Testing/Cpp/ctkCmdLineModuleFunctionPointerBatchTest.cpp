@@ -0,0 +1,313 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+
+// Qt includes
+#include <QAtomicInt>
+#include <QList>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QVariant>
+
+// CTK includes
+#include "ctkCmdLineModuleBackendFunctionPointer.h"
+#include "ctkCmdLineModuleFuture.h"
+#include "ctkCmdLineModuleRunException.h"
+
+#include "ctkTest.h"
+
+// STD includes
+#include <stdexcept>
+
+// ----------------------------------------------------------------------------
+QAtomicInt SliceSum(0);
+void ProcessSlice(int slice)
+{
+  if (slice % 100 == 42)
+  {
+    throw std::runtime_error("Slice cannot be processed.");
+  }
+  SliceSum.fetchAndAddOrdered(slice);
+}
+
+// ----------------------------------------------------------------------------
+QAtomicInt WeightedSliceSum(0);
+void ProcessWeightedSlice(int slice, int weight)
+{
+  WeightedSliceSum.fetchAndAddOrdered(slice * weight);
+}
+
+// ----------------------------------------------------------------------------
+// Signals each call and blocks it until the test opens the gate
+QSemaphore CallStarted(0);
+QSemaphore CallGate(0);
+QAtomicInt BlockingCallCount(0);
+void ProcessSliceBlocking(int /*slice*/)
+{
+  BlockingCallCount.fetchAndAddOrdered(1);
+  CallStarted.release();
+  CallGate.acquire();
+}
+
+// ----------------------------------------------------------------------------
+class ctkCmdLineModuleFunctionPointerBatchTester: public QObject
+{
+  Q_OBJECT
+
+private Q_SLOTS:
+
+  void testBatch_data();
+  void testBatch();
+
+  void testTwoParameterBatch();
+
+  void testEmptyBatch();
+
+  void testUnknownLocation();
+
+  void testMalformedBatch();
+
+  void testCancelBatch();
+
+  void testPauseBatch();
+
+};
+
+// ----------------------------------------------------------------------------
+void ctkCmdLineModuleFunctionPointerBatchTester::testBatch_data()
+{
+  QTest::addColumn<int>("chunkSize");
+  QTest::addColumn<int>("threadCount");
+
+  QTest::newRow("automatic chunk size") << 0 << QThread::idealThreadCount();
+  QTest::newRow("single call chunks") << 1 << 4;
+  QTest::newRow("odd chunk size") << 33 << 3;
+  QTest::newRow("one chunk") << 10000 << 2;
+  QTest::newRow("single thread") << 16 << 1;
+}
+
+// ----------------------------------------------------------------------------
+void ctkCmdLineModuleFunctionPointerBatchTester::testBatch()
+{
+  QFETCH(int, chunkSize);
+  QFETCH(int, threadCount);
+
+  ctkCmdLineModuleBackendFunctionPointer fpBackend;
+  QUrl url = fpBackend.registerFunctionPointer("Slice Processing", ProcessSlice)->moduleLocation();
+
+  QVERIFY(fpBackend.batchThreadPool() != 0);
+  QVERIFY(fpBackend.batchThreadPool() != QThreadPool::globalInstance());
+  fpBackend.batchThreadPool()->setMaxThreadCount(threadCount);
+
+  const int sliceCount = 1000;
+  QList<QList<QVariant> > parameterSets;
+  int expectedSum = 0;
+  for (int slice = 0; slice < sliceCount; ++slice)
+  {
+    parameterSets.push_back(QList<QVariant>() << slice);
+    if (slice % 100 != 42) expectedSum += slice;
+  }
+
+  SliceSum.fetchAndStoreOrdered(0);
+  ctkCmdLineModuleFuture future = fpBackend.runBatch(url, parameterSets, chunkSize);
+  future.waitForFinished();
+
+  QVERIFY(future.isFinished());
+  QVERIFY(!future.isCanceled());
+  QCOMPARE(future.progressMinimum(), 0);
+  QCOMPARE(future.progressMaximum(), sliceCount);
+  QCOMPARE(future.progressValue(), sliceCount);
+  QCOMPARE(int(SliceSum.fetchAndAddOrdered(0)), expectedSum);
+
+  // one result per parameter set, at the index of the parameter set
+  QList<ctkCmdLineModuleResult> results = future.results();
+  QCOMPARE(results.size(), sliceCount);
+  for (int slice = 0; slice < sliceCount; ++slice)
+  {
+    QCOMPARE(results[slice].parameter(), QString("exception"));
+    if (slice % 100 == 42)
+    {
+      QCOMPARE(results[slice].value().toString(), QString("Slice cannot be processed."));
+    }
+    else
+    {
+      QVERIFY(!results[slice].value().isValid());
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+void ctkCmdLineModuleFunctionPointerBatchTester::testTwoParameterBatch()
+{
+  ctkCmdLineModuleBackendFunctionPointer fpBackend;
+  QUrl url = fpBackend.registerFunctionPointer("Weighted Slice Processing", ProcessWeightedSlice)->moduleLocation();
+
+  QList<QList<QVariant> > parameterSets;
+  int expectedSum = 0;
+  for (int slice = 0; slice < 100; ++slice)
+  {
+    parameterSets.push_back(QList<QVariant>() << slice << 3);
+    expectedSum += 3 * slice;
+  }
+
+  WeightedSliceSum.fetchAndStoreOrdered(0);
+  ctkCmdLineModuleFuture future = fpBackend.runBatch(url, parameterSets, 7);
+  future.waitForFinished();
+
+  QCOMPARE(future.resultCount(), parameterSets.size());
+  QCOMPARE(int(WeightedSliceSum.fetchAndAddOrdered(0)), expectedSum);
+}
+
+// ----------------------------------------------------------------------------
+void ctkCmdLineModuleFunctionPointerBatchTester::testEmptyBatch()
+{
+  ctkCmdLineModuleBackendFunctionPointer fpBackend;
+  QUrl url = fpBackend.registerFunctionPointer("Slice Processing", ProcessSlice)->moduleLocation();
+
+  ctkCmdLineModuleFuture future = fpBackend.runBatch(url, QList<QList<QVariant> >());
+  future.waitForFinished();
+
+  QVERIFY(future.isFinished());
+  QCOMPARE(future.resultCount(), 0);
+}
+
+// ----------------------------------------------------------------------------
+void ctkCmdLineModuleFunctionPointerBatchTester::testUnknownLocation()
+{
+  ctkCmdLineModuleBackendFunctionPointer fpBackend;
+
+  ctkCmdLineModuleFuture future = fpBackend.runBatch(QUrl("fp://0x0"), QList<QList<QVariant> >() << (QList<QVariant>() << 1));
+
+  bool exceptionThrown = false;
+  try
+  {
+    future.waitForFinished();
+  }
+  catch (const ctkCmdLineModuleRunException&)
+  {
+    exceptionThrown = true;
+  }
+  QVERIFY(exceptionThrown);
+}
+
+// ----------------------------------------------------------------------------
+void ctkCmdLineModuleFunctionPointerBatchTester::testMalformedBatch()
+{
+  ctkCmdLineModuleBackendFunctionPointer fpBackend;
+  QUrl url = fpBackend.registerFunctionPointer("Weighted Slice Processing", ProcessWeightedSlice)->moduleLocation();
+
+  QList<QList<QVariant> > parameterSets;
+  parameterSets.push_back(QList<QVariant>() << 1 << 2);
+  parameterSets.push_back(QList<QVariant>() << 3);
+  parameterSets.push_back(QList<QVariant>());
+  parameterSets.push_back(QList<QVariant>() << QVariant() << 4);
+  parameterSets.push_back(QList<QVariant>() << 5 << QVariant(QUrl("file:///tmp")));
+  parameterSets.push_back(QList<QVariant>() << 6 << 7);
+
+  // only the valid parameter sets are called, the others report an error
+  WeightedSliceSum.fetchAndStoreOrdered(0);
+  ctkCmdLineModuleFuture future = fpBackend.runBatch(url, parameterSets, 2);
+  future.waitForFinished();
+
+  QCOMPARE(future.progressValue(), parameterSets.size());
+  QCOMPARE(int(WeightedSliceSum.fetchAndAddOrdered(0)), 1 * 2 + 6 * 7);
+
+  QList<ctkCmdLineModuleResult> results = future.results();
+  QCOMPARE(results.size(), parameterSets.size());
+  QVERIFY(!results[0].value().isValid());
+  QVERIFY(results[1].value().toString().contains("2 argument(s) expected, got 1"));
+  QVERIFY(results[2].value().toString().contains("2 argument(s) expected, got 0"));
+  QVERIFY(results[3].value().toString().contains("argument 1 cannot be converted"));
+  QVERIFY(results[4].value().toString().contains("argument 2 cannot be converted"));
+  QVERIFY(!results[5].value().isValid());
+}
+
+// ----------------------------------------------------------------------------
+void ctkCmdLineModuleFunctionPointerBatchTester::testCancelBatch()
+{
+  ctkCmdLineModuleBackendFunctionPointer fpBackend;
+  QUrl url = fpBackend.registerFunctionPointer("Blocking Slice Processing", ProcessSliceBlocking)->moduleLocation();
+  fpBackend.batchThreadPool()->setMaxThreadCount(1);
+
+  const int sliceCount = 100;
+  QList<QList<QVariant> > parameterSets;
+  for (int slice = 0; slice < sliceCount; ++slice)
+  {
+    parameterSets.push_back(QList<QVariant>() << slice);
+  }
+
+  BlockingCallCount.fetchAndStoreOrdered(0);
+  ctkCmdLineModuleFuture future = fpBackend.runBatch(url, parameterSets, 10);
+  QVERIFY(future.canCancel());
+
+  // cancel while the first call is running
+  CallStarted.acquire();
+  future.cancel();
+  CallGate.release();
+  future.waitForFinished();
+
+  QVERIFY(future.isCanceled());
+  QCOMPARE(int(BlockingCallCount.fetchAndAddOrdered(0)), 1);
+  QVERIFY(future.resultCount() < sliceCount);
+  QCOMPARE(CallStarted.available(), 0);
+}
+
+// ----------------------------------------------------------------------------
+void ctkCmdLineModuleFunctionPointerBatchTester::testPauseBatch()
+{
+  ctkCmdLineModuleBackendFunctionPointer fpBackend;
+  QUrl url = fpBackend.registerFunctionPointer("Blocking Slice Processing", ProcessSliceBlocking)->moduleLocation();
+  fpBackend.batchThreadPool()->setMaxThreadCount(1);
+
+  const int sliceCount = 20;
+  QList<QList<QVariant> > parameterSets;
+  for (int slice = 0; slice < sliceCount; ++slice)
+  {
+    parameterSets.push_back(QList<QVariant>() << slice);
+  }
+
+  BlockingCallCount.fetchAndStoreOrdered(0);
+  ctkCmdLineModuleFuture future = fpBackend.runBatch(url, parameterSets, 5);
+  QVERIFY(future.canPause());
+
+  // pause while the first call is running, no further call may start
+  CallStarted.acquire();
+  future.pause();
+  CallGate.release();
+  QVERIFY(!CallStarted.tryAcquire(1, 200));
+  QCOMPARE(int(BlockingCallCount.fetchAndAddOrdered(0)), 1);
+  QVERIFY(!future.isFinished());
+
+  // the remaining calls run after resuming
+  CallGate.release(sliceCount - 1);
+  future.resume();
+  future.waitForFinished();
+
+  QVERIFY(!future.isCanceled());
+  QCOMPARE(int(BlockingCallCount.fetchAndAddOrdered(0)), sliceCount);
+  QCOMPARE(future.resultCount(), sliceCount);
+  CallStarted.acquire(sliceCount - 1);
+  QCOMPARE(CallGate.available(), 0);
+}
+
+// ----------------------------------------------------------------------------
+CTK_TEST_MAIN(ctkCmdLineModuleFunctionPointerBatchTest)
+#include "moc_ctkCmdLineModuleFunctionPointerBatchTest.cpp"
@@ -0,0 +1,428 @@
+/*=============================================================================
+  
+  Library: CTK
+  
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+    
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+    http://www.apache.org/licenses/LICENSE-2.0
+    
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+  
+=============================================================================*/
+
+#include <ctkCmdLineModuleManager.h>
+#include <ctkCmdLineModuleFrontendFactory.h>
+#include <ctkCmdLineModuleFrontend.h>
+#include <ctkCmdLineModuleReference.h>
+#include <ctkCmdLineModuleDescription.h>
+#include <ctkCmdLineModuleFuture.h>
+#include <ctkCmdLineModuleParameter.h>
+#include <ctkCmdLineModulePipeline.h>
+
+#include "ctkCmdLineModuleBackendLocalProcess.h"
+
+#include "ctkTest.h"
+
+#include <ctkException.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTime>
+#include <QVariant>
+
+//-----------------------------------------------------------------------------
+class ctkCmdLineModulePipelineFrontendMockup : public ctkCmdLineModuleFrontend
+{
+public:
+
+  ctkCmdLineModulePipelineFrontendMockup(const ctkCmdLineModuleReference& moduleRef)
+    : ctkCmdLineModuleFrontend(moduleRef) {}
+
+  virtual QObject* guiHandle() const { return NULL; }
+
+  virtual QVariant value(const QString& parameter, int role) const
+  {
+    Q_UNUSED(role)
+    QVariant value = currentValues[parameter];
+    if (!value.isValid())
+      return this->moduleReference().description().parameter(parameter).defaultValue();
+    return value;
+  }
+
+  virtual void setValue(const QString& parameter, const QVariant& value, int role = DisplayRole)
+  {
+    Q_UNUSED(role)
+    currentValues[parameter] = value;
+  }
+
+private:
+
+  QHash<QString, QVariant> currentValues;
+};
+
+//-----------------------------------------------------------------------------
+class ctkCmdLineModulePipelineTester : public QObject
+{
+  Q_OBJECT
+
+public Q_SLOTS:
+
+  void stepStarted(int step);
+  void stepFinished(int step);
+
+private Q_SLOTS:
+
+  void initTestCase();
+  void cleanupTestCase();
+
+  void init();
+  void cleanup();
+
+  void testChain();
+  void testConcurrency();
+  void testFailure();
+  void testCancel();
+  void testCancelStep();
+  void testCycle();
+  void testInvalidScratchDirectory();
+
+private:
+
+  ctkCmdLineModuleFrontend* createStep(int runtime = 0);
+  void runPipeline();
+  void startCancelablePipeline(int& first, int& second, int& third);
+  void checkCanceledPipeline(QSignalSpy& finishedSpy, int first, int second, int third);
+  QStringList scratchEntries() const;
+
+  ctkCmdLineModuleBackendLocalProcess backend;
+  ctkCmdLineModuleManager manager;
+  ctkCmdLineModuleReference moduleRef;
+
+  QString scratchDirectory;
+  ctkCmdLineModulePipeline* pipeline;
+  QList<ctkCmdLineModuleFrontend*> frontends;
+
+  int runningSteps;
+  int maximumRunningSteps;
+};
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::stepStarted(int /*step*/)
+{
+  ++runningSteps;
+  maximumRunningSteps = qMax(maximumRunningSteps, runningSteps);
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::stepFinished(int /*step*/)
+{
+  --runningSteps;
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::initTestCase()
+{
+  manager.registerBackend(&backend);
+
+  QUrl moduleUrl = QUrl::fromLocalFile(QCoreApplication::applicationDirPath() + "/ctkCmdLineModuleTestBed");
+  moduleRef = manager.registerModule(moduleUrl);
+
+  scratchDirectory = QDir::temp().absoluteFilePath(
+        QString("ctkCmdLineModulePipelineTest-%1").arg(QCoreApplication::applicationPid()));
+  QVERIFY(QDir().mkpath(scratchDirectory));
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::cleanupTestCase()
+{
+  QDir().rmdir(scratchDirectory);
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::init()
+{
+  pipeline = new ctkCmdLineModulePipeline(&manager);
+  pipeline->setScratchDirectory(scratchDirectory);
+  connect(pipeline, SIGNAL(stepStarted(int)), SLOT(stepStarted(int)));
+  connect(pipeline, SIGNAL(stepFinished(int)), SLOT(stepFinished(int)));
+  runningSteps = 0;
+  maximumRunningSteps = 0;
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::cleanup()
+{
+  delete pipeline;
+  qDeleteAll(frontends);
+  frontends.clear();
+}
+
+//-----------------------------------------------------------------------------
+ctkCmdLineModuleFrontend* ctkCmdLineModulePipelineTester::createStep(int runtime)
+{
+  ctkCmdLineModuleFrontend* frontend = new ctkCmdLineModulePipelineFrontendMockup(moduleRef);
+  frontend->setValue("runtimeVar", runtime);
+  frontends.push_back(frontend);
+  return frontend;
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::runPipeline()
+{
+  QEventLoop eventLoop;
+  connect(pipeline, SIGNAL(finished()), &eventLoop, SLOT(quit()));
+  pipeline->start();
+  if (pipeline->isRunning())
+  {
+    eventLoop.exec();
+  }
+  QVERIFY(!pipeline->isRunning());
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::startCancelablePipeline(int& first, int& second, int& third)
+{
+  // two long running steps and a pending step with an intermediate
+  pipeline->setMaximumConcurrentSteps(2);
+  first = pipeline->addStep(createStep(30));
+  second = pipeline->addStep(createStep(30));
+  third = pipeline->addStep(createStep());
+  pipeline->bind(first, "imageOutput", third, "errorTextVar");
+
+  pipeline->start();
+
+  QVERIFY(pipeline->isRunning());
+  QCOMPARE(pipeline->stepState(first), ctkCmdLineModulePipeline::StepRunning);
+  QCOMPARE(pipeline->stepState(second), ctkCmdLineModulePipeline::StepRunning);
+  QCOMPARE(pipeline->stepState(third), ctkCmdLineModulePipeline::StepPending);
+  QCOMPARE(scratchEntries().size(), 1);
+
+  // give event processing a chance before killing the processes
+  QTest::qWait(500);
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::checkCanceledPipeline(QSignalSpy& finishedSpy,
+                                                          int first, int second, int third)
+{
+  // the running modules are killed instead of running to their end
+  QTime time;
+  time.start();
+  while (finishedSpy.isEmpty() && time.elapsed() < 10000)
+  {
+    QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 100);
+  }
+  QCOMPARE(finishedSpy.count(), 1);
+
+  QVERIFY(!pipeline->isRunning());
+  QVERIFY(pipeline->isCanceled());
+  QVERIFY(pipeline->errorString().isEmpty());
+  QCOMPARE(pipeline->stepState(first), ctkCmdLineModulePipeline::StepCanceled);
+  QCOMPARE(pipeline->stepState(second), ctkCmdLineModulePipeline::StepCanceled);
+  QCOMPARE(pipeline->stepState(third), ctkCmdLineModulePipeline::StepCanceled);
+
+  // the run directory is removed
+  QVERIFY(scratchEntries().isEmpty());
+
+  // finished() is not emitted again
+  pipeline->cancel();
+  QTest::qWait(200);
+  QCOMPARE(finishedSpy.count(), 1);
+}
+
+//-----------------------------------------------------------------------------
+QStringList ctkCmdLineModulePipelineTester::scratchEntries() const
+{
+  return QDir(scratchDirectory).entryList(QDir::AllEntries | QDir::NoDotAndDotDot);
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::testChain()
+{
+  // the image output of each step is the error text of the next one,
+  // which the module reports back as a result
+  int first = pipeline->addStep(createStep());
+  int second = pipeline->addStep(createStep());
+  int third = pipeline->addStep(createStep());
+  pipeline->bind(first, "imageOutput", second, "errorTextVar");
+  pipeline->bind(second, "errorMsgOutput", third, "errorTextVar");
+
+  QSignalSpy progressSpy(pipeline, SIGNAL(progressValueChanged(int)));
+  runPipeline();
+
+  QVERIFY(pipeline->errorString().isEmpty());
+  QVERIFY(!pipeline->isCanceled());
+  QCOMPARE(pipeline->stepState(first), ctkCmdLineModulePipeline::StepFinished);
+  QCOMPARE(pipeline->stepState(second), ctkCmdLineModulePipeline::StepFinished);
+  QCOMPARE(pipeline->stepState(third), ctkCmdLineModulePipeline::StepFinished);
+  QCOMPARE(maximumRunningSteps, 1);
+
+  // the intermediate was placed in the scratch directory
+  QString intermediate = pipeline->step(first)->value("imageOutput").toString();
+  QVERIFY(intermediate.startsWith(QDir(scratchDirectory).absolutePath()));
+  QCOMPARE(pipeline->step(second)->value("errorTextVar").toString(), intermediate);
+  QCOMPARE(pipeline->step(third)->value("errorTextVar").toString(), intermediate);
+
+  QVERIFY(progressSpy.count() > 1);
+  QCOMPARE(pipeline->progressValue(), pipeline->progressMaximum());
+
+  // and removed after the pipeline finished
+  QVERIFY(scratchEntries().isEmpty());
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::testConcurrency()
+{
+  pipeline->setMaximumConcurrentSteps(2);
+  pipeline->setAutoRemoveIntermediates(false);
+
+  int source = pipeline->addStep(createStep());
+  for (int i = 0; i < 4; ++i)
+  {
+    int branch = pipeline->addStep(createStep(1));
+    pipeline->bind(source, "imageOutput", branch, "errorTextVar");
+  }
+
+  runPipeline();
+
+  QVERIFY(pipeline->errorString().isEmpty());
+  for (int i = 0; i < pipeline->stepCount(); ++i)
+  {
+    QCOMPARE(pipeline->stepState(i), ctkCmdLineModulePipeline::StepFinished);
+  }
+  QCOMPARE(maximumRunningSteps, 2);
+
+  // kept on request
+  QStringList entries = scratchEntries();
+  QCOMPARE(entries.size(), 1);
+  QDir runDirectory(QDir(scratchDirectory).absoluteFilePath(entries.front()));
+  foreach(const QString& entry, runDirectory.entryList(QDir::AllEntries | QDir::NoDotAndDotDot))
+  {
+    runDirectory.remove(entry);
+  }
+  QVERIFY(QDir(scratchDirectory).rmdir(entries.front()));
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::testFailure()
+{
+  ctkCmdLineModuleFrontend* failing = createStep();
+  failing->setValue("exitCodeVar", 1);
+
+  int first = pipeline->addStep(failing);
+  int second = pipeline->addStep(createStep());
+  pipeline->bind(first, "imageOutput", second, "errorTextVar");
+
+  QSignalSpy failedSpy(pipeline, SIGNAL(stepFailed(int,QString)));
+  runPipeline();
+
+  QCOMPARE(failedSpy.count(), 1);
+  QVERIFY(!pipeline->errorString().isEmpty());
+  QCOMPARE(pipeline->stepState(first), ctkCmdLineModulePipeline::StepFailed);
+  QCOMPARE(pipeline->stepState(second), ctkCmdLineModulePipeline::StepCanceled);
+  QVERIFY(scratchEntries().isEmpty());
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::testCancel()
+{
+  QSignalSpy finishedSpy(pipeline, SIGNAL(finished()));
+  QSignalSpy failedSpy(pipeline, SIGNAL(stepFailed(int,QString)));
+
+  int first, second, third;
+  startCancelablePipeline(first, second, third);
+  if (QTest::currentTestFailed()) return;
+
+  pipeline->cancel();
+  QVERIFY(pipeline->isCanceled());
+
+  checkCanceledPipeline(finishedSpy, first, second, third);
+  if (QTest::currentTestFailed()) return;
+  QCOMPARE(failedSpy.count(), 0);
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::testCancelStep()
+{
+  QSignalSpy finishedSpy(pipeline, SIGNAL(finished()));
+  QSignalSpy failedSpy(pipeline, SIGNAL(stepFailed(int,QString)));
+
+  int first, second, third;
+  startCancelablePipeline(first, second, third);
+  if (QTest::currentTestFailed()) return;
+
+  // canceling the future of a step cancels the whole pipeline
+  ctkCmdLineModuleFuture future = pipeline->step(first)->future();
+  QVERIFY(future.canCancel());
+  future.cancel();
+
+  checkCanceledPipeline(finishedSpy, first, second, third);
+  if (QTest::currentTestFailed()) return;
+  QCOMPARE(failedSpy.count(), 0);
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::testCycle()
+{
+  int first = pipeline->addStep(createStep());
+  int second = pipeline->addStep(createStep());
+  pipeline->addDependency(first, second);
+  pipeline->addDependency(second, first);
+
+  try
+  {
+    pipeline->start();
+    QFAIL("ctkInvalidArgumentException (dependency cycle) expected");
+  }
+  catch (const ctkInvalidArgumentException&)
+  {
+  }
+  QVERIFY(!pipeline->isRunning());
+}
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModulePipelineTester::testInvalidScratchDirectory()
+{
+  // a file where the scratch directory is expected
+  QString scratchFile = QDir(scratchDirectory).absoluteFilePath("scratchFile");
+  QFile file(scratchFile);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.close();
+  pipeline->setScratchDirectory(scratchFile);
+
+  int first = pipeline->addStep(createStep());
+  int second = pipeline->addStep(createStep());
+  pipeline->bind(first, "imageOutput", second, "errorTextVar");
+
+  QSignalSpy startedSpy(pipeline, SIGNAL(started()));
+  bool exceptionThrown = false;
+  try
+  {
+    pipeline->start();
+  }
+  catch (const ctkRuntimeException&)
+  {
+    exceptionThrown = true;
+  }
+  QFile::remove(scratchFile);
+
+  QVERIFY(exceptionThrown);
+  QVERIFY(!pipeline->isRunning());
+  QCOMPARE(startedSpy.count(), 0);
+}
+
+// ----------------------------------------------------------------------------
+CTK_TEST_MAIN(ctkCmdLineModulePipelineTest)
+#include "moc_ctkCmdLineModulePipelineTest.cpp"
@@ -0,0 +1,108 @@
+/*=============================================================================
+  
+  Library: CTK
+  
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+    
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+  
+    http://www.apache.org/licenses/LICENSE-2.0
+    
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+  
+=============================================================================*/
+
+#include "ctkCmdLineModuleXmlProgressWatcher.h"
+
+#include "ctkTest.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QProcess>
+#include <QDebug>
+
+//-----------------------------------------------------------------------------
+class ctkCmdLineModuleXmlProgressWatcherThroughputTester : public QObject
+{
+  Q_OBJECT
+
+public:
+
+  ctkCmdLineModuleXmlProgressWatcherThroughputTester()
+    : outputSize(0), progressCount(0)
+  {}
+
+public Q_SLOTS:
+
+  void outputDataAvailable(const QByteArray& outputData)
+  {
+    outputSize += outputData.size();
+  }
+
+  void filterProgress(float /*progress*/, const QString& /*comment*/)
+  {
+    ++progressCount;
+  }
+
+  void filterXmlError(const QString& error)
+  {
+    xmlError = error;
+  }
+
+private Q_SLOTS:
+
+  void testVerboseModule();
+
+private:
+
+  qint64 outputSize;
+  int progressCount;
+  QString xmlError;
+};
+
+//-----------------------------------------------------------------------------
+void ctkCmdLineModuleXmlProgressWatcherThroughputTester::testVerboseModule()
+{
+  const int outputMegabytes = 256;
+
+  QString processLocation = QCoreApplication::applicationDirPath() + "/ctkCmdLineModuleTestBed";
+  QProcess process;
+  ctkCmdLineModuleXmlProgressWatcher progressWatcher(&process);
+  connect(&progressWatcher, SIGNAL(outputDataAvailable(QByteArray)), SLOT(outputDataAvailable(QByteArray)));
+  connect(&progressWatcher, SIGNAL(filterProgress(float,QString)), SLOT(filterProgress(float,QString)));
+  connect(&progressWatcher, SIGNAL(filterXmlError(QString)), SLOT(filterXmlError(QString)));
+
+  QEventLoop eventLoop;
+  connect(&process, SIGNAL(finished(int)), &eventLoop, SLOT(quit()));
+
+  QElapsedTimer timer;
+  timer.start();
+  process.start(processLocation, QStringList() << "--runtime" << "0"
+                << "--outputSize" << QString::number(outputMegabytes) << "dummy");
+  QVERIFY(process.waitForStarted());
+  eventLoop.exec();
+  qint64 elapsed = timer.elapsed();
+
+  QCOMPARE(process.exitStatus(), QProcess::NormalExit);
+  QVERIFY2(xmlError.isEmpty(), qPrintable(xmlError));
+
+  // the plain output lines plus the result lines at the end of the module
+  QVERIFY(outputSize >= qint64(outputMegabytes) * 1024 * 1024);
+  // one progress element per megabyte and the final one
+  QCOMPARE(progressCount, outputMegabytes + 1);
+
+  qDebug() << "Watched" << outputSize / (1024 * 1024) << "MB of output in" << elapsed << "ms"
+           << "(" << (elapsed > 0 ? outputSize / 1024 / elapsed : 0) << "MB/s )";
+}
+
+// ----------------------------------------------------------------------------
+CTK_TEST_MAIN(ctkCmdLineModuleXmlProgressWatcherThroughputTest)
+#include "moc_ctkCmdLineModuleXmlProgressWatcherThroughputTest.cpp"
@@ -27,7 +27,9 @@
 #include <QDebug>
 #include <QTime>
 
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -67,6 +69,7 @@ int main(int argc, char* argv[])
   parser.addArgument("exitCrash", "", QVariant::Bool, "Force crash", false);
   parser.addArgument("exitTime", "", QVariant::Int, "Exit time", 0);
   parser.addArgument("errorText", "", QVariant::String, "Error text printed at the end");
+  parser.addArgument("outputSize", "", QVariant::Int, "Megabytes of plain standard output", 0);
 
   QTextStream out(stdout, QIODevice::WriteOnly | QIODevice::Text);
   QTextStream err(stderr, QIODevice::WriteOnly | QIODevice::Text);
@@ -115,6 +118,7 @@ int main(int argc, char* argv[])
   int exitCode = parsedArgs["exitCode"].toInt();
   bool exitCrash = parsedArgs["exitCrash"].toBool();
   QString errorText = parsedArgs["errorText"].toString();
+  int outputSize = parsedArgs["outputSize"].toInt();
 
   QString imageOutput = parser.unparsedArguments().at(0);
 
@@ -139,6 +143,25 @@ int main(int argc, char* argv[])
   out << "<filter-comment>Does nothing useful</filter-comment>\n";
   out << "</filter-start>" << endl;
 
+  if (outputSize > 0)
+  {
+    // write plain output lines as fast as possible, with a
+    // progress element after each megabyte
+    out.flush();
+    char line[1024];
+    memset(line, 'x', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\n';
+    for (int i = 0; i < outputSize; ++i)
+    {
+      for (int j = 0; j < 1024; ++j)
+      {
+        fwrite(line, 1, sizeof(line), stdout);
+      }
+      fprintf(stdout, "<filter-progress>%f</filter-progress>\n", static_cast<float>(i+1) / outputSize);
+    }
+    fflush(stdout);
+  }
+
   if (outputs.empty())
   {
     outputs.push_back("dummy");
@@ -0,0 +1,64 @@
+-- 
+-- In-place migration of a 0.5.3 database to the current schema
+-- (see dicom-schema.sql). Only columns, indexes and triggers are added,
+-- so existing rows are kept and files do not need to be re-read.
+-- 
+-- Note: the semicolon at the end is necessary for the simple parser to separate
+--       the statements since the SQlite driver does not handle multiple
+--       commands per QSqlQuery::exec call!
+-- ;
+
+ALTER TABLE 'Patients' ADD COLUMN 'StudyCount' INT NOT NULL DEFAULT 0 ;
+ALTER TABLE 'Patients' ADD COLUMN 'LastStudyDate' DATE NULL ;
+ALTER TABLE 'Studies' ADD COLUMN 'SeriesCount' INT NOT NULL DEFAULT 0 ;
+ALTER TABLE 'Series' ADD COLUMN 'ImageCount' INT NOT NULL DEFAULT 0 ;
+
+CREATE INDEX IF NOT EXISTS 'PatientsNameIndex' ON 'Patients' ('PatientsName', 'UID');
+CREATE INDEX IF NOT EXISTS 'StudiesPatientDateIndex' ON 'Studies' ('PatientsUID', 'StudyDate');
+CREATE INDEX IF NOT EXISTS 'StudiesDateIndex' ON 'Studies' ('StudyDate', 'PatientsUID', 'StudyInstanceUID');
+CREATE INDEX IF NOT EXISTS 'SeriesStudyNumberIndex' ON 'Series' ('StudyInstanceUID', 'SeriesNumber');
+CREATE INDEX IF NOT EXISTS 'SeriesModalityIndex' ON 'Series' ('Modality', 'StudyInstanceUID');
+
+UPDATE 'Series' SET ImageCount =
+  ( SELECT COUNT(*) FROM 'Images' WHERE Images.SeriesInstanceUID = Series.SeriesInstanceUID );
+UPDATE 'Studies' SET SeriesCount =
+  ( SELECT COUNT(*) FROM 'Series' WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID );
+UPDATE 'Patients' SET
+  StudyCount = ( SELECT COUNT(*) FROM 'Studies' WHERE Studies.PatientsUID = Patients.UID ),
+  LastStudyDate = ( SELECT MAX(StudyDate) FROM 'Studies' WHERE Studies.PatientsUID = Patients.UID );
+
+CREATE TRIGGER IF NOT EXISTS 'ImagesInsertTrigger' AFTER INSERT ON 'Images'
+BEGIN
+  UPDATE 'Series' SET ImageCount = ImageCount + 1
+    WHERE SeriesInstanceUID = NEW.SeriesInstanceUID;
+END;
+CREATE TRIGGER IF NOT EXISTS 'ImagesDeleteTrigger' AFTER DELETE ON 'Images'
+BEGIN
+  UPDATE 'Series' SET ImageCount = ImageCount - 1
+    WHERE SeriesInstanceUID = OLD.SeriesInstanceUID;
+END;
+CREATE TRIGGER IF NOT EXISTS 'SeriesInsertTrigger' AFTER INSERT ON 'Series'
+BEGIN
+  UPDATE 'Studies' SET SeriesCount = SeriesCount + 1
+    WHERE StudyInstanceUID = NEW.StudyInstanceUID;
+END;
+CREATE TRIGGER IF NOT EXISTS 'SeriesDeleteTrigger' AFTER DELETE ON 'Series'
+BEGIN
+  UPDATE 'Studies' SET SeriesCount = SeriesCount - 1
+    WHERE StudyInstanceUID = OLD.StudyInstanceUID;
+END;
+CREATE TRIGGER IF NOT EXISTS 'StudiesInsertTrigger' AFTER INSERT ON 'Studies'
+BEGIN
+  UPDATE 'Patients' SET StudyCount = StudyCount + 1,
+    LastStudyDate = CASE WHEN LastStudyDate IS NULL OR NEW.StudyDate > LastStudyDate
+                         THEN NEW.StudyDate ELSE LastStudyDate END
+    WHERE UID = NEW.PatientsUID;
+END;
+CREATE TRIGGER IF NOT EXISTS 'StudiesDeleteTrigger' AFTER DELETE ON 'Studies'
+BEGIN
+  UPDATE 'Patients' SET StudyCount = StudyCount - 1,
+    LastStudyDate = ( SELECT MAX(StudyDate) FROM 'Studies' WHERE PatientsUID = OLD.PatientsUID )
+    WHERE UID = OLD.PatientsUID;
+END;
+
+UPDATE 'SchemaInfo' SET Version = '0.6.0' ;
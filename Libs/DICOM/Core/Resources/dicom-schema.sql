@@ -19,9 +19,14 @@ DROP INDEX IF EXISTS 'ImagesFilenameIndex' ;
 DROP INDEX IF EXISTS 'ImagesSeriesIndex' ;
 DROP INDEX IF EXISTS 'SeriesStudyIndex' ;
 DROP INDEX IF EXISTS 'StudiesPatientIndex' ;
+DROP INDEX IF EXISTS 'PatientsNameIndex' ;
+DROP INDEX IF EXISTS 'StudiesPatientDateIndex' ;
+DROP INDEX IF EXISTS 'StudiesDateIndex' ;
+DROP INDEX IF EXISTS 'SeriesStudyNumberIndex' ;
+DROP INDEX IF EXISTS 'SeriesModalityIndex' ;
 
 CREATE TABLE 'SchemaInfo' ( 'Version' VARCHAR(1024) NOT NULL );
-INSERT INTO 'SchemaInfo' VALUES('0.5.3');
+INSERT INTO 'SchemaInfo' VALUES('0.6.0');
 
 CREATE TABLE 'Images' (
   'SOPInstanceUID' VARCHAR(64) NOT NULL,
@@ -37,7 +42,9 @@ CREATE TABLE 'Patients' (
   'PatientsBirthTime' TIME NULL ,
   'PatientsSex' varchar(1) NULL ,
   'PatientsAge' varchar(10) NULL ,
-  'PatientsComments' VARCHAR(255) NULL );
+  'PatientsComments' VARCHAR(255) NULL ,
+  'StudyCount' INT NOT NULL DEFAULT 0 ,
+  'LastStudyDate' DATE NULL );
 CREATE TABLE 'Series' (
   'SeriesInstanceUID' VARCHAR(64) NOT NULL ,
   'StudyInstanceUID' VARCHAR(64) NOT NULL ,
@@ -53,6 +60,7 @@ CREATE TABLE 'Series' (
   'ScanningSequence' VARCHAR(45) NULL ,
   'EchoNumber' INT NULL ,
   'TemporalPosition' INT NULL ,
+  'ImageCount' INT NOT NULL DEFAULT 0 ,
   PRIMARY KEY ('SeriesInstanceUID') );
 CREATE TABLE 'Studies' (
   'StudyInstanceUID' VARCHAR(64) NOT NULL ,
@@ -66,6 +74,7 @@ CREATE TABLE 'Studies' (
   'ReferringPhysician' VARCHAR(255) NULL ,
   'PerformingPhysiciansName' VARCHAR(255) NULL ,
   'StudyDescription' VARCHAR(255) NULL ,
+  'SeriesCount' INT NOT NULL DEFAULT 0 ,
   PRIMARY KEY ('StudyInstanceUID') );
 
 CREATE UNIQUE INDEX IF NOT EXISTS 'ImagesFilenameIndex' ON 'Images' ('Filename');
@@ -73,6 +82,49 @@ CREATE INDEX IF NOT EXISTS 'ImagesSeriesIndex' ON 'Images' ('SeriesInstanceUID')
 CREATE INDEX IF NOT EXISTS 'SeriesStudyIndex' ON 'Series' ('StudyInstanceUID');
 CREATE INDEX IF NOT EXISTS 'StudiesPatientIndex' ON 'Studies' ('PatientsUID');
 
+-- Covering indexes for the columns the browser sorts and filters on ;
+CREATE INDEX IF NOT EXISTS 'PatientsNameIndex' ON 'Patients' ('PatientsName', 'UID');
+CREATE INDEX IF NOT EXISTS 'StudiesPatientDateIndex' ON 'Studies' ('PatientsUID', 'StudyDate');
+CREATE INDEX IF NOT EXISTS 'StudiesDateIndex' ON 'Studies' ('StudyDate', 'PatientsUID', 'StudyInstanceUID');
+CREATE INDEX IF NOT EXISTS 'SeriesStudyNumberIndex' ON 'Series' ('StudyInstanceUID', 'SeriesNumber');
+CREATE INDEX IF NOT EXISTS 'SeriesModalityIndex' ON 'Series' ('Modality', 'StudyInstanceUID');
+
+-- Keep the denormalized ImageCount, SeriesCount, StudyCount and
+-- LastStudyDate columns up to date ;
+CREATE TRIGGER IF NOT EXISTS 'ImagesInsertTrigger' AFTER INSERT ON 'Images'
+BEGIN
+  UPDATE 'Series' SET ImageCount = ImageCount + 1
+    WHERE SeriesInstanceUID = NEW.SeriesInstanceUID;
+END;
+CREATE TRIGGER IF NOT EXISTS 'ImagesDeleteTrigger' AFTER DELETE ON 'Images'
+BEGIN
+  UPDATE 'Series' SET ImageCount = ImageCount - 1
+    WHERE SeriesInstanceUID = OLD.SeriesInstanceUID;
+END;
+CREATE TRIGGER IF NOT EXISTS 'SeriesInsertTrigger' AFTER INSERT ON 'Series'
+BEGIN
+  UPDATE 'Studies' SET SeriesCount = SeriesCount + 1
+    WHERE StudyInstanceUID = NEW.StudyInstanceUID;
+END;
+CREATE TRIGGER IF NOT EXISTS 'SeriesDeleteTrigger' AFTER DELETE ON 'Series'
+BEGIN
+  UPDATE 'Studies' SET SeriesCount = SeriesCount - 1
+    WHERE StudyInstanceUID = OLD.StudyInstanceUID;
+END;
+CREATE TRIGGER IF NOT EXISTS 'StudiesInsertTrigger' AFTER INSERT ON 'Studies'
+BEGIN
+  UPDATE 'Patients' SET StudyCount = StudyCount + 1,
+    LastStudyDate = CASE WHEN LastStudyDate IS NULL OR NEW.StudyDate > LastStudyDate
+                         THEN NEW.StudyDate ELSE LastStudyDate END
+    WHERE UID = NEW.PatientsUID;
+END;
+CREATE TRIGGER IF NOT EXISTS 'StudiesDeleteTrigger' AFTER DELETE ON 'Studies'
+BEGIN
+  UPDATE 'Patients' SET StudyCount = StudyCount - 1,
+    LastStudyDate = ( SELECT MAX(StudyDate) FROM 'Studies' WHERE PatientsUID = OLD.PatientsUID )
+    WHERE UID = OLD.PatientsUID;
+END;
+
 CREATE TABLE 'Directories' (
   'Dirname' VARCHAR(1024) ,
   PRIMARY KEY ('Dirname') );
@@ -0,0 +1,180 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlQuery>
+#include <QVariant>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+
+int ctkDICOMDatabaseTest8( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 3)
+    {
+    std::cerr << "ctkDICOMDatabaseTest8: missing dicom filePath arguments";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMDatabase database;
+  // The test has its own directory, other tests use the same file names
+  QDir databaseDirectory = QDir::temp();
+  if (!databaseDirectory.mkpath("ctkDICOMDatabaseTest8") ||
+      !databaseDirectory.cd("ctkDICOMDatabaseTest8"))
+    {
+    std::cerr << "ctkDICOMDatabaseTest8: could not create "
+              << qPrintable(databaseDirectory.absoluteFilePath("ctkDICOMDatabaseTest8"))
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  QFileInfo databaseFile(databaseDirectory, QString("database.test"));
+
+  // Start from an empty database, the files of a previous run would
+  // make the counts below wrong
+  QStringList staleFiles;
+  staleFiles << databaseFile.absoluteFilePath()
+             << databaseDirectory.absoluteFilePath("ctkDICOMTagCache.sql");
+  foreach(const QString& staleFile, staleFiles)
+    {
+    if (QFile::exists(staleFile) && !QFile::remove(staleFile))
+      {
+      std::cerr << "ctkDICOMDatabaseTest8: could not remove "
+                << qPrintable(staleFile) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  database.openDatabase(databaseFile.absoluteFilePath());
+
+  bool res = database.initializeDatabase();
+
+  if (!res)
+    {
+    std::cerr << "ctkDICOMDatabase::initializeDatabase() failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Insert the files into the database storage, then remove their
+  // series as a set
+  //
+  for (int i = 1; i < argc; ++i)
+    {
+    database.insert(QString(argv[i]), true, false);
+    }
+
+  QStringList storedFiles = database.allFiles();
+  if (storedFiles.count() != argc - 1)
+    {
+    std::cerr << "ctkDICOMDatabase: " << storedFiles.count()
+              << " files inserted instead of " << argc - 1 << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QStringList seriesUIDs;
+  foreach(const QString& study, database.studiesForPatient(database.patients()[0]))
+    {
+    seriesUIDs << database.seriesForStudy(study);
+    }
+  if (seriesUIDs.isEmpty())
+    {
+    std::cerr << "ctkDICOMDatabase: no series found after insert" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The denormalized counts are maintained by the schema triggers
+  QSqlQuery countQuery(database.database());
+  countQuery.exec("SELECT SUM(ImageCount) FROM Series");
+  if (!countQuery.next() || countQuery.value(0).toInt() != storedFiles.count())
+    {
+    std::cerr << "ctkDICOMDatabase: Series.ImageCount does not match "
+              << "the number of inserted images" << std::endl;
+    return EXIT_FAILURE;
+    }
+  countQuery.exec("SELECT SUM(SeriesCount) FROM Studies");
+  if (!countQuery.next() || countQuery.value(0).toInt() != seriesUIDs.count())
+    {
+    std::cerr << "ctkDICOMDatabase: Studies.SeriesCount does not match "
+              << "the number of inserted series" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Unknown UIDs are ignored
+  seriesUIDs << "1.2.3.4.5.6.7.8.9.unknown";
+
+  QFuture<bool> removal = database.removeSeriesList(seriesUIDs);
+  if (removal.isCanceled())
+    {
+    std::cerr << "ctkDICOMDatabase::removeSeriesList() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Records are removed as soon as the call returns
+  if (!database.allFiles().isEmpty() || !database.patients().isEmpty())
+    {
+    std::cerr << "ctkDICOMDatabase::removeSeriesList() did not remove all records" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  removal.waitForFinished();
+  if (removal.results().count() != storedFiles.count())
+    {
+    std::cerr << "ctkDICOMDatabase::removeSeriesList() reported "
+              << removal.results().count() << " removed files instead of "
+              << storedFiles.count() << std::endl;
+    return EXIT_FAILURE;
+    }
+  foreach(const QString& file, storedFiles)
+    {
+    if (QFileInfo(file).exists())
+      {
+      std::cerr << "ctkDICOMDatabase::removeSeriesList() did not remove "
+                << qPrintable(file) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  //
+  // Removing patients that do not exist is not an error
+  //
+  removal = database.removePatientList(QStringList("12345678"));
+  removal.waitForFinished();
+  if (removal.isCanceled() || removal.results().count() != 0)
+    {
+    std::cerr << "ctkDICOMDatabase::removePatientList() failed for unknown patient" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  database.closeDatabase();
+
+  return EXIT_SUCCESS;
+}
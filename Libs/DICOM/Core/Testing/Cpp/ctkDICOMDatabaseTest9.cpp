@@ -0,0 +1,131 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlQuery>
+#include <QVariant>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+int schemaObjectCount(ctkDICOMDatabase& database, const QString& type)
+{
+  QSqlQuery query(database.database());
+  query.prepare("SELECT COUNT(*) FROM sqlite_master WHERE type = ?");
+  query.addBindValue(type);
+  if (!query.exec() || !query.next())
+    {
+    return -1;
+    }
+  return query.value(0).toInt();
+}
+
+//------------------------------------------------------------------------------
+bool checkFreshDatabase(const QString& databaseFileName, const char* schemaFile)
+{
+  if (QFile::exists(databaseFileName) && !QFile::remove(databaseFileName))
+    {
+    std::cerr << "Could not remove " << qPrintable(databaseFileName) << std::endl;
+    return false;
+    }
+
+  ctkDICOMDatabase database;
+  // A new database is initialized with the built-in schema when opened
+  database.openDatabase(databaseFileName);
+  if (!database.lastError().isEmpty())
+    {
+    std::cerr << "ctkDICOMDatabase::openDatabase() failed: "
+              << qPrintable(database.lastError()) << std::endl;
+    return false;
+    }
+
+  if (schemaFile && !database.initializeDatabase(schemaFile))
+    {
+    std::cerr << "ctkDICOMDatabase::initializeDatabase() failed for "
+              << schemaFile << std::endl;
+    return false;
+    }
+
+  if (database.schemaVersionLoaded() != database.schemaVersion())
+    {
+    std::cerr << "Loaded schema version " << qPrintable(database.schemaVersionLoaded())
+              << " instead of " << qPrintable(database.schemaVersion()) << std::endl;
+    return false;
+    }
+
+  // The statements following the comments of the schema must all be run
+  int indexCount = schemaObjectCount(database, "index");
+  int triggerCount = schemaObjectCount(database, "trigger");
+  if (indexCount < 9 || triggerCount != 6)
+    {
+    std::cerr << "Fresh database has " << indexCount << " indexes and "
+              << triggerCount << " triggers" << std::endl;
+    return false;
+    }
+
+  database.closeDatabase();
+  return true;
+}
+
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabaseTest9( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 2)
+    {
+    std::cerr << "ctkDICOMDatabaseTest9: missing schema filePath argument";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QFileInfo databaseFile(QDir::temp(), QString("ctkDICOMDatabaseTest9.db"));
+  QString databaseFileName(databaseFile.absoluteFilePath());
+
+  // The schema compiled into the library, and the one shipped in the sources
+  if (!checkFreshDatabase(databaseFileName, 0) ||
+      !checkFreshDatabase(databaseFileName, argv[1]))
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (!QFile::remove(databaseFileName))
+    {
+    std::cerr << "Could not remove " << qPrintable(databaseFileName) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,221 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMExporter.h"
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Sorted MD5 checksums of the contents of the files, empty for unreadable files
+QStringList checksums(const QStringList& files)
+{
+  QStringList result;
+  foreach(const QString& fileName, files)
+    {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+      {
+      std::cerr << "Failed to read " << qPrintable(fileName) << std::endl;
+      result << QString();
+      continue;
+      }
+    result << QString(QCryptographicHash::hash(
+                        file.readAll(), QCryptographicHash::Md5).toHex());
+    }
+  result.sort();
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+// The files below the directory, except the DICOMDIR
+QStringList filesInDirectory(const QString& directory)
+{
+  QStringList files;
+  QDirIterator it(directory, QDir::Files, QDirIterator::Subdirectories);
+  while (it.hasNext())
+    {
+    QString fileName = it.next();
+    if (it.fileName() != "DICOMDIR")
+      {
+      files << fileName;
+      }
+    }
+  return files;
+}
+
+//-----------------------------------------------------------------------------
+// Compares the files on disk below the directory with the originals
+bool checkExportedFiles(const QString& directory, const QStringList& originalChecksums)
+{
+  QStringList exportedFiles = filesInDirectory(directory);
+  QStringList exportedChecksums = checksums(exportedFiles);
+  if (exportedChecksums != originalChecksums)
+    {
+    std::cerr << "ctkDICOMExporter: the " << exportedFiles.count()
+              << " files exported to " << qPrintable(directory)
+              << " differ from the " << originalChecksums.count()
+              << " original files." << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int ctkDICOMExporterTest1( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 3)
+    {
+    std::cerr << "ctkDICOMExporterTest1: missing dicom filePath arguments";
+    std::cerr << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Unique scratch directory: exported files are never overwritten
+  QDir tempDirectory = QDir::temp();
+  QString testDirectoryName = QString("ctkDICOMExporterTest1-")
+    + QDateTime::currentDateTime().toString("yyyyMMddhhmmsszzz");
+  tempDirectory.mkdir(testDirectoryName);
+  tempDirectory.cd(testDirectoryName);
+
+  ctkDICOMDatabase database;
+  database.openDatabase(tempDirectory.absoluteFilePath("ctkDICOM.sql"));
+  if (!database.isOpen())
+    {
+    std::cerr << "ctkDICOMDatabase::openDatabase() failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int i = 1; i < argc; ++i)
+    {
+    database.insert(QString(argv[i]), true, false);
+    }
+  QStringList seriesUIDs;
+  foreach(const QString& study, database.studiesForPatient(database.patients()[0]))
+    {
+    seriesUIDs << database.seriesForStudy(study);
+    }
+  const int numberOfFiles = argc - 1;
+  QStringList originalFiles;
+  for (int i = 1; i < argc; ++i)
+    {
+    originalFiles << QString(argv[i]);
+    }
+  const QStringList originalChecksums = checksums(originalFiles);
+
+  ctkDICOMExporter exporter;
+  if (exporter.exportSeries(tempDirectory.absoluteFilePath("export"), seriesUIDs))
+    {
+    std::cerr << "ctkDICOMExporter::exportSeries() succeeded without database."
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (exporter.verifyChecksums())
+    {
+    std::cerr << "ctkDICOMExporter: checksums are verified by default." << std::endl;
+    return EXIT_FAILURE;
+    }
+  exporter.setDatabase(database);
+  exporter.setMaximumThreadCount(2);
+
+  //
+  // Export in the browser layout
+  //
+  if (!exporter.exportSeries(tempDirectory.absoluteFilePath("export"), seriesUIDs)
+      || !exporter.isRunning())
+    {
+    std::cerr << "ctkDICOMExporter::exportSeries() failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (exporter.exportSeries(tempDirectory.absoluteFilePath("export"), seriesUIDs))
+    {
+    std::cerr << "ctkDICOMExporter::exportSeries() succeeded while running."
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  exporter.waitForFinished();
+  if (exporter.isRunning() || !exporter.failedFiles().isEmpty())
+    {
+    std::cerr << "ctkDICOMExporter: export failed: "
+              << qPrintable(exporter.errors().join("\n")) << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkExportedFiles(tempDirectory.absoluteFilePath("export"), originalChecksums))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Existing files are skipped and reported, the export goes on
+  //
+  exporter.exportSeries(tempDirectory.absoluteFilePath("export"), seriesUIDs);
+  exporter.waitForFinished();
+  if (exporter.isRunning() || exporter.failedFiles().count() != numberOfFiles)
+    {
+    std::cerr << "ctkDICOMExporter: existing files were not reported." << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkExportedFiles(tempDirectory.absoluteFilePath("export"), originalChecksums))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Media export, with the copies verified
+  //
+  exporter.setCreateDICOMDIR(true);
+  exporter.setVerifyChecksums(true);
+  exporter.exportSeries(tempDirectory.absoluteFilePath("media"), seriesUIDs);
+  exporter.waitForFinished();
+  if (!exporter.failedFiles().isEmpty()
+      || !QFileInfo(tempDirectory.absoluteFilePath("media/DICOMDIR")).exists()
+      || !QFileInfo(tempDirectory.absoluteFilePath(
+            "media/DICOM/PAT00000/STU00000/SER00000/IMG00000")).exists())
+    {
+    std::cerr << "ctkDICOMExporter: media export failed: "
+              << qPrintable(exporter.errors().join("\n")) << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkExportedFiles(tempDirectory.absoluteFilePath("media"), originalChecksums))
+    {
+    return EXIT_FAILURE;
+    }
+
+  database.closeDatabase();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTimer>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMFilterProxyModel.h"
+#include "ctkDICOMModel.h"
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+bool checkPatientCount(ctkDICOMFilterProxyModel& proxy, const QString& text,
+                       int expectedCount, int line)
+{
+  proxy.setNameSearchText(text);
+  if (proxy.filterChunkSize() > 0)
+    {
+    // The fetched rows are evaluated from the event loop
+    QEventLoop eventLoop;
+    QObject::connect(&proxy, SIGNAL(filterApplied()), &eventLoop, SLOT(quit()));
+    QTimer::singleShot(5000, &eventLoop, SLOT(quit()));
+    eventLoop.exec();
+    }
+  if (proxy.rowCount() != expectedCount)
+    {
+    std::cerr << "Line " << line << " - Search text \"" << qPrintable(text)
+              << "\" (chunk size " << proxy.filterChunkSize() << ") matched "
+              << proxy.rowCount() << " patients instead of "
+              << expectedCount << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int ctkDICOMFilterProxyModelTest1( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc <= 2)
+    {
+    std::cerr << "Usage: ctkDICOMFilterProxyModelTest1 <scratch.db> <dumpfile.sql>" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMDatabase database(argv[1]);
+  if (!database.initializeDatabase(argv[2]))
+    {
+    std::cerr << "Error when initializing the data base: " << argv[2]
+              << " error: " << database.lastError().toStdString() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMModel model;
+  model.setDatabase(database.database());
+
+  ctkDICOMFilterProxyModel proxy;
+  proxy.setSourceModel(&model);
+  if (proxy.filterChunkSize() != 1000)
+    {
+    std::cerr << "Line " << __LINE__ << " - Unexpected default chunk size: "
+              << proxy.filterChunkSize() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (proxy.rowCount() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << " - Unexpected number of patients: "
+              << proxy.rowCount() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Chunked (1 row per event loop iteration) then synchronous filtering
+  int chunkSizes[2] = {1, 0};
+  for (int i = 0; i < 2; ++i)
+    {
+    proxy.setFilterChunkSize(chunkSizes[i]);
+    proxy.setFilterCaseSensitivity(Qt::CaseSensitive);
+    // Plain substring
+    if (!checkPatientCount(proxy, "MROVERLAY", 1, __LINE__) ||
+        !checkPatientCount(proxy, "mroverlay", 0, __LINE__) ||
+    // Regular expression
+        !checkPatientCount(proxy, "^[0-9]", 1, __LINE__) ||
+        !checkPatientCount(proxy, "^(Aus|MRO)", 2, __LINE__) ||
+    // Incomplete regular expression, matched literally
+        !checkPatientCount(proxy, "(Aus", 0, __LINE__) ||
+        !checkPatientCount(proxy, "", 3, __LINE__))
+      {
+      return EXIT_FAILURE;
+      }
+    // Changing the case sensitivity discards the cached results
+    proxy.setFilterCaseSensitivity(Qt::CaseInsensitive);
+    if (!checkPatientCount(proxy, "mroverlay", 1, __LINE__) ||
+        !checkPatientCount(proxy, "", 3, __LINE__))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // The cache must not outlive a reset of the source model
+  proxy.setFilterCaseSensitivity(Qt::CaseSensitive);
+  if (!checkPatientCount(proxy, "Austrialian", 1, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+  model.setDatabase(database.database());
+  if (proxy.rowCount() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Unexpected number of patients "
+              << "after a model reset: " << proxy.rowCount() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
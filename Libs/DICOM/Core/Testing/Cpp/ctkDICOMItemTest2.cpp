@@ -0,0 +1,339 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QVector>
+
+// ctkDICOMCore includes
+#include "ctkDICOMItem.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Keeps the Base64 string of the legacy Serialize()/Deserialize() path
+class ctkDICOMStoredItem : public ctkDICOMItem
+{
+public:
+  QString StoredSerialization;
+
+protected:
+  virtual QString GetStoredSerialization()
+    {
+    return this->StoredSerialization;
+    }
+  virtual void SetStoredSerialization(QString serializedDataset)
+    {
+    this->StoredSerialization = serializedDataset;
+    }
+};
+
+//----------------------------------------------------------------------------
+QByteArray pixelData(DcmElement* element)
+{
+  Uint8* bytes = 0;
+  if (element->getUint8Array(bytes).good() && bytes)
+    {
+    return QByteArray(reinterpret_cast<const char*>(bytes), element->getLength());
+    }
+  Uint16* words = 0;
+  if (element->getUint16Array(words).good() && words)
+    {
+    return QByteArray(reinterpret_cast<const char*>(words), element->getLength());
+    }
+  return QByteArray();
+}
+
+//----------------------------------------------------------------------------
+bool checkSameDataset(const ctkDICOMItem& expected, const ctkDICOMItem& item,
+                      bool withPixelData, const char* context)
+{
+  if (item.GetSOPInstanceUID() != expected.GetSOPInstanceUID() ||
+      item.GetSeriesInstanceUID() != expected.GetSeriesInstanceUID() ||
+      item.GetElementAsString(DCM_PatientName) != expected.GetElementAsString(DCM_PatientName))
+    {
+    std::cerr << context << ": restored dataset has different values" << std::endl;
+    return false;
+    }
+  DcmElement* element = 0;
+  bool hasPixelData = item.findAndGetElement(DCM_PixelData, element).good();
+  if (hasPixelData != withPixelData)
+    {
+    std::cerr << context << ": pixel data is "
+              << (hasPixelData ? "present" : "missing") << std::endl;
+    return false;
+    }
+  if (withPixelData)
+    {
+    DcmElement* expectedElement = 0;
+    expected.findAndGetElement(DCM_PixelData, expectedElement);
+    if (element->getLength() != expectedElement->getLength())
+      {
+      std::cerr << context << ": pixel data length differs" << std::endl;
+      return false;
+      }
+    if (pixelData(element) != pixelData(expectedElement))
+      {
+      std::cerr << context << ": pixel data differs" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool checkRoundTrips(const ctkDICOMItem& item, DcmItem* dataset, const char* context)
+{
+  // binary, through QByteArray
+  QByteArray data = item.SerializeToByteArray();
+  ctkDICOMItem restored;
+  if (data.isEmpty() || !restored.InitializeFromByteArray(data))
+    {
+    std::cerr << context << ": binary serialization through QByteArray failed" << std::endl;
+    return false;
+    }
+  if (!checkSameDataset(item, restored, true, context))
+    {
+    return false;
+    }
+
+  // binary, through QIODevice
+  QByteArray deviceData;
+  QBuffer buffer(&deviceData);
+  buffer.open(QIODevice::ReadWrite);
+  ctkDICOMItem restoredFromDevice;
+  if (!item.SerializeToDevice(&buffer) || !buffer.seek(0) ||
+      !restoredFromDevice.InitializeFromDevice(&buffer) || !buffer.atEnd())
+    {
+    std::cerr << context << ": binary serialization through QIODevice failed" << std::endl;
+    return false;
+    }
+  if (!checkSameDataset(item, restoredFromDevice, true, context))
+    {
+    return false;
+    }
+
+  // legacy Base64 string
+  ctkDICOMStoredItem legacyItem;
+  legacyItem.InitializeFromItem(dataset);
+  legacyItem.Serialize();
+  ctkDICOMStoredItem legacyRestored;
+  legacyRestored.StoredSerialization = legacyItem.StoredSerialization;
+  legacyRestored.Deserialize();
+  if (legacyItem.StoredSerialization.isEmpty() ||
+      !checkSameDataset(item, legacyRestored, true, context))
+    {
+    std::cerr << context << ": Serialize()/Deserialize() failed" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool benchmark(DcmItem* dataset, const char* context, int iterations)
+{
+  ctkDICOMItem item;
+  item.InitializeFromItem(dataset);
+  ctkDICOMStoredItem legacyItem;
+  legacyItem.InitializeFromItem(dataset);
+
+  int binarySize = 0;
+  QElapsedTimer timer;
+  timer.start();
+  for (int i = 0; i < iterations; ++i)
+    {
+    QByteArray data = item.SerializeToByteArray();
+    ctkDICOMItem copy;
+    if (!copy.InitializeFromByteArray(data))
+      {
+      std::cerr << context << ": binary round trip failed" << std::endl;
+      return false;
+      }
+    binarySize = data.size();
+    }
+  qint64 binaryTime = timer.elapsed();
+
+  int legacySize = 0;
+  timer.start();
+  for (int i = 0; i < iterations; ++i)
+    {
+    legacyItem.Serialize();
+    ctkDICOMStoredItem copy;
+    copy.StoredSerialization = legacyItem.StoredSerialization;
+    copy.Deserialize();
+    if (copy.GetSOPInstanceUID() != item.GetSOPInstanceUID())
+      {
+      std::cerr << context << ": Serialize()/Deserialize() round trip failed" << std::endl;
+      return false;
+      }
+    legacySize = legacyItem.StoredSerialization.size();
+    }
+  qint64 legacyTime = timer.elapsed();
+
+  std::cout << context << ": " << iterations << " round trips, binary "
+            << binarySize << " bytes in " << binaryTime << " ms, "
+            << "Serialize()/Deserialize() " << legacySize << " characters in "
+            << legacyTime << " ms" << std::endl;
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int ctkDICOMItemTest2( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  if (argc < 2)
+    {
+    std::cerr << "ctkDICOMItemTest2: missing dicom filePath argument" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  DcmFileFormat fileFormat;
+  if (fileFormat.loadFile(argv[1]).bad())
+    {
+    std::cerr << "Could not load " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+  DcmDataset* dataset = fileFormat.getDataset();
+
+  ctkDICOMItem item;
+  item.InitializeFromFile(argv[1]);
+  if (!item.IsInitialized())
+    {
+    std::cerr << "ctkDICOMItem::InitializeFromFile() failed for " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Round trips of the file
+  //
+  if (!checkRoundTrips(item, dataset, "file"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // A truncated array is rejected
+  QByteArray data = item.SerializeToByteArray();
+  ctkDICOMItem truncated;
+  if (truncated.InitializeFromByteArray(data.left(data.size() / 2)) ||
+      truncated.InitializeFromByteArray(QByteArray("garbage")))
+    {
+    std::cerr << "ctkDICOMItem::InitializeFromByteArray() accepted invalid data" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Round trips of a dataset larger than 1 MB, the former limit of Serialize()
+  //
+  DcmFileFormat largeFileFormat(fileFormat);
+  DcmDataset* largeDataset = largeFileFormat.getDataset();
+  const Uint16 largeSize = 1024;
+  QVector<Uint16> largePixels(largeSize * largeSize);
+  for (int i = 0; i < largePixels.size(); ++i)
+    {
+    largePixels[i] = static_cast<Uint16>(i % 4093);
+    }
+  if (largeDataset->putAndInsertUint16(DCM_Rows, largeSize).bad() ||
+      largeDataset->putAndInsertUint16(DCM_Columns, largeSize).bad() ||
+      largeDataset->putAndInsertUint16(DCM_BitsAllocated, 16).bad() ||
+      largeDataset->putAndInsertUint16Array(DCM_PixelData, largePixels.constData(),
+                                            largePixels.size()).bad())
+    {
+    std::cerr << "Could not create a large dataset" << std::endl;
+    return EXIT_FAILURE;
+    }
+  ctkDICOMItem largeItem;
+  largeItem.InitializeFromItem(largeDataset);
+  if (largeItem.SerializeToByteArray().size() <= 1024 * 1024)
+    {
+    std::cerr << "The large dataset is not larger than 1 MB" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!checkRoundTrips(largeItem, largeDataset, "large dataset"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  //
+  // Metadata only
+  //
+  QByteArray metadata = item.SerializeToByteArray(true);
+  ctkDICOMItem restoredMetadata;
+  if (metadata.isEmpty() || metadata.size() >= data.size() ||
+      !restoredMetadata.InitializeFromByteArray(metadata) ||
+      !checkSameDataset(item, restoredMetadata, false, "metadata"))
+    {
+    std::cerr << "ctkDICOMItem::SerializeToByteArray(excludePixelData) failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //
+  // QDataStream: several datasets and other values in the same stream
+  //
+  QByteArray streamData;
+  {
+  QDataStream out(&streamData, QIODevice::WriteOnly);
+  out << item << qint32(42) << restoredMetadata;
+  if (out.status() != QDataStream::Ok)
+    {
+    std::cerr << "operator<<(QDataStream, ctkDICOMItem) failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+  {
+  QDataStream in(streamData);
+  ctkDICOMItem first;
+  ctkDICOMItem second;
+  qint32 value = 0;
+  in >> first >> value >> second;
+  if (in.status() != QDataStream::Ok || value != 42 ||
+      !checkSameDataset(item, first, true, "QDataStream") ||
+      !checkSameDataset(item, second, false, "QDataStream"))
+    {
+    std::cerr << "operator>>(QDataStream, ctkDICOMItem) failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  //
+  // Throughput, compared to the legacy Serialize()/Deserialize() path
+  //
+  if (!benchmark(dataset, "file", 50) ||
+      !benchmark(largeDataset, "large dataset", 10))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
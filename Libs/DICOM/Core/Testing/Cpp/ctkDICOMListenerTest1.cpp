@@ -0,0 +1,150 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStringList>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMListener.h"
+#include "ctkDICOMTester.h"
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+void ctkDICOMListenerTest1PrintUsage()
+{
+  std::cout << " ctkDICOMListenerTest1 images" << std::endl;
+}
+
+// Push images with storescu over loopback and check they are indexed
+int ctkDICOMListenerTest1( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  QStringList arguments = app.arguments();
+  arguments.pop_front(); // remove application name
+  arguments.pop_front(); // remove test name
+  if (!arguments.count())
+    {
+    ctkDICOMListenerTest1PrintUsage();
+    return EXIT_FAILURE;
+    }
+
+  QDir databaseDirectory = QDir::temp();
+  databaseDirectory.mkdir("ctkDICOMListenerTest1");
+  databaseDirectory.cd("ctkDICOMListenerTest1");
+  databaseDirectory.remove("ctkDICOM.sql");
+  databaseDirectory.remove("ctkDICOMTagCache.sql");
+
+  QSharedPointer<ctkDICOMDatabase> database(new ctkDICOMDatabase);
+  database->openDatabase(databaseDirectory.absoluteFilePath("ctkDICOM.sql"));
+  if (!database->isOpen())
+    {
+    std::cerr << "ctkDICOMDatabase::openDatabase() failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMListener listener;
+  listener.setAETitle("CTK_STORE");
+  listener.setPort(11114);
+  listener.setDatabase(database);
+  // Force several transactions
+  listener.setBatchSize(1);
+
+  if (!listener.start() || !listener.isListening())
+    {
+    std::cerr << "ctkDICOMListener::start() failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (listener.start())
+    {
+    std::cerr << "ctkDICOMListener::start() succeeded "
+              << "while the listener was already running." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The port is already in use: a second listener must not pretend to listen
+  ctkDICOMListener busyListener;
+  busyListener.setPort(listener.port());
+  busyListener.setDatabase(database);
+  if (busyListener.start() || busyListener.isListening())
+    {
+    std::cerr << "ctkDICOMListener::start() succeeded "
+              << "while the port was in use." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDICOMTester tester;
+  QProcess storeSCU;
+  QStringList storescuArgs;
+  storescuArgs << "-aec" << "CTK_STORE";
+  storescuArgs << "-aet" << "CTK_AE";
+  storescuArgs << "localhost" << QString::number(listener.port());
+  storescuArgs << arguments;
+  storeSCU.start(tester.storeSCUExecutable(), storescuArgs);
+  if (!storeSCU.waitForFinished(-1) || storeSCU.exitCode() != 0)
+    {
+    std::cerr << "storescu failed: "
+              << storeSCU.readAllStandardError().constData() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // stop() waits until all received files are indexed
+  listener.stop();
+  if (listener.isListening())
+    {
+    std::cerr << "ctkDICOMListener::stop() failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (listener.receivedInstanceCount() != arguments.count())
+    {
+    std::cerr << "ctkDICOMListener received " << listener.receivedInstanceCount()
+              << " instances instead of " << arguments.count() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  QStringList files = database->allFiles();
+  if (files.count() != arguments.count())
+    {
+    std::cerr << "Database contains " << files.count()
+              << " files instead of " << arguments.count() << std::endl;
+    return EXIT_FAILURE;
+    }
+  QString storageDirectory = database->databaseDirectory() + "/dicom/";
+  foreach(const QString& file, files)
+    {
+    if (!file.startsWith(storageDirectory) || !QFileInfo(file).exists())
+      {
+      std::cerr << "Received file " << qPrintable(file)
+                << " is not in the database storage directory." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  database->closeDatabase();
+  return EXIT_SUCCESS;
+}
@@ -26,6 +26,7 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QFutureInterface>
 #include <QSet>
 #include <QSqlError>
 #include <QSqlQuery>
@@ -33,6 +34,7 @@
 #include <QStringList>
 #include <QUuid>
 #include <QVariant>
+#include <QtConcurrentMap>
 
 // ctkDICOM includes
 #include "ctkDICOMDatabase.h"
@@ -81,6 +83,10 @@ public:
   void init(QString databaseFile);
   void registerCompressionLibraries();
   bool executeScript(const QString script);
+  /// Apply the dicom-schema-migrate-<version>.sql resource scripts until
+  /// the schema is up to date. Returns false (and leaves the database
+  /// unchanged by the failing script) if a script is missing or fails.
+  bool migrateSchema();
   ///
   /// \brief runs a query and prints debug output of status
   ///
@@ -92,8 +98,18 @@ public:
   ///
   /// \brief group several inserts into a single transaction
   ///
-  void beginTransaction();
-  void endTransaction();
+  /// Calls can be nested: only the outermost pair begins and ends the
+  /// transaction. If any level is rolled back, the whole transaction is
+  /// rolled back when the outermost level ends.
+  /// beginTransaction() returns false if the transaction could not be
+  /// started, endTransaction() must not be called then. endTransaction()
+  /// and rollbackTransaction() return false if the transaction was not
+  /// committed.
+  bool beginTransaction();
+  bool endTransaction();
+  bool rollbackTransaction();
+  int TransactionDepth;
+  bool TransactionRolledBack;
 
   // dataset must be set always
   // filePath has to be set if this is an import of an actual file
@@ -145,11 +161,38 @@ public:
   bool openTagCacheDatabase();
   void precacheTags( const QString sopInstanceUID );
 
+  enum RemoveLevel { RemoveSeries, RemoveStudies, RemovePatients };
+  /// Remove the series, studies or patients identified by \a uids and
+  /// the parents they leave empty, in a single transaction.
+  /// \a filesToRemove is filled with (database file path, internal path)
+  /// pairs of the removed images.
+  bool removeRecords(RemoveLevel level, const QStringList& uids,
+                     QList< QPair<QString,QString> >& filesToRemove);
+  /// Delete image files and thumbnails on the global thread pool
+  QFuture<bool> removeFiles(const QList< QPair<QString,QString> >& filesToRemove);
+  QFuture<bool> remove(RemoveLevel level, const QStringList& uids);
+
   int insertPatient(const ctkDICOMItem& ctkDataset);
   void insertStudy(const ctkDICOMItem& ctkDataset, int dbPatientID);
   void insertSeries( const ctkDICOMItem& ctkDataset, QString studyInstanceUID);
 };
 
+//------------------------------------------------------------------------------
+/// Function object deleting the file and thumbnail of a removed image.
+/// It is used with QtConcurrent::mapped, see ctkDICOMDatabasePrivate::removeFiles
+class ctkDICOMDatabaseFileRemover
+{
+public:
+  typedef bool result_type;
+
+  ctkDICOMDatabaseFileRemover(const QString& databaseDirectory, bool verbose);
+  bool operator()(const QPair<QString,QString>& fileToRemove);
+
+private:
+  QString DatabaseDirectory;
+  bool Verbose;
+};
+
 //------------------------------------------------------------------------------
 // ctkDICOMDatabasePrivate methods
 
@@ -159,6 +202,8 @@ ctkDICOMDatabasePrivate::ctkDICOMDatabasePrivate(ctkDICOMDatabase& o): q_ptr(&o)
   this->thumbnailGenerator = NULL;
   this->LoggedExecVerbose = false;
   this->TagCacheVerified = false;
+  this->TransactionDepth = 0;
+  this->TransactionRolledBack = false;
   this->resetLastInsertedValues();
 }
 
@@ -257,19 +302,53 @@ bool ctkDICOMDatabasePrivate::loggedExecBatch(QSqlQuery& query)
 }
 
 //------------------------------------------------------------------------------
-void ctkDICOMDatabasePrivate::beginTransaction()
+bool ctkDICOMDatabasePrivate::beginTransaction()
 {
+  if (this->TransactionDepth++ > 0)
+    {
+    // join the enclosing transaction
+    return true;
+    }
+  this->TransactionRolledBack = false;
   QSqlQuery transaction( this->Database );
   transaction.prepare( "BEGIN TRANSACTION" );
-  transaction.exec();
+  if (!transaction.exec())
+    {
+    logger.error("SQLITE ERROR: could not start transaction: " + transaction.lastError().driverText());
+    this->TransactionDepth = 0;
+    return false;
+    }
+  return true;
 }
 
 //------------------------------------------------------------------------------
-void ctkDICOMDatabasePrivate::endTransaction()
+bool ctkDICOMDatabasePrivate::endTransaction()
 {
+  if (this->TransactionDepth == 0)
+    {
+    logger.warn("endTransaction() called without a transaction");
+    return false;
+    }
+  if (--this->TransactionDepth > 0)
+    {
+    return !this->TransactionRolledBack;
+    }
   QSqlQuery transaction( this->Database );
-  transaction.prepare( "END TRANSACTION" );
-  transaction.exec();
+  transaction.prepare( this->TransactionRolledBack ? "ROLLBACK TRANSACTION" : "END TRANSACTION" );
+  if (!transaction.exec())
+    {
+    logger.error("SQLITE ERROR: could not end transaction: " + transaction.lastError().driverText());
+    return false;
+    }
+  return !this->TransactionRolledBack;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::rollbackTransaction()
+{
+  this->TransactionRolledBack = true;
+  this->endTransaction();
+  return false;
 }
 
 //------------------------------------------------------------------------------
@@ -423,20 +502,37 @@ bool ctkDICOMDatabasePrivate::executeScript(const QString script) {
 
   QStringList sqlCommandsLines = sqlCommands.split('\n');
 
+  // Trigger bodies contain statements terminated by "; " as well:
+  // join them back with their CREATE TRIGGER statement up to the "END;"
+  for (int i = 0; i < sqlCommandsLines.count() - 1; ++i)
+    {
+    if (!sqlCommandsLines[i].trimmed().startsWith("CREATE TRIGGER", Qt::CaseInsensitive))
+      {
+      continue;
+      }
+    while (i + 1 < sqlCommandsLines.count() - 1 &&
+           !sqlCommandsLines[i].trimmed().endsWith("END;", Qt::CaseInsensitive))
+      {
+      sqlCommandsLines[i] += " " + sqlCommandsLines.takeAt(i + 1);
+      }
+    }
+
   QSqlQuery query(Database);
 
   for (QStringList::iterator it = sqlCommandsLines.begin(); it != sqlCommandsLines.end()-1; ++it)
     {
-      if (! (*it).startsWith("--") )
+      // Statements following a blank line or a comment start with spaces
+      QString statement = (*it).trimmed();
+      if (!statement.isEmpty() && !statement.startsWith("--"))
         {
           if (LoggedExecVerbose)
             {
-            qDebug() << *it << "\n";
+            qDebug() << statement << "\n";
             }
-          query.exec(*it);
+          query.exec(statement);
           if (query.lastError().type())
             {
-              qDebug() << "There was an error during execution of the statement: " << (*it);
+              qDebug() << "There was an error during execution of the statement: " << statement;
               qDebug() << "Error message: " << query.lastError().text();
               return false;
             }
@@ -445,6 +541,45 @@ bool ctkDICOMDatabasePrivate::executeScript(const QString script) {
   return true;
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::migrateSchema()
+{
+  Q_Q(ctkDICOMDatabase);
+  QString loadedVersion = q->schemaVersionLoaded();
+  if (loadedVersion.isEmpty())
+    {
+    return false;
+    }
+  while (loadedVersion != q->schemaVersion())
+    {
+    QString migrationScript =
+      QString(":/dicom/dicom-schema-migrate-%1.sql").arg(loadedVersion);
+    if (!QFile::exists(migrationScript))
+      {
+      return false;
+      }
+    this->Database.transaction();
+    if (!this->executeScript(migrationScript))
+      {
+      logger.warn("Failed to migrate database schema from version " + loadedVersion);
+      this->Database.rollback();
+      return false;
+      }
+    this->Database.commit();
+
+    QString migratedVersion = q->schemaVersionLoaded();
+    if (migratedVersion == loadedVersion)
+      {
+      return false;
+      }
+    logger.info("Migrated database schema from version " + loadedVersion
+                + " to " + migratedVersion);
+    loadedVersion = migratedVersion;
+    }
+  this->resetLastInsertedValues();
+  return true;
+}
+
 //------------------------------------------------------------------------------
 QStringList ctkDICOMDatabasePrivate::filenames(QString table)
 {
@@ -502,8 +637,11 @@ QString ctkDICOMDatabase::schemaVersion()
   // * make sure the 'Images' contains a 'Filename' column
   //   so that the ctkDICOMDatabasePrivate::filenames method
   //   still works.
+  // * if the change can be applied in place, add a
+  //   Resources/dicom-schema-migrate-<previous version>.sql script
+  //   (see ctkDICOMDatabase::updateSchema)
   //
-  return QString("0.5.3");
+  return QString("0.6.0");
 };
 
 //------------------------------------------------------------------------------
@@ -529,6 +667,17 @@ bool ctkDICOMDatabase::updateSchema(const char* schemaFile)
   // reinsert everything
 
   Q_D(ctkDICOMDatabase);
+
+  // Migrate in place when a script is available for the loaded version:
+  // the schema is altered without re-reading any file.
+  if (QString(schemaFile) == ":/dicom/dicom-schema.sql"
+      && d->migrateSchema())
+    {
+    emit schemaUpdateStarted(0);
+    emit schemaUpdated();
+    return true;
+    }
+
   d->createBackupFileList();
 
   d->resetLastInsertedValues();
@@ -1102,6 +1251,36 @@ void ctkDICOMDatabase::insert ( const QString& filePath, bool storeFile, bool ge
     }
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::insertFiles(const QStringList& filePaths, bool generateThumbnail)
+{
+  Q_D(ctkDICOMDatabase);
+  d->beginTransaction();
+  foreach(const QString& filePath, filePaths)
+    {
+    if (this->fileExistsAndUpToDate(filePath))
+      {
+      logger.debug( "File " + filePath + " already added.");
+      continue;
+      }
+
+    // Only the header is indexed: stop parsing before the pixel data
+    // instead of loading it. Thumbnails are generated from the file.
+    DcmFileFormat fileFormat;
+    OFCondition status = fileFormat.loadFileUntilTag(filePath.toLatin1().data(),
+      EXS_Unknown, EGL_noChange, DCM_MaxReadLength, ERM_autoDetect, DCM_PixelData);
+    if (status.bad())
+      {
+      logger.warn(QString("Could not read DICOM file: %1 (%2)").arg(filePath).arg(status.text()));
+      continue;
+      }
+    ctkDICOMItem ctkDataset;
+    ctkDataset.InitializeFromItem(fileFormat.getDataset(), false /* do not take ownership */);
+    d->insert(ctkDataset, filePath, false, generateThumbnail);
+    }
+  d->endTransaction();
+}
+
 //------------------------------------------------------------------------------
 int ctkDICOMDatabasePrivate::insertPatient(const ctkDICOMItem& ctkDataset)
 {
@@ -1627,84 +1806,208 @@ bool ctkDICOMDatabase::isInMemory() const
 }
 
 //------------------------------------------------------------------------------
-bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID)
+ctkDICOMDatabaseFileRemover::ctkDICOMDatabaseFileRemover(const QString& databaseDirectory, bool verbose)
+  : DatabaseDirectory(databaseDirectory)
+  , Verbose(verbose)
 {
-  Q_D(ctkDICOMDatabase);
+}
 
-  // get all images from series
-  QSqlQuery fileExistsQuery ( d->Database );
-  fileExistsQuery.prepare("SELECT Filename, SOPInstanceUID, StudyInstanceUID FROM Images,Series WHERE Series.SeriesInstanceUID = Images.SeriesInstanceUID AND Images.SeriesInstanceUID = :seriesID");
-  fileExistsQuery.bindValue(":seriesID",seriesInstanceUID);
-  bool success = fileExistsQuery.exec();
-  if (!success)
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabaseFileRemover::operator()(const QPair<QString,QString>& fileToRemove)
+{
+  bool result = true;
+  QString dbFilePath = fileToRemove.first;
+  QString thumbnailToRemove = this->DatabaseDirectory + "/thumbs/" + fileToRemove.second + ".png";
+
+  // check that the file is below our internal storage
+  if (dbFilePath.startsWith( this->DatabaseDirectory + "/dicom/"))
     {
-      logger.error("SQLITE ERROR: " + fileExistsQuery.lastError().driverText());
-      return false;
+      if (!dbFilePath.endsWith(fileToRemove.second))
+        {
+          logger.error("Database inconsistency detected during delete!");
+          return false;
+        }
+      if (QFile( dbFilePath ).remove())
+        {
+          if (this->Verbose)
+            {
+            logger.debug("Removed file " + dbFilePath );
+            }
+        }
+      else
+        {
+          logger.warn("Failed to remove file " + dbFilePath );
+          result = false;
+        }
+    }
+  // Remove thumbnail (if exists)
+  QFile thumbnailFile(thumbnailToRemove);
+  if (thumbnailFile.exists())
+    {
+    if (!thumbnailFile.remove())
+      {
+      logger.warn("Failed to remove thumbnail " + thumbnailToRemove);
+      }
     }
+  return result;
+}
 
-  QList< QPair<QString,QString> > removeList;
-  while ( fileExistsQuery.next() )
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::removeRecords(RemoveLevel level, const QStringList& uids,
+                                            QList< QPair<QString,QString> >& filesToRemove)
+{
+  if (!this->beginTransaction())
     {
-      QString dbFilePath = fileExistsQuery.value(fileExistsQuery.record().indexOf("Filename")).toString();
-      QString sopInstanceUID = fileExistsQuery.value(fileExistsQuery.record().indexOf("SOPInstanceUID")).toString();
-      QString studyInstanceUID = fileExistsQuery.value(fileExistsQuery.record().indexOf("StudyInstanceUID")).toString();
-      QString internalFilePath = studyInstanceUID + "/" + seriesInstanceUID + "/" + sopInstanceUID;
-      removeList << qMakePair(dbFilePath,internalFilePath);
+    return false;
     }
 
-  QSqlQuery fileRemove ( d->Database );
-  fileRemove.prepare("DELETE FROM Images WHERE SeriesInstanceUID == :seriesID");
-  fileRemove.bindValue(":seriesID",seriesInstanceUID);
-  logger.debug("SQLITE: removing seriesInstanceUID " + seriesInstanceUID);
-  success = fileRemove.exec();
-  if (!success)
+  QSqlQuery query(this->Database);
+  bool success =
+    loggedExec(query, "CREATE TEMP TABLE IF NOT EXISTS RemovedSeries (UID TEXT PRIMARY KEY)")
+    && loggedExec(query, "CREATE TEMP TABLE IF NOT EXISTS AffectedStudies (UID TEXT PRIMARY KEY)")
+    && loggedExec(query, "CREATE TEMP TABLE IF NOT EXISTS AffectedPatients (UID INTEGER PRIMARY KEY)")
+    && loggedExec(query, "DELETE FROM temp.RemovedSeries")
+    && loggedExec(query, "DELETE FROM temp.AffectedStudies")
+    && loggedExec(query, "DELETE FROM temp.AffectedPatients");
+
+  // Fill the table of the requested level, then derive the others from it
+  const char* startTable = "temp.RemovedSeries";
+  if (level == RemoveStudies)
+    {
+    startTable = "temp.AffectedStudies";
+    }
+  else if (level == RemovePatients)
+    {
+    startTable = "temp.AffectedPatients";
+    }
+  if (success)
     {
-      logger.error("SQLITE ERROR: could not remove seriesInstanceUID " + seriesInstanceUID);
-      logger.error("SQLITE ERROR: " + fileRemove.lastError().driverText());
+    QSqlQuery insertUIDs(this->Database);
+    insertUIDs.prepare(QString("INSERT OR IGNORE INTO %1 VALUES (?)").arg(startTable));
+    insertUIDs.addBindValue(uids);
+    success = loggedExecBatch(insertUIDs);
+    }
+  if (success && level == RemovePatients)
+    {
+    success = loggedExec(query,
+      "INSERT OR IGNORE INTO temp.AffectedStudies SELECT StudyInstanceUID FROM Studies "
+      "WHERE PatientsUID IN (SELECT UID FROM temp.AffectedPatients)");
+    }
+  if (success && level != RemoveSeries)
+    {
+    success = loggedExec(query,
+      "INSERT OR IGNORE INTO temp.RemovedSeries SELECT SeriesInstanceUID FROM Series "
+      "WHERE StudyInstanceUID IN (SELECT UID FROM temp.AffectedStudies)");
+    }
+  if (success && level == RemoveSeries)
+    {
+    success = loggedExec(query,
+      "INSERT OR IGNORE INTO temp.AffectedStudies SELECT DISTINCT StudyInstanceUID FROM Series "
+      "WHERE SeriesInstanceUID IN (SELECT UID FROM temp.RemovedSeries)");
+    }
+  if (success && level != RemovePatients)
+    {
+    success = loggedExec(query,
+      "INSERT OR IGNORE INTO temp.AffectedPatients SELECT DISTINCT PatientsUID FROM Studies "
+      "WHERE StudyInstanceUID IN (SELECT UID FROM temp.AffectedStudies)");
     }
 
-  QPair<QString,QString> fileToRemove;
-  foreach (fileToRemove, removeList)
+  // get all images of the removed series
+  if (success)
     {
-      QString dbFilePath = fileToRemove.first;
-      QString thumbnailToRemove = databaseDirectory() + "/thumbs/" + fileToRemove.second + ".png";
+    success = loggedExec(query,
+      "SELECT Images.Filename, Images.SOPInstanceUID, Series.StudyInstanceUID, Series.SeriesInstanceUID "
+      "FROM Images JOIN Series ON Series.SeriesInstanceUID = Images.SeriesInstanceUID "
+      "WHERE Images.SeriesInstanceUID IN (SELECT UID FROM temp.RemovedSeries)");
+    while (success && query.next())
+      {
+      QString dbFilePath = query.value(0).toString();
+      QString internalFilePath = query.value(2).toString() + "/" + query.value(3).toString()
+        + "/" + query.value(1).toString();
+      filesToRemove << qMakePair(dbFilePath, internalFilePath);
+      }
+    }
 
-      // check that the file is below our internal storage
-      if (dbFilePath.startsWith( databaseDirectory() + "/dicom/"))
-        {
-          if (!dbFilePath.endsWith(fileToRemove.second))
-            {
-              logger.error("Database inconsistency detected during delete!");
-              continue;
-            }
-          if (QFile( dbFilePath ).remove())
-            {
-              if (d->LoggedExecVerbose)
-                {
-                logger.debug("Removed file " + dbFilePath );
-                }
-            }
-          else
-            {
-              logger.warn("Failed to remove file " + dbFilePath );
-            }
-        }
-      // Remove thumbnail (if exists)
-      QFile thumbnailFile(thumbnailToRemove);
-      if (thumbnailFile.exists())
-        {
-        if (!thumbnailFile.remove())
-          {
-          logger.warn("Failed to remove thumbnail " + thumbnailToRemove);
-          }
-        }
+  // remove the records, checking emptiness only for the affected parents
+  success = success
+    && loggedExec(query,
+      "DELETE FROM Images WHERE SeriesInstanceUID IN (SELECT UID FROM temp.RemovedSeries)")
+    && loggedExec(query,
+      "DELETE FROM Series WHERE SeriesInstanceUID IN (SELECT UID FROM temp.RemovedSeries)")
+    && loggedExec(query,
+      "DELETE FROM Studies WHERE StudyInstanceUID IN (SELECT UID FROM temp.AffectedStudies) "
+      "AND NOT EXISTS (SELECT 1 FROM Series WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID)")
+    && loggedExec(query,
+      "DELETE FROM Patients WHERE UID IN (SELECT UID FROM temp.AffectedPatients) "
+      "AND NOT EXISTS (SELECT 1 FROM Studies WHERE Studies.PatientsUID = Patients.UID)");
+  query.finish();
+
+  if (!success)
+    {
+    logger.error("SQLITE ERROR: removing records failed, rolling back");
+    this->rollbackTransaction();
+    filesToRemove.clear();
+    }
+  else if (!this->endTransaction())
+    {
+    filesToRemove.clear();
+    success = false;
     }
 
-  this->cleanup();
+  this->resetLastInsertedValues();
+  return success;
+}
 
-  d->resetLastInsertedValues();
+//------------------------------------------------------------------------------
+QFuture<bool> ctkDICOMDatabasePrivate::removeFiles(const QList< QPair<QString,QString> >& filesToRemove)
+{
+  Q_Q(ctkDICOMDatabase);
+  return QtConcurrent::mapped(filesToRemove,
+    ctkDICOMDatabaseFileRemover(q->databaseDirectory(), this->LoggedExecVerbose));
+}
 
-  return true;
+//------------------------------------------------------------------------------
+QFuture<bool> ctkDICOMDatabasePrivate::remove(RemoveLevel level, const QStringList& uids)
+{
+  QList< QPair<QString,QString> > filesToRemove;
+  if (!this->removeRecords(level, uids, filesToRemove))
+    {
+    QFutureInterface<bool> failed;
+    failed.reportStarted();
+    failed.reportCanceled();
+    failed.reportFinished();
+    return failed.future();
+    }
+  return this->removeFiles(filesToRemove);
+}
+
+//------------------------------------------------------------------------------
+QFuture<bool> ctkDICOMDatabase::removeSeriesList(const QStringList& seriesInstanceUIDs)
+{
+  Q_D(ctkDICOMDatabase);
+  return d->remove(ctkDICOMDatabasePrivate::RemoveSeries, seriesInstanceUIDs);
+}
+
+//------------------------------------------------------------------------------
+QFuture<bool> ctkDICOMDatabase::removeStudyList(const QStringList& studyInstanceUIDs)
+{
+  Q_D(ctkDICOMDatabase);
+  return d->remove(ctkDICOMDatabasePrivate::RemoveStudies, studyInstanceUIDs);
+}
+
+//------------------------------------------------------------------------------
+QFuture<bool> ctkDICOMDatabase::removePatientList(const QStringList& patientUIDs)
+{
+  Q_D(ctkDICOMDatabase);
+  return d->remove(ctkDICOMDatabasePrivate::RemovePatients, patientUIDs);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID)
+{
+  QFuture<bool> removal = this->removeSeriesList(QStringList(seriesInstanceUID));
+  removal.waitForFinished();
+  return !removal.isCanceled();
 }
 
 //------------------------------------------------------------------------------
@@ -1712,64 +2015,26 @@ bool ctkDICOMDatabase::cleanup()
 {
   Q_D(ctkDICOMDatabase);
   QSqlQuery seriesCleanup ( d->Database );
-  seriesCleanup.exec("DELETE FROM Series WHERE ( SELECT COUNT(*) FROM Images WHERE Images.SeriesInstanceUID = Series.SeriesInstanceUID ) = 0;");
-  seriesCleanup.exec("DELETE FROM Studies WHERE ( SELECT COUNT(*) FROM Series WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID ) = 0;");
-  seriesCleanup.exec("DELETE FROM Patients WHERE ( SELECT COUNT(*) FROM Studies WHERE Studies.PatientsUID = Patients.UID ) = 0;");
+  seriesCleanup.exec("DELETE FROM Series WHERE NOT EXISTS ( SELECT 1 FROM Images WHERE Images.SeriesInstanceUID = Series.SeriesInstanceUID );");
+  seriesCleanup.exec("DELETE FROM Studies WHERE NOT EXISTS ( SELECT 1 FROM Series WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID );");
+  seriesCleanup.exec("DELETE FROM Patients WHERE NOT EXISTS ( SELECT 1 FROM Studies WHERE Studies.PatientsUID = Patients.UID );");
   return true;
 }
 
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::removeStudy(const QString& studyInstanceUID)
 {
-  Q_D(ctkDICOMDatabase);
-
-  QSqlQuery seriesForStudy( d->Database );
-  seriesForStudy.prepare("SELECT SeriesInstanceUID FROM Series WHERE StudyInstanceUID = :studyID");
-  seriesForStudy.bindValue(":studyID", studyInstanceUID);
-  bool success = seriesForStudy.exec();
-  if (!success)
-    {
-      logger.error("SQLITE ERROR: " + seriesForStudy.lastError().driverText());
-      return false;
-    }
-  bool result = true;
-  while ( seriesForStudy.next() )
-    {
-      QString seriesInstanceUID = seriesForStudy.value(seriesForStudy.record().indexOf("SeriesInstanceUID")).toString();
-      if ( ! this->removeSeries(seriesInstanceUID) )
-        {
-          result = false;
-        }
-    }
-  d->resetLastInsertedValues();
-  return result;
+  QFuture<bool> removal = this->removeStudyList(QStringList(studyInstanceUID));
+  removal.waitForFinished();
+  return !removal.isCanceled();
 }
 
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::removePatient(const QString& patientID)
 {
-  Q_D(ctkDICOMDatabase);
-
-  QSqlQuery studiesForPatient( d->Database );
-  studiesForPatient.prepare("SELECT StudyInstanceUID FROM Studies WHERE PatientsUID = :patientsID");
-  studiesForPatient.bindValue(":patientsID", patientID);
-  bool success = studiesForPatient.exec();
-  if (!success)
-    {
-      logger.error("SQLITE ERROR: " + studiesForPatient.lastError().driverText());
-      return false;
-    }
-  bool result = true;
-  while ( studiesForPatient.next() )
-    {
-      QString studyInstanceUID = studiesForPatient.value(studiesForPatient.record().indexOf("StudyInstanceUID")).toString();
-      if ( ! this->removeStudy(studyInstanceUID) )
-        {
-          result = false;
-        }
-    }
-  d->resetLastInsertedValues();
-  return result;
+  QFuture<bool> removal = this->removePatientList(QStringList(patientID));
+  removal.waitForFinished();
+  return !removal.isCanceled();
 }
 
 ///
@@ -22,6 +22,7 @@
 #define __ctkDICOMDatabase_h
 
 // Qt includes
+#include <QFuture>
 #include <QObject>
 #include <QStringList>
 #include <QSqlDatabase>
@@ -199,6 +200,12 @@ public:
                             bool createHierarchy = true,
                             const QString& destinationDirectoryName = QString() );
 
+  /// Insert a batch of files that already reside in their final location
+  /// (e.g. in the internal storage directory, as written by ctkDICOMListener)
+  /// using a single transaction. The files are not copied and only their
+  /// header is read, parsing stops before the pixel data.
+  Q_INVOKABLE void insertFiles(const QStringList& filePaths, bool generateThumbnail = false);
+
   /// Reset cached item IDs to make sure previous
   /// inserts do not interfere with upcoming insert operations.
   /// Typically, it should be call just before a batch of files
@@ -221,6 +228,19 @@ public:
   Q_INVOKABLE bool removePatient(const QString& patientID);
   Q_INVOKABLE bool cleanup();
 
+  /// Remove a set of series (resp. studies, patients) from the database.
+  /// The records are removed with set-based statements in a single
+  /// transaction; only the studies and patients referenced by the removed
+  /// items are checked for being left empty.
+  /// Image files stored in the database directory and thumbnails are
+  /// deleted asynchronously on the global thread pool. The returned future
+  /// holds one result per image (true if its file was removed or did not
+  /// need to be) and is finished once all files have been processed.
+  /// If the database could not be updated, a canceled future is returned.
+  QFuture<bool> removeSeriesList(const QStringList& seriesInstanceUIDs);
+  QFuture<bool> removeStudyList(const QStringList& studyInstanceUIDs);
+  QFuture<bool> removePatientList(const QStringList& patientUIDs);
+
   ///
   /// \brief access element values for given instance
   /// @param sopInstanceUID A string with the uid for a given instance
@@ -0,0 +1,694 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMExporter.h"
+#include "ctkLogger.h"
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcddirif.h>   /* for class DicomDirInterface */
+
+static ctkLogger logger("org.commontk.dicom.DICOMExporter");
+
+// Delay before the first retry of a copy, doubled for each further retry
+static const unsigned long RetryDelay = 50;
+static const unsigned long MaximumRetryDelay = 1000;
+
+//------------------------------------------------------------------------------
+// QThread::msleep() is protected in Qt 4
+class ctkDICOMExporterSleep : public QThread
+{
+public:
+  static void msleep(unsigned long msecs)
+  {
+    QThread::msleep(msecs);
+  }
+};
+
+//------------------------------------------------------------------------------
+struct ctkDICOMExporterFile
+{
+  QString Source;
+  /// Relative to the export directory
+  QString Destination;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMExporterPrivate
+{
+  Q_DECLARE_PUBLIC(ctkDICOMExporter);
+protected:
+  ctkDICOMExporter* const q_ptr;
+
+  friend class ctkDICOMExporterCopyTask;
+  friend class ctkDICOMExporterDICOMDIRTask;
+
+public:
+  ctkDICOMExporterPrivate(ctkDICOMExporter& obj);
+  ~ctkDICOMExporterPrivate();
+
+  /// Compute the destination of the files of the series, in the layout
+  /// of the original browser export.
+  void addSeriesFiles(const QString& seriesUID);
+  /// Same, in the ISO 9660 compliant media layout.
+  void addMediaSeriesFiles(const QString& seriesUID);
+  void addFiles(const QStringList& sourceFiles, const QString& destinationDirectory,
+                const QString& fileNameFormat, int fileNumberWidth);
+  void finish();
+
+  QSharedPointer<ctkDICOMDatabase> Database;
+  QThreadPool ThreadPool;
+  int MaximumRetries;
+  bool VerifyChecksums;
+  bool CreateDICOMDIR;
+
+  bool Running;
+  QAtomicInt Canceled;
+  QString Directory;
+  QList<ctkDICOMExporterFile> Files;
+  QList<bool> Exported;
+  int NumberOfFiles;
+  int ProcessedFileCount;
+  int ExportedFileCount;
+  QStringList FailedFiles;
+  QStringList Errors;
+
+  /// Media layout numbering
+  QHash<QString, QString> PatientDirectories;
+  QHash<QString, QString> StudyDirectories;
+  QHash<QString, int> SeriesCounts;
+};
+
+//------------------------------------------------------------------------------
+/// Copy one file, with retries. The result is sent back to the exporter
+/// through a queued call.
+class ctkDICOMExporterCopyTask : public QRunnable
+{
+public:
+  ctkDICOMExporterCopyTask(ctkDICOMExporterPrivate* exporter, int fileIndex)
+    : Exporter(exporter), FileIndex(fileIndex)
+  {
+    this->Source = exporter->Files[fileIndex].Source;
+    this->Destination = exporter->Directory + "/" + exporter->Files[fileIndex].Destination;
+    this->MaximumRetries = exporter->MaximumRetries;
+    this->VerifyChecksums = exporter->VerifyChecksums;
+  }
+  virtual void run();
+
+protected:
+  bool copy(QString& error);
+  static QByteArray checksum(const QString& fileName);
+
+  ctkDICOMExporterPrivate* Exporter;
+  int FileIndex;
+  QString Source;
+  QString Destination;
+  int MaximumRetries;
+  bool VerifyChecksums;
+};
+
+//------------------------------------------------------------------------------
+/// Write the DICOMDIR of the exported files once they are all copied.
+class ctkDICOMExporterDICOMDIRTask : public QRunnable
+{
+public:
+  ctkDICOMExporterDICOMDIRTask(ctkDICOMExporterPrivate* exporter)
+    : Exporter(exporter)
+  {
+    this->Directory = exporter->Directory;
+    for (int i = 0; i < exporter->Files.count(); ++i)
+      {
+      if (exporter->Exported[i])
+        {
+        this->Files << exporter->Files[i].Destination;
+        }
+      }
+  }
+  virtual void run();
+
+protected:
+  ctkDICOMExporterPrivate* Exporter;
+  QString Directory;
+  QStringList Files;
+};
+
+//------------------------------------------------------------------------------
+// ctkDICOMExporterCopyTask methods
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporterCopyTask::run()
+{
+  QString error;
+  bool success = false;
+  if (this->Exporter->Canceled.fetchAndAddOrdered(0))
+    {
+    error = "Export canceled";
+    }
+  else if (!QFile::exists(this->Source))
+    {
+    error = "Export source file not found. Error may be fixed via Repair.";
+    }
+  else if (QFile::exists(this->Destination))
+    {
+    error = "Export destination file already exists.";
+    }
+  else
+    {
+    unsigned long delay = RetryDelay;
+    for (int attempt = 0; !success && attempt <= this->MaximumRetries; ++attempt)
+      {
+      if (attempt > 0)
+        {
+        // Give a transient cause (locked or busy file, network share) time
+        // to go away instead of retrying right away
+        logger.warn(QString("Retrying export of %1 in %2 ms: %3").arg(this->Source).arg(delay).arg(error));
+        ctkDICOMExporterSleep::msleep(delay);
+        delay = qMin(2 * delay, MaximumRetryDelay);
+        if (this->Exporter->Canceled.fetchAndAddOrdered(0))
+          {
+          error = "Export canceled";
+          break;
+          }
+        }
+      success = this->copy(error);
+      }
+    }
+  QMetaObject::invokeMethod(this->Exporter->q_func(), "onFileProcessed", Qt::QueuedConnection,
+                            Q_ARG(int, this->FileIndex),
+                            Q_ARG(bool, success),
+                            Q_ARG(QString, success ? QString() : error));
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMExporterCopyTask::copy(QString& error)
+{
+  // Remove what a previous attempt may have left
+  if (QFile::exists(this->Destination))
+    {
+    QFile::remove(this->Destination);
+    }
+  if (!QFile::copy(this->Source, this->Destination))
+    {
+    error = "Failed to copy the file.";
+    return false;
+    }
+  if (this->VerifyChecksums)
+    {
+    QByteArray sourceChecksum = checksum(this->Source);
+    if (sourceChecksum.isEmpty() || sourceChecksum != checksum(this->Destination))
+      {
+      QFile::remove(this->Destination);
+      error = "Checksum of the copy does not match the source file.";
+      return false;
+      }
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+QByteArray ctkDICOMExporterCopyTask::checksum(const QString& fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly))
+    {
+    return QByteArray();
+    }
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  while (!file.atEnd())
+    {
+    QByteArray block = file.read(1024 * 1024);
+    if (block.isEmpty())
+      {
+      return QByteArray();
+      }
+    hash.addData(block);
+    }
+  return hash.result();
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMExporterDICOMDIRTask methods
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporterDICOMDIRTask::run()
+{
+  QString error;
+  QString dicomDirPath = this->Directory + "/DICOMDIR";
+
+  DicomDirInterface dicomDir;
+  // Database files are kept in their original transfer syntax
+  dicomDir.disableTransferSyntaxCheck();
+  OFCondition status = dicomDir.createNewDicomDir(
+    DicomDirInterface::AP_GeneralPurpose, dicomDirPath.toLatin1().data(), "CTK_EXPORT");
+  if (status.good())
+    {
+    int rejectedFiles = 0;
+    foreach (const QString& file, this->Files)
+      {
+      if (this->Exporter->Canceled.fetchAndAddOrdered(0))
+        {
+        status = EC_IllegalCall;
+        error = "Export canceled";
+        break;
+        }
+      OFCondition fileStatus = dicomDir.addDicomFile(
+        file.toLatin1().data(), this->Directory.toLatin1().data());
+      if (fileStatus.bad())
+        {
+        logger.warn(QString("Could not add %1 to the DICOMDIR: %2")
+                    .arg(file).arg(fileStatus.text()));
+        ++rejectedFiles;
+        }
+      }
+    if (status.good())
+      {
+      status = dicomDir.writeDicomDir();
+      }
+    if (status.good() && rejectedFiles > 0)
+      {
+      error = QString("%1 files could not be referenced in the DICOMDIR").arg(rejectedFiles);
+      }
+    }
+  if (status.bad() && error.isEmpty())
+    {
+    error = QString("Could not write %1: %2").arg(dicomDirPath).arg(status.text());
+    }
+  QMetaObject::invokeMethod(this->Exporter->q_func(), "onDICOMDIRWritten", Qt::QueuedConnection,
+                            Q_ARG(bool, status.good()),
+                            Q_ARG(QString, error));
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMExporterPrivate methods
+
+//------------------------------------------------------------------------------
+ctkDICOMExporterPrivate::ctkDICOMExporterPrivate(ctkDICOMExporter& obj)
+  : q_ptr(&obj)
+{
+  this->ThreadPool.setMaxThreadCount(4);
+  this->MaximumRetries = 2;
+  this->VerifyChecksums = false;
+  this->CreateDICOMDIR = false;
+  this->Running = false;
+  this->NumberOfFiles = 0;
+  this->ProcessedFileCount = 0;
+  this->ExportedFileCount = 0;
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMExporterPrivate::~ctkDICOMExporterPrivate()
+{
+  this->Canceled.fetchAndStoreOrdered(1);
+  this->ThreadPool.waitForDone();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporterPrivate::addSeriesFiles(const QString& seriesUID)
+{
+  QStringList filesForSeries = this->Database->filesForSeries(seriesUID);
+  if (filesForSeries.isEmpty())
+    {
+    return;
+    }
+
+  // Use the first file to get the overall series information
+  QString firstFilePath = filesForSeries[0];
+  QHash<QString,QString> descriptions (this->Database->descriptionsForFile(firstFilePath));
+  QString patientName = descriptions["PatientsName"];
+  QString patientID = this->Database->fileValue(firstFilePath, "0010,0020");
+  QString studyDescription = descriptions["StudyDescription"];
+  QString seriesDescription = descriptions["SeriesDescription"];
+  QString studyDate = this->Database->fileValue(firstFilePath, "0008,0020");
+  QString seriesNumber = this->Database->fileValue(firstFilePath, "0020,0011");
+
+  QString sep = "/";
+  QString nameSep = "-";
+  QString destinationDir = patientID;
+  if (!patientName.isEmpty())
+    {
+    destinationDir += nameSep + patientName;
+    }
+  destinationDir += sep + studyDate;
+  if (!studyDescription.isEmpty())
+    {
+    destinationDir += nameSep + studyDescription;
+    }
+  destinationDir += sep + seriesNumber;
+  if (!seriesDescription.isEmpty())
+    {
+    destinationDir += nameSep + seriesDescription;
+    }
+
+  // make sure only ascii characters are in the directory path
+  destinationDir = destinationDir.toLatin1();
+  // replace any question marks that were used as replacements for non ascii
+  // characters with underscore
+  destinationDir.replace("?", "_");
+
+  this->addFiles(filesForSeries, destinationDir, "%1.dcm", 6);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporterPrivate::addMediaSeriesFiles(const QString& seriesUID)
+{
+  QString studyUID = this->Database->studyForSeries(seriesUID);
+  QString patientUID = this->Database->patientForStudy(studyUID);
+
+  // Directory names are limited to 8 characters in ISO 9660
+  QString patientDirectory = this->PatientDirectories.value(patientUID);
+  if (patientDirectory.isEmpty())
+    {
+    patientDirectory = QString("DICOM/PAT%1").arg(this->PatientDirectories.count(), 5, 10, QChar('0'));
+    this->PatientDirectories[patientUID] = patientDirectory;
+    }
+  QString studyDirectory = this->StudyDirectories.value(studyUID);
+  if (studyDirectory.isEmpty())
+    {
+    int studyCount = this->SeriesCounts.value(patientDirectory);
+    this->SeriesCounts[patientDirectory] = studyCount + 1;
+    studyDirectory = patientDirectory + QString("/STU%1").arg(studyCount, 5, 10, QChar('0'));
+    this->StudyDirectories[studyUID] = studyDirectory;
+    }
+  int seriesCount = this->SeriesCounts.value(studyDirectory);
+  this->SeriesCounts[studyDirectory] = seriesCount + 1;
+  QString seriesDirectory = studyDirectory + QString("/SER%1").arg(seriesCount, 5, 10, QChar('0'));
+
+  this->addFiles(this->Database->filesForSeries(seriesUID), seriesDirectory, "IMG%1", 5);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporterPrivate::addFiles(const QStringList& sourceFiles,
+                                       const QString& destinationDirectory,
+                                       const QString& fileNameFormat,
+                                       int fileNumberWidth)
+{
+  Q_Q(ctkDICOMExporter);
+  QString absoluteDirectory = this->Directory + "/" + destinationDirectory;
+  bool directoryCreated = QDir().exists(absoluteDirectory) || QDir().mkpath(absoluteDirectory);
+
+  int fileNumber = 0;
+  foreach (const QString& sourceFile, sourceFiles)
+    {
+    ctkDICOMExporterFile file;
+    file.Source = sourceFile;
+    // sequentially number the files
+    file.Destination = destinationDirectory + "/" +
+      fileNameFormat.arg(fileNumber++, fileNumberWidth, 10, QChar('0'));
+    if (!directoryCreated)
+      {
+      // Skip the series: no need to retry each file
+      ++this->ProcessedFileCount;
+      this->FailedFiles << file.Source;
+      this->Errors << "Unable to create export destination directory.";
+      emit q->fileFailed(file.Source, absoluteDirectory, this->Errors.last());
+      continue;
+      }
+    this->Files << file;
+    }
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporterPrivate::finish()
+{
+  Q_Q(ctkDICOMExporter);
+  this->Running = false;
+  this->Files.clear();
+  this->Exported.clear();
+  emit q->progress(QString("Export finished"));
+  emit q->finished(this->ExportedFileCount,
+                   this->NumberOfFiles - this->ExportedFileCount);
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMExporter methods
+
+//------------------------------------------------------------------------------
+ctkDICOMExporter::ctkDICOMExporter(QObject* parent)
+  : QObject(parent)
+  , d_ptr(new ctkDICOMExporterPrivate(*this))
+{
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMExporter::~ctkDICOMExporter()
+{
+}
+
+//------------------------------------------------------------------------------
+static void skipDelete(QObject* obj)
+{
+  Q_UNUSED(obj);
+  // this deleter does not delete the object from memory
+  // useful if the pointer is not owned by the smart pointer
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporter::setDatabase(ctkDICOMDatabase& dicomDatabase)
+{
+  Q_D(ctkDICOMExporter);
+  d->Database = QSharedPointer<ctkDICOMDatabase>(&dicomDatabase, skipDelete);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporter::setDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabase)
+{
+  Q_D(ctkDICOMExporter);
+  d->Database = dicomDatabase;
+}
+
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMDatabase> ctkDICOMExporter::database()const
+{
+  Q_D(const ctkDICOMExporter);
+  return d->Database;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporter::setMaximumThreadCount(int count)
+{
+  Q_D(ctkDICOMExporter);
+  d->ThreadPool.setMaxThreadCount(qMax(1, count));
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMExporter::maximumThreadCount()const
+{
+  Q_D(const ctkDICOMExporter);
+  return d->ThreadPool.maxThreadCount();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporter::setMaximumRetries(int retries)
+{
+  Q_D(ctkDICOMExporter);
+  d->MaximumRetries = qMax(0, retries);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMExporter::maximumRetries()const
+{
+  Q_D(const ctkDICOMExporter);
+  return d->MaximumRetries;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporter::setVerifyChecksums(bool verify)
+{
+  Q_D(ctkDICOMExporter);
+  d->VerifyChecksums = verify;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMExporter::verifyChecksums()const
+{
+  Q_D(const ctkDICOMExporter);
+  return d->VerifyChecksums;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporter::setCreateDICOMDIR(bool create)
+{
+  Q_D(ctkDICOMExporter);
+  d->CreateDICOMDIR = create;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMExporter::createDICOMDIR()const
+{
+  Q_D(const ctkDICOMExporter);
+  return d->CreateDICOMDIR;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMExporter::isRunning()const
+{
+  Q_D(const ctkDICOMExporter);
+  return d->Running;
+}
+
+//------------------------------------------------------------------------------
+QStringList ctkDICOMExporter::failedFiles()const
+{
+  Q_D(const ctkDICOMExporter);
+  return d->FailedFiles;
+}
+
+//------------------------------------------------------------------------------
+QStringList ctkDICOMExporter::errors()const
+{
+  Q_D(const ctkDICOMExporter);
+  return d->Errors;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMExporter::exportSeries(const QString& directory, const QStringList& seriesInstanceUIDs)
+{
+  Q_D(ctkDICOMExporter);
+  if (d->Running || !d->Database)
+    {
+    return false;
+    }
+  d->Running = true;
+  d->Canceled.fetchAndStoreOrdered(0);
+  d->Directory = QDir(directory).absolutePath();
+  d->Files.clear();
+  d->ProcessedFileCount = 0;
+  d->ExportedFileCount = 0;
+  d->FailedFiles.clear();
+  d->Errors.clear();
+  d->PatientDirectories.clear();
+  d->StudyDirectories.clear();
+  d->SeriesCounts.clear();
+
+  // The database is only queried from this thread
+  emit progress(QString("Listing files to export"));
+  foreach (const QString& seriesUID, seriesInstanceUIDs)
+    {
+    if (d->CreateDICOMDIR)
+      {
+      d->addMediaSeriesFiles(seriesUID);
+      }
+    else
+      {
+      d->addSeriesFiles(seriesUID);
+      }
+    }
+  d->NumberOfFiles = d->ProcessedFileCount + d->Files.count();
+  emit started(d->NumberOfFiles);
+  emit progress(QString("Exporting %1 files").arg(d->NumberOfFiles));
+
+  if (d->Files.isEmpty())
+    {
+    d->finish();
+    return true;
+    }
+  for (int i = 0; i < d->Files.count(); ++i)
+    {
+    d->Exported << false;
+    }
+  for (int i = 0; i < d->Files.count(); ++i)
+    {
+    d->ThreadPool.start(new ctkDICOMExporterCopyTask(d, i));
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporter::cancel()
+{
+  Q_D(ctkDICOMExporter);
+  d->Canceled.fetchAndStoreOrdered(1);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporter::waitForFinished()
+{
+  Q_D(ctkDICOMExporter);
+  if (!d->Running)
+    {
+    return;
+    }
+  QEventLoop eventLoop;
+  connect(this, SIGNAL(finished(int,int)), &eventLoop, SLOT(quit()));
+  eventLoop.exec();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporter::onFileProcessed(int fileIndex, bool success, const QString& error)
+{
+  Q_D(ctkDICOMExporter);
+  const ctkDICOMExporterFile& file = d->Files[fileIndex];
+  ++d->ProcessedFileCount;
+  d->Exported[fileIndex] = success;
+  if (success)
+    {
+    ++d->ExportedFileCount;
+    }
+  else
+    {
+    d->FailedFiles << file.Source;
+    d->Errors << error;
+    logger.error(QString("Export of %1 failed: %2").arg(file.Source).arg(error));
+    emit fileFailed(file.Source, d->Directory + "/" + file.Destination, error);
+    }
+  emit progress(d->ProcessedFileCount, d->NumberOfFiles);
+
+  if (d->ProcessedFileCount < d->NumberOfFiles)
+    {
+    return;
+    }
+  if (d->CreateDICOMDIR && d->ExportedFileCount > 0 && !d->Canceled.fetchAndAddOrdered(0))
+    {
+    emit progress(QString("Writing DICOMDIR"));
+    d->ThreadPool.start(new ctkDICOMExporterDICOMDIRTask(d));
+    return;
+    }
+  d->finish();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMExporter::onDICOMDIRWritten(bool success, const QString& error)
+{
+  Q_D(ctkDICOMExporter);
+  if (!success || !error.isEmpty())
+    {
+    // The DICOMDIR is reported as a failed (generated) file
+    QString dicomDirPath = d->Directory + "/DICOMDIR";
+    logger.error(error);
+    d->FailedFiles << dicomDirPath;
+    d->Errors << error;
+    emit fileFailed(QString(), dicomDirPath, error);
+    }
+  d->finish();
+}
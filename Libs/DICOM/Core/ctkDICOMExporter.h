@@ -0,0 +1,129 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMExporter_h
+#define __ctkDICOMExporter_h
+
+// Qt includes
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+
+#include "ctkDICOMCoreExport.h"
+
+class ctkDICOMDatabase;
+class ctkDICOMExporterPrivate;
+
+/// \ingroup DICOM_Core
+///
+/// \brief Copy the files of series of a database to a directory.
+///
+/// The destination layout is computed from the database when an export is
+/// started; the files are then copied on a dedicated thread pool of
+/// maximumThreadCount threads, so exportSeries() returns immediately.
+/// A file that cannot be copied is retried up to maximumRetries times, after
+/// a delay doubling from 50 ms up to 1 s, then
+/// skipped and reported with fileFailed(): the other files are exported
+/// anyway. If verifyChecksums is set, each copy is read back and compared
+/// (MD5) with its source.
+///
+/// For media export, createDICOMDIR lays the files out with ISO 9660
+/// compliant names (DICOM/PATnnnnn/STUnnnnn/SERnnnnn/IMGnnnnn) and writes a
+/// DICOMDIR index (DCMTK DicomDirInterface, general purpose profile) at the
+/// root of the destination directory once all files are copied.
+///
+/// All the signals are emitted in the thread the exporter lives in.
+class CTK_DICOM_CORE_EXPORT ctkDICOMExporter : public QObject
+{
+  Q_OBJECT
+  Q_PROPERTY(int maximumThreadCount READ maximumThreadCount WRITE setMaximumThreadCount);
+  Q_PROPERTY(int maximumRetries READ maximumRetries WRITE setMaximumRetries);
+  Q_PROPERTY(bool verifyChecksums READ verifyChecksums WRITE setVerifyChecksums);
+  Q_PROPERTY(bool createDICOMDIR READ createDICOMDIR WRITE setCreateDICOMDIR);
+  Q_PROPERTY(bool isRunning READ isRunning);
+
+public:
+  explicit ctkDICOMExporter(QObject* parent = 0);
+  virtual ~ctkDICOMExporter();
+
+  /// Database the exported series are looked up in.
+  Q_INVOKABLE void setDatabase(ctkDICOMDatabase& dicomDatabase);
+  void setDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabase);
+  Q_INVOKABLE QSharedPointer<ctkDICOMDatabase> database()const;
+
+  /// Number of files copied concurrently. Copying to slow media (USB keys,
+  /// network shares) does not benefit from many threads. 4 by default
+  void setMaximumThreadCount(int count);
+  int maximumThreadCount()const;
+
+  /// Number of times a failed copy (or checksum mismatch) is retried
+  /// before the file is skipped. 2 by default
+  void setMaximumRetries(int retries);
+  int maximumRetries()const;
+
+  /// Read back each copy and compare its checksum with the source.
+  /// false by default
+  void setVerifyChecksums(bool verify);
+  bool verifyChecksums()const;
+
+  /// Use a media layout and write a DICOMDIR file. false by default
+  void setCreateDICOMDIR(bool create);
+  bool createDICOMDIR()const;
+
+  bool isRunning()const;
+
+  /// Source files that could not be exported by the last export, and
+  /// the reason why, in the same order.
+  QStringList failedFiles()const;
+  QStringList errors()const;
+
+  /// Block until the running export (if any) is finished. Queued events
+  /// are processed meanwhile.
+  void waitForFinished();
+
+public Q_SLOTS:
+  /// Start exporting the series into \a directory. Returns false if an
+  /// export is already running or no database is set.
+  bool exportSeries(const QString& directory, const QStringList& seriesInstanceUIDs);
+  /// The files not copied yet are skipped. finished() is still emitted.
+  void cancel();
+
+Q_SIGNALS:
+  void started(int numberOfFiles);
+  void progress(int exportedFiles, int numberOfFiles);
+  void progress(const QString& message);
+  /// Emitted when a file is skipped after all its retries failed
+  void fileFailed(const QString& sourceFile, const QString& destinationFile,
+                  const QString& error);
+  void finished(int exportedFiles, int failedFiles);
+
+protected Q_SLOTS:
+  void onFileProcessed(int fileIndex, bool success, const QString& error);
+  void onDICOMDIRWritten(bool success, const QString& error);
+
+protected:
+  QScopedPointer<ctkDICOMExporterPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(ctkDICOMExporter);
+  Q_DISABLE_COPY(ctkDICOMExporter);
+};
+
+#endif
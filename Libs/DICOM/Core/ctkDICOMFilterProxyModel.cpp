@@ -18,6 +18,13 @@
 
 =========================================================================*/
 
+
+// Qt includes
+#include <QHash>
+#include <QPersistentModelIndex>
+#include <QRegExp>
+#include <QTimer>
+
 #include "ctkDICOMFilterProxyModel.h"
 
 #include "ctkDICOMModel.h"
@@ -26,6 +33,59 @@
 #include <ctkLogger.h>
 static ctkLogger logger("org.commontk.DICOM.Core.ctkDICOMFilterProxyModel");
 
+//----------------------------------------------------------------------------
+/// Search text compiled once, when it is set.
+class ctkDICOMFilterProxyModelMatcher
+{
+public:
+    ctkDICOMFilterProxyModelMatcher(): Mode(MatchAll){}
+
+    void setPattern(const QString& text){
+        this->Pattern = text;
+        if(text.isEmpty()){
+            this->Mode = MatchAll;
+            return;
+        }
+        static const QRegExp metaCharacters("[\\\\^$.|?*+()\\[\\]{}]");
+        this->Mode = MatchSubstring;
+        if(text.contains(metaCharacters)){
+            this->RegExp = QRegExp(text);
+            // While typing, the expression is often incomplete: match it literally
+            if(this->RegExp.isValid()){
+                this->Mode = MatchRegExp;
+            }
+        }
+    }
+
+    bool matchesAll()const{
+        return this->Mode == MatchAll;
+    }
+
+    bool matches(const QString& value, Qt::CaseSensitivity caseSensitivity)const{
+        switch(this->Mode){
+            case MatchSubstring:
+                return value.contains(this->Pattern, caseSensitivity);
+            case MatchRegExp:
+                if(this->RegExp.caseSensitivity() != caseSensitivity){
+                    this->RegExp.setCaseSensitivity(caseSensitivity);
+                }
+                return value.contains(this->RegExp);
+            default:
+                return true;
+        }
+    }
+
+    QString Pattern;
+
+private:
+    enum MatchMode{
+        MatchAll,
+        MatchSubstring,
+        MatchRegExp
+    };
+    MatchMode Mode;
+    mutable QRegExp RegExp;
+};
 
 //----------------------------------------------------------------------------
 class ctkDICOMFilterProxyModelPrivate
@@ -37,22 +97,94 @@ protected:
 public:
   ctkDICOMFilterProxyModelPrivate(ctkDICOMFilterProxyModel* parent = 0);
 
-  QString searchTextName;
-  QString searchTextStudy;
-  QString searchTextSeries;
+  const ctkDICOMFilterProxyModelMatcher* matcher(int type)const;
+  bool accepts(const ctkDICOMModel* model, const QModelIndex& index)const;
+  bool setSearchText(ctkDICOMModel::IndexType type, const QString& text);
+
+  ctkDICOMFilterProxyModelMatcher searchTextName;
+  ctkDICOMFilterProxyModelMatcher searchTextStudy;
+  ctkDICOMFilterProxyModelMatcher searchTextSeries;
   QString searchTextID;
+
+  /// Acceptance of the source rows (keyed by the index internal pointer,
+  /// which is stable until the source model is reset) for each IndexType.
+  mutable QHash<void*, bool> AcceptedRows[ctkDICOMModel::ImageType + 1];
+  mutable Qt::CaseSensitivity CacheCaseSensitivity;
+
+  /// Source parents whose rows are still to be evaluated
+  QList<QPersistentModelIndex> PendingParents;
+  int PendingRow;
+  int ChunkSize;
+  QTimer ChunkTimer;
 };
 
 //----------------------------------------------------------------------------
 ctkDICOMFilterProxyModelPrivate::ctkDICOMFilterProxyModelPrivate(ctkDICOMFilterProxyModel* parent): q_ptr(parent){
+    this->CacheCaseSensitivity = Qt::CaseSensitive;
+    this->PendingRow = 0;
+    this->ChunkSize = 1000;
+    this->ChunkTimer.setSingleShot(true);
+    this->ChunkTimer.setInterval(0);
+}
 
+//----------------------------------------------------------------------------
+const ctkDICOMFilterProxyModelMatcher* ctkDICOMFilterProxyModelPrivate::matcher(int type)const{
+    switch(type){
+        case ctkDICOMModel::PatientType:
+            return &this->searchTextName;
+        case ctkDICOMModel::StudyType:
+            return &this->searchTextStudy;
+        case ctkDICOMModel::SeriesType:
+            return &this->searchTextSeries;
+        default:
+            return 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool ctkDICOMFilterProxyModelPrivate::accepts(const ctkDICOMModel* model, const QModelIndex& index)const{
+    Q_Q(const ctkDICOMFilterProxyModel);
+    int type = model->data(index, ctkDICOMModel::TypeRole).toInt();
+    const ctkDICOMFilterProxyModelMatcher* typeMatcher = this->matcher(type);
+    if(!typeMatcher || typeMatcher->matchesAll()){
+        return true;
+    }
+
+    if(this->CacheCaseSensitivity != q->filterCaseSensitivity()){
+        for(int i = 0; i <= ctkDICOMModel::ImageType; ++i){
+            this->AcceptedRows[i].clear();
+        }
+        this->CacheCaseSensitivity = q->filterCaseSensitivity();
+    }
+    QHash<void*, bool>& cache = this->AcceptedRows[type];
+    QHash<void*, bool>::const_iterator it = cache.constFind(index.internalPointer());
+    if(it != cache.constEnd()){
+        return it.value();
+    }
+    bool accepted = typeMatcher->matches(
+        model->data(index, Qt::DisplayRole).toString(), this->CacheCaseSensitivity);
+    cache.insert(index.internalPointer(), accepted);
+    return accepted;
+}
+
+//----------------------------------------------------------------------------
+bool ctkDICOMFilterProxyModelPrivate::setSearchText(ctkDICOMModel::IndexType type, const QString& text){
+    ctkDICOMFilterProxyModelMatcher* typeMatcher =
+        const_cast<ctkDICOMFilterProxyModelMatcher*>(this->matcher(type));
+    if(typeMatcher->Pattern == text){
+        return false;
+    }
+    typeMatcher->setPattern(text);
+    this->AcceptedRows[type].clear();
+    return true;
 }
 
 //----------------------------------------------------------------------------
 ctkDICOMFilterProxyModel::ctkDICOMFilterProxyModel(QObject *parent):Superclass(parent),
     d_ptr(new ctkDICOMFilterProxyModelPrivate(this))
 {
-
+    Q_D(ctkDICOMFilterProxyModel);
+    connect(&d->ChunkTimer, SIGNAL(timeout()), this, SLOT(processFilterChunk()));
 }
 
 //----------------------------------------------------------------------------
@@ -61,24 +193,114 @@ ctkDICOMFilterProxyModel::~ctkDICOMFilterProxyModel(){
 }
 
 //----------------------------------------------------------------------------
-void ctkDICOMFilterProxyModel::setNameSearchText(const QString &text){
+void ctkDICOMFilterProxyModel::setSourceModel(QAbstractItemModel* model){
+    if(this->sourceModel()){
+        disconnect(this->sourceModel(), 0, this, SLOT(clearFilterCache()));
+    }
+    this->clearFilterCache();
+    this->Superclass::setSourceModel(model);
+    if(model){
+        connect(model, SIGNAL(modelReset()), this, SLOT(clearFilterCache()));
+        connect(model, SIGNAL(layoutChanged()), this, SLOT(clearFilterCache()));
+        connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(clearFilterCache()));
+    }
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMFilterProxyModel::setFilterChunkSize(int rows){
+    Q_D(ctkDICOMFilterProxyModel);
+    d->ChunkSize = rows;
+}
+
+//----------------------------------------------------------------------------
+int ctkDICOMFilterProxyModel::filterChunkSize()const{
+    Q_D(const ctkDICOMFilterProxyModel);
+    return d->ChunkSize;
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMFilterProxyModel::scheduleFilter(){
     Q_D(ctkDICOMFilterProxyModel);
-    d->searchTextName = text;
+    if(d->ChunkSize <= 0 || !qobject_cast<ctkDICOMModel*>(this->sourceModel())){
+        d->PendingParents.clear();
+        d->ChunkTimer.stop();
+        this->invalidateFilter();
+        emit filterApplied();
+        return;
+    }
+    // (Re)start evaluating the fetched rows from the top
+    d->PendingParents.clear();
+    d->PendingParents << QPersistentModelIndex();
+    d->PendingRow = 0;
+    d->ChunkTimer.start();
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMFilterProxyModel::clearFilterCache(){
+    Q_D(ctkDICOMFilterProxyModel);
+    for(int i = 0; i <= ctkDICOMModel::ImageType; ++i){
+        d->AcceptedRows[i].clear();
+    }
+    // Rows being evaluated may not exist anymore: start over
+    if(!d->PendingParents.isEmpty()){
+        d->PendingParents.clear();
+        d->PendingParents << QPersistentModelIndex();
+        d->PendingRow = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMFilterProxyModel::processFilterChunk(){
+    Q_D(ctkDICOMFilterProxyModel);
+    ctkDICOMModel* model = qobject_cast<ctkDICOMModel*>(this->sourceModel());
+    int evaluatedRows = 0;
+    while(model && !d->PendingParents.isEmpty() && evaluatedRows < d->ChunkSize){
+        QModelIndex parent = d->PendingParents.first();
+        if(d->PendingRow >= model->rowCount(parent)){
+            d->PendingParents.removeFirst();
+            d->PendingRow = 0;
+            continue;
+        }
+        QModelIndex index = model->index(d->PendingRow++, 0, parent);
+        // Children of rejected rows are not displayed
+        if(d->accepts(model, index) && model->rowCount(index) > 0){
+            d->PendingParents << index;
+        }
+        ++evaluatedRows;
+    }
+    if(model && !d->PendingParents.isEmpty()){
+        d->ChunkTimer.start();
+        return;
+    }
+    d->PendingParents.clear();
+    // All the fetched rows are cached: filterAcceptsRow() is only hash
+    // lookups, but the proxy mapping of all the rows is rebuilt at once
     this->invalidateFilter();
+    emit filterApplied();
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMFilterProxyModel::setNameSearchText(const QString &text){
+    Q_D(ctkDICOMFilterProxyModel);
+    if(d->setSearchText(ctkDICOMModel::PatientType, text)){
+        this->scheduleFilter();
+    }
 }
 
 //----------------------------------------------------------------------------
 void ctkDICOMFilterProxyModel::setStudySearchText(const QString &text){
     Q_D(ctkDICOMFilterProxyModel);
-    d->searchTextStudy = text;
-    this->invalidateFilter();
+    if(d->setSearchText(ctkDICOMModel::StudyType, text)){
+        this->scheduleFilter();
+    }
 }
 
 //----------------------------------------------------------------------------
 void ctkDICOMFilterProxyModel::setSeriesSearchText(const QString &text){
     Q_D(ctkDICOMFilterProxyModel);
-    d->searchTextSeries = text;
-    this->invalidateFilter();
+    if(d->setSearchText(ctkDICOMModel::SeriesType, text)){
+        this->scheduleFilter();
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -88,36 +310,13 @@ void ctkDICOMFilterProxyModel::setIdSearchText(const QString &text){
     this->invalidateFilter();
 }
 
+//----------------------------------------------------------------------------
 bool ctkDICOMFilterProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const{
     Q_D(const ctkDICOMFilterProxyModel);
 
-    ctkDICOMModel* model = const_cast<ctkDICOMModel*>(qobject_cast<const ctkDICOMModel*>(this->sourceModel()));
-
-    if(model){
-        QModelIndex index = model->index(source_row, 0, source_parent);
-        if(model->data(index, ctkDICOMModel::TypeRole) == static_cast<int>(ctkDICOMModel::PatientType)){
-            QRegExp regExp = QRegExp(d->searchTextName);
-            if(model->data(index, Qt::DisplayRole).toString().contains(regExp)){
-                return true;
-            }else{
-                return false;
-            }
-        }else if(model->data(index, ctkDICOMModel::TypeRole) == static_cast<int>(ctkDICOMModel::StudyType)){
-            QRegExp regExp = QRegExp(d->searchTextStudy);
-            if(model->data(index, Qt::DisplayRole).toString().contains(regExp)){
-                return true;
-            }else{
-                return false;
-            }
-        }else if(model->data(index, ctkDICOMModel::TypeRole) == static_cast<int>(ctkDICOMModel::SeriesType)){
-            QRegExp regExp = QRegExp(d->searchTextSeries);
-            if(model->data(index, Qt::DisplayRole).toString().contains(regExp)){
-                return true;
-            }else{
-                return false;
-            }
-        }
+    const ctkDICOMModel* model = qobject_cast<const ctkDICOMModel*>(this->sourceModel());
+    if(!model){
+        return true;
     }
-
-    return true;
+    return d->accepts(model, model->index(source_row, 0, source_parent));
 }
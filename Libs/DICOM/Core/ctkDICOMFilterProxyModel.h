@@ -29,8 +29,31 @@
 class ctkDICOMFilterProxyModelPrivate;
 
 /// \ingroup DICOM_Core
+///
+/// Filter the patients, studies and series of a ctkDICOMModel by name.
+///
+/// The search texts are compiled once when they are set: texts without
+/// regular expression metacharacters are matched as plain substrings, other
+/// texts as regular expressions (an invalid expression is matched as a plain
+/// substring). The matching honors filterCaseSensitivity.
+///
+/// The acceptance of each row is cached until the search text of its type
+/// changes or the source model is reset. When a search text is set, the
+/// already fetched rows of the source model are evaluated in chunks of
+/// filterChunkSize rows from the event loop, so that typing stays responsive
+/// on large trees; the filter is applied once all of them are evaluated
+/// (see filterApplied()).
+///
+/// Applying the filter still is a single synchronous invalidateFilter() call:
+/// QSortFilterProxyModel cannot re-filter a subset of its rows. That pass
+/// only looks the acceptance of each fetched row up in the cache, but it
+/// rebuilds the proxy mapping of all of them and attached views update
+/// accordingly, which is proportional to the number of fetched rows.
 class CTK_DICOM_CORE_EXPORT ctkDICOMFilterProxyModel : public QSortFilterProxyModel{
     Q_OBJECT
+    /// Number of source rows evaluated per event loop iteration after a search
+    /// text changed. If 0, the filter is applied immediately. 1000 by default.
+    Q_PROPERTY(int filterChunkSize READ filterChunkSize WRITE setFilterChunkSize);
 
 public:
     typedef QSortFilterProxyModel Superclass;
@@ -39,6 +62,19 @@ public:
 
     virtual bool filterAcceptsRow ( int source_row, const QModelIndex & source_parent ) const;
 
+    virtual void setSourceModel(QAbstractItemModel* sourceModel);
+
+    void setFilterChunkSize(int rows);
+    int filterChunkSize()const;
+
+Q_SIGNALS:
+    /// Emitted when the filter has been applied after a search text change.
+    void filterApplied();
+
+protected Q_SLOTS:
+    void processFilterChunk();
+    void clearFilterCache();
+
 protected:
     QScopedPointer<ctkDICOMFilterProxyModelPrivate> d_ptr;
 
@@ -46,6 +82,8 @@ private:
     Q_DECLARE_PRIVATE(ctkDICOMFilterProxyModel);
     Q_DISABLE_COPY(ctkDICOMFilterProxyModel);
 
+    void scheduleFilter();
+
 public Q_SLOTS:
     void setNameSearchText(const QString& text);
     void setStudySearchText(const QString& text);
@@ -25,9 +25,188 @@
 #include <dcmtk/dcmdata/dctk.h>
 #include <dcmtk/dcmdata/dcostrmb.h>
 #include <dcmtk/dcmdata/dcistrmb.h>
+#include <dcmtk/dcmdata/dcxfer.h>
 
+#include <QBuffer>
+#include <QtEndian>
+
+#include <cstring>
 #include <stdexcept>
 
+namespace
+{
+
+// Binary serialization format (see ctkDICOMItem::SerializeToDevice):
+//   "CTKD" | version (1 byte) | flags (1 byte) | UID length (2 bytes)
+//   | transfer syntax UID | dataset length (4 bytes) | dataset
+// Integers are little endian. The dataset is encoded with explicit lengths
+// so that its size is known before it is written.
+const char ctkDICOMItemBinaryMagic[4] = { 'C', 'T', 'K', 'D' };
+const quint8 ctkDICOMItemBinaryVersion = 1;
+const quint8 ctkDICOMItemBinaryNoPixelData = 0x01;
+const int ctkDICOMItemChunkSize = 256 * 1024;
+const int ctkDICOMItemReadTimeout = 30000; // ms
+
+//------------------------------------------------------------------------------
+bool ctkDICOMItemIsPixelData(DcmElement* element)
+{
+  return element->getTag().getGroup() == 0x7fe0;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMItemReadExactly(QIODevice* device, char* data, qint64 size)
+{
+  qint64 done = 0;
+  while (done < size)
+    {
+    qint64 read = device->read(data + done, size - done);
+    if (read < 0)
+      {
+      return false;
+      }
+    if (read == 0 && !device->waitForReadyRead(ctkDICOMItemReadTimeout))
+      {
+      return false;
+      }
+    done += read;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/// Write DCMTK objects to a QIODevice through a fixed size buffer, which is
+/// flushed each time DCMTK reports it is full.
+class ctkDICOMItemOutputStream
+{
+public:
+  ctkDICOMItemOutputStream(QIODevice* device)
+    : Device(device)
+    , Buffer(ctkDICOMItemChunkSize)
+    , Stream(Buffer.data(), Buffer.size())
+    , Written(0)
+  {
+  }
+
+  bool write(DcmObject* object, E_TransferSyntax xfer, E_EncodingType encoding)
+  {
+    object->transferInit();
+    OFCondition condition = object->write(this->Stream, xfer, encoding, NULL);
+    while (condition == EC_StreamNotifyClient)
+      {
+      if (!this->flush())
+        {
+        object->transferEnd();
+        return false;
+        }
+      condition = object->write(this->Stream, xfer, encoding, NULL);
+      }
+    object->transferEnd();
+    if (condition.bad())
+      {
+      std::cerr << "Could not DcmObject::write(..): " << condition.text() << std::endl;
+      return false;
+      }
+    return true;
+  }
+
+  bool flush()
+  {
+    void* data = NULL;
+    offile_off_t length = 0;
+    this->Stream.flushBuffer(data, length);
+    if (length > 0 &&
+        this->Device->write(static_cast<const char*>(data), length) != length)
+      {
+      return false;
+      }
+    this->Written += length;
+    return true;
+  }
+
+  qint64 written()const
+  {
+    return this->Written;
+  }
+
+private:
+  QIODevice* Device;
+  QVector<char> Buffer;
+  DcmOutputBufferStream Stream;
+  qint64 Written;
+};
+
+//------------------------------------------------------------------------------
+E_TransferSyntax ctkDICOMItemBinaryTransferSyntax(DcmItem* item, bool excludePixelData)
+{
+  DcmDataset* dataset = dynamic_cast<DcmDataset*>(item);
+  if (dataset && !excludePixelData)
+    {
+    // Compressed pixel data can only be written in its own transfer syntax
+    E_TransferSyntax originalXfer = dataset->getOriginalXfer();
+    if (originalXfer != EXS_Unknown && DcmXfer(originalXfer).isEncapsulated())
+      {
+      return originalXfer;
+      }
+    }
+  return EXS_LittleEndianExplicit;
+}
+
+//------------------------------------------------------------------------------
+quint32 ctkDICOMItemBinaryLength(DcmItem* item, E_TransferSyntax xfer, bool excludePixelData)
+{
+  quint32 length = 0;
+  for (unsigned long i = 0; i < item->card(); ++i)
+    {
+    DcmElement* element = item->getElement(i);
+    if (!excludePixelData || !ctkDICOMItemIsPixelData(element))
+      {
+      length += element->calcElementLength(xfer, EET_ExplicitLength);
+      }
+    }
+  return length;
+}
+
+//------------------------------------------------------------------------------
+QByteArray ctkDICOMItemBinaryHeader(E_TransferSyntax xfer, quint8 flags, quint32 length)
+{
+  QByteArray uid(DcmXfer(xfer).getXferID());
+  QByteArray header(ctkDICOMItemBinaryMagic, 4);
+  header.append(static_cast<char>(ctkDICOMItemBinaryVersion));
+  header.append(static_cast<char>(flags));
+  uchar value[4];
+  qToLittleEndian<quint16>(uid.size(), value);
+  header.append(reinterpret_cast<const char*>(value), 2);
+  header.append(uid);
+  qToLittleEndian<quint32>(length, value);
+  header.append(reinterpret_cast<const char*>(value), 4);
+  return header;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMItemReadBinaryHeader(QIODevice* device, E_TransferSyntax& xfer, quint32& length)
+{
+  char header[8];
+  if (!ctkDICOMItemReadExactly(device, header, 8) ||
+      memcmp(header, ctkDICOMItemBinaryMagic, 4) != 0 ||
+      static_cast<quint8>(header[4]) != ctkDICOMItemBinaryVersion)
+    {
+    return false;
+    }
+  quint16 uidLength = qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(header + 6));
+  QByteArray uid(uidLength, '\0');
+  uchar value[4];
+  if (!ctkDICOMItemReadExactly(device, uid.data(), uidLength) ||
+      !ctkDICOMItemReadExactly(device, reinterpret_cast<char*>(value), 4))
+    {
+    return false;
+    }
+  xfer = DcmXfer(uid.constData()).getXfer();
+  length = qFromLittleEndian<quint32>(value);
+  return xfer != EXS_Unknown;
+}
+
+} // end of anonymous namespace
+
 
 class ctkDICOMItemPrivate
 {
@@ -135,36 +314,183 @@ void ctkDICOMItem::Serialize()
   EnsureDcmDataSetIsInitialized();
 
   // store content of current DcmDataset (our parent) as QByteArray into m_ctkDICOMItem
-  Uint32 buffersize = 1024*1024; // reserve 1MB
-  char* writebuffer = new char[buffersize];
-
-  // write into buffer
-  DcmOutputBufferStream dcmbuffer(writebuffer, buffersize);
-  d->m_DcmItem->transferInit();
-  OFCondition condition = d->m_DcmItem->write(dcmbuffer, EXS_LittleEndianImplicit, EET_UndefinedLength, NULL );
-  d->m_DcmItem->transferEnd();
-  if ( condition.bad() )
+  // (the byte array grows as needed, there is no size limit)
+  QByteArray qtArray;
+  QBuffer dcmbuffer(&qtArray);
+  dcmbuffer.open(QIODevice::WriteOnly);
+  ctkDICOMItemOutputStream stream(&dcmbuffer);
+  if ( !stream.write(d->m_DcmItem, EXS_LittleEndianImplicit, EET_UndefinedLength)
+       || !stream.flush() )
   {
-    std::cerr << "Could not DcmDataset::write(..): " << condition.text() << std::endl;
+    std::cerr << "Could not serialize dataset" << std::endl;
   }
 
-  // get written contents of buffer
-  offile_off_t datasetsize = 0;
-  void* readbuffer = NULL;
-  dcmbuffer.flushBuffer(readbuffer, datasetsize);
-
-  //std::cerr << "** " << (void*)this << " ctkDICOMItem: Serializing Dataset into " << datasetsize << " bytes" << std::endl;
-
   // construct Qt type from that contents
-  QByteArray qtArray = QByteArray::fromRawData( static_cast<const char*>(readbuffer), datasetsize );
-  //std::cerr << "** Buffer size: " << qtArray.size() << std::endl;
   QString stringbuffer = QString::fromLatin1(qtArray.toBase64());
 
-  //std::cerr << "** String of size " << stringbuffer.size() << " looks like this:\n" << stringbuffer.toStdString() << std::endl << std::endl;
-
   this->SetStoredSerialization( stringbuffer );
+}
 
-  delete[] writebuffer;
+QByteArray ctkDICOMItem::SerializeToByteArray(bool excludePixelData) const
+{
+  Q_D(const ctkDICOMItem);
+  EnsureDcmDataSetIsInitialized();
+
+  QByteArray data;
+  E_TransferSyntax xfer = ctkDICOMItemBinaryTransferSyntax(d->m_DcmItem, excludePixelData);
+  data.reserve(ctkDICOMItemBinaryLength(d->m_DcmItem, xfer, excludePixelData) + 64);
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  if (!this->SerializeToDevice(&buffer, excludePixelData))
+  {
+    return QByteArray();
+  }
+  buffer.close();
+  return data;
+}
+
+bool ctkDICOMItem::SerializeToDevice(QIODevice* device, bool excludePixelData) const
+{
+  Q_D(const ctkDICOMItem);
+  EnsureDcmDataSetIsInitialized();
+  if (!device || !device->isWritable())
+  {
+    return false;
+  }
+
+  E_TransferSyntax xfer = ctkDICOMItemBinaryTransferSyntax(d->m_DcmItem, excludePixelData);
+  quint32 length = ctkDICOMItemBinaryLength(d->m_DcmItem, xfer, excludePixelData);
+  QByteArray header = ctkDICOMItemBinaryHeader(
+    xfer, excludePixelData ? ctkDICOMItemBinaryNoPixelData : 0, length);
+  if (device->write(header) != header.size())
+  {
+    return false;
+  }
+
+  // Write the top-level elements one by one, which allows skipping the
+  // pixel data without copying or modifying the dataset.
+  ctkDICOMItemOutputStream stream(device);
+  for (unsigned long i = 0; i < d->m_DcmItem->card(); ++i)
+  {
+    DcmElement* element = d->m_DcmItem->getElement(i);
+    if (excludePixelData && ctkDICOMItemIsPixelData(element))
+    {
+      continue;
+    }
+    if (!stream.write(element, xfer, EET_ExplicitLength))
+    {
+      return false;
+    }
+  }
+  if (!stream.flush())
+  {
+    return false;
+  }
+  if (stream.written() != length)
+  {
+    std::cerr << "ctkDICOMItem: wrote " << stream.written()
+              << " bytes instead of " << length << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ctkDICOMItem::InitializeFromByteArray(const QByteArray& data)
+{
+  Q_D(ctkDICOMItem);
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+  E_TransferSyntax xfer = EXS_Unknown;
+  quint32 length = 0;
+  if (!ctkDICOMItemReadBinaryHeader(&buffer, xfer, length) ||
+      buffer.pos() + length > data.size())
+  {
+    return false;
+  }
+
+  // Parse the dataset directly from the array, without intermediate copy
+  DcmInputBufferStream dcmbuffer;
+  dcmbuffer.setBuffer(data.constData() + buffer.pos(), length);
+  dcmbuffer.setEos();
+
+  DcmDataset* dataset = new DcmDataset;
+  dataset->transferInit();
+  OFCondition condition = dataset->read(dcmbuffer, xfer);
+  dataset->transferEnd();
+  dcmbuffer.releaseBuffer();
+  if (condition.bad())
+  {
+    std::cerr << "Could not DcmDataset::read(..): " << condition.text() << std::endl;
+    delete dataset;
+    return false;
+  }
+
+  d->m_SpecificCharacterSet.clear();
+  d->m_DICOMDataSetInitialized = false;
+  this->InitializeFromItem(dataset, true);
+  return true;
+}
+
+bool ctkDICOMItem::InitializeFromDevice(QIODevice* device)
+{
+  Q_D(ctkDICOMItem);
+  E_TransferSyntax xfer = EXS_Unknown;
+  quint32 length = 0;
+  if (!device || !ctkDICOMItemReadBinaryHeader(device, xfer, length))
+  {
+    return false;
+  }
+
+  // Feed DCMTK chunk by chunk: it asks for more data (EC_StreamNotifyClient)
+  // until the end of the stream is reached.
+  DcmInputBufferStream dcmbuffer;
+  DcmDataset* dataset = new DcmDataset;
+  dataset->transferInit();
+  QVector<char> chunk(qMin<quint32>(length, ctkDICOMItemChunkSize));
+  quint32 remaining = length;
+  OFCondition condition = EC_StreamNotifyClient;
+  do
+  {
+    int chunkSize = static_cast<int>(qMin<quint32>(remaining, ctkDICOMItemChunkSize));
+    if (!ctkDICOMItemReadExactly(device, chunk.data(), chunkSize))
+    {
+      condition = EC_EndOfStream;
+      break;
+    }
+    remaining -= chunkSize;
+    dcmbuffer.setBuffer(chunk.constData(), chunkSize);
+    if (remaining == 0)
+    {
+      dcmbuffer.setEos();
+    }
+    condition = dataset->read(dcmbuffer, xfer);
+    dcmbuffer.releaseBuffer();
+  }
+  while (condition == EC_StreamNotifyClient && remaining > 0);
+  dataset->transferEnd();
+
+  if (condition.bad() || remaining > 0)
+  {
+    std::cerr << "Could not DcmDataset::read(..): " << condition.text() << std::endl;
+    delete dataset;
+    // Skip the rest of the dataset so the device stays in sync
+    while (remaining > 0 && !device->atEnd())
+    {
+      qint64 skipped = device->read(chunk.data(), qMin<quint32>(remaining, chunk.size()));
+      if (skipped <= 0)
+      {
+        break;
+      }
+      remaining -= skipped;
+    }
+    return false;
+  }
+
+  d->m_SpecificCharacterSet.clear();
+  d->m_DICOMDataSetInitialized = false;
+  this->InitializeFromItem(dataset, true);
+  return true;
 }
 
 void ctkDICOMItem::MarkForInitialization()
@@ -215,14 +541,15 @@ void ctkDICOMItem::Deserialize()
   dcmbuffer.setBuffer( qtArray.data(), qtArray.size() );
   //std::cerr << "** Buffer state: " << dcmbuffer.status().code() << " " <<  dcmbuffer.good() << " " << dcmbuffer.eos() << " tell " << dcmbuffer.tell() << " avail " << dcmbuffer.avail() << std::endl;
 
-  DcmDataset dataset;
-  dataset.transferInit();
-  //std::cerr << "** Dataset state: " << dataset.transferState() << std::endl << std::endl;
-  OFCondition condition = dataset.read( dcmbuffer, EXS_LittleEndianImplicit );
-  dataset.transferEnd();
+  // the item keeps the restored dataset
+  DcmDataset* dataset = new DcmDataset;
+  dataset->transferInit();
+  //std::cerr << "** Dataset state: " << dataset->transferState() << std::endl << std::endl;
+  OFCondition condition = dataset->read( dcmbuffer, EXS_LittleEndianImplicit );
+  dataset->transferEnd();
 
   // do this in all cases, even when reading reported an error
-  this->InitializeFromItem(&dataset);
+  this->InitializeFromItem(dataset, true);
 
   if ( condition.bad() )
   {
@@ -234,7 +561,7 @@ void ctkDICOMItem::Deserialize()
               << " tell " << dcmbuffer.tell()
               << " avail " << dcmbuffer.avail() << std::endl;
     std::cerr << "** Dataset state: "
-              << static_cast<int>(dataset.transferState()) << std::endl;
+              << static_cast<int>(dataset->transferState()) << std::endl;
     std::cerr << "Could not DcmDataset::read(..): "
               << condition.text() << std::endl;
     //throw std::invalid_argument( std::string("Could not DcmDataset::read(..): ") + condition.text() );
@@ -1004,3 +1331,20 @@ bool ctkDICOMItem::SaveToFile(const QString& filePath) const
   return status.good();
 }
 
+QDataStream& operator<<(QDataStream& stream, const ctkDICOMItem& item)
+{
+  if (!stream.device() || !item.SerializeToDevice(stream.device()))
+  {
+    stream.setStatus(QDataStream::WriteFailed);
+  }
+  return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, ctkDICOMItem& item)
+{
+  if (!stream.device() || !item.InitializeFromDevice(stream.device()))
+  {
+    stream.setStatus(QDataStream::ReadCorruptData);
+  }
+  return stream;
+}
@@ -59,6 +59,9 @@ class ctkDICOMItemPrivate;
 ///  A subclass could possibly want to store the internal DcmDataset.
 ///  For this purpose, the internal DcmDataset is serialized into a memory buffer using DcmDataset::write(..). This buffer
 ///  is stored in a base64 encoded string. For deserialization we decode the string and use DcmDataset::read(..).
+///
+///  To pass datasets between threads or processes, prefer the binary SerializeToByteArray() /
+///  SerializeToDevice() methods (or the QDataStream operators) which avoid the text encoding.
 class ctkDICOMItem;
 
 typedef ctkDICOMItem ctkDICOMItem;
@@ -114,6 +117,37 @@ public:
     /// the internal DcmDataset is created using DcmDataset::read(..).
     void Deserialize();
 
+    /// \brief Binary representation of the dataset.
+    ///
+    /// Unlike Serialize(), the dataset is written without text encoding and
+    /// without any size limit. The result is self-describing (it records the
+    /// transfer syntax and its own length) and can be restored with
+    /// InitializeFromByteArray() in another thread or process.
+    ///
+    /// If \a excludePixelData is true, the pixel data elements (group 7FE0)
+    /// are skipped, which is much cheaper when only the metadata is needed.
+    ///
+    /// Returns an empty array on failure.
+    QByteArray SerializeToByteArray(bool excludePixelData = false) const;
+
+    /// \brief Write the binary representation of the dataset to \a device.
+    ///
+    /// The dataset is streamed in chunks, no copy of the whole dataset is made.
+    /// \sa SerializeToByteArray()
+    bool SerializeToDevice(QIODevice* device, bool excludePixelData = false) const;
+
+    /// \brief Restore the dataset from the output of SerializeToByteArray().
+    ///
+    /// \returns false if the data is not a valid binary representation.
+    bool InitializeFromByteArray(const QByteArray& data);
+
+    /// \brief Restore the dataset from the output of SerializeToDevice().
+    ///
+    /// Exactly the bytes of one dataset are read from \a device, so several
+    /// datasets (or other data) can be read in sequence. On sequential
+    /// devices, this waits for the data to be available.
+    bool InitializeFromDevice(QIODevice* device);
+
 
     /// \brief To be called from InitializeData, flags status as dirty.
     ///
@@ -260,5 +294,12 @@ private:
   Q_DECLARE_PRIVATE(ctkDICOMItem);
 };
 
+/// \ingroup DICOM_Core
+/// Write the binary representation of \a item (see ctkDICOMItem::SerializeToDevice())
+CTK_DICOM_CORE_EXPORT QDataStream& operator<<(QDataStream& stream, const ctkDICOMItem& item);
+/// \ingroup DICOM_Core
+/// Read a dataset written with operator<<() into \a item
+CTK_DICOM_CORE_EXPORT QDataStream& operator>>(QDataStream& stream, ctkDICOMItem& item);
+
 #endif
 
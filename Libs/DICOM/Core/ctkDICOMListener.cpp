@@ -0,0 +1,670 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QUuid>
+#include <QWaitCondition>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMListener.h"
+#include "ctkLogger.h"
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcuid.h>
+#include <dcmtk/dcmnet/diutil.h>
+#include <dcmtk/dcmnet/scppool.h>
+#include <dcmtk/dcmnet/scpthrd.h>
+
+static ctkLogger logger("org.commontk.dicom.DICOMListener");
+
+class ctkDICOMListenerSCPPool;
+
+//------------------------------------------------------------------------------
+/// Network thread: runs the (blocking) accept loop of the SCP pool.
+class ctkDICOMListenerNetworkThread : public QThread
+{
+public:
+  ctkDICOMListenerNetworkThread(ctkDICOMListenerPrivate* listener)
+    : Listener(listener)
+    {
+    }
+protected:
+  virtual void run();
+  ctkDICOMListenerPrivate* Listener;
+};
+
+//------------------------------------------------------------------------------
+/// Indexing thread: inserts received files into the database in batches,
+/// using its own database connection.
+class ctkDICOMListenerIndexThread : public QThread
+{
+public:
+  ctkDICOMListenerIndexThread(ctkDICOMListenerPrivate* listener)
+    : Listener(listener)
+    {
+    }
+protected:
+  virtual void run();
+  ctkDICOMListenerPrivate* Listener;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMListenerPrivate
+{
+  Q_DECLARE_PUBLIC(ctkDICOMListener);
+
+protected:
+  ctkDICOMListener* const q_ptr;
+
+  friend class ctkDICOMListenerIndexThread;
+  friend class ctkDICOMListenerNetworkThread;
+
+public:
+  ctkDICOMListenerPrivate(ctkDICOMListener& obj);
+  ~ctkDICOMListenerPrivate();
+
+  /// Called from the network threads
+  QString incomingFilePath(const QString& sopInstanceUID)const;
+  bool storeReceivedFile(const QString& incomingFilePath);
+
+  /// Called from the indexing thread. Blocks until a batch is ready,
+  /// returns an empty list once stopped and the queue is drained.
+  QStringList takeBatch();
+
+  /// Called from the network thread when the network has been
+  /// initialized (the port is bound) and when the accept loop ended.
+  void setNetworkState(int state, const QString& error = QString());
+
+  /// Wait for the threads to finish and release them
+  void releaseThreads();
+
+  enum NetworkStates
+    {
+    NetworkStopped,
+    NetworkStarting,
+    NetworkListening
+    };
+
+  QString AETitle;
+  int Port;
+  int MaximumAssociations;
+  int BatchSize;
+  int BatchTimeout;
+  QSharedPointer<ctkDICOMDatabase> Database;
+
+  /// Copies of the database settings, safe to read from other threads
+  QString DatabaseFileName;
+  QString StorageDirectory;
+
+  ctkDICOMListenerSCPPool* Pool;
+  ctkDICOMListenerNetworkThread* NetworkThread;
+  ctkDICOMListenerIndexThread* IndexThread;
+
+  mutable QMutex NetworkMutex;
+  QWaitCondition NetworkCondition;
+  int NetworkState;
+  QString NetworkError;
+
+  mutable QMutex QueueMutex;
+  QWaitCondition QueueCondition;
+  QStringList IndexQueue;
+  bool Stopping;
+  int ReceivedCount;
+};
+
+//------------------------------------------------------------------------------
+/// SCP serving one association at a time within the pool. Only C-STORE
+/// requests are handled here, C-ECHO is handled by DcmSCP itself.
+class ctkDICOMListenerSCPWorker
+  : public DcmBaseSCPPool::BaseSCPWorker
+  , public DcmThreadSCP
+{
+public:
+  ctkDICOMListenerSCPWorker(DcmBaseSCPPool& pool, ctkDICOMListenerPrivate* listener)
+    : DcmBaseSCPPool::BaseSCPWorker(pool)
+    , DcmThreadSCP()
+    , Listener(listener)
+    {
+    }
+
+  virtual OFCondition setSharedConfig(const DcmSharedSCPConfig& config)
+    {
+    return DcmThreadSCP::setSharedConfig(config);
+    }
+
+  virtual OFBool busy()
+    {
+    return DcmThreadSCP::isConnected();
+    }
+
+protected:
+  virtual OFCondition workerListen(T_ASC_Association* const assoc)
+    {
+    return DcmThreadSCP::run(assoc);
+    }
+
+  virtual OFCondition handleIncomingCommand(T_DIMSE_Message* incomingMsg,
+                                            const DcmPresentationContextInfo& presInfo)
+    {
+    if (incomingMsg->CommandField != DIMSE_C_STORE_RQ)
+      {
+      return DcmThreadSCP::handleIncomingCommand(incomingMsg, presInfo);
+      }
+
+    T_DIMSE_C_StoreRQ& storeRequest = incomingMsg->msg.CStoreRQ;
+    QString incomingFile =
+      this->Listener->incomingFilePath(QString(storeRequest.AffectedSOPInstanceUID));
+
+    // The dataset is streamed from the network directly into the file
+    Uint16 status = STATUS_STORE_Refused_OutOfResources;
+    OFCondition result = this->receiveSTORERequest(
+      storeRequest, presInfo.presentationContextID,
+      OFString(incomingFile.toLocal8Bit().constData()));
+    if (result.good())
+      {
+      status = this->Listener->storeReceivedFile(incomingFile) ?
+        STATUS_Success : STATUS_STORE_Error_CannotUnderstand;
+      }
+    else
+      {
+      logger.error(QString("Receiving C-STORE request failed: %1").arg(result.text()));
+      QFile::remove(incomingFile);
+      }
+    OFCondition responseResult = this->sendSTOREResponse(
+      presInfo.presentationContextID, storeRequest, status);
+    return result.good() ? responseResult : result;
+    }
+
+  ctkDICOMListenerPrivate* Listener;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMListenerSCPPool : public DcmBaseSCPPool
+{
+public:
+  ctkDICOMListenerSCPPool(ctkDICOMListenerPrivate* listener)
+    : Listener(listener)
+    {
+    }
+protected:
+  virtual BaseSCPWorker* createSCPWorker()
+    {
+    return new ctkDICOMListenerSCPWorker(*this, this->Listener);
+    }
+  virtual OFCondition initializeNetwork(T_ASC_Network** network)
+    {
+    OFCondition result = DcmBaseSCPPool::initializeNetwork(network);
+    if (result.good())
+      {
+      this->Listener->setNetworkState(ctkDICOMListenerPrivate::NetworkListening);
+      }
+    return result;
+    }
+  ctkDICOMListenerPrivate* Listener;
+};
+
+//------------------------------------------------------------------------------
+void ctkDICOMListenerNetworkThread::run()
+{
+  OFCondition result = this->Listener->Pool->listen();
+  // A failure to open the port is reported by start()
+  bool wasListening = this->Listener->q_func()->isListening();
+  this->Listener->setNetworkState(ctkDICOMListenerPrivate::NetworkStopped,
+                                  result.bad() ? QString(result.text()) : QString());
+  if (result.bad() && wasListening)
+    {
+    QString message = QString("DICOM listener stopped: %1").arg(result.text());
+    logger.error(message);
+    emit this->Listener->q_func()->error(message);
+    }
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListenerIndexThread::run()
+{
+  // QSqlDatabase connections can only be used from the thread
+  // that created them, therefore open a dedicated one here.
+  ctkDICOMDatabase database;
+  database.openDatabase(this->Listener->DatabaseFileName,
+                        "ctkDICOMListener_" + QUuid::createUuid().toString());
+  if (!database.isOpen())
+    {
+    QString message = QString("DICOM listener could not open database %1: %2")
+      .arg(this->Listener->DatabaseFileName).arg(database.lastError());
+    logger.error(message);
+    emit this->Listener->q_func()->error(message);
+    }
+  database.prepareInsert();
+
+  QStringList batch = this->Listener->takeBatch();
+  while (!batch.isEmpty())
+    {
+    if (database.isOpen())
+      {
+      database.insertFiles(batch, false);
+      emit this->Listener->q_func()->batchIndexed(batch.count());
+      }
+    batch = this->Listener->takeBatch();
+    }
+  database.closeDatabase();
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMListenerPrivate methods
+
+//------------------------------------------------------------------------------
+ctkDICOMListenerPrivate::ctkDICOMListenerPrivate(ctkDICOMListener& obj)
+  : q_ptr(&obj)
+{
+  this->AETitle = "CTK_STORE";
+  this->Port = 11112;
+  this->MaximumAssociations = 4;
+  this->BatchSize = 100;
+  this->BatchTimeout = 500;
+  this->Pool = 0;
+  this->NetworkThread = 0;
+  this->IndexThread = 0;
+  this->NetworkState = NetworkStopped;
+  this->Stopping = false;
+  this->ReceivedCount = 0;
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMListenerPrivate::~ctkDICOMListenerPrivate()
+{
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMListenerPrivate::incomingFilePath(const QString& sopInstanceUID)const
+{
+  // A unique suffix keeps concurrent associations sending the
+  // same instance from writing into the same file.
+  return this->StorageDirectory + "/.incoming/" + sopInstanceUID
+    + QUuid::createUuid().toString();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMListenerPrivate::storeReceivedFile(const QString& incomingFilePath)
+{
+  Q_Q(ctkDICOMListener);
+
+  // Only parse the header: stop before the pixel data, other long
+  // element values are not loaded into memory
+  DcmFileFormat fileFormat;
+  OFCondition status = fileFormat.loadFileUntilTag(incomingFilePath.toLocal8Bit().constData(),
+    EXS_Unknown, EGL_noChange, 256 /* maxReadLength */, ERM_autoDetect, DCM_PixelData);
+  if (status.bad())
+    {
+    logger.error(QString("Could not read received file %1: %2")
+                 .arg(incomingFilePath).arg(status.text()));
+    QFile::remove(incomingFilePath);
+    return false;
+    }
+  DcmDataset* dataset = fileFormat.getDataset();
+  OFString studyInstanceUID, seriesInstanceUID, sopInstanceUID;
+  dataset->findAndGetOFString(DCM_StudyInstanceUID, studyInstanceUID);
+  dataset->findAndGetOFString(DCM_SeriesInstanceUID, seriesInstanceUID);
+  dataset->findAndGetOFString(DCM_SOPInstanceUID, sopInstanceUID);
+  if (studyInstanceUID.empty() || seriesInstanceUID.empty() || sopInstanceUID.empty())
+    {
+    logger.error("Received dataset is missing study, series or SOP instance UID");
+    QFile::remove(incomingFilePath);
+    return false;
+    }
+
+  // Same layout as ctkDICOMDatabase uses for stored files
+  QString seriesDirectory = QString("%1/%2").arg(studyInstanceUID.c_str()).arg(seriesInstanceUID.c_str());
+  QDir(this->StorageDirectory).mkpath(seriesDirectory);
+  QString destinationFile = this->StorageDirectory + "/" + seriesDirectory + "/" + sopInstanceUID.c_str();
+
+  // Both files are in the same directory tree, so this is a cheap rename
+  // rather than a copy
+  QFile::remove(destinationFile);
+  if (!QFile::rename(incomingFilePath, destinationFile))
+    {
+    logger.error(QString("Could not move received file to %1").arg(destinationFile));
+    QFile::remove(incomingFilePath);
+    return false;
+    }
+
+  {
+  QMutexLocker locker(&this->QueueMutex);
+  this->IndexQueue << destinationFile;
+  ++this->ReceivedCount;
+  if (this->IndexQueue.count() >= this->BatchSize)
+    {
+    this->QueueCondition.wakeOne();
+    }
+  }
+
+  emit q->instanceReceived(QString(sopInstanceUID.c_str()));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+QStringList ctkDICOMListenerPrivate::takeBatch()
+{
+  QMutexLocker locker(&this->QueueMutex);
+  while (!this->Stopping && this->IndexQueue.count() < this->BatchSize)
+    {
+    // Commit a partial batch on timeout so that received objects
+    // become visible in the database without too much delay.
+    if (!this->QueueCondition.wait(&this->QueueMutex, this->BatchTimeout)
+        && !this->IndexQueue.isEmpty())
+      {
+      break;
+      }
+    }
+  QStringList batch = this->IndexQueue.mid(0, this->BatchSize);
+  this->IndexQueue = this->IndexQueue.mid(batch.count());
+  return batch;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListenerPrivate::setNetworkState(int state, const QString& error)
+{
+  QMutexLocker locker(&this->NetworkMutex);
+  this->NetworkState = state;
+  this->NetworkError = error;
+  this->NetworkCondition.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListenerPrivate::releaseThreads()
+{
+  this->NetworkThread->wait();
+  {
+  QMutexLocker locker(&this->QueueMutex);
+  this->Stopping = true;
+  this->QueueCondition.wakeAll();
+  }
+  this->IndexThread->wait();
+
+  delete this->NetworkThread;
+  this->NetworkThread = 0;
+  delete this->IndexThread;
+  this->IndexThread = 0;
+  delete this->Pool;
+  this->Pool = 0;
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMListener methods
+
+//------------------------------------------------------------------------------
+ctkDICOMListener::ctkDICOMListener(QObject* parentObject)
+  : QObject(parentObject)
+  , d_ptr(new ctkDICOMListenerPrivate(*this))
+{
+  // batchIndexed() is emitted from the indexing thread
+  connect(this, SIGNAL(batchIndexed(int)), this, SLOT(onBatchIndexed()),
+          Qt::QueuedConnection);
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMListener::~ctkDICOMListener()
+{
+  this->stop();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListener::setAETitle(const QString& aeTitle)
+{
+  Q_D(ctkDICOMListener);
+  d->AETitle = aeTitle;
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMListener::AETitle()const
+{
+  Q_D(const ctkDICOMListener);
+  return d->AETitle;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListener::setPort(int port)
+{
+  Q_D(ctkDICOMListener);
+  d->Port = port;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMListener::port()const
+{
+  Q_D(const ctkDICOMListener);
+  return d->Port;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListener::setMaximumAssociations(int maximumAssociations)
+{
+  Q_D(ctkDICOMListener);
+  d->MaximumAssociations = qMax(1, maximumAssociations);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMListener::maximumAssociations()const
+{
+  Q_D(const ctkDICOMListener);
+  return d->MaximumAssociations;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListener::setBatchSize(int batchSize)
+{
+  Q_D(ctkDICOMListener);
+  QMutexLocker locker(&d->QueueMutex);
+  d->BatchSize = qMax(1, batchSize);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMListener::batchSize()const
+{
+  Q_D(const ctkDICOMListener);
+  QMutexLocker locker(&d->QueueMutex);
+  return d->BatchSize;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListener::setBatchTimeout(int msec)
+{
+  Q_D(ctkDICOMListener);
+  QMutexLocker locker(&d->QueueMutex);
+  d->BatchTimeout = qMax(1, msec);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMListener::batchTimeout()const
+{
+  Q_D(const ctkDICOMListener);
+  QMutexLocker locker(&d->QueueMutex);
+  return d->BatchTimeout;
+}
+
+//------------------------------------------------------------------------------
+static void skipDelete(QObject* obj)
+{
+  Q_UNUSED(obj);
+  // this deleter does not delete the object from memory
+  // useful if the pointer is not owned by the smart pointer
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListener::setDatabase(ctkDICOMDatabase& dicomDatabase)
+{
+  Q_D(ctkDICOMListener);
+  d->Database = QSharedPointer<ctkDICOMDatabase>(&dicomDatabase, skipDelete);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListener::setDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabase)
+{
+  Q_D(ctkDICOMListener);
+  d->Database = dicomDatabase;
+}
+
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMDatabase> ctkDICOMListener::database()const
+{
+  Q_D(const ctkDICOMListener);
+  return d->Database;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListener::onBatchIndexed()
+{
+  Q_D(ctkDICOMListener);
+  // The batch was committed on the connection of the indexing thread:
+  // tell the users of the main connection to query the database again
+  if (d->Database)
+    {
+    QMetaObject::invokeMethod(d->Database.data(), "databaseChanged");
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMListener::isListening()const
+{
+  Q_D(const ctkDICOMListener);
+  QMutexLocker locker(&d->NetworkMutex);
+  return d->NetworkState == ctkDICOMListenerPrivate::NetworkListening;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMListener::receivedInstanceCount()const
+{
+  Q_D(const ctkDICOMListener);
+  QMutexLocker locker(&d->QueueMutex);
+  return d->ReceivedCount;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMListener::start()
+{
+  Q_D(ctkDICOMListener);
+  if (this->isListening())
+    {
+    return false;
+    }
+  if (d->NetworkThread)
+    {
+    // The accept loop ended with an error, release the previous run
+    this->stop();
+    }
+  if (!d->Database || !d->Database->isOpen() || d->Database->isInMemory())
+    {
+    logger.error("DICOM listener requires an open, file based database");
+    return false;
+    }
+
+  d->DatabaseFileName = d->Database->databaseFilename();
+  d->StorageDirectory = d->Database->databaseDirectory() + "/dicom";
+  QDir(d->StorageDirectory).mkpath(".incoming");
+  {
+  QMutexLocker locker(&d->QueueMutex);
+  d->Stopping = false;
+  d->ReceivedCount = 0;
+  d->IndexQueue.clear();
+  }
+
+  d->Pool = new ctkDICOMListenerSCPPool(d);
+  DcmSCPConfig& config = d->Pool->getConfig();
+  config.setAETitle(d->AETitle.toStdString().c_str());
+  config.setPort(static_cast<Uint16>(d->Port));
+  // Non-blocking accept so that stop() is noticed by the accept loop
+  config.setConnectionBlockingMode(DUL_NOBLOCK);
+  config.setConnectionTimeout(1);
+
+  OFList<OFString> transferSyntaxes;
+  transferSyntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
+  transferSyntaxes.push_back(UID_BigEndianExplicitTransferSyntax);
+  transferSyntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+  transferSyntaxes.push_back(UID_JPEGProcess1TransferSyntax);
+  transferSyntaxes.push_back(UID_JPEGProcess2_4TransferSyntax);
+  transferSyntaxes.push_back(UID_JPEGProcess14SV1TransferSyntax);
+  transferSyntaxes.push_back(UID_JPEG2000LosslessOnlyTransferSyntax);
+  transferSyntaxes.push_back(UID_JPEG2000TransferSyntax);
+  transferSyntaxes.push_back(UID_RLELosslessTransferSyntax);
+  config.addPresentationContext(UID_VerificationSOPClass, transferSyntaxes);
+  for (int i = 0; i < numberOfDcmAllStorageSOPClassUIDs; ++i)
+    {
+    config.addPresentationContext(dcmAllStorageSOPClassUIDs[i], transferSyntaxes);
+    }
+  d->Pool->setMaxThreads(static_cast<Uint16>(d->MaximumAssociations));
+
+  d->IndexThread = new ctkDICOMListenerIndexThread(d);
+  d->IndexThread->start();
+  d->setNetworkState(ctkDICOMListenerPrivate::NetworkStarting);
+  d->NetworkThread = new ctkDICOMListenerNetworkThread(d);
+  d->NetworkThread->start();
+
+  // Wait until the port is bound, or opening it failed (e.g. the port is
+  // already in use) and the network thread returned
+  bool listening = false;
+  QString networkError;
+  {
+  QMutexLocker locker(&d->NetworkMutex);
+  while (d->NetworkState == ctkDICOMListenerPrivate::NetworkStarting)
+    {
+    d->NetworkCondition.wait(&d->NetworkMutex);
+    }
+  listening = d->NetworkState == ctkDICOMListenerPrivate::NetworkListening;
+  networkError = d->NetworkError;
+  }
+  if (!listening)
+    {
+    d->releaseThreads();
+    QString message = QString("DICOM listener could not listen on port %1: %2")
+      .arg(d->Port).arg(networkError);
+    logger.error(message);
+    emit error(message);
+    return false;
+    }
+
+  emit started();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMListener::stop()
+{
+  Q_D(ctkDICOMListener);
+  if (!d->NetworkThread)
+    {
+    return;
+    }
+
+  // Let running associations finish, then drain the indexing queue
+  d->Pool->stopAfterCurrentAssociations();
+  d->releaseThreads();
+  QDir(d->StorageDirectory).rmdir(".incoming");
+
+  emit stopped();
+}
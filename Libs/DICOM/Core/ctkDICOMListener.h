@@ -0,0 +1,134 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMListener_h
+#define __ctkDICOMListener_h
+
+// Qt includes
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+
+#include "ctkDICOMCoreExport.h"
+
+class ctkDICOMDatabase;
+class ctkDICOMListenerPrivate;
+
+/// \ingroup DICOM_Core
+///
+/// \brief C-STORE SCP receiving DICOM objects pushed by modalities or PACS.
+///
+/// Incoming datasets are written by DCMTK directly into the internal storage
+/// layout of the database (<databaseDirectory>/dicom/<study>/<series>/<sop>),
+/// so no intermediate directory scan is needed. Several associations are
+/// served concurrently (see maximumAssociations). The received files are
+/// indexed on a separate thread, which uses its own database connection and
+/// inserts the rows in batches of batchSize files per transaction.
+///
+/// The listener must not be used with an in-memory database.
+class CTK_DICOM_CORE_EXPORT ctkDICOMListener : public QObject
+{
+  Q_OBJECT
+  Q_PROPERTY(QString AETitle READ AETitle WRITE setAETitle);
+  Q_PROPERTY(int port READ port WRITE setPort);
+  Q_PROPERTY(int maximumAssociations READ maximumAssociations WRITE setMaximumAssociations);
+  Q_PROPERTY(int batchSize READ batchSize WRITE setBatchSize);
+  Q_PROPERTY(int batchTimeout READ batchTimeout WRITE setBatchTimeout);
+  Q_PROPERTY(bool isListening READ isListening);
+
+public:
+  explicit ctkDICOMListener(QObject* parent = 0);
+  virtual ~ctkDICOMListener();
+
+  /// AE title the listener answers to. "CTK_STORE" by default
+  void setAETitle(const QString& aeTitle);
+  QString AETitle()const;
+
+  /// [0, 65535] port to listen on. 11112 by default
+  void setPort(int port);
+  int port()const;
+
+  /// Number of associations that are served concurrently, each one
+  /// on its own thread. 4 by default
+  void setMaximumAssociations(int maximumAssociations);
+  int maximumAssociations()const;
+
+  /// Maximum number of received files inserted into the database
+  /// within a single transaction. 100 by default
+  void setBatchSize(int batchSize);
+  int batchSize()const;
+
+  /// Maximum time (in ms) a received file waits before its batch is
+  /// committed, even if the batch is not full. 500 by default
+  void setBatchTimeout(int msec);
+  int batchTimeout()const;
+
+  /// Database the received objects are stored into and indexed in.
+  /// Only the database file name is used: the indexing thread opens its
+  /// own connection to it.
+  Q_INVOKABLE void setDatabase(ctkDICOMDatabase& dicomDatabase);
+  void setDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabase);
+  Q_INVOKABLE QSharedPointer<ctkDICOMDatabase> database()const;
+
+  /// True while associations are accepted: false if start() could not
+  /// open the port or if the network loop ended with an error.
+  bool isListening()const;
+
+  /// Total number of instances received since the last start()
+  Q_INVOKABLE int receivedInstanceCount()const;
+
+public Q_SLOTS:
+  /// Start accepting associations. Returns false if the listener is
+  /// already running, if no (file based) database is set or if the port
+  /// can't be opened (e.g. it is in use). error() is emitted in the
+  /// latter case.
+  bool start();
+  /// Stop accepting associations, wait for the running ones to finish
+  /// and index all received files before returning.
+  void stop();
+
+Q_SIGNALS:
+  void started();
+  void stopped();
+  /// Emitted (from a network thread) each time an object has been
+  /// received and written to the database storage directory.
+  void instanceReceived(const QString& sopInstanceUID);
+  /// Emitted (from the indexing thread) after a batch of received
+  /// files has been committed to the database. The database() then
+  /// emits databaseChanged() from the thread of the listener, so that
+  /// views of the database show the new records.
+  void batchIndexed(int numberOfFiles);
+  void error(const QString& message);
+
+protected Q_SLOTS:
+  void onBatchIndexed();
+
+protected:
+  QScopedPointer<ctkDICOMListenerPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(ctkDICOMListener);
+  Q_DISABLE_COPY(ctkDICOMListener);
+
+  friend class ctkDICOMListenerIndexThread;
+  friend class ctkDICOMListenerNetworkThread;
+};
+
+#endif
@@ -25,7 +25,6 @@
 
 // Qt includes
 #include <QApplication>
-#include <QFileDialog>
 #include <QHeaderView>
 #include <QString>
 #include <QTimer>
@@ -37,12 +36,65 @@
 int ctkDICOMObjectModelTest1( int argc, char * argv [] )
 {
   QApplication app(argc, argv);
-  QString fileName;
-  //TODO: Add the option for reading the test file from argv
-  fileName = QFileDialog::getOpenFileName( 0,
-    "Choose a DCM File", ".","DCM (*)" );
+  if (argc < 2)
+    {
+    std::cerr << "Usage: ctkDICOMObjectModelTest1 dcmfile [-I]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  QString fileName(argv[1]);
+
   ctkDICOMObjectModel dcmObjModel;
   dcmObjModel.setFile(fileName);
+  if (dcmObjModel.rowCount() == 0 || dcmObjModel.columnCount() != 5)
+    {
+    std::cerr << "ctkDICOMObjectModel::setFile() failed: " << dcmObjModel.rowCount()
+              << " rows, " << dcmObjModel.columnCount() << " columns" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Bulk data is not loaded, nested rows are created on demand
+  bool pixelDataFound = false;
+  for (int row = 0; row < dcmObjModel.rowCount(); ++row)
+    {
+    QModelIndex tagIndex = dcmObjModel.index(row, ctkDICOMObjectModel::TagColumn);
+    QModelIndex valueIndex = dcmObjModel.index(row, ctkDICOMObjectModel::ValueColumn);
+    QModelIndex lengthIndex = dcmObjModel.index(row, ctkDICOMObjectModel::LengthColumn);
+    if (dcmObjModel.data(tagIndex).toString() == "(7fe0,0010)"
+        && dcmObjModel.data(lengthIndex).toInt() > dcmObjModel.bulkDataThreshold())
+      {
+      pixelDataFound = true;
+      if (!dcmObjModel.data(valueIndex).toString().contains("not loaded"))
+        {
+        std::cerr << "Pixel data was loaded: "
+                  << qPrintable(dcmObjModel.data(valueIndex).toString()) << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    if (dcmObjModel.hasChildren(tagIndex))
+      {
+      if (dcmObjModel.rowCount(tagIndex) != 0 || !dcmObjModel.canFetchMore(tagIndex))
+        {
+        std::cerr << "Sequence " << qPrintable(dcmObjModel.data(tagIndex).toString())
+                  << " was populated before being fetched" << std::endl;
+        return EXIT_FAILURE;
+        }
+      dcmObjModel.fetchMore(tagIndex);
+      if (dcmObjModel.rowCount(tagIndex) == 0
+          || dcmObjModel.parent(dcmObjModel.index(0, 0, tagIndex)) != tagIndex)
+        {
+        std::cerr << "ctkDICOMObjectModel::fetchMore() failed for "
+                  << qPrintable(dcmObjModel.data(tagIndex).toString()) << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  if (!pixelDataFound)
+    {
+    std::cerr << "No pixel data found in " << qPrintable(fileName) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  dcmObjModel.fetchAll();
 
   QTreeView *viewer = new QTreeView();
   viewer->setModel( &dcmObjModel);
@@ -52,9 +104,21 @@ int ctkDICOMObjectModelTest1( int argc, char * argv [] )
   viewer->resizeColumnToContents(2);
   viewer->resizeColumnToContents(3);
   viewer->resizeColumnToContents(4);
-  //viewer->header()->setResizeMode( QHeaderView::Stretch);
   viewer->show();
   viewer->raise();
 
-  return app.exec();
+  if (argc <= 2 || QString(argv[2]) != "-I")
+    {
+    QTimer::singleShot(200, &app, SLOT(quit()));
+    }
+  int status = app.exec();
+
+  dcmObjModel.clear();
+  if (dcmObjModel.rowCount() != 0)
+    {
+    std::cerr << "ctkDICOMObjectModel::clear() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  delete viewer;
+  return status;
 }
@@ -38,6 +38,7 @@
 #include <QPushButton>
 #include <QSettings>
 #include <QStringListModel>
+#include <QVBoxLayout>
 #include <QWidgetAction>
 
 // ctkWidgets includes
@@ -47,6 +48,7 @@
 
 // ctkDICOMCore includes
 #include "ctkDICOMDatabase.h"
+#include "ctkDICOMExporter.h"
 #include "ctkDICOMIndexer.h"
 
 // ctkDICOMWidgets includes
@@ -85,9 +87,17 @@ public:
   QProgressDialog *IndexerProgress;
   QProgressDialog *UpdateSchemaProgress;
   QProgressDialog *ExportProgress;
+  ctkDICOMExporter* Exporter;
+  bool ExportCreateDICOMDIR;
+  bool ExportVerifyChecksums;
 
   void showIndexerDialog();
   void showUpdateSchemaDialog();
+  void showExportDialog();
+
+  /// Ask the user for the export destination directory (and whether a
+  /// DICOMDIR should be written). Returns an empty string if canceled.
+  QString selectExportDirectory();
 
   // used when suspending the ctkDICOMModel
   QSqlDatabase EmptyDatabase;
@@ -143,6 +153,9 @@ ctkDICOMBrowserPrivate::ctkDICOMBrowserPrivate(ctkDICOMBrowser* parent): q_ptr(p
   IndexerProgress = 0;
   UpdateSchemaProgress = 0;
   ExportProgress = 0;
+  Exporter = 0;
+  ExportCreateDICOMDIR = false;
+  ExportVerifyChecksums = false;
   DisplayImportSummary = true;
   PatientsAddedDuringImport = 0;
   StudiesAddedDuringImport = 0;
@@ -202,6 +215,72 @@ void ctkDICOMBrowserPrivate::showUpdateSchemaDialog()
   UpdateSchemaProgress->show();
 }
 
+//----------------------------------------------------------------------------
+void ctkDICOMBrowserPrivate::showExportDialog()
+{
+  Q_Q(ctkDICOMBrowser);
+  if (ExportProgress == 0)
+    {
+    //
+    // Set up the Export Progress Dialog. It is not modal: the export runs
+    // on a thread pool and the browser remains usable meanwhile.
+    //
+    ExportProgress = new QProgressDialog(q->tr("DICOM Export"), "Cancel", 0, 100, q,
+         Qt::WindowTitleHint | Qt::WindowSystemMenuHint);
+
+    // We don't want the progress dialog to resize itself, so we bypass the label
+    // by creating our own
+    QLabel* progressLabel = new QLabel(q->tr("Initialization..."));
+    ExportProgress->setLabel(progressLabel);
+    ExportProgress->setWindowModality(Qt::NonModal);
+    ExportProgress->setMinimumDuration(0);
+    ExportProgress->setAutoClose(false);
+    ExportProgress->setAutoReset(false);
+
+    q->connect(Exporter, SIGNAL(started(int)),
+            ExportProgress, SLOT(setMaximum(int)));
+    q->connect(Exporter, SIGNAL(progress(int,int)),
+            ExportProgress, SLOT(setValue(int)));
+    q->connect(Exporter, SIGNAL(progress(QString)),
+            progressLabel, SLOT(setText(QString)));
+    q->connect(ExportProgress, SIGNAL(canceled()),
+            Exporter, SLOT(cancel()));
+    }
+  ExportProgress->setValue(0);
+  ExportProgress->show();
+}
+
+//----------------------------------------------------------------------------
+QString ctkDICOMBrowserPrivate::selectExportDirectory()
+{
+  Q_Q(ctkDICOMBrowser);
+  ctkFileDialog* directoryDialog = new ctkFileDialog();
+  directoryDialog->setOption(QFileDialog::DontUseNativeDialog);
+  directoryDialog->setOption(QFileDialog::ShowDirsOnly);
+  directoryDialog->setFileMode(QFileDialog::DirectoryOnly);
+  QWidget* optionsWidget = new QWidget();
+  QVBoxLayout* optionsLayout = new QVBoxLayout(optionsWidget);
+  optionsLayout->setContentsMargins(0, 0, 0, 0);
+  QCheckBox* dicomDirCheckBox = new QCheckBox(
+    q->tr("Create DICOMDIR (media export)"));
+  dicomDirCheckBox->setChecked(ExportCreateDICOMDIR);
+  optionsLayout->addWidget(dicomDirCheckBox);
+  QCheckBox* verifyChecksumsCheckBox = new QCheckBox(
+    q->tr("Verify the copied files (slower)"));
+  verifyChecksumsCheckBox->setChecked(ExportVerifyChecksums);
+  optionsLayout->addWidget(verifyChecksumsCheckBox);
+  directoryDialog->setBottomWidget(optionsWidget);
+  QString dirPath;
+  if (directoryDialog->exec())
+    {
+    dirPath = directoryDialog->selectedFiles()[0];
+    ExportCreateDICOMDIR = dicomDirCheckBox->isChecked();
+    ExportVerifyChecksums = verifyChecksumsCheckBox->isChecked();
+    }
+  delete directoryDialog;
+  return dirPath;
+}
+
 //----------------------------------------------------------------------------
 void ctkDICOMBrowserPrivate::showIndexerDialog()
 {
@@ -372,6 +451,22 @@ void ctkDICOMBrowser::setDisplayImportSummary(bool onOff)
   d->DisplayImportSummary = onOff;
 }
 
+//----------------------------------------------------------------------------
+bool ctkDICOMBrowser::exportVerifyChecksums()
+{
+  Q_D(ctkDICOMBrowser);
+
+  return d->ExportVerifyChecksums;
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMBrowser::setExportVerifyChecksums(bool onOff)
+{
+  Q_D(ctkDICOMBrowser);
+
+  d->ExportVerifyChecksums = onOff;
+}
+
 //----------------------------------------------------------------------------
 int ctkDICOMBrowser::patientsAddedDuringImport()
 {
@@ -537,21 +632,22 @@ void ctkDICOMBrowser::onQueryRetrieveFinished()
 void ctkDICOMBrowser::onRemoveAction()
 {
   Q_D(ctkDICOMBrowser);
+  // The records are removed in one transaction per level, the files
+  // are deleted in the background
   QStringList selectedSeriesUIDs = d->dicomTableManager->currentSeriesSelection();
-
-  foreach (const QString& uid, selectedSeriesUIDs)
+  if (!selectedSeriesUIDs.isEmpty())
     {
-      d->DICOMDatabase->removeSeries(uid);
+    d->DICOMDatabase->removeSeriesList(selectedSeriesUIDs);
     }
   QStringList selectedStudiesUIDs = d->dicomTableManager->currentStudiesSelection();
-  foreach (const QString& uid, selectedStudiesUIDs)
+  if (!selectedStudiesUIDs.isEmpty())
     {
-      d->DICOMDatabase->removeStudy(uid);
+    d->DICOMDatabase->removeStudyList(selectedStudiesUIDs);
     }
   QStringList selectedPatientUIDs = d->dicomTableManager->currentPatientsSelection();
-  foreach (const QString& uid, selectedPatientUIDs)
+  if (!selectedPatientUIDs.isEmpty())
     {
-      d->DICOMDatabase->removePatient(uid);
+    d->DICOMDatabase->removePatientList(selectedPatientUIDs);
     }
   // Update the table views
   d->dicomTableManager->updateTableViews();
@@ -919,26 +1015,16 @@ void ctkDICOMBrowser::onPatientsRightClicked(const QPoint &point)
       && this->confirmDeleteSelectedUIDs(selectedPatientsUIDs))
     {
     qDebug() << "Deleting " << numPatients << " patients";
-    foreach (const QString& uid, selectedPatientsUIDs)
-      {
-      d->DICOMDatabase->removePatient(uid);
-      d->dicomTableManager->updateTableViews();
-      }
+    d->DICOMDatabase->removePatientList(selectedPatientsUIDs);
+    d->dicomTableManager->updateTableViews();
     }
   else if (selectedAction == exportAction)
     {
-    ctkFileDialog* directoryDialog = new ctkFileDialog();
-    directoryDialog->setOption(QFileDialog::DontUseNativeDialog);
-    directoryDialog->setOption(QFileDialog::ShowDirsOnly);
-    directoryDialog->setFileMode(QFileDialog::DirectoryOnly);
-    bool res = directoryDialog->exec();
-    if (res)
+    QString dirPath = d->selectExportDirectory();
+    if (!dirPath.isEmpty())
       {
-      QStringList dirs = directoryDialog->selectedFiles();
-      QString dirPath = dirs[0];
       this->exportSelectedPatients(dirPath, selectedPatientsUIDs);
       }
-    delete directoryDialog;
     }
 }
 
@@ -979,26 +1065,16 @@ void ctkDICOMBrowser::onStudiesRightClicked(const QPoint &point)
   if (selectedAction == deleteAction
       && this->confirmDeleteSelectedUIDs(selectedStudiesUIDs))
     {
-    foreach (const QString& uid, selectedStudiesUIDs)
-      {
-      d->DICOMDatabase->removeStudy(uid);
-      d->dicomTableManager->updateTableViews();
-      }
+    d->DICOMDatabase->removeStudyList(selectedStudiesUIDs);
+    d->dicomTableManager->updateTableViews();
     }
   else if (selectedAction == exportAction)
     {
-    ctkFileDialog* directoryDialog = new ctkFileDialog();
-    directoryDialog->setOption(QFileDialog::DontUseNativeDialog);
-    directoryDialog->setOption(QFileDialog::ShowDirsOnly);
-    directoryDialog->setFileMode(QFileDialog::DirectoryOnly);
-    bool res = directoryDialog->exec();
-    if (res)
+    QString dirPath = d->selectExportDirectory();
+    if (!dirPath.isEmpty())
       {
-      QStringList dirs = directoryDialog->selectedFiles();
-      QString dirPath = dirs[0];
       this->exportSelectedStudies(dirPath, selectedStudiesUIDs);
       }
-    delete directoryDialog;
     }
 }
 
@@ -1038,26 +1114,16 @@ void ctkDICOMBrowser::onSeriesRightClicked(const QPoint &point)
   if (selectedAction == deleteAction
       && this->confirmDeleteSelectedUIDs(selectedSeriesUIDs))
     {
-    foreach (const QString& uid, selectedSeriesUIDs)
-      {
-      d->DICOMDatabase->removeSeries(uid);
-      d->dicomTableManager->updateTableViews();
-      }
+    d->DICOMDatabase->removeSeriesList(selectedSeriesUIDs);
+    d->dicomTableManager->updateTableViews();
     }
   else if (selectedAction == exportAction)
     {
-    ctkFileDialog* directoryDialog = new ctkFileDialog();
-    directoryDialog->setOption(QFileDialog::DontUseNativeDialog);
-    directoryDialog->setOption(QFileDialog::ShowDirsOnly);
-    directoryDialog->setFileMode(QFileDialog::DirectoryOnly);
-    bool res = directoryDialog->exec();
-    if (res)
+    QString dirPath = d->selectExportDirectory();
+    if (!dirPath.isEmpty())
       {
-      QStringList dirs = directoryDialog->selectedFiles();
-      QString dirPath = dirs[0];
       this->exportSelectedSeries(dirPath, selectedSeriesUIDs);
       }
-    delete directoryDialog;
     }
 }
 
@@ -1066,141 +1132,58 @@ void ctkDICOMBrowser::exportSelectedSeries(QString dirPath, QStringList uids)
 {
   Q_D(ctkDICOMBrowser);
 
-  foreach (const QString& uid, uids)
+  if (d->Exporter == 0)
     {
-    QStringList filesForSeries = d->DICOMDatabase->filesForSeries(uid);
-
-    // Use the first file to get the overall series information
-    QString firstFilePath = filesForSeries[0];
-    QHash<QString,QString> descriptions (d->DICOMDatabase->descriptionsForFile(firstFilePath));
-    QString patientName = descriptions["PatientsName"];
-    QString patientIDTag = QString("0010,0020");
-    QString patientID = d->DICOMDatabase->fileValue(firstFilePath, patientIDTag);
-    QString studyDescription = descriptions["StudyDescription"];
-    QString seriesDescription = descriptions["SeriesDescription"];
-    QString studyDateTag = QString("0008,0020");
-    QString studyDate = d->DICOMDatabase->fileValue(firstFilePath,studyDateTag);
-    QString seriesNumberTag = QString("0020,0011");
-    QString seriesNumber = d->DICOMDatabase->fileValue(firstFilePath,seriesNumberTag);
-
-    QString sep = "/";
-    QString nameSep = "-";
-    QString destinationDir = dirPath + sep + patientID;
-    if (!patientName.isEmpty())
-      {
-      destinationDir += nameSep + patientName;
-      }
-    destinationDir += sep + studyDate;
-    if (!studyDescription.isEmpty())
-      {
-      destinationDir += nameSep + studyDescription;
-      }
-    destinationDir += sep + seriesNumber;
-    if (!seriesDescription.isEmpty())
-      {
-      destinationDir += nameSep + seriesDescription;
-      }
-    destinationDir += sep;
-
-    // make sure only ascii characters are in the directory path
-    destinationDir = destinationDir.toLatin1();
-    // replace any question marks that were used as replacements for non ascii
-    // characters with underscore
-    destinationDir.replace("?", "_");
+    d->Exporter = new ctkDICOMExporter(this);
+    connect(d->Exporter, SIGNAL(finished(int,int)),
+            this, SLOT(onExportFinished(int,int)));
+    }
+  if (d->Exporter->isRunning())
+    {
+    ctkMessageBox runningMessageBox;
+    runningMessageBox.setText(this->tr("An export is already in progress."));
+    runningMessageBox.setIcon(QMessageBox::Warning);
+    runningMessageBox.exec();
+    return;
+    }
+  d->Exporter->setDatabase(d->DICOMDatabase);
+  d->Exporter->setCreateDICOMDIR(d->ExportCreateDICOMDIR);
+  d->Exporter->setVerifyChecksums(d->ExportVerifyChecksums);
+  d->showExportDialog();
+  d->Exporter->exportSeries(dirPath, uids);
+}
 
-    // create the destination directory if necessary
-    if (!QDir().exists(destinationDir))
-      {
-      if (!QDir().mkpath(destinationDir))
-        {
-        QString errorString =
-          QString("Unable to create export destination directory:\n\n")
-          + destinationDir
-          + QString("\n\nHalting export.");
-        ctkMessageBox createDirectoryErrorMessageBox;
-        createDirectoryErrorMessageBox.setText(errorString);
-        createDirectoryErrorMessageBox.setIcon(QMessageBox::Warning);
-        createDirectoryErrorMessageBox.exec();
-        return;
-        }
-      }
+//----------------------------------------------------------------------------
+void ctkDICOMBrowser::onExportFinished(int exportedFiles, int failedFiles)
+{
+  Q_D(ctkDICOMBrowser);
+  if (d->ExportProgress)
+    {
+    d->ExportProgress->close();
+    }
+  if (failedFiles == 0)
+    {
+    return;
+    }
 
-    // show progress
-    if (d->ExportProgress == 0)
-      {
-      d->ExportProgress = new QProgressDialog(this->tr("DICOM Export"), "Close", 0, 100, this, Qt::WindowTitleHint | Qt::WindowSystemMenuHint);
-      d->ExportProgress->setWindowModality(Qt::ApplicationModal);
-      d->ExportProgress->setMinimumDuration(0);
-      }
-    QLabel *exportLabel = new QLabel(this->tr("Exporting series ") + seriesNumber);
-    d->ExportProgress->setLabel(exportLabel);
-    d->ExportProgress->setValue(0);
-
-    int fileNumber = 0;
-    int numFiles = filesForSeries.size();
-    d->ExportProgress->setMaximum(numFiles);
-    foreach (const QString& filePath, filesForSeries)
-      {
-      QString destinationFileName = destinationDir;
-
-      QString fileNumberString;
-      // sequentially number the files
-      fileNumberString.sprintf("%06d", fileNumber);
-
-      destinationFileName += fileNumberString + QString(".dcm");
-
-      // replace non ASCII characters
-      destinationFileName = destinationFileName.toLatin1();
-      // replace any question marks that were used as replacements for non ascii
-      // characters with underscore
-      destinationFileName.replace("?", "_");
-
-      if (!QFile::exists(filePath))
-        {
-        d->ExportProgress->setValue(numFiles);
-        QString errorString = QString("Export source file not found:\n\n")
-          + filePath
-          + QString("\n\nHalting export.\n\nError may be fixed via Repair.");
-        ctkMessageBox copyErrorMessageBox;
-        copyErrorMessageBox.setText(errorString);
-        copyErrorMessageBox.setIcon(QMessageBox::Warning);
-        copyErrorMessageBox.exec();
-        return;
-      }
-      if (QFile::exists(destinationFileName))
-        {
-        d->ExportProgress->setValue(numFiles);
-        QString errorString = QString("Export destination file already exists:\n\n")
-          + destinationFileName
-          + QString("\n\nHalting export.");
-        ctkMessageBox copyErrorMessageBox;
-        copyErrorMessageBox.setText(errorString);
-        copyErrorMessageBox.setIcon(QMessageBox::Warning);
-        copyErrorMessageBox.exec();
-        return;
-        }
-
-      bool copyResult = QFile::copy(filePath, destinationFileName);
-      if (!copyResult)
-        {
-        d->ExportProgress->setValue(numFiles);
-        QString errorString = QString("Failed to copy\n\n")
-          + filePath
-          + QString("\n\nto\n\n")
-          + destinationFileName
-          + QString("\n\nHalting export.");
-        ctkMessageBox copyErrorMessageBox;
-        copyErrorMessageBox.setText(errorString);
-        copyErrorMessageBox.setIcon(QMessageBox::Warning);
-        copyErrorMessageBox.exec();
-        return;
-        }
-
-      fileNumber++;
-      d->ExportProgress->setValue(fileNumber);
-      }
-    d->ExportProgress->setValue(numFiles);
+  // Skipped files are reported once the whole export is done
+  QString errorString = QString("%1 files exported, %2 files could not be exported:\n")
+    .arg(exportedFiles).arg(failedFiles);
+  QStringList failed = d->Exporter->failedFiles();
+  QStringList errors = d->Exporter->errors();
+  const int maximumReportedFiles = 10;
+  for (int i = 0; i < failed.count() && i < maximumReportedFiles; ++i)
+    {
+    errorString += QString("\n") + failed[i] + QString(": ") + errors[i];
+    }
+  if (failed.count() > maximumReportedFiles)
+    {
+    errorString += QString("\n...");
     }
+  ctkMessageBox exportErrorMessageBox;
+  exportErrorMessageBox.setText(errorString);
+  exportErrorMessageBox.setIcon(QMessageBox::Warning);
+  exportErrorMessageBox.exec();
 }
 
 //----------------------------------------------------------------------------
@@ -1208,11 +1191,12 @@ void ctkDICOMBrowser::exportSelectedStudies(QString dirPath, QStringList uids)
 {
   Q_D(ctkDICOMBrowser);
 
+  QStringList seriesUIDs;
   foreach (const QString& uid, uids)
     {
-    QStringList seriesUIDs = d->DICOMDatabase->seriesForStudy(uid);
-    this->exportSelectedSeries(dirPath, seriesUIDs);
+    seriesUIDs << d->DICOMDatabase->seriesForStudy(uid);
     }
+  this->exportSelectedSeries(dirPath, seriesUIDs);
 }
 
 //----------------------------------------------------------------------------
@@ -1220,9 +1204,10 @@ void ctkDICOMBrowser::exportSelectedPatients(QString dirPath, QStringList uids)
 {
   Q_D(ctkDICOMBrowser);
 
+  QStringList studiesUIDs;
   foreach (const QString& uid, uids)
     {
-    QStringList studiesUIDs = d->DICOMDatabase->studiesForPatient(uid);
-    this->exportSelectedStudies(dirPath, studiesUIDs);
+    studiesUIDs << d->DICOMDatabase->studiesForPatient(uid);
     }
+  this->exportSelectedStudies(dirPath, studiesUIDs);
 }
@@ -63,6 +63,7 @@ class CTK_DICOM_WIDGETS_EXPORT ctkDICOMBrowser : public QWidget
   Q_PROPERTY(int instancesAddedDuringImport READ instancesAddedDuringImport)
   Q_PROPERTY(QStringList tagsToPrecache READ tagsToPrecache WRITE setTagsToPrecache)
   Q_PROPERTY(bool displayImportSummary READ displayImportSummary WRITE setDisplayImportSummary)
+  Q_PROPERTY(bool exportVerifyChecksums READ exportVerifyChecksums WRITE setExportVerifyChecksums)
   Q_PROPERTY(ctkDICOMBrowser::ImportDirectoryMode ImportDirectoryMode READ importDirectoryMode WRITE setImportDirectoryMode)
 
 public:
@@ -99,6 +100,12 @@ public:
   /// of disabling it for batch modes or testing.
   void setDisplayImportSummary(bool);
   bool displayImportSummary();
+  /// Compare the checksums of the exported files with the originals.
+  /// Reads every file twice, disabled by default. Can also be set in the
+  /// export directory dialog.
+  /// \sa ctkDICOMExporter::setVerifyChecksums
+  void setExportVerifyChecksums(bool);
+  bool exportVerifyChecksums();
   /// Accessors to status of last directory import operation
   int patientsAddedDuringImport();
   int studiesAddedDuringImport();
@@ -218,7 +225,8 @@ protected Q_SLOTS:
     /// Called when a right mouse click is made in the series table
     void onSeriesRightClicked(const QPoint &point);
 
-    /// Called to export the series associated with the selected UIDs
+    /// Called to export the series associated with the selected UIDs.
+    /// The files are copied in the background, see ctkDICOMExporter.
     /// \sa exportSelectedStudies, exportSelectedPatients
     void exportSelectedSeries(QString dirPath, QStringList uids);
     /// Called to export the studies associated with the selected UIDs
@@ -228,6 +236,10 @@ protected Q_SLOTS:
     /// \sa exportSelectedStudies, exportSelectedSeries
     void exportSelectedPatients(QString dirPath, QStringList uids);
 
+    /// Called when the export started by exportSelectedSeries is done.
+    /// Reports the files that could not be exported, if any.
+    void onExportFinished(int exportedFiles, int failedFiles);
+
     /// To be called when dialog finishes
     void onQueryRetrieveFinished();
 
@@ -18,6 +18,10 @@
 
 =========================================================================*/
 
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMListener.h"
+
 // ctkDICOMWidgets includes
 #include "ctkDICOMListenerWidget.h"
 #include "ui_ctkDICOMListenerWidget.h"
@@ -27,11 +31,33 @@ class ctkDICOMListenerWidgetPrivate: public Ui_ctkDICOMListenerWidget
 {
 public:
   ctkDICOMListenerWidgetPrivate(){}
+
+  void updateStatus();
+
+  ctkDICOMListener Listener;
 };
 
 //----------------------------------------------------------------------------
 // ctkDICOMListenerWidgetPrivate methods
 
+//----------------------------------------------------------------------------
+void ctkDICOMListenerWidgetPrivate::updateStatus()
+{
+  bool listening = this->Listener.isListening();
+  this->AETitleLineEdit->setEnabled(!listening);
+  this->PortSpinBox->setEnabled(!listening);
+  this->StartStopButton->blockSignals(true);
+  this->StartStopButton->setChecked(listening);
+  this->StartStopButton->blockSignals(false);
+  this->StartStopButton->setText(listening ? "Stop" : "Start");
+  QString status = listening ? "Listening" : "Stopped";
+  int received = this->Listener.receivedInstanceCount();
+  if (received > 0)
+    {
+    status += QString(" (%1 instances received)").arg(received);
+    }
+  this->StatusLabel->setText(status);
+}
 
 //----------------------------------------------------------------------------
 // ctkDICOMListenerWidget methods
@@ -44,11 +70,87 @@ ctkDICOMListenerWidget::ctkDICOMListenerWidget(QWidget* parentWidget)
   Q_D(ctkDICOMListenerWidget);
 
   d->setupUi(this);
+  d->AETitleLineEdit->setText(d->Listener.AETitle());
+  d->PortSpinBox->setValue(d->Listener.port());
+
+  connect(d->StartStopButton, SIGNAL(toggled(bool)),
+          this, SLOT(onStartStopToggled(bool)));
+  // Signals are emitted from the listener threads, use queued connections
+  connect(&d->Listener, SIGNAL(instanceReceived(QString)),
+          this, SLOT(onInstanceReceived()), Qt::QueuedConnection);
+  connect(&d->Listener, SIGNAL(error(QString)),
+          this, SLOT(onError(QString)), Qt::QueuedConnection);
 }
 
 //----------------------------------------------------------------------------
 ctkDICOMListenerWidget::~ctkDICOMListenerWidget()
 {
+  Q_D(ctkDICOMListenerWidget);
+  d->Listener.stop();
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMListenerWidget::setDatabase(QSharedPointer<ctkDICOMDatabase> database)
+{
+  Q_D(ctkDICOMListenerWidget);
+  bool wasListening = d->Listener.isListening();
+  d->Listener.stop();
+  d->Listener.setDatabase(database);
+  if (wasListening)
+    {
+    this->start();
+    }
+}
+
+//----------------------------------------------------------------------------
+ctkDICOMListener* ctkDICOMListenerWidget::listener()const
+{
+  Q_D(const ctkDICOMListenerWidget);
+  return const_cast<ctkDICOMListener*>(&d->Listener);
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMListenerWidget::start()
+{
+  Q_D(ctkDICOMListenerWidget);
+  d->Listener.setAETitle(d->AETitleLineEdit->text());
+  d->Listener.setPort(d->PortSpinBox->value());
+  d->Listener.start();
+  d->updateStatus();
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMListenerWidget::stop()
+{
+  Q_D(ctkDICOMListenerWidget);
+  d->Listener.stop();
+  d->updateStatus();
 }
 
+//----------------------------------------------------------------------------
+void ctkDICOMListenerWidget::onStartStopToggled(bool start)
+{
+  if (start)
+    {
+    this->start();
+    }
+  else
+    {
+    this->stop();
+    }
+}
 
+//----------------------------------------------------------------------------
+void ctkDICOMListenerWidget::onInstanceReceived()
+{
+  Q_D(ctkDICOMListenerWidget);
+  d->updateStatus();
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMListenerWidget::onError(const QString& message)
+{
+  Q_D(ctkDICOMListenerWidget);
+  d->updateStatus();
+  d->StatusLabel->setText(message);
+}
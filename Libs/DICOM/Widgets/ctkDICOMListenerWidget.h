@@ -22,20 +22,41 @@
 #define __ctkDICOMListenerWidget_h
 
 // Qt includes 
+#include <QSharedPointer>
 #include <QWidget>
 
 #include "ctkDICOMWidgetsExport.h"
 
+class ctkDICOMDatabase;
+class ctkDICOMListener;
 class ctkDICOMListenerWidgetPrivate;
 
 /// \ingroup DICOM_Widgets
+/// User interface for ctkDICOMListener: lets the user choose the AE title
+/// and port and start/stop receiving objects into the database.
 class CTK_DICOM_WIDGETS_EXPORT ctkDICOMListenerWidget : public QWidget
 {
+  Q_OBJECT
 public:
   typedef QWidget Superclass;
   explicit ctkDICOMListenerWidget(QWidget* parent=0);
   virtual ~ctkDICOMListenerWidget();
 
+  /// Database received objects are stored into
+  void setDatabase(QSharedPointer<ctkDICOMDatabase> database);
+
+  /// The underlying C-STORE SCP
+  ctkDICOMListener* listener()const;
+
+public Q_SLOTS:
+  void start();
+  void stop();
+
+protected Q_SLOTS:
+  void onStartStopToggled(bool start);
+  void onInstanceReceived();
+  void onError(const QString& message);
+
 protected:
   QScopedPointer<ctkDICOMListenerWidgetPrivate> d_ptr;
 
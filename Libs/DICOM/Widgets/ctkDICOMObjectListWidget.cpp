@@ -126,6 +126,13 @@ ctkDICOMObjectListWidgetPrivate::~ctkDICOMObjectListWidgetPrivate()
 //----------------------------------------------------------------------------
 void ctkDICOMObjectListWidgetPrivate::setFilterExpressionInModel(qRecursiveTreeProxyFilter* filterModel, const QString& expr)
 {
+  // The model is populated on demand: all the rows must exist to be searched
+  ctkDICOMObjectModel* objectModel = qobject_cast<ctkDICOMObjectModel*>(filterModel->sourceModel());
+  if (objectModel && !expr.isEmpty())
+    {
+    objectModel->fetchAll();
+    }
+
   const QString regexpPrefix("regexp:");
   if (expr.startsWith(regexpPrefix))
     {
@@ -145,7 +152,13 @@ void ctkDICOMObjectListWidgetPrivate::populateDICOMObjectTreeView(const QString&
   this->dicomObjectModel->setFile(fileName);
   this->filterModel->invalidate();
   this->dcmObjectTreeView->setModel(this->filterModel);
-  this->dcmObjectTreeView->expandAll();
+  // Sequences are only expanded (and loaded) on demand, unless
+  // they must be searched
+  if (!this->filterExpression.isEmpty())
+    {
+    this->setFilterExpressionInModel(this->filterModel, this->filterExpression);
+    this->dcmObjectTreeView->expandAll();
+    }
 }
 
 // --------------------------------------------------------------------------
@@ -330,6 +343,7 @@ QString ctkDICOMObjectListWidget::metadataAsText(bool allFiles /*=false*/)
 
       ctkDICOMObjectModel* aDicomObjectModel = new ctkDICOMObjectModel();
       aDicomObjectModel->setFile(fileName);
+      aDicomObjectModel->fetchAll();
 
       qRecursiveTreeProxyFilter* afilterModel = new qRecursiveTreeProxyFilter();
       afilterModel->setSourceModel(aDicomObjectModel);
@@ -353,6 +367,7 @@ QString ctkDICOMObjectListWidget::metadataAsText(bool allFiles /*=false*/)
   else
     {
     // single file
+    d->dicomObjectModel->fetchAll();
     metadata = d->dicomObjectModelAsString(d->filterModel);
     }
   return metadata;
@@ -401,6 +416,10 @@ void ctkDICOMObjectListWidget::setFilterExpression(const QString& expr)
   Q_D(ctkDICOMObjectListWidget);
   d->filterExpression = expr;
   d->setFilterExpressionInModel(d->filterModel, expr);
+  if (!expr.isEmpty())
+    {
+    d->dcmObjectTreeView->expandAll();
+    }
 }
 
 //------------------------------------------------------------------------------
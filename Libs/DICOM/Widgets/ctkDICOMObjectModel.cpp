@@ -20,10 +20,9 @@
 =============================================================================*/
 
 // Qt include
-#include <QSharedData>
-#include <QStandardItem>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 // DCMTK includes
 #include "dcmtk/dcmdata/dcdeftag.h"
@@ -31,6 +30,7 @@
 #include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmdata/dcmetinf.h"
 #include "dcmtk/dcmdata/dcitem.h"
+#include "dcmtk/dcmdata/dcsequen.h"
 #include "dcmtk/ofstd/ofcond.h"
 #include "dcmtk/ofstd/ofstring.h"
 #include "dcmtk/ofstd/ofstd.h"
@@ -38,6 +38,36 @@
 // CTK DICOM Core
 #include "ctkDICOMObjectModel.h"
 
+namespace
+{
+// Number of rows created by each call to fetchMore()
+const int FetchBatchSize = 256;
+// Number of values displayed for multi-valued elements
+const int MaximumDisplayedValues = 64;
+}
+
+//------------------------------------------------------------------------------
+/// A row of the model: a data element, or an item of a sequence.
+/// Nodes are created only when their parent is fetched.
+struct ctkDICOMObjectModelNode
+{
+  ctkDICOMObjectModelNode(DcmObject* object, ctkDICOMObjectModelNode* parent, int row)
+    : Object(object), Parent(parent), Row(row), ValueFormatted(false)
+  {
+  }
+  ~ctkDICOMObjectModelNode()
+  {
+    qDeleteAll(this->Children);
+  }
+
+  DcmObject* Object;
+  ctkDICOMObjectModelNode* Parent;
+  int Row;
+  QVector<ctkDICOMObjectModelNode*> Children;
+  QString Value;
+  bool ValueFormatted;
+};
+
 //------------------------------------------------------------------------------
 class ctkDICOMObjectModelPrivate
 {
@@ -49,21 +79,23 @@ protected:
 public:
   ctkDICOMObjectModelPrivate(ctkDICOMObjectModel&);
   virtual ~ctkDICOMObjectModelPrivate();
-  
+
   void init();
-  void itemInsert( DcmItem *dataset, QStandardItem *parent);
-  void seqInsert( DcmSequenceOfItems *dataset, QStandardItem *parent);
-  QString getTagValue( DcmElement *dcmElem);
-  QStandardItem* populateModelRow(const QString& tagName,const QString& tagHexName,
-  const QString& tagValue, const QString& VRName,
-  const QString& elementLengthQString, QStandardItem *parent);
+  ctkDICOMObjectModelNode* node(const QModelIndex& index)const;
+  static int childCount(DcmObject* object);
+  static DcmObject* child(DcmObject* object, int row);
+  QString getTagValue(ctkDICOMObjectModelNode* node)const;
 
   DcmFileFormat fileFormat;
-  QStandardItem *rootItem;
+  QScopedPointer<ctkDICOMObjectModelNode> rootNode;
+  QStringList horizontalHeaderLabels;
+  int bulkDataThreshold;
 };
 
 //------------------------------------------------------------------------------
-ctkDICOMObjectModelPrivate::ctkDICOMObjectModelPrivate(ctkDICOMObjectModel& o):q_ptr(&o)
+ctkDICOMObjectModelPrivate::ctkDICOMObjectModelPrivate(ctkDICOMObjectModel& o)
+  : q_ptr(&o)
+  , bulkDataThreshold(DCM_MaxReadLength)
 {
 }
 
@@ -75,175 +107,92 @@ ctkDICOMObjectModelPrivate::~ctkDICOMObjectModelPrivate()
 //------------------------------------------------------------------------------
 void ctkDICOMObjectModelPrivate::init()
 {
-  Q_Q(ctkDICOMObjectModel);
-  QStringList horizontalHeaderLabels;
-  horizontalHeaderLabels.append( QString("Tag"));
-  horizontalHeaderLabels.append( QString("Attribute"));
-  horizontalHeaderLabels.append( QString("Value"));
-  horizontalHeaderLabels.append( QString("VR"));
-  horizontalHeaderLabels.append( QString("Length"));
-  q->setHorizontalHeaderLabels(horizontalHeaderLabels);
+  this->horizontalHeaderLabels.append( QString("Tag"));
+  this->horizontalHeaderLabels.append( QString("Attribute"));
+  this->horizontalHeaderLabels.append( QString("Value"));
+  this->horizontalHeaderLabels.append( QString("VR"));
+  this->horizontalHeaderLabels.append( QString("Length"));
 }
 
 //------------------------------------------------------------------------------
-void ctkDICOMObjectModelPrivate::itemInsert( DcmItem *dataset, QStandardItem *parent)
+ctkDICOMObjectModelNode* ctkDICOMObjectModelPrivate::node(const QModelIndex& index)const
 {
-  DcmStack stack;
-  dataset->nextObject( stack, OFTrue);
-  for( ; stack.top(); dataset->nextObject( stack, OFFalse))
+  if (!index.isValid())
     {
-    DcmObject *dO =  stack.top();
-    // put in the visit node function
-    QString tagValue = "";
-    DcmTag tag = dO->getTag();
-	  // std::cout<<tag;
-    QString tagName = tag.getTagName();
-    //
-    DcmTagKey tagX = tag.getXTag();
-    QString tagHexName = tagX.toString().c_str();
-    //
-    DcmVR VR = dO->getVR();
-    QString VRName = VR.getVRName();
-    //
-    // Getting length
-    int elementLength;
-    elementLength = dO->getLength();
-    QString elementLengthQString = QString::number(elementLength);
-    //
-    DcmTag tagKey = tag.getXTag();
-    if( tagKey == DCM_SequenceDelimitationItem
-        || tagKey == DCM_ItemDelimitationItem
-        || "Item" == tagName)
-      {
-      return;
-      }
-
-    DcmElement *dcmElem = dynamic_cast<DcmElement *> (dO);
-    tagValue = getTagValue(dcmElem);
-
-    // Populate QStandardModel with current DICOM element tag name and value
-    QStandardItem *tagItem = populateModelRow(tagName,tagHexName,tagValue,VRName,elementLengthQString,parent);
-
-    // Check if the DICOM object is a SQ Data element and extract the nested DICOM objects
-    if( dcmElem && !dcmElem->isLeaf())
-      {
-      // now dcmElem points to a sequence of items
-      ctkDICOMObjectModelPrivate::seqInsert( dynamic_cast<DcmSequenceOfItems*> (dcmElem), tagItem);
-      }
-  }
+    return this->rootNode.data();
+    }
+  return static_cast<ctkDICOMObjectModelNode*>(index.internalPointer());
 }
 
 //------------------------------------------------------------------------------
-void ctkDICOMObjectModelPrivate::seqInsert( DcmSequenceOfItems *dataset, QStandardItem *parent)
+int ctkDICOMObjectModelPrivate::childCount(DcmObject* object)
 {
-  DcmObject *dO = dataset->nextInContainer(NULL);
-
-  for( ; dO; dO = dataset->nextInContainer(dO))
+  // Sequences contain items, items (and the dataset) contain elements
+  if (DcmSequenceOfItems* sequence = dynamic_cast<DcmSequenceOfItems*>(object))
     {
-    DcmElement *dcmElem = dynamic_cast<DcmElement *> (dO);
-    QString tagValue = "";
-    DcmTag tag = dO->getTag();
-    DcmTag tagKey = tag.getXTag();
-    if( tagKey == DCM_SequenceDelimitationItem
-        || tagKey == DCM_ItemDelimitationItem)
-      {
-      return;
-      }
-
-    QString tagName = tag.getTagName();
-    DcmTagKey tagX = tag.getXTag();
-    QString tagHexName = tagX.toString().c_str();
-    DcmVR VR = dO->getVR();
-    QString VRName = VR.getVRName();
-
-    // Getting length
-    int elementLength;
-    elementLength = dO->getLength();
-    QString elementLengthQString = QString::number(elementLength);
-
-    if( dcmElem)
-      {
-      tagValue = getTagValue(dcmElem);
-      }
-
-    QStandardItem *tagItem = populateModelRow(tagName,tagHexName,tagValue,VRName,elementLengthQString,parent);
+    return static_cast<int>(sequence->card());
+    }
+  if (DcmItem* item = dynamic_cast<DcmItem*>(object))
+    {
+    return static_cast<int>(item->card());
+    }
+  return 0;
+}
 
-   if( dcmElem && !dcmElem->isLeaf())
-      {
-      ctkDICOMObjectModelPrivate::seqInsert( dynamic_cast<DcmSequenceOfItems*> (dcmElem), tagItem);
-      }
-    else if( tag.getXTag() == DCM_Item)
-      {
-      itemInsert( dynamic_cast<DcmItem*> (dO), tagItem);
-      }
-   }
+//------------------------------------------------------------------------------
+DcmObject* ctkDICOMObjectModelPrivate::child(DcmObject* object, int row)
+{
+  if (DcmSequenceOfItems* sequence = dynamic_cast<DcmSequenceOfItems*>(object))
+    {
+    return sequence->getItem(row);
+    }
+  if (DcmItem* item = dynamic_cast<DcmItem*>(object))
+    {
+    return item->getElement(row);
+    }
+  return 0;
 }
 
 //------------------------------------------------------------------------------
-QString ctkDICOMObjectModelPrivate::getTagValue( DcmElement *dcmElem)
+QString ctkDICOMObjectModelPrivate::getTagValue(ctkDICOMObjectModelNode* node)const
 {
-  QString tagValue = "";
-  std::ostringstream value;
+  DcmElement *dcmElem = dynamic_cast<DcmElement *>(node->Object);
+  if (!dcmElem || !dcmElem->isLeaf())
+    {
+    return QString();
+    }
+  // Large values have not been read from the file: reading them here
+  // would defeat the purpose of the threshold.
+  if (dcmElem->getLength() > static_cast<Uint32>(this->bulkDataThreshold))
+    {
+    return QString("(%1 bytes not loaded)").arg(dcmElem->getLength());
+    }
+
+  QString tagValue;
   OFString part;
-  std::string sep;
   int mult = dcmElem->getVM();
-  int pos;
-
-  if( mult>1)
+  if (mult > 1)
     {
-    value << "[" << mult << "] ";
+    tagValue = QString("[%1] ").arg(mult);
     }
-
-  for( pos=0; pos < mult; pos++)
+  QString sep;
+  int pos;
+  for (pos = 0; pos < mult && pos < MaximumDisplayedValues; pos++)
     {
-    value << sep;
-    OFCondition status = dcmElem->getOFString( part, pos);
-    if( status.good())
+    OFCondition status = dcmElem->getOFString(part, pos);
+    if (status.good())
       {
-      value << part.c_str();
+      tagValue += sep + QString::fromLatin1(part.c_str());
       sep = ", ";
       }
     }
-    if( pos < mult-1)
-      {
-      value << " ...";
-      }
-  tagValue = value.str().c_str();
-
+  if (pos < mult)
+    {
+    tagValue += " ...";
+    }
   return tagValue;
 }
 
-//------------------------------------------------------------------------------
-QStandardItem* ctkDICOMObjectModelPrivate::populateModelRow(const QString& tagName,
-   const QString& tagHexName, const QString& tagValue,const QString& VRName,
-   const QString& elementLengthQString, QStandardItem *parent)
-{
-  // Create items
-  QStandardItem *VRItem = new QStandardItem( VRName);
-  QStandardItem *tagItem = new QStandardItem( tagName);
-  QStandardItem *tagHexItem = new QStandardItem( tagHexName);
-  QStandardItem *lengthItem = new QStandardItem( elementLengthQString);
-  QStandardItem *valItem = new QStandardItem( tagValue);
-
-  VRItem->setFlags(VRItem->flags() & ~Qt::ItemIsEditable);
-  tagItem->setFlags(tagItem->flags() & ~Qt::ItemIsEditable);
-  tagHexItem->setFlags(tagHexItem->flags() & ~Qt::ItemIsEditable);
-  lengthItem->setFlags(lengthItem->flags() & ~Qt::ItemIsEditable);
-  valItem->setFlags(valItem->flags() & ~Qt::ItemIsEditable);
-
-  // Insert items
-  QList<QStandardItem *> modelRow;
-
-  modelRow.append( tagHexItem);
-  modelRow.append( tagItem);
-  modelRow.append( valItem);
-  modelRow.append( VRItem);
-  modelRow.append( lengthItem);
-  parent->appendRow( modelRow);
-
-  return tagHexItem;
-}
-
 //------------------------------------------------------------------------------
 ctkDICOMObjectModel::ctkDICOMObjectModel(QObject* parentObject)
   : Superclass(parentObject)
@@ -263,19 +212,216 @@ void ctkDICOMObjectModel::setFile(const QString &fileName)
 {
   Q_D(ctkDICOMObjectModel);
 
-  OFCondition status = d->fileFormat.loadFile( fileName.toLatin1().data());
+  this->beginResetModel();
+  d->rootNode.reset();
+  // Values above the threshold are not loaded in memory
+  OFCondition status = d->fileFormat.loadFile( fileName.toLatin1().data(),
+    EXS_Unknown, EGL_noChange, static_cast<Uint32>(d->bulkDataThreshold));
   if( !status.good() )
     {
     // TODO: Through an error message.
     }
 
+  // Only the top-level rows are created here
   DcmDataset *dataset = d->fileFormat.getDataset();
-  d->rootItem = this->invisibleRootItem();
+  d->rootNode.reset(new ctkDICOMObjectModelNode(dataset, 0, 0));
+  int count = ctkDICOMObjectModelPrivate::childCount(dataset);
+  d->rootNode->Children.reserve(count);
+  for (int row = 0; row < count; ++row)
+    {
+    d->rootNode->Children.append(new ctkDICOMObjectModelNode(
+      ctkDICOMObjectModelPrivate::child(dataset, row), d->rootNode.data(), row));
+    }
+  this->endResetModel();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMObjectModel::clear()
+{
+  Q_D(ctkDICOMObjectModel);
+  this->beginResetModel();
+  d->rootNode.reset();
+  d->fileFormat.clear();
+  this->endResetModel();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMObjectModel::setBulkDataThreshold(int bytes)
+{
+  Q_D(ctkDICOMObjectModel);
+  d->bulkDataThreshold = qMax(0, bytes);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMObjectModel::bulkDataThreshold()const
+{
+  Q_D(const ctkDICOMObjectModel);
+  return d->bulkDataThreshold;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMObjectModel::fetchAll(const QModelIndex& parent)
+{
+  while (this->canFetchMore(parent))
+    {
+    this->fetchMore(parent);
+    }
+  int rows = this->rowCount(parent);
+  for (int row = 0; row < rows; ++row)
+    {
+    this->fetchAll(this->index(row, 0, parent));
+    }
+}
+
+//------------------------------------------------------------------------------
+QModelIndex ctkDICOMObjectModel::index(int row, int column, const QModelIndex& parent)const
+{
+  Q_D(const ctkDICOMObjectModel);
+  ctkDICOMObjectModelNode* parentNode = d->node(parent);
+  if (!parentNode || (parent.isValid() && parent.column() != 0)
+      || row < 0 || row >= parentNode->Children.count()
+      || column < 0 || column >= d->horizontalHeaderLabels.count())
+    {
+    return QModelIndex();
+    }
+  return this->createIndex(row, column, parentNode->Children[row]);
+}
+
+//------------------------------------------------------------------------------
+QModelIndex ctkDICOMObjectModel::parent(const QModelIndex& index)const
+{
+  Q_D(const ctkDICOMObjectModel);
+  if (!index.isValid())
+    {
+    return QModelIndex();
+    }
+  ctkDICOMObjectModelNode* parentNode = d->node(index)->Parent;
+  if (!parentNode || parentNode == d->rootNode.data())
+    {
+    return QModelIndex();
+    }
+  return this->createIndex(parentNode->Row, 0, parentNode);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMObjectModel::rowCount(const QModelIndex& parent)const
+{
+  Q_D(const ctkDICOMObjectModel);
+  ctkDICOMObjectModelNode* parentNode = d->node(parent);
+  if (!parentNode || parent.column() > 0)
+    {
+    return 0;
+    }
+  return parentNode->Children.count();
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMObjectModel::columnCount(const QModelIndex& parent)const
+{
+  Q_D(const ctkDICOMObjectModel);
+  Q_UNUSED(parent);
+  return d->horizontalHeaderLabels.count();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMObjectModel::hasChildren(const QModelIndex& parent)const
+{
+  Q_D(const ctkDICOMObjectModel);
+  ctkDICOMObjectModelNode* parentNode = d->node(parent);
+  if (!parentNode || parent.column() > 0)
+    {
+    return false;
+    }
+  return ctkDICOMObjectModelPrivate::childCount(parentNode->Object) > 0;
+}
 
-  if(d->rootItem->hasChildren())
+//------------------------------------------------------------------------------
+bool ctkDICOMObjectModel::canFetchMore(const QModelIndex& parent)const
+{
+  Q_D(const ctkDICOMObjectModel);
+  ctkDICOMObjectModelNode* parentNode = d->node(parent);
+  if (!parentNode || parent.column() > 0)
     {
-    d->rootItem->removeRows(0, d->rootItem->rowCount());
+    return false;
     }
+  return parentNode->Children.count() <
+    ctkDICOMObjectModelPrivate::childCount(parentNode->Object);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMObjectModel::fetchMore(const QModelIndex& parent)
+{
+  Q_D(ctkDICOMObjectModel);
+  if (!this->canFetchMore(parent))
+    {
+    return;
+    }
+  ctkDICOMObjectModelNode* parentNode = d->node(parent);
+  int first = parentNode->Children.count();
+  int last = qMin(ctkDICOMObjectModelPrivate::childCount(parentNode->Object),
+                  first + FetchBatchSize) - 1;
+  this->beginInsertRows(parent, first, last);
+  for (int row = first; row <= last; ++row)
+    {
+    parentNode->Children.append(new ctkDICOMObjectModelNode(
+      ctkDICOMObjectModelPrivate::child(parentNode->Object, row), parentNode, row));
+    }
+  this->endInsertRows();
+}
 
-  d->itemInsert( dataset, d->rootItem);
+//------------------------------------------------------------------------------
+QVariant ctkDICOMObjectModel::data(const QModelIndex& index, int role)const
+{
+  Q_D(const ctkDICOMObjectModel);
+  if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::ToolTipRole))
+    {
+    return QVariant();
+    }
+  ctkDICOMObjectModelNode* node = d->node(index);
+  DcmObject* object = node->Object;
+  DcmTag tag = object->getTag();
+  switch (index.column())
+    {
+    case TagColumn:
+      return QString(tag.getXTag().toString().c_str());
+    case AttributeColumn:
+      return QString(tag.getTagName());
+    case ValueColumn:
+      if (!node->ValueFormatted)
+        {
+        node->Value = d->getTagValue(node);
+        node->ValueFormatted = true;
+        }
+      return node->Value;
+    case VRColumn:
+      return QString(DcmVR(object->getVR()).getVRName());
+    case LengthColumn:
+      return QString::number(object->getLength());
+    default:
+      break;
+    }
+  return QVariant();
+}
+
+//------------------------------------------------------------------------------
+QVariant ctkDICOMObjectModel::headerData(int section, Qt::Orientation orientation,
+                                         int role)const
+{
+  Q_D(const ctkDICOMObjectModel);
+  if (orientation == Qt::Horizontal && role == Qt::DisplayRole
+      && section >= 0 && section < d->horizontalHeaderLabels.count())
+    {
+    return d->horizontalHeaderLabels[section];
+    }
+  return this->Superclass::headerData(section, orientation, role);
+}
+
+//------------------------------------------------------------------------------
+Qt::ItemFlags ctkDICOMObjectModel::flags(const QModelIndex& index)const
+{
+  if (!index.isValid())
+    {
+    return Qt::NoItemFlags;
+    }
+  return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
 }
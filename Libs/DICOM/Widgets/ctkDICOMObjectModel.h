@@ -22,12 +22,9 @@
 #ifndef __ctkDICOMObjectModel_h
 #define __ctkDICOMObjectModel_h
 
-// STD includes
-#include <string>
-
 // Qt includes
+#include <QAbstractItemModel>
 #include <QMetaType>
-#include <QStandardItemModel>
 #include <QString>
 
 #include "ctkDICOMWidgetsExport.h"
@@ -35,14 +32,23 @@
 class ctkDICOMObjectModelPrivate;
 /// \ingroup DICOM_Widgets
 ///
-/// \brief Provides a Qt MVC-compatible wrapper around a ctkDICOMItem.
+/// \brief Provides a Qt MVC-compatible wrapper around the elements of a DICOM file.
+///
+/// The model is populated lazily: the rows of a sequence or item are created
+/// only when the sequence or item is expanded (see canFetchMore() and
+/// fetchMore()), and element values are formatted on demand in data().
+/// Values larger than bulkDataThreshold (e.g. the pixel data) are not read
+/// from the file at all, which allows to inspect the header of very large
+/// objects.
 ///
 class CTK_DICOM_WIDGETS_EXPORT ctkDICOMObjectModel
-  : public QStandardItemModel
+  : public QAbstractItemModel
 {
   Q_OBJECT
-  typedef QStandardItemModel Superclass;
-  //Q_PROPERTY(setFile);
+  typedef QAbstractItemModel Superclass;
+  /// Size (in bytes) above which element values are not loaded
+  /// (and not displayed). 4096 by default.
+  Q_PROPERTY(int bulkDataThreshold READ bulkDataThreshold WRITE setBulkDataThreshold);
   Q_ENUMS(ColumnIndex)
 
 public:
@@ -51,6 +57,17 @@ public:
   virtual ~ctkDICOMObjectModel();
   Q_INVOKABLE void setFile (const QString& fileName);
 
+  /// Remove all rows and release the file.
+  Q_INVOKABLE void clear();
+
+  /// Only affects the next call to setFile().
+  void setBulkDataThreshold(int bytes);
+  int bulkDataThreshold()const;
+
+  /// Create all the rows below \a parent (recursively), e.g. before
+  /// searching or exporting the whole content of the model.
+  Q_INVOKABLE void fetchAll(const QModelIndex& parent = QModelIndex());
+
   enum ColumnIndex
     {
     TagColumn = 0,
@@ -60,6 +77,18 @@ public:
     LengthColumn = 4
     };
 
+  virtual QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex())const;
+  virtual QModelIndex parent(const QModelIndex& index)const;
+  virtual int rowCount(const QModelIndex& parent = QModelIndex())const;
+  virtual int columnCount(const QModelIndex& parent = QModelIndex())const;
+  virtual bool hasChildren(const QModelIndex& parent = QModelIndex())const;
+  virtual bool canFetchMore(const QModelIndex& parent)const;
+  virtual void fetchMore(const QModelIndex& parent);
+  virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole)const;
+  virtual QVariant headerData(int section, Qt::Orientation orientation,
+                              int role = Qt::DisplayRole)const;
+  virtual Qt::ItemFlags flags(const QModelIndex& index)const;
+
 protected:
   QScopedPointer<ctkDICOMObjectModelPrivate> d_ptr;
 
@@ -0,0 +1,416 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkPluginFrameworkBenchmarkConfigure.h"
+
+#include <ctkCommandLineParser.h>
+#include <ctkException.h>
+#include <ctkHighPrecisionTimer.h>
+#include <ctkPlugin.h>
+#include <ctkPluginConstants.h>
+#include <ctkPluginContext.h>
+#include <ctkPluginFrameworkLauncher.h>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QUrl>
+
+#include <cstdlib>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct ctkPluginFrameworkBenchmarkResult
+{
+  QString name;
+  int count;
+  double milliseconds;
+};
+
+//----------------------------------------------------------------------------
+class ctkPluginFrameworkBenchmarkResults
+{
+public:
+
+  void add(const QString& name, int count, qint64 microseconds)
+  {
+    ctkPluginFrameworkBenchmarkResult result;
+    result.name = name;
+    result.count = count;
+    result.milliseconds = microseconds / 1000.0;
+    results << result;
+
+    QTextStream out(stdout);
+    out << qSetFieldWidth(32) << left << name << qSetFieldWidth(0)
+        << QString::number(result.milliseconds, 'f', 3) << " ms for "
+        << count << " (" << QString::number(perItem(result), 'f', 3) << " ms each)\n";
+  }
+
+  static double perItem(const ctkPluginFrameworkBenchmarkResult& result)
+  {
+    return result.count ? result.milliseconds / result.count : 0.0;
+  }
+
+  /**
+   * Writes the results as JSON. The format is versioned so that scripts
+   * comparing runs of different CTK versions can detect changes.
+   */
+  bool writeJSON(const QString& fileName, int plugins, int repetitions, int lookups) const
+  {
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+      return false;
+    }
+    QTextStream out(&file);
+    out << "{\n";
+    out << "  \"format\": \"ctkPluginFrameworkBenchmark\",\n";
+    out << "  \"formatVersion\": 1,\n";
+    out << "  \"date\": \"" << QDateTime::currentDateTime().toString(Qt::ISODate) << "\",\n";
+    out << "  \"qtVersion\": \"" << qVersion() << "\",\n";
+    out << "  \"plugins\": {\n";
+    out << "    \"count\": " << plugins << ",\n";
+    out << "    \"dependencyGraph\": \"" << CTK_PLUGINFW_BENCHMARK_GRAPH << "\",\n";
+    out << "    \"dependencies\": " << CTK_PLUGINFW_BENCHMARK_DEPENDENCIES << ",\n";
+    out << "    \"manifestHeaders\": " << CTK_PLUGINFW_BENCHMARK_MANIFEST_HEADERS << ",\n";
+    out << "    \"resources\": " << CTK_PLUGINFW_BENCHMARK_RESOURCES << "\n";
+    out << "  },\n";
+    out << "  \"warmStartRepetitions\": " << repetitions << ",\n";
+    out << "  \"resourceLookups\": " << lookups << ",\n";
+    out << "  \"results\": [\n";
+    for (int i = 0; i < results.count(); ++i)
+    {
+      const ctkPluginFrameworkBenchmarkResult& result = results[i];
+      out << "    { \"name\": \"" << result.name << "\""
+          << ", \"count\": " << result.count
+          << ", \"totalMs\": " << QString::number(result.milliseconds, 'f', 3)
+          << ", \"perItemMs\": " << QString::number(perItem(result), 'f', 6)
+          << " }" << (i + 1 < results.count() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return true;
+  }
+
+private:
+
+  QList<ctkPluginFrameworkBenchmarkResult> results;
+};
+
+//----------------------------------------------------------------------------
+int pluginIndex(const QString& symbolicName)
+{
+  // pluginBench<i>.test
+  return symbolicName.mid(11, symbolicName.size() - 16).toInt();
+}
+
+//----------------------------------------------------------------------------
+bool pluginIndexLessThan(const QString& left, const QString& right)
+{
+  return pluginIndex(left) < pluginIndex(right);
+}
+
+//----------------------------------------------------------------------------
+QString resourcePath(int index)
+{
+  return QString("CTK-INF/benchmark/resource%1.txt").arg(index);
+}
+
+//----------------------------------------------------------------------------
+bool checkStates(const QList<QSharedPointer<ctkPlugin> >& plugins,
+                 ctkPlugin::States states, const QString& phase)
+{
+  foreach(const QSharedPointer<ctkPlugin>& plugin, plugins)
+  {
+    if (!(states & plugin->getState()))
+    {
+      QTextStream(stderr) << "Plug-in " << plugin->getSymbolicName()
+                          << " is in state " << static_cast<int>(plugin->getState())
+                          << " after " << phase << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+QList<QSharedPointer<ctkPlugin> > syntheticPlugins(ctkPluginContext* context,
+                                                   const QStringList& symbolicNames)
+{
+  QList<QSharedPointer<ctkPlugin> > plugins;
+  foreach(const QString& symbolicName, symbolicNames)
+  {
+    foreach(const QSharedPointer<ctkPlugin>& plugin, context->getPlugins())
+    {
+      if (plugin->getSymbolicName() == symbolicName)
+      {
+        plugins << plugin;
+        break;
+      }
+    }
+  }
+  return plugins;
+}
+
+//----------------------------------------------------------------------------
+ctkProperties frameworkProperties(const QString& storage, bool clean,
+                                  const QStringList& symbolicNames)
+{
+  ctkProperties fwProps;
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE, storage);
+  if (clean)
+  {
+    fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN,
+                   ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT);
+  }
+  if (!symbolicNames.isEmpty())
+  {
+    fwProps.insert(ctkPluginFrameworkLauncher::PROP_PLUGINS, symbolicNames.join(","));
+  }
+#if defined(Q_CC_GNU) && ((__GNUC__ < 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ < 5)))
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_PLUGIN_LOAD_HINTS, QVariant::fromValue<QLibrary::LoadHints>(QLibrary::ExportExternalSymbolsHint));
+#endif
+  return fwProps;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  QCoreApplication app(argc, argv);
+
+  app.setOrganizationName("CTK");
+  app.setOrganizationDomain("commontk.org");
+  app.setApplicationName("ctkPluginFrameworkBenchmark");
+
+  QString defaultPluginDir;
+#ifdef CMAKE_INTDIR
+  defaultPluginDir = qApp->applicationDirPath() + "/../benchmark_plugins/" CMAKE_INTDIR "/";
+#else
+  defaultPluginDir = qApp->applicationDirPath() + "/benchmark_plugins/";
+#endif
+
+  ctkCommandLineParser parser;
+  parser.setArgumentPrefix("--", "-");
+  parser.setStrictModeEnabled(true);
+  parser.addArgument("plugin-dir", "", QVariant::String,
+                     "Directory containing the synthetic plug-ins.", defaultPluginDir);
+  parser.addArgument("storage", "", QVariant::String,
+                     "Plug-in framework storage directory. It is cleaned on the cold start.",
+                     QDir::temp().absoluteFilePath("ctkPluginFrameworkBenchmark"));
+  parser.addArgument("repetitions", "", QVariant::Int,
+                     "Number of warm framework starts.", 3);
+  parser.addArgument("lookups", "", QVariant::Int,
+                     "Number of times the resources of each plug-in are looked up.", 10);
+  parser.addArgument("output", "o", QVariant::String,
+                     "JSON file the results are written to.");
+  parser.addArgument("help", "h", QVariant::Bool, "Print this help text.");
+
+  QTextStream out(stdout);
+  bool ok = false;
+  QHash<QString, QVariant> args = parser.parseArguments(app.arguments(), &ok);
+  if (!ok)
+  {
+    out << "Error parsing command line arguments: " << parser.errorString() << "\n";
+    return EXIT_FAILURE;
+  }
+  if (args.contains("help"))
+  {
+    out << "Usage:\n" << parser.helpText();
+    return EXIT_SUCCESS;
+  }
+
+  const QString pluginDir = args.value("plugin-dir", defaultPluginDir).toString();
+  const QString storage = args.value("storage",
+    QDir::temp().absoluteFilePath("ctkPluginFrameworkBenchmark")).toString();
+  const int repetitions = qMax(1, args.value("repetitions", 3).toInt());
+  const int lookups = qMax(1, args.value("lookups", 10).toInt());
+
+  ctkPluginFrameworkLauncher::addSearchPath(pluginDir);
+
+  QStringList symbolicNames;
+  foreach(const QString& symbolicName, ctkPluginFrameworkLauncher::getPluginSymbolicNames(pluginDir))
+  {
+    if (symbolicName.startsWith("pluginBench"))
+    {
+      symbolicNames << symbolicName;
+    }
+  }
+  qSort(symbolicNames.begin(), symbolicNames.end(), pluginIndexLessThan);
+  const int nPlugins = symbolicNames.size();
+  if (nPlugins != CTK_PLUGINFW_BENCHMARK_PLUGINS)
+  {
+    QTextStream(stderr) << "Found " << nPlugins << " synthetic plug-ins in " << pluginDir
+                        << " instead of " << CTK_PLUGINFW_BENCHMARK_PLUGINS << "\n";
+    return EXIT_FAILURE;
+  }
+
+  QStringList pluginPaths;
+  foreach(const QString& symbolicName, symbolicNames)
+  {
+    pluginPaths << ctkPluginFrameworkLauncher::getPluginPath(symbolicName);
+  }
+
+  ctkPluginFrameworkBenchmarkResults results;
+  ctkHighPrecisionTimer t;
+
+  try
+  {
+    //
+    // Framework cold start: empty storage, all plug-ins are installed,
+    // resolved and started by the launcher
+    //
+    ctkPluginFrameworkLauncher::setFrameworkProperties(frameworkProperties(storage, true, symbolicNames));
+    t.start();
+    ctkPluginContext* context = ctkPluginFrameworkLauncher::startup(0);
+    results.add("launcher.coldStart", 1, t.elapsedMicro());
+    if (!checkStates(syntheticPlugins(context, symbolicNames), ctkPlugin::ACTIVE, "the cold start"))
+    {
+      return EXIT_FAILURE;
+    }
+
+    t.start();
+    ctkPluginFrameworkLauncher::shutdown();
+    results.add("launcher.shutdown", 1, t.elapsedMicro());
+
+    //
+    // Framework warm start: the plug-ins are read from the storage
+    //
+    ctkPluginFrameworkLauncher::setFrameworkProperties(frameworkProperties(storage, false, symbolicNames));
+    qint64 warmStart = 0;
+    for (int i = 0; i < repetitions; ++i)
+    {
+      t.start();
+      context = ctkPluginFrameworkLauncher::startup(0);
+      warmStart += t.elapsedMicro();
+      if (!checkStates(syntheticPlugins(context, symbolicNames), ctkPlugin::ACTIVE, "a warm start"))
+      {
+        return EXIT_FAILURE;
+      }
+      ctkPluginFrameworkLauncher::shutdown();
+    }
+    results.add("launcher.warmStart", repetitions, warmStart);
+
+    //
+    // Single lifecycle phases on a clean framework
+    //
+    ctkPluginFrameworkLauncher::setFrameworkProperties(frameworkProperties(storage, true, QStringList()));
+    context = ctkPluginFrameworkLauncher::startup(0);
+
+    QList<QSharedPointer<ctkPlugin> > plugins;
+    t.start();
+    foreach(const QString& pluginPath, pluginPaths)
+    {
+      plugins << context->installPlugin(QUrl::fromLocalFile(pluginPath));
+    }
+    results.add("plugin.install", nPlugins, t.elapsedMicro());
+    if (!checkStates(plugins, ctkPlugin::INSTALLED, "installing")) return EXIT_FAILURE;
+
+    t.start();
+    foreach(const QSharedPointer<ctkPlugin>& plugin, plugins)
+    {
+      ctkPluginFrameworkLauncher::resolve(plugin);
+    }
+    results.add("plugin.resolve", nPlugins, t.elapsedMicro());
+    if (!checkStates(plugins, ctkPlugin::RESOLVED, "resolving")) return EXIT_FAILURE;
+
+    t.start();
+    foreach(const QSharedPointer<ctkPlugin>& plugin, plugins)
+    {
+      plugin->start();
+    }
+    results.add("plugin.start", nPlugins, t.elapsedMicro());
+    if (!checkStates(plugins, ctkPlugin::ACTIVE, "starting")) return EXIT_FAILURE;
+
+    int nWrong = 0;
+    t.start();
+    for (int i = 0; i < lookups; ++i)
+    {
+      foreach(const QSharedPointer<ctkPlugin>& plugin, plugins)
+      {
+        for (int r = 0; r < CTK_PLUGINFW_BENCHMARK_RESOURCES; ++r)
+        {
+          if (plugin->getResource(resourcePath(r)).isEmpty()) ++nWrong;
+        }
+      }
+    }
+    results.add("resource.getResource", lookups * nPlugins * CTK_PLUGINFW_BENCHMARK_RESOURCES,
+                t.elapsedMicro());
+
+    t.start();
+    for (int i = 0; i < lookups; ++i)
+    {
+      foreach(const QSharedPointer<ctkPlugin>& plugin, plugins)
+      {
+        if (plugin->findResources("CTK-INF/benchmark", "*.txt", false).size() !=
+            CTK_PLUGINFW_BENCHMARK_RESOURCES)
+        {
+          ++nWrong;
+        }
+      }
+    }
+    results.add("resource.findResources", lookups * nPlugins, t.elapsedMicro());
+    if (nWrong)
+    {
+      QTextStream(stderr) << nWrong << " resource lookups failed\n";
+      return EXIT_FAILURE;
+    }
+
+    // stop the dependent plug-ins first
+    t.start();
+    for (int i = nPlugins - 1; i >= 0; --i)
+    {
+      plugins[i]->stop();
+    }
+    results.add("plugin.stop", nPlugins, t.elapsedMicro());
+    if (!checkStates(plugins, ctkPlugin::RESOLVED, "stopping")) return EXIT_FAILURE;
+
+    t.start();
+    for (int i = nPlugins - 1; i >= 0; --i)
+    {
+      plugins[i]->uninstall();
+    }
+    results.add("plugin.uninstall", nPlugins, t.elapsedMicro());
+    if (!checkStates(plugins, ctkPlugin::UNINSTALLED, "uninstalling")) return EXIT_FAILURE;
+
+    ctkPluginFrameworkLauncher::shutdown();
+  }
+  catch (const ctkException& e)
+  {
+    QTextStream(stderr) << "Benchmark failed: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (args.contains("output") &&
+      !results.writeJSON(args.value("output").toString(), nPlugins, repetitions, lookups))
+  {
+    QTextStream(stderr) << "Failed to write " << args.value("output").toString() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
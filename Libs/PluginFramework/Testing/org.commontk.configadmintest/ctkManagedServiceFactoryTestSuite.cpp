@@ -29,6 +29,7 @@
 #include <service/cm/ctkConfigurationAdmin.h>
 
 #include <QTest>
+#include <QTime>
 
 //----------------------------------------------------------------------------
 _ManagedServiceFactoryUpdateTest::_ManagedServiceFactoryUpdateTest(ctkManagedServiceFactoryTestSuite* ts)
@@ -66,6 +67,60 @@ void _ManagedServiceFactoryUpdateTest::updated(const QString& pid, const ctkDict
   ts->updateCount++;
 }
 
+//----------------------------------------------------------------------------
+_ManagedServiceFactoryConcurrencyTest::_ManagedServiceFactoryConcurrencyTest()
+  : activeCalls(0), maxActiveCalls(0)
+{
+
+}
+
+//----------------------------------------------------------------------------
+void _ManagedServiceFactoryConcurrencyTest::deleted(const QString& pid)
+{
+  enter();
+  {
+    QMutexLocker l(&mutex);
+    lastProperties.remove(pid);
+  }
+  leave();
+}
+
+//----------------------------------------------------------------------------
+QString _ManagedServiceFactoryConcurrencyTest::getName()
+{
+  return QString();
+}
+
+//----------------------------------------------------------------------------
+void _ManagedServiceFactoryConcurrencyTest::updated(const QString& pid, const ctkDictionary& properties)
+{
+  enter();
+  {
+    QMutexLocker l(&mutex);
+    lastProperties.insert(pid, properties);
+  }
+  leave();
+}
+
+//----------------------------------------------------------------------------
+void _ManagedServiceFactoryConcurrencyTest::enter()
+{
+  {
+    QMutexLocker l(&mutex);
+    ++activeCalls;
+    maxActiveCalls = qMax(maxActiveCalls, activeCalls);
+  }
+  // give a concurrent call the chance to overlap
+  QTest::qSleep(20);
+}
+
+//----------------------------------------------------------------------------
+void _ManagedServiceFactoryConcurrencyTest::leave()
+{
+  QMutexLocker l(&mutex);
+  --activeCalls;
+}
+
 //----------------------------------------------------------------------------
 ctkManagedServiceFactoryTestSuite::ctkManagedServiceFactoryTestSuite(ctkPluginContext* pc, long cmPluginId)
   : context(pc), cmPluginId(cmPluginId), cm(0), updateCount(0),
@@ -200,3 +255,59 @@ void ctkManagedServiceFactoryTestSuite::testGeneralManagedServiceFactory()
   }
   reg.unregister();
 }
+
+//----------------------------------------------------------------------------
+void ctkManagedServiceFactoryTestSuite::testConcurrentInstanceUpdates()
+{
+  _ManagedServiceFactoryConcurrencyTest msf;
+  ctkDictionary dict;
+  dict.insert(ctkPluginConstants::SERVICE_PID, "concurrent");
+  ctkServiceRegistration reg = context->registerService<ctkManagedServiceFactory>(&msf, dict);
+
+  // Two instances of the same factory are updated at the same time
+  ctkConfigurationPtr config1 = cm->createFactoryConfiguration("concurrent");
+  ctkConfigurationPtr config2 = cm->createFactoryConfiguration("concurrent");
+  for (int i = 1; i <= 5; ++i)
+  {
+    ctkDictionary props;
+    props.insert("testkey", i);
+    config1->update(props);
+    config2->update(props);
+  }
+
+  // Only the last update of each instance must be delivered
+  QTime time;
+  time.start();
+  bool delivered = false;
+  while (!delivered && time.elapsed() < 5000)
+  {
+    {
+      QMutexLocker l(&msf.mutex);
+      delivered = msf.lastProperties.value(config1->getPid()).value("testkey").toInt() == 5 &&
+                  msf.lastProperties.value(config2->getPid()).value("testkey").toInt() == 5;
+    }
+    QTest::qSleep(10);
+  }
+  QVERIFY2(delivered, "should have updated both instances");
+
+  config1->remove();
+  config2->remove();
+  time.restart();
+  bool removed = false;
+  while (!removed && time.elapsed() < 5000)
+  {
+    {
+      QMutexLocker l(&msf.mutex);
+      removed = msf.lastProperties.isEmpty();
+    }
+    QTest::qSleep(10);
+  }
+  QVERIFY2(removed, "should have deleted both instances");
+
+  // The factory must never have been called concurrently
+  {
+    QMutexLocker l(&msf.mutex);
+    QCOMPARE(msf.maxActiveCalls, 1);
+  }
+  reg.unregister();
+}
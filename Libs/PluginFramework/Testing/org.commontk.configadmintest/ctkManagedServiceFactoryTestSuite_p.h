@@ -23,6 +23,7 @@
 #ifndef CTKMANAGEDSERVICEFACTORYTESTSUITE_P_H
 #define CTKMANAGEDSERVICEFACTORYTESTSUITE_P_H
 
+#include <QHash>
 #include <QObject>
 #include <QWaitCondition>
 #include <QMutex>
@@ -53,6 +54,33 @@ private:
   ctkManagedServiceFactoryTestSuite* const ts;
 };
 
+class _ManagedServiceFactoryConcurrencyTest : public QObject,
+    public ctkManagedServiceFactory
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkManagedServiceFactory)
+
+public:
+
+  _ManagedServiceFactoryConcurrencyTest();
+
+  void deleted(const QString& pid);
+  QString getName();
+  void updated(const QString& pid, const ctkDictionary& properties);
+
+  QMutex mutex;
+  /** Number of calls currently running, and the maximum of it */
+  int activeCalls;
+  int maxActiveCalls;
+  /** The last properties delivered per PID */
+  QHash<QString, ctkDictionary> lastProperties;
+
+private:
+
+  void enter();
+  void leave();
+};
+
 class ctkManagedServiceFactoryTestSuite : public QObject,
     public ctkTestSuiteInterface
 {
@@ -70,6 +98,7 @@ private Q_SLOTS:
 
   void testSamePidManagedServiceFactory();
   void testGeneralManagedServiceFactory();
+  void testConcurrentInstanceUpdates();
 
 private:
 
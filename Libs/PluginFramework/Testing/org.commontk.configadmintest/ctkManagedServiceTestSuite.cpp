@@ -48,6 +48,25 @@ void _ManagedServiceUpdateTest::updated(
   ts->updateCount++;
 }
 
+//----------------------------------------------------------------------------
+_ManagedServiceBlockingTest::_ManagedServiceBlockingTest()
+  : updateCount(0)
+{
+
+}
+
+//----------------------------------------------------------------------------
+void _ManagedServiceBlockingTest::updated(const ctkDictionary& properties)
+{
+  {
+    QMutexLocker l(&mutex);
+    updateCount++;
+    lastProperties = properties;
+  }
+  entered.release();
+  proceed.tryAcquire(1, 5000);
+}
+
 //----------------------------------------------------------------------------
 ctkManagedServiceTestSuite::ctkManagedServiceTestSuite(
   ctkPluginContext* pc, long cmPluginId)
@@ -196,3 +215,51 @@ void ctkManagedServiceTestSuite::testGeneralManagedService()
   }
   reg.unregister();
 }
+
+//----------------------------------------------------------------------------
+void ctkManagedServiceTestSuite::testConcurrentAndSupersededUpdates()
+{
+  _ManagedServiceBlockingTest slow;
+  ctkDictionary slowDict;
+  slowDict.insert(ctkPluginConstants::SERVICE_PID, "slow");
+  ctkServiceRegistration slowReg = context->registerService<ctkManagedService>(&slow, slowDict);
+  // the initial update blocks the delivery for the "slow" PID
+  QVERIFY(slow.entered.tryAcquire(1, 5000));
+
+  // updates for other PIDs are still delivered
+  updateCount = 0;
+  _ManagedServiceUpdateTest ms(this);
+  ctkDictionary dict;
+  dict.insert(ctkPluginConstants::SERVICE_PID, "test");
+  ctkServiceRegistration reg;
+  {
+    QMutexLocker l(&mutex);
+    reg = context->registerService<ctkManagedService>(&ms, dict);
+    locked = true;
+    lock.wait(&mutex, 5000);
+    if (locked)
+      QFAIL("should have updated while another PID is blocked");
+    QCOMPARE(1, updateCount);
+  }
+
+  // queued updates for the blocked PID are superseded by the newest one
+  ctkConfigurationPtr config = cm->getConfiguration("slow");
+  for (int i = 1; i <= 3; ++i)
+  {
+    ctkDictionary props;
+    props.insert("testkey", i);
+    config->update(props);
+  }
+  slow.proceed.release(2);
+  QVERIFY(slow.entered.tryAcquire(1, 5000));
+  QVERIFY(!slow.entered.tryAcquire(1, 200));
+  {
+    QMutexLocker l(&slow.mutex);
+    QCOMPARE(2, slow.updateCount);
+    QCOMPARE(3, slow.lastProperties.value("testkey").toInt());
+  }
+
+  reg.unregister();
+  slowReg.unregister();
+  config->remove();
+}
@@ -26,6 +26,7 @@
 #include <QObject>
 #include <QWaitCondition>
 #include <QMutex>
+#include <QSemaphore>
 
 #include <service/cm/ctkManagedService.h>
 #include <ctkServiceReference.h>
@@ -50,6 +51,27 @@ private:
   ctkManagedServiceTestSuite* const ts;
 };
 
+class _ManagedServiceBlockingTest : public QObject, public ctkManagedService
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkManagedService)
+
+public:
+
+  _ManagedServiceBlockingTest();
+
+  void updated(const ctkDictionary& properties);
+
+  /** Released when updated() is entered */
+  QSemaphore entered;
+  /** Acquired before updated() returns */
+  QSemaphore proceed;
+
+  QMutex mutex;
+  int updateCount;
+  ctkDictionary lastProperties;
+};
+
 class ctkManagedServiceTestSuite : public QObject,
     public ctkTestSuiteInterface
 {
@@ -67,6 +89,7 @@ private Q_SLOTS:
 
   void testSamePidManagedService();
   void testGeneralManagedService();
+  void testConcurrentAndSupersededUpdates();
 
 private:
 
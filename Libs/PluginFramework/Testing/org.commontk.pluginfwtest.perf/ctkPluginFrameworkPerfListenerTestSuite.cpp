@@ -0,0 +1,160 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkPluginFrameworkPerfListenerTestSuite_p.h"
+
+#include "ctkPluginFrameworkPerfRegistryTestSuite_p.h"
+
+#include <ctkPluginContext.h>
+#include <ctkHighPrecisionTimer.h>
+
+#undef REGISTERED
+#include <ctkServiceEvent.h>
+
+#include <QTest>
+#include <QDebug>
+
+//----------------------------------------------------------------------------
+ctkPluginFrameworkPerfListenerTestSuite::ctkPluginFrameworkPerfListenerTestSuite(ctkPluginContext* context)
+  : QObject(0)
+  , pc(context)
+  , nMatchingListeners(100)
+  , nOtherListeners(4900)
+  , nServices(1000)
+  , nNotified(0)
+{
+  this->setObjectName("ctkPluginFrameworkPerfListenerTestSuite");
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfListenerTestSuite::initTestCase()
+{
+  ctkHighPrecisionTimer t;
+  t.start();
+
+  // Listeners interested in the registered services
+  addListeners(nMatchingListeners,
+               "(&(objectclass=org.commontk.test.PerfTestService)(perf.listener.value>=0))");
+
+  // Listeners interested in other services only, with complex and with
+  // simple filters
+  addListeners(nOtherListeners / 2,
+               "(&(objectclass=org.commontk.test.OtherPerfService)(perf.listener.value>=0))");
+  addListeners(nOtherListeners - nOtherListeners / 2,
+               "(objectclass=org.commontk.test.OtherPerfService)");
+
+  log() << "adding" << listeners.size() << "service listeners took"
+        << t.elapsedMilli() << "ms";
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfListenerTestSuite::cleanupTestCase()
+{
+  foreach (ctkPerfServiceListener* l, listeners)
+  {
+    try
+    {
+      pc->disconnectServiceListener(l, "serviceChanged");
+    }
+    catch (const ctkException& e)
+    {
+      qDebug() << e.printStackTrace();
+    }
+  }
+  qDeleteAll(listeners);
+  listeners.clear();
+  qDeleteAll(services);
+  services.clear();
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfListenerTestSuite::addListeners(int n, const QString& filter)
+{
+  for(int i = 0; i < n; i++)
+  {
+    ctkPerfServiceListener* l = new ctkPerfServiceListener(this);
+    try
+    {
+      listeners.push_back(l);
+      pc->connectServiceListener(l, "serviceChanged", filter);
+    }
+    catch (const ctkException& e)
+    {
+      qDebug() << e.printStackTrace();
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfListenerTestSuite::testRegisterServices()
+{
+  log() << "registering" << nServices << "services, listener count=" << listeners.size();
+
+  nNotified = 0;
+  ctkHighPrecisionTimer t;
+  t.start();
+  for(int i = 0; i < nServices; i++)
+  {
+    ctkDictionary props;
+    props.insert("perf.listener.value", i);
+
+    QObject* service = new PerfTestService();
+    services.push_back(service);
+    regs.push_back(pc->registerService<IPerfTestService>(service, props));
+  }
+  qint64 us = t.elapsedMicro();
+  log() << "register took" << us / 1000 << "ms ("
+        << double(us) / nServices << "us per service)";
+
+  QCOMPARE(nNotified, nServices * nMatchingListeners);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfListenerTestSuite::testUnregisterServices()
+{
+  nNotified = 0;
+  ctkHighPrecisionTimer t;
+  t.start();
+  for(int i = 0; i < regs.size(); i++)
+  {
+    regs[i].unregister();
+  }
+  qint64 us = t.elapsedMicro();
+  log() << "unregister took" << us / 1000 << "ms ("
+        << double(us) / regs.size() << "us per service)";
+
+  QCOMPARE(nNotified, regs.size() * nMatchingListeners);
+  regs.clear();
+}
+
+//----------------------------------------------------------------------------
+ctkPerfServiceListener::ctkPerfServiceListener(ctkPluginFrameworkPerfListenerTestSuite* ts)
+  : ts(ts)
+{
+}
+
+//----------------------------------------------------------------------------
+void ctkPerfServiceListener::serviceChanged(const ctkServiceEvent& ev)
+{
+  Q_UNUSED(ev)
+  ts->nNotified++;
+}
@@ -0,0 +1,100 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKPLUGINFRAMEWORKPERFLISTENERTESTSUITE_P_H
+#define CTKPLUGINFRAMEWORKPERFLISTENERTESTSUITE_P_H
+
+#include "ctkTestSuiteInterface.h"
+#include "ctkServiceRegistration.h"
+
+#include <QDebug>
+
+class ctkPluginContext;
+class ctkServiceEvent;
+
+class ctkPerfServiceListener;
+
+/**
+ * Measures the dispatch of service events to a large number of service
+ * listeners, most of which are not interested in the registered services.
+ */
+class ctkPluginFrameworkPerfListenerTestSuite : public QObject, public ctkTestSuiteInterface
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkTestSuiteInterface)
+
+private:
+
+  ctkPluginContext* pc;
+
+  int nMatchingListeners;
+  int nOtherListeners;
+  int nServices;
+
+  int nNotified;
+
+  QList<ctkServiceRegistration> regs;
+  QList<ctkPerfServiceListener*> listeners;
+  QList<QObject*> services;
+
+public:
+
+  ctkPluginFrameworkPerfListenerTestSuite(ctkPluginContext* context);
+
+  QDebug log()
+  {
+    return qDebug() << "listener_perf:";
+  }
+
+private:
+
+  friend class ctkPerfServiceListener;
+
+  void addListeners(int n, const QString& filter);
+
+private Q_SLOTS:
+
+  void initTestCase();
+  void cleanupTestCase();
+
+  void testRegisterServices();
+  void testUnregisterServices();
+};
+
+class ctkPerfServiceListener : public QObject
+{
+  Q_OBJECT
+
+private:
+
+  ctkPluginFrameworkPerfListenerTestSuite* ts;
+
+public:
+
+  ctkPerfServiceListener(ctkPluginFrameworkPerfListenerTestSuite* ts);
+
+protected Q_SLOTS:
+
+  void serviceChanged(const ctkServiceEvent& ev);
+};
+
+#endif // CTKPLUGINFRAMEWORKPERFLISTENERTESTSUITE_P_H
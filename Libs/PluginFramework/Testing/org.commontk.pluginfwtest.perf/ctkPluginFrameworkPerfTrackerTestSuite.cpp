@@ -0,0 +1,357 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkPluginFrameworkPerfTrackerTestSuite_p.h"
+
+#include <ctkPluginConstants.h>
+#include <ctkPluginContext.h>
+#include <ctkHighPrecisionTimer.h>
+
+#include <QAtomicInt>
+#include <QTest>
+#include <QThread>
+#include <QDebug>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+class ctkTrackerReaderThread : public QThread
+{
+public:
+
+  ctkTrackerReaderThread(ctkServiceTracker<IPerfTestService*>* tracker, int nReads)
+    : tracker(tracker), nReads(nReads), nNull(0)
+  {}
+
+  void run()
+  {
+    for (int i = 0; i < nReads; i++)
+    {
+      if (tracker->getService() == 0)
+      {
+        nNull++;
+      }
+      if (tracker->getServices().isEmpty())
+      {
+        nNull++;
+      }
+    }
+  }
+
+  ctkServiceTracker<IPerfTestService*>* tracker;
+  int nReads;
+  int nNull;
+};
+
+//----------------------------------------------------------------------------
+class ctkGetServiceThread : public QThread
+{
+public:
+
+  ctkGetServiceThread(ctkPluginContext* pc, const ctkServiceReference& reference,
+                      IPerfTestService* expected, int nReads)
+    : pc(pc), reference(reference), expected(expected), nReads(nReads), nWrong(0)
+  {}
+
+  void run()
+  {
+    for (int i = 0; i < nReads; i++)
+    {
+      if (pc->getService<IPerfTestService>(reference) != expected)
+      {
+        nWrong++;
+      }
+      if (!pc->ungetService(reference))
+      {
+        nWrong++;
+      }
+    }
+  }
+
+  ctkPluginContext* pc;
+  ctkServiceReference reference;
+  IPerfTestService* expected;
+  int nReads;
+  int nWrong;
+};
+
+}
+
+//----------------------------------------------------------------------------
+ctkPluginFrameworkPerfTrackerTestSuite::ctkPluginFrameworkPerfTrackerTestSuite(ctkPluginContext* context)
+  : QObject(0)
+  , pc(context)
+  , nServices(100)
+  , nReads(1000000)
+  , nThreads(4)
+  , tracker(0)
+{
+  this->setObjectName("ctkPluginFrameworkPerfTrackerTestSuite");
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::initTestCase()
+{
+  registerServices(nServices);
+
+  tracker = new ctkServiceTracker<IPerfTestService*>(pc);
+  ctkHighPrecisionTimer t;
+  t.start();
+  tracker->open();
+  log() << "opening a tracker for" << nServices << "services took" << t.elapsedMilli() << "ms";
+
+  QCOMPARE(tracker->size(), nServices);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::cleanupTestCase()
+{
+  if (tracker)
+  {
+    tracker->close();
+    delete tracker;
+    tracker = 0;
+  }
+  unregisterServices();
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::registerServices(int n)
+{
+  QString pid("my.tracked.service.%1");
+
+  for(int i = 0; i < n; i++)
+  {
+    ctkDictionary props;
+    props.insert(ctkPluginConstants::SERVICE_PID, pid.arg(i));
+    // several services share a ranking, the lowest service id must win
+    props.insert(ctkPluginConstants::SERVICE_RANKING, i / 4);
+
+    QObject* service = new PerfTestService();
+    services.push_back(service);
+    ctkServiceRegistration reg =
+        pc->registerService<IPerfTestService>(service, props);
+    regs.push_back(reg);
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::unregisterServices()
+{
+  for(int i = 0; i < regs.size(); i++)
+  {
+    regs[i].unregister();
+  }
+  regs.clear();
+  qDeleteAll(services);
+  services.clear();
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::testGetService()
+{
+  // services with the highest ranking are the last four registered ones
+  IPerfTestService* expected = qobject_cast<IPerfTestService*>(services[nServices - 4]);
+
+  ctkHighPrecisionTimer t;
+  t.start();
+  IPerfTestService* service = 0;
+  for (int i = 0; i < nReads; i++)
+  {
+    service = tracker->getService();
+  }
+  qint64 us = t.elapsedMicro();
+  log() << nReads << "x getService() took" << us / 1000 << "ms"
+        << "(" << double(us) * 1000.0 / nReads << "ns per call)";
+  QVERIFY(service == expected);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::testGetServiceReference()
+{
+  ctkHighPrecisionTimer t;
+  t.start();
+  ctkServiceReference reference;
+  for (int i = 0; i < nReads; i++)
+  {
+    reference = tracker->getServiceReference();
+  }
+  qint64 us = t.elapsedMicro();
+  log() << nReads << "x getServiceReference() took" << us / 1000 << "ms"
+        << "(" << double(us) * 1000.0 / nReads << "ns per call)";
+  QVERIFY(reference == regs[nServices - 4].getReference());
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::testGetServices()
+{
+  ctkHighPrecisionTimer t;
+  t.start();
+  QList<IPerfTestService*> trackedServices;
+  for (int i = 0; i < nReads; i++)
+  {
+    trackedServices = tracker->getServices();
+  }
+  qint64 us = t.elapsedMicro();
+  log() << nReads << "x getServices() took" << us / 1000 << "ms"
+        << "(" << double(us) * 1000.0 / nReads << "ns per call)";
+  QCOMPARE(trackedServices.size(), nServices);
+  // sorted by ranking, then by service id
+  QVERIFY(trackedServices.front() == qobject_cast<IPerfTestService*>(services[nServices - 4]));
+  QVERIFY(trackedServices.back() == qobject_cast<IPerfTestService*>(services[3]));
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::testGetTracked()
+{
+  ctkHighPrecisionTimer t;
+  t.start();
+  QMap<ctkServiceReference, IPerfTestService*> tracked;
+  for (int i = 0; i < nReads; i++)
+  {
+    tracked = tracker->getTracked();
+  }
+  qint64 us = t.elapsedMicro();
+  log() << nReads << "x getTracked() took" << us / 1000 << "ms"
+        << "(" << double(us) * 1000.0 / nReads << "ns per call)";
+  QCOMPARE(tracked.size(), nServices);
+  // natural order: the last entry has the highest ranking and lowest id
+  QVERIFY(tracked.lastKey() == regs[nServices - 4].getReference());
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::testConcurrentReads()
+{
+  QList<ctkTrackerReaderThread*> readers;
+  for (int i = 0; i < nThreads; i++)
+  {
+    readers.push_back(new ctkTrackerReaderThread(tracker, nReads / nThreads));
+  }
+
+  ctkHighPrecisionTimer t;
+  t.start();
+  foreach (ctkTrackerReaderThread* reader, readers)
+  {
+    reader->start();
+  }
+
+  // Republish snapshots while the readers are running: move the first
+  // service to the top of the ranking and back
+  int nModifications = 0;
+  bool running = true;
+  while (running)
+  {
+    ctkDictionary props;
+    props.insert(ctkPluginConstants::SERVICE_PID, QString("my.tracked.service.0"));
+    props.insert(ctkPluginConstants::SERVICE_RANKING, (nModifications % 2) ? 0 : nServices);
+    regs[0].setProperties(props);
+    nModifications++;
+
+    running = false;
+    foreach (ctkTrackerReaderThread* reader, readers)
+    {
+      running = running || !reader->isFinished();
+    }
+  }
+  foreach (ctkTrackerReaderThread* reader, readers)
+  {
+    reader->wait();
+  }
+  qint64 ms = t.elapsedMilli();
+  log() << nThreads << "threads x" << nReads / nThreads << "reads with"
+        << nModifications << "concurrent modifications took" << ms << "ms";
+
+  foreach (ctkTrackerReaderThread* reader, readers)
+  {
+    QCOMPARE(reader->nNull, 0);
+  }
+  qDeleteAll(readers);
+
+  QCOMPARE(tracker->size(), nServices);
+  IPerfTestService* expected = qobject_cast<IPerfTestService*>(
+        services[(nModifications % 2) ? 0 : nServices - 4]);
+  QVERIFY(tracker->getService() == expected);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::testGetUngetService()
+{
+  ctkServiceReference reference = regs[1].getReference();
+  IPerfTestService* expected = qobject_cast<IPerfTestService*>(services[1]);
+
+  // The open tracker keeps the service in use, so getService() and
+  // ungetService() do not need to lock
+  ctkHighPrecisionTimer t;
+  t.start();
+  int nWrong = 0;
+  for (int i = 0; i < nReads; i++)
+  {
+    if (pc->getService<IPerfTestService>(reference) != expected) nWrong++;
+    pc->ungetService(reference);
+  }
+  qint64 us = t.elapsedMicro();
+  log() << nReads << "x getService()/ungetService() took" << us / 1000 << "ms"
+        << "(" << double(us) * 1000.0 / nReads << "ns per pair)";
+  QCOMPARE(nWrong, 0);
+  QCOMPARE(reference.getUsingPlugins().size(), 1);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfTrackerTestSuite::testConcurrentGetUngetService()
+{
+  ctkServiceReference reference = regs[2].getReference();
+  IPerfTestService* expected = qobject_cast<IPerfTestService*>(services[2]);
+
+  QList<ctkGetServiceThread*> threads;
+  for (int i = 0; i < nThreads; i++)
+  {
+    threads.push_back(new ctkGetServiceThread(pc, reference, expected, nReads / nThreads));
+  }
+
+  ctkHighPrecisionTimer t;
+  t.start();
+  foreach (ctkGetServiceThread* thread, threads)
+  {
+    thread->start();
+  }
+  foreach (ctkGetServiceThread* thread, threads)
+  {
+    thread->wait();
+  }
+  qint64 ms = t.elapsedMilli();
+  log() << nThreads << "threads x" << nReads / nThreads
+        << "getService()/ungetService() took" << ms << "ms";
+
+  foreach (ctkGetServiceThread* thread, threads)
+  {
+    QCOMPARE(thread->nWrong, 0);
+  }
+  qDeleteAll(threads);
+
+  // the use count must be balanced, only the tracker still uses the service
+  QCOMPARE(reference.getUsingPlugins().size(), 1);
+  QVERIFY(pc->ungetService(reference));
+  QVERIFY(reference.getUsingPlugins().isEmpty());
+  QVERIFY(!pc->ungetService(reference));
+  QVERIFY(pc->getService<IPerfTestService>(reference) == expected);
+}
@@ -0,0 +1,87 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKPLUGINFRAMEWORKPERFTRACKERTESTSUITE_P_H
+#define CTKPLUGINFRAMEWORKPERFTRACKERTESTSUITE_P_H
+
+#include "ctkTestSuiteInterface.h"
+#include "ctkServiceRegistration.h"
+#include "ctkServiceTracker.h"
+
+#include "ctkPluginFrameworkPerfRegistryTestSuite_p.h"
+
+#include <QDebug>
+
+class ctkPluginContext;
+
+/**
+ * Measures the read methods of ctkServiceTracker and
+ * ctkPluginContext::getService(), which are expected to be called
+ * on hot paths.
+ */
+class ctkPluginFrameworkPerfTrackerTestSuite : public QObject, public ctkTestSuiteInterface
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkTestSuiteInterface)
+
+private:
+
+  ctkPluginContext* pc;
+
+  int nServices;
+  int nReads;
+  int nThreads;
+
+  QList<ctkServiceRegistration> regs;
+  QList<QObject*> services;
+
+  ctkServiceTracker<IPerfTestService*>* tracker;
+
+public:
+
+  ctkPluginFrameworkPerfTrackerTestSuite(ctkPluginContext* context);
+
+  QDebug log()
+  {
+    return qDebug() << "tracker_perf:";
+  }
+
+private:
+
+  void registerServices(int n);
+  void unregisterServices();
+
+private Q_SLOTS:
+
+  void initTestCase();
+  void cleanupTestCase();
+
+  void testGetService();
+  void testGetServiceReference();
+  void testGetServices();
+  void testGetTracked();
+  void testConcurrentReads();
+  void testGetUngetService();
+  void testConcurrentGetUngetService();
+};
+
+#endif // CTKPLUGINFRAMEWORKPERFTRACKERTESTSUITE_P_H
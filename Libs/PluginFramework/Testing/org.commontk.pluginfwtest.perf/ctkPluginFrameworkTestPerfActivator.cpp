@@ -22,13 +22,17 @@
 #include "ctkPluginFrameworkTestPerfActivator_p.h"
 
 #include "ctkPluginFrameworkPerfRegistryTestSuite_p.h"
+#include "ctkPluginFrameworkPerfListenerTestSuite_p.h"
+#include "ctkPluginFrameworkPerfTrackerTestSuite_p.h"
+
+#include <ctkPluginConstants.h>
 
 #include <QtPlugin>
 
 
 //----------------------------------------------------------------------------
 ctkPluginFrameworkTestPerfActivator::ctkPluginFrameworkTestPerfActivator()
-  : perfTestSuite(0)
+  : perfTestSuite(0), perfListenerTestSuite(0), perfTrackerTestSuite(0)
 {
 
 }
@@ -37,13 +41,28 @@ ctkPluginFrameworkTestPerfActivator::ctkPluginFrameworkTestPerfActivator()
 ctkPluginFrameworkTestPerfActivator::~ctkPluginFrameworkTestPerfActivator()
 {
   delete perfTestSuite;
+  delete perfListenerTestSuite;
+  delete perfTrackerTestSuite;
 }
 
 //----------------------------------------------------------------------------
 void ctkPluginFrameworkTestPerfActivator::start(ctkPluginContext* context)
 {
+  ctkDictionary props;
+
   perfTestSuite = new ctkPluginFrameworkPerfRegistryTestSuite(context);
-  context->registerService<ctkTestSuiteInterface>(perfTestSuite);
+  props.insert(ctkPluginConstants::SERVICE_PID, perfTestSuite->metaObject()->className());
+  context->registerService<ctkTestSuiteInterface>(perfTestSuite, props);
+
+  perfListenerTestSuite = new ctkPluginFrameworkPerfListenerTestSuite(context);
+  props.clear();
+  props.insert(ctkPluginConstants::SERVICE_PID, perfListenerTestSuite->metaObject()->className());
+  context->registerService<ctkTestSuiteInterface>(perfListenerTestSuite, props);
+
+  perfTrackerTestSuite = new ctkPluginFrameworkPerfTrackerTestSuite(context);
+  props.clear();
+  props.insert(ctkPluginConstants::SERVICE_PID, perfTrackerTestSuite->metaObject()->className());
+  context->registerService<ctkTestSuiteInterface>(perfTrackerTestSuite, props);
 }
 
 //----------------------------------------------------------------------------
@@ -53,6 +72,10 @@ void ctkPluginFrameworkTestPerfActivator::stop(ctkPluginContext* context)
 
   delete perfTestSuite;
   perfTestSuite = 0;
+  delete perfListenerTestSuite;
+  perfListenerTestSuite = 0;
+  delete perfTrackerTestSuite;
+  perfTrackerTestSuite = 0;
 }
 
 #if QT_VERSION < QT_VERSION_CHECK(5,0,0)
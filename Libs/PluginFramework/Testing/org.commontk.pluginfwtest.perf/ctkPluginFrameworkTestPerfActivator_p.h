@@ -46,6 +46,8 @@ public:
 private:
 
   QObject* perfTestSuite;
+  QObject* perfListenerTestSuite;
+  QObject* perfTrackerTestSuite;
 };
 
 #endif // CTKPLUGINFRAMEWORKTESTPERFACTIVATOR_H
@@ -266,6 +266,13 @@ QList<S> ctkPluginAbstractTracked<S,T,R>::getTracked() const
   return tracked.keys();
 }
 
+//----------------------------------------------------------------------------
+template<class S, class T, class R>
+QHash<S,T> ctkPluginAbstractTracked<S,T,R>::getTrackedEntries() const
+{
+  return tracked;
+}
+
 //----------------------------------------------------------------------------
 template<class S, class T, class R>
 void ctkPluginAbstractTracked<S,T,R>::modified()
@@ -143,6 +143,14 @@ public:
    */
   QList<S> getTracked() const;
 
+  /**
+   * Return the map of tracked items to customized objects.
+   *
+   * @return A (shallow) copy of the tracked entries.
+   * @GuardedBy this
+   */
+  QHash<S,T> getTrackedEntries() const;
+
   /**
    * Increment the modification count. If this method is overridden, the
    * overriding method MUST call this method to increment the tracking count.
@@ -165,6 +165,20 @@ QObject* ctkPluginContext::getService(const ctkServiceReference& reference)
   return internalRef.d_func()->getService(d->plugin->q_func());
 }
 
+//----------------------------------------------------------------------------
+void* ctkPluginContext::getServiceInterface(const ctkServiceReference& reference, const char* iid)
+{
+  Q_D(ctkPluginContext);
+  d->isPluginContextValid();
+
+  if (!reference)
+  {
+    throw ctkInvalidArgumentException("Default constructed ctkServiceReference is not a valid input to getService()");
+  }
+  ctkServiceReference internalRef(reference);
+  return internalRef.d_func()->getServiceInterface(d->plugin->q_func(), iid);
+}
+
 //----------------------------------------------------------------------------
 bool ctkPluginContext::ungetService(const ctkServiceReference& reference)
 {
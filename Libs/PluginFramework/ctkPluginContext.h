@@ -23,6 +23,7 @@
 #define CTKPLUGINCONTEXT_H_
 
 #include <QHash>
+#include <QObject>
 #include <QString>
 #include <QVariant>
 #include <QUrl>
@@ -452,6 +453,11 @@ public:
    *         <code>ctkServiceFactory</code> does not implement the classes under
    *         which it was registered, the <code>ctkServiceFactory</code> threw
    *         an exception or the service could not be casted to the desired type.
+   * <p>
+   * If <code>S</code> is an interface declared with Q_DECLARE_INTERFACE, the
+   * result of the cast is cached and repeated calls for a service which is
+   * already used by the context plugin do not lock.
+   *
    * @throws ctkIllegalStateException If this ctkPluginContext is no
    *         longer valid.
    * @throws ctkInvalidArgumentException If the specified
@@ -465,6 +471,10 @@ public:
   template<class S>
   S* getService(const ctkServiceReference& reference)
   {
+    if (const char* iid = qobject_interface_iid<S*>())
+    {
+      return static_cast<S*>(getServiceInterface(reference, iid));
+    }
     return qobject_cast<S*>(getService(reference));
   }
 
@@ -735,6 +745,8 @@ protected:
 
 private:
   Q_DECLARE_PRIVATE(ctkPluginContext)
+
+  void* getServiceInterface(const ctkServiceReference& reference, const char* iid);
 };
 
 
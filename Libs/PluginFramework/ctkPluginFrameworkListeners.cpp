@@ -55,6 +55,7 @@ void ctkPluginFrameworkListeners::addServiceSlot(
 {
   QMutexLocker lock(&mutex); Q_UNUSED(lock)
   ctkServiceSlotEntry sse(plugin, receiver, slot, filter);
+  sse.resolveSlot();
   if (serviceSet.contains(sse))
   {
     removeServiceSlot_unlocked(plugin, receiver, slot);
@@ -113,17 +114,41 @@ QSet<ctkServiceSlotEntry> ctkPluginFrameworkListeners::getMatchingServiceSlots(
   QMutexLocker lock(&mutex); Q_UNUSED(lock);
 
   QSet<ctkServiceSlotEntry> set;
-  set.reserve(serviceSet.size());
   // Check complicated or empty listener filters
   int n = 0;
-  ctkLDAPExpr expr;
-  foreach (const ctkServiceSlotEntry& sse, complicatedListeners)
+  const ctkServiceProperties& props = sr.d_func()->getProperties();
+  QList<ctkServiceSlotEntry>::const_iterator end = complicatedListeners.end();
+  for (QList<ctkServiceSlotEntry>::const_iterator it = complicatedListeners.begin();
+       it != end; ++it)
   {
     ++n;
-    expr = sse.getLDAPExpr();
-    if (expr.isNull() || expr.evaluate(sr.d_func()->getProperties(), false))
+    const ctkLDAPExpr expr = it->getLDAPExpr();
+    if (expr.isNull() || expr.evaluate(props, false))
     {
-      set.insert(sse);
+      set.insert(*it);
+    }
+  }
+
+  // Check the complicated filters of listeners interested in the
+  // object classes of the service only
+  QStringList c = sr.d_func()->getProperty(ctkPluginConstants::OBJECTCLASS, lockProps).toStringList();
+  foreach (const QString& objClass, c)
+  {
+    QHash<QString, QList<ctkServiceSlotEntry> >::const_iterator l =
+        objectClassListeners.constFind(objClass);
+    if (l == objectClassListeners.constEnd())
+    {
+      continue;
+    }
+    end = l.value().end();
+    for (QList<ctkServiceSlotEntry>::const_iterator it = l.value().begin();
+         it != end; ++it)
+    {
+      ++n;
+      if (it->getLDAPExpr().evaluate(props, false))
+      {
+        set.insert(*it);
+      }
     }
   }
 
@@ -134,8 +159,7 @@ QSet<ctkServiceSlotEntry> ctkPluginFrameworkListeners::getMatchingServiceSlots(
   }
 
   // Check the cache
-  QStringList c = sr.d_func()->getProperty(ctkPluginConstants::OBJECTCLASS, lockProps).toStringList();
-  foreach (QString objClass, c)
+  foreach (const QString& objClass, c)
   {
     addToSet(set, OBJECTCLASS_IX, objClass);
   }
@@ -202,13 +226,22 @@ void ctkPluginFrameworkListeners::serviceChanged(
 
   //framework.hooks.filterServiceEventReceivers(evt, receivers);
 
-  foreach (ctkServiceSlotEntry l, receivers)
+  QSet<ctkServiceSlotEntry>::const_iterator end = receivers.end();
+  for (QSet<ctkServiceSlotEntry>::const_iterator it = receivers.begin();
+       it != end; ++it)
   {
+    const ctkServiceSlotEntry& l = *it;
     if (!matchBefore.isEmpty())
     {
       matchBefore.remove(l);
     }
 
+    // The listener may have been removed by a previously notified one
+    if (l.isRemoved())
+    {
+      continue;
+    }
+
     // TODO permission checks
     //if (l.bundle.hasPermission(new ServicePermission(sr, ServicePermission.GET))) {
     //foreach (QString clazz, classes)
@@ -262,6 +295,15 @@ void ctkPluginFrameworkListeners::removeFromCache(const ctkServiceSlotEntry& sse
   }
   else
   {
+    foreach (const QString& objClass, sse.getObjectClassIndex())
+    {
+      QList<ctkServiceSlotEntry>& sses = objectClassListeners[objClass];
+      sses.removeAll(sse);
+      if (sses.isEmpty())
+      {
+        objectClassListeners.remove(objClass);
+      }
+    }
     complicatedListeners.removeAll(sse);
   }
 }
@@ -292,11 +334,24 @@ void ctkPluginFrameworkListeners::checkSimple(const ctkServiceSlotEntry& sse)
     }
     else
     {
-      if (pluginFw->debug.ldap)
+      QSet<QString> objClasses;
+      if (sse.getLDAPExpr().getMatchedObjectClasses(objClasses))
       {
-        qDebug() << "## DEBUG: Too complicated filter:" << sse.getFilter();
+        // The filter is evaluated only for services of these classes
+        sse.getObjectClassIndex() = objClasses.toList();
+        foreach (const QString& objClass, objClasses)
+        {
+          objectClassListeners[objClass].push_back(sse);
+        }
+      }
+      else
+      {
+        if (pluginFw->debug.ldap)
+        {
+          qDebug() << "## DEBUG: Too complicated filter:" << sse.getFilter();
+        }
+        complicatedListeners.push_back(sse);
       }
-      complicatedListeners.push_back(sse);
     }
   }
 }
@@ -305,16 +360,19 @@ void ctkPluginFrameworkListeners::checkSimple(const ctkServiceSlotEntry& sse)
 void ctkPluginFrameworkListeners::addToSet(QSet<ctkServiceSlotEntry>& set,
                                            int cache_ix, const QString& val)
 {
-  QList<ctkServiceSlotEntry>& l = cache[cache_ix][val];
-  if (!l.isEmpty())
+  QHash<QString, QList<ctkServiceSlotEntry> >::const_iterator it = cache[cache_ix].constFind(val);
+  if (it != cache[cache_ix].constEnd() && !it.value().isEmpty())
   {
+    const QList<ctkServiceSlotEntry>& l = it.value();
     if (pluginFw->debug.ldap)
     {
       qDebug() << hashedServiceKeys[cache_ix] << "matches" << l.size();
     }
-    foreach (ctkServiceSlotEntry entry, l)
+    QList<ctkServiceSlotEntry>::const_iterator end = l.end();
+    for (QList<ctkServiceSlotEntry>::const_iterator entry = l.begin();
+         entry != end; ++entry)
     {
-      set.insert(entry);
+      set.insert(*entry);
     }
   }
   else
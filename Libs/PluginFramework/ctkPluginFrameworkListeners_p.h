@@ -121,6 +121,10 @@ private:
   // Service listeners with complicated or empty filters
   QList<ctkServiceSlotEntry> complicatedListeners;
 
+  // Service listeners with complicated filters which can only match
+  // services registered under specific object classes, indexed by class
+  QHash<QString, QList<ctkServiceSlotEntry> > objectClassListeners;
+
   // Service listeners with "simple" filters are cached
   QList<QHash<QString, QList<ctkServiceSlotEntry> > > cache;
 
@@ -46,13 +46,61 @@ ctkServiceReferencePrivate::~ctkServiceReferencePrivate()
     delete registration;
 }
 
+//----------------------------------------------------------------------------
+ctkServiceUse* ctkServiceReferencePrivate::acquireUse(const QSharedPointer<ctkPlugin>& plugin)
+{
+  if (registration->isFactory) return 0;
+
+  ctkServiceUse* use = registration->findUse(plugin->getPluginId());
+  if (use == 0) return 0;
+
+  for (;;)
+  {
+    int count = use->count.fetchAndAddOrdered(0);
+    // first acquisition, or the service has been unregistered
+    if (count <= 0) return 0;
+    if (use->count.testAndSetOrdered(count, count + 1)) return use;
+  }
+}
+
+//----------------------------------------------------------------------------
+bool ctkServiceReferencePrivate::releaseUse(const QSharedPointer<ctkPlugin>& plugin)
+{
+  if (registration->isFactory) return false;
+
+  ctkServiceUse* use = registration->findUse(plugin->getPluginId());
+  if (use == 0) return false;
+
+  for (;;)
+  {
+    int count = use->count.fetchAndAddOrdered(0);
+    // the last release removes the plugin from the dependents
+    if (count <= 1) return false;
+    if (use->count.testAndSetOrdered(count, count - 1)) return true;
+  }
+}
+
 //----------------------------------------------------------------------------
 QObject* ctkServiceReferencePrivate::getService(QSharedPointer<ctkPlugin> plugin)
 {
+  if (ctkServiceUse* use = acquireUse(plugin))
+  {
+    return use->service;
+  }
+
   QObject* s = 0;
   {
     QMutexLocker lock(&registration->propsLock);
-    if (registration->available)
+    if (registration->available && !registration->isFactory)
+    {
+      ctkServiceUse* use = registration->findOrCreateUse(plugin->getPluginId());
+      if (use->count.fetchAndAddOrdered(1) == 0)
+      {
+        registration->dependents.insert(plugin, 1);
+      }
+      s = use->service;
+    }
+    else if (registration->available)
     {
       int count = registration->dependents.value(plugin);
       if (count == 0)
@@ -60,69 +108,122 @@ QObject* ctkServiceReferencePrivate::getService(QSharedPointer<ctkPlugin> plugin
         QStringList classes =
             registration->properties.value(ctkPluginConstants::OBJECTCLASS).toStringList();
         registration->dependents[plugin] = 1;
-        if (ctkServiceFactory* serviceFactory = qobject_cast<ctkServiceFactory*>(registration->getService()))
+        ctkServiceFactory* serviceFactory = qobject_cast<ctkServiceFactory*>(registration->getService());
+        try
         {
-          try
-          {
-            s = serviceFactory->getService(plugin, ctkServiceRegistration(registration));
-          }
-          catch (const ctkException& pe)
-          {
-            ctkServiceException se("ctkServiceFactory throw an exception",
-                                   ctkServiceException::FACTORY_EXCEPTION, pe);
-            plugin->d_func()->fwCtx->listeners.frameworkError(registration->plugin->q_func(), se);
-            return 0;
-          }
-          if (s == 0)
+          s = serviceFactory->getService(plugin, ctkServiceRegistration(registration));
+        }
+        catch (const ctkException& pe)
+        {
+          ctkServiceException se("ctkServiceFactory throw an exception",
+                                 ctkServiceException::FACTORY_EXCEPTION, pe);
+          plugin->d_func()->fwCtx->listeners.frameworkError(registration->plugin->q_func(), se);
+          return 0;
+        }
+        if (s == 0)
+        {
+          ctkServiceException se("ctkServiceFactory produced null",
+                                 ctkServiceException::FACTORY_ERROR);
+          plugin->d_func()->fwCtx->listeners.frameworkError(registration->plugin->q_func(), se);
+          return 0;
+        }
+        for (QStringListIterator i(classes); i.hasNext(); )
+        {
+          QString cls = i.next();
+          if (!registration->plugin->fwCtx->services->checkServiceClass(s, cls))
           {
-            ctkServiceException se("ctkServiceFactory produced null",
+            ctkServiceException se(QString("ctkServiceFactory produced an object ") +
+                                   "that did not implement: " + cls,
                                    ctkServiceException::FACTORY_ERROR);
             plugin->d_func()->fwCtx->listeners.frameworkError(registration->plugin->q_func(), se);
             return 0;
           }
-          for (QStringListIterator i(classes); i.hasNext(); )
-          {
-            QString cls = i.next();
-            if (!registration->plugin->fwCtx->services->checkServiceClass(s, cls))
-            {
-              ctkServiceException se(QString("ctkServiceFactory produced an object ") +
-                                     "that did not implement: " + cls,
-                                     ctkServiceException::FACTORY_ERROR);
-              plugin->d_func()->fwCtx->listeners.frameworkError(registration->plugin->q_func(), se);
-              return 0;
-            }
-          }
-          registration->serviceInstances.insert(plugin, s);
-        }
-        else
-        {
-          s = registration->getService();
         }
+        registration->serviceInstances.insert(plugin, s);
       }
       else
       {
         registration->dependents.insert(plugin, count + 1);
-        if (qobject_cast<ctkServiceFactory*>(registration->getService()))
-        {
-          s = registration->serviceInstances.value(plugin);
-        }
-        else
-        {
-          s = registration->getService();
-        }
+        s = registration->serviceInstances.value(plugin);
       }
     }
   }
   return s;
 }
 
+//----------------------------------------------------------------------------
+void* ctkServiceReferencePrivate::getServiceInterface(QSharedPointer<ctkPlugin> plugin, const char* iid)
+{
+  ctkServiceUse* use = acquireUse(plugin);
+  if (use)
+  {
+    ctkServiceCast* cast = use->cast.fetchAndAddOrdered(0);
+    if (cast && qstrcmp(cast->iid.constData(), iid) == 0)
+    {
+      return cast->object;
+    }
+  }
+  else
+  {
+    QObject* s = getService(plugin);
+    if (s == 0 || registration->isFactory)
+    {
+      return s ? s->qt_metacast(iid) : 0;
+    }
+    use = registration->findUse(plugin->getPluginId());
+  }
+
+  void* object = use->service ? use->service->qt_metacast(iid) : 0;
+  if (use->cast.fetchAndAddOrdered(0) == 0)
+  {
+    // Only the first requested interface is cached, the cast result never
+    // changes afterwards.
+    ctkServiceCast* cast = new ctkServiceCast(iid, object);
+    if (!use->cast.testAndSetOrdered(0, cast))
+    {
+      delete cast;
+    }
+  }
+  return object;
+}
+
 //----------------------------------------------------------------------------
 bool ctkServiceReferencePrivate::ungetService(QSharedPointer<ctkPlugin> plugin, bool checkRefCounter)
 {
+  if (checkRefCounter && releaseUse(plugin))
+  {
+    return true;
+  }
+
   QMutexLocker lock(&registration->propsLock);
   bool hadReferences = false;
   bool removeService = false;
 
+  if (!registration->isFactory)
+  {
+    ctkServiceUse* use = registration->findUse(plugin->getPluginId());
+    int count = 0;
+    if (use && checkRefCounter)
+    {
+      // fast getService() and ungetService() calls may still race with us
+      while ((count = use->count.fetchAndAddOrdered(0)) > 0 &&
+             !use->count.testAndSetOrdered(count, count - 1))
+      {
+      }
+      removeService = count == 1;
+    }
+    else if (use)
+    {
+      count = use->count.fetchAndStoreOrdered(0);
+      removeService = true;
+    }
+    if (removeService)
+    {
+      registration->dependents.remove(plugin);
+    }
+    return count > 0;
+  }
+
   int count= registration->dependents.value(plugin);
   if (count > 0)
   {
@@ -32,6 +32,7 @@ class QObject;
 
 class ctkServiceRegistrationPrivate;
 class ctkPlugin;
+struct ctkServiceUse;
 
 /**
  * \ingroup PluginFramework
@@ -52,6 +53,18 @@ public:
     */
   QObject* getService(QSharedPointer<ctkPlugin> plugin);
 
+  /**
+   * Get the service object cast to the interface with the given id.
+   * The result of the cast is cached per plugin, unless the service
+   * is a ctkServiceFactory.
+   *
+   * @param plugin requester of service.
+   * @param iid The interface id, as declared by Q_DECLARE_INTERFACE.
+   * @return Service requested or null in case of failure or if the
+   *         service does not implement the interface.
+   */
+  void* getServiceInterface(QSharedPointer<ctkPlugin> plugin, const char* iid);
+
   /**
    * Unget the service object.
    *
@@ -94,6 +107,26 @@ public:
    */
   QVariant getProperty(const QString& key, bool lock) const;
 
+  /**
+   * Increment the use count of the service by the given plugin without
+   * locking. This is only possible if the service is not a ctkServiceFactory
+   * and the plugin already uses it.
+   *
+   * @return The use count node of the plugin or <code>0</code> if
+   *         the locked path must be taken.
+   */
+  ctkServiceUse* acquireUse(const QSharedPointer<ctkPlugin>& plugin);
+
+  /**
+   * Decrement the use count of the service by the given plugin without
+   * locking. This is only possible if the service is not a ctkServiceFactory
+   * and the use count does not drop to zero.
+   *
+   * @return <code>true</code> if the use count was decremented,
+   *         <code>false</code> if the locked path must be taken.
+   */
+  bool releaseUse(const QSharedPointer<ctkPlugin>& plugin);
+
   /**
    * Reference count for implicitly shared private implementation.
    */
@@ -178,6 +178,8 @@ void ctkServiceRegistration::unregister()
     {
       QMutexLocker lock2(&d->propsLock);
       d->available = false;
+      // force lock-free getService() calls to take the locked path
+      d->resetUses();
       if (d->plugin)
       {
         for (QHashIterator<QSharedPointer<ctkPlugin>, QObject*> i(d->serviceInstances); i.hasNext();)
@@ -21,12 +21,16 @@
 
 #include "ctkServiceRegistration_p.h"
 
+#include "ctkServiceFactory.h"
+
 //----------------------------------------------------------------------------
 ctkServiceRegistrationPrivate::ctkServiceRegistrationPrivate(
   ctkPluginPrivate* plugin, QObject* service,
   const ctkDictionary& props)
   : ref(1), service(service), plugin(plugin), reference(this),
-    properties(props), available(true), unregistering(false),
+    properties(props), uses(0),
+    isFactory(qobject_cast<ctkServiceFactory*>(service) != 0),
+    available(true), unregistering(false),
     propsLock()
 {
 
@@ -35,7 +39,13 @@ ctkServiceRegistrationPrivate::ctkServiceRegistrationPrivate(
 //----------------------------------------------------------------------------
 ctkServiceRegistrationPrivate::~ctkServiceRegistrationPrivate()
 {
-
+  ctkServiceUse* use = uses.fetchAndStoreOrdered(0);
+  while (use)
+  {
+    ctkServiceUse* next = use->next;
+    delete use;
+    use = next;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -45,6 +55,40 @@ bool ctkServiceRegistrationPrivate::isUsedByPlugin(QSharedPointer<ctkPlugin> p)
   return deps.contains(p);
 }
 
+//----------------------------------------------------------------------------
+ctkServiceUse* ctkServiceRegistrationPrivate::findUse(long pluginId) const
+{
+  // Nodes are only prepended and never removed while the registration
+  // exists, hence the list can be walked without locking.
+  ctkServiceUse* use = const_cast<QAtomicPointer<ctkServiceUse>&>(uses).fetchAndAddOrdered(0);
+  while (use && use->pluginId != pluginId)
+  {
+    use = use->next;
+  }
+  return use;
+}
+
+//----------------------------------------------------------------------------
+ctkServiceUse* ctkServiceRegistrationPrivate::findOrCreateUse(long pluginId)
+{
+  ctkServiceUse* use = findUse(pluginId);
+  if (use == 0)
+  {
+    use = new ctkServiceUse(pluginId, service, uses.fetchAndAddOrdered(0));
+    uses.fetchAndStoreOrdered(use);
+  }
+  return use;
+}
+
+//----------------------------------------------------------------------------
+void ctkServiceRegistrationPrivate::resetUses()
+{
+  for (ctkServiceUse* use = uses.fetchAndAddOrdered(0); use; use = use->next)
+  {
+    use->count.fetchAndStoreOrdered(0);
+  }
+}
+
 //----------------------------------------------------------------------------
 QObject* ctkServiceRegistrationPrivate::getService()
 {
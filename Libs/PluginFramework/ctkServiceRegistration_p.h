@@ -23,6 +23,8 @@
 #ifndef CTKSERVICEREGISTRATIONPRIVATE_H
 #define CTKSERVICEREGISTRATIONPRIVATE_H
 
+#include <QAtomicPointer>
+#include <QByteArray>
 #include <QHash>
 #include <QMutex>
 
@@ -33,6 +35,66 @@
 class ctkPluginPrivate;
 class ctkServiceRegistration;
 
+/**
+ * \ingroup PluginFramework
+ *
+ * Service object of a registration cast to an interface.
+ */
+struct ctkServiceCast
+{
+  ctkServiceCast(const char* iid, void* object)
+    : iid(iid), object(object)
+  {}
+
+  const QByteArray iid;
+  void* const object;
+};
+
+/**
+ * \ingroup PluginFramework
+ *
+ * Use count of a service, which is not a ctkServiceFactory, by one plugin.
+ *
+ * A node is created (while holding the propsLock of the registration) by the
+ * first getService() call of a plugin and is kept until the registration is
+ * destroyed. Further getService() and ungetService() calls which do not
+ * change whether the plugin uses the service update the count atomically,
+ * without locking.
+ */
+struct ctkServiceUse
+{
+  ctkServiceUse(long pluginId, QObject* service, ctkServiceUse* next)
+    : pluginId(pluginId), count(0), service(service), cast(0), next(next)
+  {}
+
+  ~ctkServiceUse()
+  {
+    delete cast.fetchAndStoreOrdered(0);
+  }
+
+  const long pluginId;
+
+  /**
+   * Number of unbalanced getService() calls. Zero if the plugin does not
+   * use the service (anymore), in which case the locked path must be taken.
+   */
+  QAtomicInt count;
+
+  QObject* const service;
+
+  /**
+   * The service object cast to the first interface requested by the
+   * plugin through ctkPluginContext::getService<S>().
+   */
+  QAtomicPointer<ctkServiceCast> cast;
+
+  ctkServiceUse* const next;
+
+private:
+
+  Q_DISABLE_COPY(ctkServiceUse)
+};
+
 /**
  * \ingroup PluginFramework
  */
@@ -80,9 +142,23 @@ public:
   /**
    * Plugins dependent on this service. Integer is used as
    * reference counter, counting number of unbalanced getService().
+   * For services which are not a ctkServiceFactory the counter is
+   * kept in the corresponding ctkServiceUse node instead (the hash
+   * value is 1).
    */
   QHash<QSharedPointer<ctkPlugin>,int> dependents;
 
+  /**
+   * Lock-free list of the use counts of this service by plugin. Only used
+   * if the service is not a ctkServiceFactory.
+   */
+  QAtomicPointer<ctkServiceUse> uses;
+
+  /**
+   * Is the service object a ctkServiceFactory.
+   */
+  const bool isFactory;
+
   /**
    * Object instances that factory has produced.
    */
@@ -121,6 +197,31 @@ public:
    */
   bool isUsedByPlugin(QSharedPointer<ctkPlugin> p);
 
+  /**
+   * Find the use count of this service by the plugin with the given id.
+   * This method does not lock.
+   *
+   * @return The use count node or <code>0</code> if the plugin never got
+   *         the service.
+   */
+  ctkServiceUse* findUse(long pluginId) const;
+
+  /**
+   * Find or create the use count of this service by the plugin with the
+   * given id.
+   *
+   * @GuardedBy propsLock
+   */
+  ctkServiceUse* findOrCreateUse(long pluginId);
+
+  /**
+   * Reset the use counts of all plugins, forcing further getService() calls
+   * to take the locked path.
+   *
+   * @GuardedBy propsLock
+   */
+  void resetUses();
+
   virtual QObject* getService();
 
 private:
@@ -26,6 +26,7 @@
 #include "ctkPlugin.h"
 #include "ctkException.h"
 
+#include <QMetaObject>
 #include <QSharedData>
 
 #include <cstring>
@@ -37,7 +38,7 @@ public:
   ctkServiceSlotEntryData(QSharedPointer<ctkPlugin> p, QObject* receiver,
                           const char* slot)
     : plugin(p), receiver(receiver),
-      slot(slot), removed(false),
+      slot(slot), methodIndex(-1), removed(false),
       hashValue(0)
   {
 
@@ -64,10 +65,17 @@ public:
    */
   ctkLDAPExpr::LocalCache local_cache;
 
+  /**
+   * Object classes required by a filter which is not simple, see
+   * ctkLDAPExpr::getMatchedObjectClasses().
+   */
+  QStringList objectClassIndex;
+
   ctkLDAPExpr ldap;
   QSharedPointer<ctkPlugin> plugin;
   QObject* receiver;
   const char* slot;
+  int methodIndex;
   bool removed;
 
   uint hashValue;
@@ -120,8 +128,29 @@ bool ctkServiceSlotEntry::operator==(const ctkServiceSlotEntry& other) const
 }
 
 //----------------------------------------------------------------------------
-void ctkServiceSlotEntry::invokeSlot(const ctkServiceEvent &event)
+void ctkServiceSlotEntry::resolveSlot()
+{
+  d->methodIndex = -1;
+  if (d->receiver == 0 || d->slot == 0)
+  {
+    return;
+  }
+  QByteArray signature = QMetaObject::normalizedSignature(
+        (QByteArray(d->slot) + "(ctkServiceEvent)").constData());
+  d->methodIndex = d->receiver->metaObject()->indexOfMethod(signature.constData());
+}
+
+//----------------------------------------------------------------------------
+void ctkServiceSlotEntry::invokeSlot(const ctkServiceEvent &event) const
 {
+  if (d->methodIndex >= 0)
+  {
+    void* args[] = { 0, const_cast<void*>(reinterpret_cast<const void*>(&event)) };
+    QMetaObject::metacall(d->receiver, QMetaObject::InvokeMetaMethod, d->methodIndex, args);
+    return;
+  }
+
+  // Not resolved, let invokeMethod() report the error
   if (!QMetaObject::invokeMethod(d->receiver, d->slot,
                                  Qt::DirectConnection,
                                  Q_ARG(ctkServiceEvent, event)))
@@ -170,6 +199,12 @@ ctkLDAPExpr::LocalCache& ctkServiceSlotEntry::getLocalCache() const
   return d->local_cache;
 }
 
+//----------------------------------------------------------------------------
+QStringList& ctkServiceSlotEntry::getObjectClassIndex() const
+{
+  return d->objectClassIndex;
+}
+
 //----------------------------------------------------------------------------
 uint qHash(const ctkServiceSlotEntry& serviceSlot)
 {
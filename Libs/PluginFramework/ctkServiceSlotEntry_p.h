@@ -64,7 +64,14 @@ public:
 
   bool operator==(const ctkServiceSlotEntry& other) const;
 
-  void invokeSlot(const ctkServiceEvent& event);
+  /**
+   * Look up the meta method of the slot in the receiver's meta object,
+   * so that invokeSlot() does not have to resolve the slot by name for
+   * every event.
+   */
+  void resolveSlot();
+
+  void invokeSlot(const ctkServiceEvent& event) const;
 
   void setRemoved(bool removed);
 
@@ -78,6 +85,13 @@ public:
 
   ctkLDAPExpr::LocalCache& getLocalCache() const;
 
+  /**
+   * The object classes under which a listener with a filter which is not
+   * simple is indexed. Its filter can only match services registered
+   * under one of these classes.
+   */
+  QStringList& getObjectClassIndex() const;
+
 private:
 
   friend uint qHash(const ctkServiceSlotEntry& serviceSlot);
@@ -59,6 +59,12 @@ class ctkPluginContext;
  * <code>ctkServiceTrackerCustomizer</code> while holding any locks.
  * <code>ctkServiceTrackerCustomizer</code> implementations must also be
  * thread-safe.
+ * <p>
+ * The tracked services are kept in an immutable snapshot, sorted by service
+ * ranking, which is replaced each time a service is added, modified or
+ * removed. Hence the methods reading the tracked services (e.g.
+ * <code>getService</code>, <code>getServices</code> or <code>getTracked</code>)
+ * do not lock and do not allocate memory, and can be called at a high rate.
  *
  * \tparam S The type of the service being tracked. The type must be an
  *         assignable datatype. Further, if the
@@ -215,7 +221,8 @@ public:
    * Return a list of <code>ctkServiceReference</code>s for all services being
    * tracked by this <code>ctkServiceTracker</code>.
    *
-   * @return List of <code>ctkServiceReference</code>s.
+   * @return List of <code>ctkServiceReference</code>s, sorted by descending
+   *         service ranking and then by ascending service id.
    */
   virtual QList<ctkServiceReference> getServiceReferences() const;
 
@@ -232,8 +239,8 @@ public:
    * algorithm used by <code>ctkPluginContext::getServiceReference()</code>.
    *
    * <p>
-   * This implementation calls getServiceReferences() to get the list
-   * of references for the tracked services.
+   * This implementation returns the first reference of the ranked snapshot
+   * of the tracked services.
    *
    * @return A <code>ctkServiceReference</code> for a tracked service.
    * @throws ctkServiceException if no services are being tracked.
@@ -257,10 +264,8 @@ public:
    * <code>ctkServiceTracker</code>.
    *
    * <p>
-   * This implementation calls getServiceReferences() to get the list
-   * of references for the tracked services and then calls
-   * getService(const ctkServiceReference&) for each reference to get the
-   * tracked service object.
+   * This implementation returns the service objects of the ranked snapshot
+   * of the tracked services, in the order of getServiceReferences().
    *
    * @return A list of service objects or an empty list if no services
    *         are being tracked.
@@ -272,8 +277,8 @@ public:
    * <code>ctkServiceTracker</code>.
    *
    * <p>
-   * If any services are being tracked, this implementation returns the result
-   * of calling <code>getService(getServiceReference())</code>.
+   * If any services are being tracked, this implementation returns the
+   * service object for the reference returned by getServiceReference().
    *
    * @return A service object or <code>null</code> if no services are being
    *         tracked.
@@ -26,11 +26,9 @@
 #include "ctkPluginConstants.h"
 #include "ctkPluginContext.h"
 
-#include <QVarLengthArray>
 #include <QDebug>
 
 #include <stdexcept>
-#include <limits>
 
 //----------------------------------------------------------------------------
 template<class S, class T>
@@ -115,6 +113,8 @@ void ctkServiceTracker<S,T>::open()
         }
         /* set tracked with the initial references */
         t->setInitial(references);
+        /* publish an (empty) snapshot before events can be processed */
+        d->modified(t.data());
       }
       catch (const ctkInvalidArgumentException& e)
       {
@@ -145,9 +145,13 @@ void ctkServiceTracker<S,T>::close()
     {
       qDebug() << "ctkServiceTracker<S,T>::close:" << d->filter;
     }
-    outgoing->close();
-    references = getServiceReferences();
-    d->trackedService.clear();;
+    {
+      QMutexLocker lockT(outgoing.data());
+      outgoing->close();
+      references = getServiceReferences();
+      d->publish(0); /* clear the snapshot */
+    }
+    d->trackedService.clear();
     try
     {
       d->context->disconnectServiceListener(outgoing.data(), "serviceChanged");
@@ -157,7 +161,6 @@ void ctkServiceTracker<S,T>::close()
       /* In case the context was stopped. */
     }
   }
-  d->modified(); /* clear the cache */
   {
     QMutexLocker lockT(outgoing.data());
     outgoing->wakeAll(); /* wake up any waiters */
@@ -169,10 +172,10 @@ void ctkServiceTracker<S,T>::close()
 
   if (d->DEBUG_FLAG)
   {
-    QMutexLocker lock(&d->mutex);
-    if ((d->cachedReference.getPlugin().isNull()) && (d->cachedService == 0))
+    ctkServiceTrackerSnapshotReader<S,T> snapshot(d);
+    if (snapshot.isNull())
     {
-      qDebug() << "ctkServiceTracker<S,T>::close[cached cleared]:"
+      qDebug() << "ctkServiceTracker<S,T>::close[snapshot cleared]:"
           << d->filter;
     }
   }
@@ -212,15 +215,12 @@ template<class S, class T>
 QList<ctkServiceReference> ctkServiceTracker<S,T>::getServiceReferences() const
 {
   Q_D(const ServiceTracker);
-  QSharedPointer<TrackedService> t = d->tracked();
-  if (t.isNull())
+  ctkServiceTrackerSnapshotReader<S,T> snapshot(d);
+  if (snapshot.isNull())
   { /* if ServiceTracker is not open */
     return QList<ctkServiceReference>();
   }
-  {
-    QMutexLocker lockT(t.data());
-    return d->getServiceReferences_unlocked(t.data());
-  }
+  return snapshot->references;
 }
 
 //----------------------------------------------------------------------------
@@ -228,80 +228,17 @@ template<class S, class T>
 ctkServiceReference ctkServiceTracker<S,T>::getServiceReference() const
 {
   Q_D(const ServiceTracker);
-  ctkServiceReference reference(0);
-  {
-    QMutexLocker lock(&d->mutex);
-    reference = d->cachedReference;
-  }
-  if (!reference.getPlugin().isNull())
-  {
-    if (d->DEBUG_FLAG)
-    {
-      qDebug() << "ctkServiceTracker<S,T>::getServiceReference[cached]:"
-                   << d->filter;
-    }
-    return reference;
-  }
   if (d->DEBUG_FLAG)
   {
     qDebug() << "ctkServiceTracker<S,T>::getServiceReference:" << d->filter;
   }
-  QList<ctkServiceReference> references = getServiceReferences();
-  int length = references.size();
-  if (length == 0)
+  ctkServiceTrackerSnapshotReader<S,T> snapshot(d);
+  if (snapshot.isNull() || snapshot->references.isEmpty())
   { /* if no service is being tracked */
     throw ctkServiceException("No service is being tracked");
   }
-  int index = 0;
-  if (length > 1)
-  { /* if more than one service, select highest ranking */
-    QVarLengthArray<int, 10> rankings(length);
-    int count = 0;
-    int maxRanking = std::numeric_limits<int>::min();
-    for (int i = 0; i < length; i++)
-    {
-      bool ok = false;
-      int ranking = references[i].getProperty(ctkPluginConstants::SERVICE_RANKING).toInt(&ok);
-      if (!ok) ranking = 0;
-
-      rankings[i] = ranking;
-      if (ranking > maxRanking)
-      {
-        index = i;
-        maxRanking = ranking;
-        count = 1;
-      }
-      else
-      {
-        if (ranking == maxRanking)
-        {
-          count++;
-        }
-      }
-    }
-    if (count > 1)
-    { /* if still more than one service, select lowest id */
-      qlonglong minId = std::numeric_limits<qlonglong>::max();
-      for (int i = 0; i < length; i++)
-      {
-        if (rankings[i] == maxRanking)
-        {
-          qlonglong id = references[i].getProperty(ctkPluginConstants::SERVICE_ID).toLongLong();
-          if (id < minId)
-          {
-            index = i;
-            minId = id;
-          }
-        }
-      }
-    }
-  }
-
-  {
-    QMutexLocker lock(&d->mutex);
-    d->cachedReference = references[index];
-    return d->cachedReference;
-  }
+  /* the snapshot is sorted by ranking and service id */
+  return snapshot->references.front();
 }
 
 //----------------------------------------------------------------------------
@@ -309,15 +246,12 @@ template<class S, class T>
 T ctkServiceTracker<S,T>::getService(const ctkServiceReference& reference) const
 {
   Q_D(const ServiceTracker);
-  QSharedPointer<TrackedService> t = d->tracked();
-  if (t.isNull())
+  ctkServiceTrackerSnapshotReader<S,T> snapshot(d);
+  if (snapshot.isNull())
   { /* if ServiceTracker is not open */
     return 0;
   }
-  {
-    QMutexLocker lockT(t.data());
-    return t->getCustomizedObject(reference);
-  }
+  return snapshot->objects.value(reference);
 }
 
 //----------------------------------------------------------------------------
@@ -325,22 +259,12 @@ template<class S, class T>
 QList<T> ctkServiceTracker<S,T>::getServices() const
 {
   Q_D(const ServiceTracker);
-  QSharedPointer<TrackedService> t = d->tracked();
-  if (t.isNull())
+  ctkServiceTrackerSnapshotReader<S,T> snapshot(d);
+  if (snapshot.isNull())
   { /* if ServiceTracker is not open */
     return QList<T>();
   }
-  {
-    QMutexLocker lockT(t.data());
-    QList<ctkServiceReference> references = d->getServiceReferences_unlocked(t.data());
-    QList<T> objects;
-    foreach (ctkServiceReference ref, references)
-    {
-      //objects << getService(ref);
-      objects << t->getCustomizedObject(ref);
-    }
-    return objects;
-  }
+  return snapshot->services;
 }
 
 //----------------------------------------------------------------------------
@@ -348,34 +272,16 @@ template<class S, class T>
 T ctkServiceTracker<S,T>::getService() const
 {
   Q_D(const ServiceTracker);
-  T service = d->cachedService;
-  if (service != 0)
-  {
-    if (d->DEBUG_FLAG)
-    {
-      qDebug() << "ctkServiceTracker<S,T>::getService[cached]:"
-               << d->filter;
-    }
-    return service;
-  }
   if (d->DEBUG_FLAG)
   {
     qDebug() << "ctkServiceTracker<S,T>::getService:" << d->filter;
   }
-
-  try
-  {
-    ctkServiceReference reference = getServiceReference();
-    if (reference.getPlugin().isNull())
-    {
-      return 0;
-    }
-    return d->cachedService = getService(reference);
-  }
-  catch (const ctkServiceException&)
+  ctkServiceTrackerSnapshotReader<S,T> snapshot(d);
+  if (snapshot.isNull() || snapshot->services.isEmpty())
   {
     return 0;
   }
+  return snapshot->services.front();
 }
 
 //----------------------------------------------------------------------------
@@ -396,15 +302,12 @@ template<class S, class T>
 int ctkServiceTracker<S,T>::size() const
 {
   Q_D(const ServiceTracker);
-  QSharedPointer<TrackedService> t = d->tracked();
-  if (t.isNull())
+  ctkServiceTrackerSnapshotReader<S,T> snapshot(d);
+  if (snapshot.isNull())
   { /* if ServiceTracker is not open */
     return 0;
   }
-  {
-    QMutexLocker lockT(t.data());
-    return t->size();
-  }
+  return snapshot->references.size();
 }
 
 //----------------------------------------------------------------------------
@@ -412,32 +315,25 @@ template<class S, class T>
 int ctkServiceTracker<S,T>::getTrackingCount() const
 {
   Q_D(const ServiceTracker);
-  QSharedPointer<TrackedService> t = d->tracked();
-  if (t.isNull())
+  ctkServiceTrackerSnapshotReader<S,T> snapshot(d);
+  if (snapshot.isNull())
   { /* if ServiceTracker is not open */
     return -1;
   }
-  {
-    QMutexLocker lockT(t.data());
-    return t->getTrackingCount();
-  }
+  return snapshot->trackingCount;
 }
 
 //----------------------------------------------------------------------------
 template<class S, class T>
 QMap<ctkServiceReference, T> ctkServiceTracker<S,T>::getTracked() const
 {
-  QMap<ctkServiceReference, T> map;
   Q_D(const ServiceTracker);
-  QSharedPointer<TrackedService> t = d->tracked();
-  if (t.isNull())
+  ctkServiceTrackerSnapshotReader<S,T> snapshot(d);
+  if (snapshot.isNull())
   { /* if ServiceTracker is not open */
-    return map;
-  }
-  {
-    QMutexLocker lockT(t.data());
-    return t->copyEntries(map);
+    return QMap<ctkServiceReference, T>();
   }
+  return snapshot->tracked;
 }
 
 //----------------------------------------------------------------------------
@@ -445,15 +341,12 @@ template<class S, class T>
 bool ctkServiceTracker<S,T>::isEmpty() const
 {
   Q_D(const ServiceTracker);
-  QSharedPointer<TrackedService> t = d->tracked();
-  if (t.isNull())
+  ctkServiceTrackerSnapshotReader<S,T> snapshot(d);
+  if (snapshot.isNull())
   { /* if ServiceTracker is not open */
     return true;
   }
-  {
-    QMutexLocker lockT(t.data());
-    return t->isEmpty();
-  }
+  return snapshot->references.isEmpty();
 }
 
 //----------------------------------------------------------------------------
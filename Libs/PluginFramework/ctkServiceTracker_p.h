@@ -26,9 +26,62 @@
 #include "ctkServiceReference.h"
 #include "ctkLDAPSearchFilter.h"
 
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QHash>
+#include <QMap>
 #include <QMutex>
 #include <QSharedPointer>
 
+/**
+ * \ingroup PluginFramework
+ *
+ * Immutable view of the services tracked by a <code>ctkServiceTracker</code>.
+ * A new snapshot is published each time a service is added, modified or
+ * removed, so that the read methods of the tracker neither lock nor
+ * allocate: they only copy implicitly shared containers.
+ */
+template<class T>
+struct ctkServiceTrackerSnapshot
+{
+  ctkServiceTrackerSnapshot() : trackingCount(0), readers(0) {}
+
+  /**
+   * Tracked references, sorted by descending service ranking and then by
+   * ascending service id. The first reference is the one returned by
+   * <code>ctkServiceTracker::getServiceReference()</code>.
+   */
+  QList<ctkServiceReference> references;
+
+  /**
+   * Customized objects, in the order of <code>references</code>.
+   */
+  QList<T> services;
+
+  /**
+   * Tracked references -> customized objects.
+   */
+  QHash<ctkServiceReference, T> objects;
+
+  /**
+   * Same content as <code>objects</code>, sorted in natural order of
+   * <code>ctkServiceReference</code>.
+   */
+  QMap<ctkServiceReference, T> tracked;
+
+  /**
+   * Tracking count of the <code>ctkTrackedService</code> object when the
+   * snapshot was taken.
+   */
+  int trackingCount;
+
+  /**
+   * Number of <code>ctkServiceTrackerSnapshotReader</code> objects holding
+   * this snapshot.
+   */
+  mutable QAtomicInt readers;
+};
+
 /**
  * \ingroup PluginFramework
  */
@@ -69,8 +122,6 @@ public:
   QList<ctkServiceReference> getInitialReferences(const QString& className,
                                                   const QString& filterString);
 
-  QList<ctkServiceReference> getServiceReferences_unlocked(ctkTrackedService<S,T>* t) const;
-
   /* set this to true to compile in debug messages */
   static const bool	DEBUG_FLAG; //	= false;
 
@@ -126,26 +177,44 @@ public:
 
   /**
    * Called by the ctkTrackedService object whenever the set of tracked services is
-   * modified. Clears the cache.
+   * modified. Publishes a new snapshot of the tracked services.
+   *
+   * @GuardedBy t
    */
   /*
    * This method must not be synchronized since it is called by ctkTrackedService while
    * ctkTrackedService is synchronized. We don't want synchronization interactions
    * between the listener thread and the user thread.
    */
-  void modified();
+  void modified(ctkTrackedService<S,T>* t);
+
+  /**
+   * Replace the current snapshot by <code>snapshot</code> (which may be 0
+   * when the tracker is closed). A replaced snapshot which is still held by
+   * a reader is retired and deleted by a later call, once its readers are
+   * gone.
+   */
+  void publish(ctkServiceTrackerSnapshot<T>* snapshot);
 
   /**
-   * Cached ctkServiceReference for getServiceReference.
+   * Snapshot of the tracked services, 0 if the tracker is not open.
    */
-  mutable ctkServiceReference cachedReference;
+  mutable QAtomicPointer<ctkServiceTrackerSnapshot<T> > snapshot;
 
   /**
-   * Cached service object for getService.
+   * Number of threads which are loading the snapshot pointer and have not
+   * yet registered with the snapshot itself.
+   */
+  mutable QAtomicInt snapshotLoaders;
+
+  /**
+   * Replaced snapshots which were still in use when replaced.
    *
-   * This field is volatile since it is accessed by multiple threads.
+   * @GuardedBy snapshotMutex
    */
-  mutable T volatile cachedService;
+  QList<ctkServiceTrackerSnapshot<T>*> retiredSnapshots;
+
+  QMutex snapshotMutex;
 
   mutable QMutex mutex;
 
@@ -167,6 +236,61 @@ private:
 
 };
 
+/**
+ * \ingroup PluginFramework
+ *
+ * Gives access to the current snapshot of a <code>ctkServiceTracker</code>
+ * for the lifetime of this object. The snapshot is guaranteed not to be
+ * deleted while a reader holds it; acquiring it is wait-free.
+ */
+template<class S, class T>
+class ctkServiceTrackerSnapshotReader
+{
+
+public:
+
+  ctkServiceTrackerSnapshotReader(const ctkServiceTrackerPrivate<S,T>* d)
+    : d(d)
+  {
+    /*
+     * register as a loader before loading the pointer, and until the
+     * snapshot itself counts this reader, see publish()
+     */
+    d->snapshotLoaders.ref();
+    snapshot = d->snapshot.fetchAndAddOrdered(0);
+    if (snapshot)
+    {
+      snapshot->readers.ref();
+    }
+    d->snapshotLoaders.deref();
+  }
+
+  ~ctkServiceTrackerSnapshotReader()
+  {
+    if (snapshot)
+    {
+      snapshot->readers.deref();
+    }
+  }
+
+  bool isNull() const
+  {
+    return snapshot == 0;
+  }
+
+  const ctkServiceTrackerSnapshot<T>* operator->() const
+  {
+    return snapshot;
+  }
+
+private:
+
+  const ctkServiceTrackerPrivate<S,T>* const d;
+  const ctkServiceTrackerSnapshot<T>* snapshot;
+
+  Q_DISABLE_COPY(ctkServiceTrackerSnapshotReader)
+};
+
 #include "ctkServiceTracker_p.tpp"
 
 #endif // CTKSERVICETRACKERPRIVATE_H
@@ -26,6 +26,36 @@
 #include "ctkPluginConstants.h"
 #include "ctkLDAPSearchFilter.h"
 
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+/**
+ * Sort key of a tracked service: highest ranking first, then lowest
+ * service id.
+ */
+template<class T>
+struct ctkServiceTrackerRankedReference
+{
+  ctkServiceTrackerRankedReference(int ranking, qlonglong id,
+                                   const ctkServiceReference& reference, T service)
+    : ranking(ranking), id(id), reference(reference), service(service)
+  {}
+
+  bool operator<(const ctkServiceTrackerRankedReference& other) const
+  {
+    if (ranking != other.ranking)
+    {
+      return ranking > other.ranking;
+    }
+    return id < other.id;
+  }
+
+  int ranking;
+  qlonglong id;
+  ctkServiceReference reference;
+  T service;
+};
+
 //----------------------------------------------------------------------------
 template<class S, class T>
 const bool ctkServiceTrackerPrivate<S,T>::DEBUG_FLAG = false;
@@ -37,7 +67,7 @@ ctkServiceTrackerPrivate<S,T>::ctkServiceTrackerPrivate(
     const ctkServiceReference& reference,
     ctkServiceTrackerCustomizer<T>* customizer)
   : context(context), customizer(customizer), trackReference(reference),
-    trackedService(0), cachedReference(0), cachedService(0), q_ptr(st)
+    trackedService(0), snapshot(0), q_ptr(st)
 {
   this->customizer = customizer ? customizer : q_func();
   this->listenerFilter = QString("(") + ctkPluginConstants::SERVICE_ID +
@@ -64,8 +94,7 @@ ctkServiceTrackerPrivate<S,T>::ctkServiceTrackerPrivate(
     ctkPluginContext* context, const QString& clazz,
     ctkServiceTrackerCustomizer<T>* customizer)
       : context(context), customizer(customizer), trackClass(clazz),
-        trackReference(0), trackedService(0), cachedReference(0),
-        cachedService(0), q_ptr(st)
+        trackReference(0), trackedService(0), snapshot(0), q_ptr(st)
 {
   this->customizer = customizer ? customizer : q_func();
   this->listenerFilter = QString("(") + ctkPluginConstants::OBJECTCLASS + "="
@@ -94,7 +123,7 @@ ctkServiceTrackerPrivate<S,T>::ctkServiceTrackerPrivate(
     ctkServiceTrackerCustomizer<T>* customizer)
       : context(context), filter(filter), customizer(customizer),
         listenerFilter(filter.toString()), trackReference(0),
-        trackedService(0), cachedReference(0), cachedService(0), q_ptr(st)
+        trackedService(0), snapshot(0), q_ptr(st)
 {
   this->customizer = customizer ? customizer : q_func();
   if (context == 0)
@@ -107,7 +136,8 @@ ctkServiceTrackerPrivate<S,T>::ctkServiceTrackerPrivate(
 template<class S, class T>
 ctkServiceTrackerPrivate<S,T>::~ctkServiceTrackerPrivate()
 {
-
+  delete snapshot.fetchAndStoreOrdered(0);
+  qDeleteAll(retiredSnapshots);
 }
 
 //----------------------------------------------------------------------------
@@ -120,30 +150,85 @@ QList<ctkServiceReference> ctkServiceTrackerPrivate<S,T>::getInitialReferences(c
 
 //----------------------------------------------------------------------------
 template<class S, class T>
-QList<ctkServiceReference> ctkServiceTrackerPrivate<S,T>::getServiceReferences_unlocked(ctkTrackedService<S,T>* t) const
+QSharedPointer<ctkTrackedService<S,T> > ctkServiceTrackerPrivate<S,T>::tracked() const
 {
-  if (t->size() == 0)
-  {
-    return QList<ctkServiceReference>();
-  }
-  return t->getTracked();
+  return trackedService;
 }
 
 //----------------------------------------------------------------------------
 template<class S, class T>
-QSharedPointer<ctkTrackedService<S,T> > ctkServiceTrackerPrivate<S,T>::tracked() const
+void ctkServiceTrackerPrivate<S,T>::modified(ctkTrackedService<S,T>* t)
 {
-  return trackedService;
+  if (t->closed)
+  {
+    /* close() publishes the final (empty) state */
+    return;
+  }
+  if (DEBUG_FLAG)
+  {
+    qDebug() << "ctkServiceTracker::modified:" << filter;
+  }
+
+  ctkServiceTrackerSnapshot<T>* newSnapshot = new ctkServiceTrackerSnapshot<T>();
+  newSnapshot->trackingCount = t->getTrackingCount();
+  newSnapshot->objects = t->getTrackedEntries();
+
+  /* read the ranking properties once per modification instead of on every lookup */
+  QList<ctkServiceTrackerRankedReference<T> > ranked;
+  typename QHash<ctkServiceReference, T>::ConstIterator end = newSnapshot->objects.end();
+  for (typename QHash<ctkServiceReference, T>::ConstIterator it = newSnapshot->objects.begin();
+       it != end; ++it)
+  {
+    bool ok = false;
+    int ranking = it.key().getProperty(ctkPluginConstants::SERVICE_RANKING).toInt(&ok);
+    if (!ok) ranking = 0;
+    qlonglong id = it.key().getProperty(ctkPluginConstants::SERVICE_ID).toLongLong();
+    ranked.push_back(ctkServiceTrackerRankedReference<T>(ranking, id, it.key(), it.value()));
+  }
+  std::sort(ranked.begin(), ranked.end());
+
+  for (int i = 0; i < ranked.size(); ++i)
+  {
+    newSnapshot->references.push_back(ranked[i].reference);
+    newSnapshot->services.push_back(ranked[i].service);
+    newSnapshot->tracked.insert(ranked[i].reference, ranked[i].service);
+  }
+
+  publish(newSnapshot);
 }
 
 //----------------------------------------------------------------------------
 template<class S, class T>
-void ctkServiceTrackerPrivate<S,T>::modified()
+void ctkServiceTrackerPrivate<S,T>::publish(ctkServiceTrackerSnapshot<T>* newSnapshot)
 {
-  cachedReference = 0; /* clear cached value */
-  cachedService = 0; /* clear cached value */
-  if (DEBUG_FLAG)
+  QMutexLocker lock(&snapshotMutex);
+  ctkServiceTrackerSnapshot<T>* oldSnapshot = snapshot.fetchAndStoreOrdered(newSnapshot);
+  if (oldSnapshot)
   {
-    qDebug() << "ctkServiceTracker::modified:" << filter;
+    retiredSnapshots.push_back(oldSnapshot);
+  }
+  /*
+   * Readers register as loaders before loading the snapshot pointer and
+   * count themselves in the loaded snapshot before they unregister. If
+   * there is no loader now, a reader registering later loads the new
+   * snapshot, and the reader count of a retired snapshot can only drop: a
+   * snapshot without readers can be deleted, independent of the others.
+   */
+  if (snapshotLoaders.fetchAndAddOrdered(0) != 0)
+  {
+    return;
+  }
+  typename QList<ctkServiceTrackerSnapshot<T>*>::Iterator it = retiredSnapshots.begin();
+  while (it != retiredSnapshots.end())
+  {
+    if ((*it)->readers.fetchAndAddOrdered(0) == 0)
+    {
+      delete *it;
+      it = retiredSnapshots.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
   }
 }
@@ -100,7 +100,7 @@ template<class S, class T>
 void ctkTrackedService<S,T>::modified()
 {
   Superclass::modified(); /* increment the modification count */
-  serviceTracker->d_func()->modified();
+  serviceTracker->d_func()->modified(this);
 }
 
 //----------------------------------------------------------------------------
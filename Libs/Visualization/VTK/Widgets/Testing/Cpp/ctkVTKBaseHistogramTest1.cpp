@@ -0,0 +1,183 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QVector>
+
+// CTKVTK includes
+#include "ctkVTKBaseHistogram_p.h"
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+bool fuzzyCompare(double value, double expected)
+{
+  return std::fabs(value - expected) < 1e-9;
+}
+
+//-----------------------------------------------------------------------------
+bool checkFrequencies(int line, const QVector<double>& frequencies,
+                      const double* expected, int size)
+{
+  bool same = frequencies.size() == size;
+  for (int i = 0; same && i < size; ++i)
+  {
+    same = fuzzyCompare(frequencies[i], expected[i]);
+  }
+  if (!same)
+  {
+    std::cerr << "Line " << line << " - Problem with rebin(): got";
+    for (int i = 0; i < frequencies.size(); ++i)
+    {
+      std::cerr << " " << frequencies[i];
+    }
+    std::cerr << ", expected";
+    for (int i = 0; i < size; ++i)
+    {
+      std::cerr << " " << expected[i];
+    }
+    std::cerr << std::endl;
+  }
+  return same;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int ctkVTKBaseHistogramTest1(int argc, char * argv [])
+{
+  Q_UNUSED(argc);
+  Q_UNUSED(argv);
+
+  QVector<double> frequencies;
+
+  // an empty histogram can't be rebinned
+  ctkVTKBaseHistogram emptyHistogram;
+  if (emptyHistogram.isValid()
+      || emptyHistogram.rebin(0., 1., 4, frequencies))
+  {
+    std::cerr << "Line " << __LINE__
+              << " - Problem with an invalid histogram" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // 4 base bins of width 1 covering [0, 4]
+  ctkVTKBaseHistogram histogram;
+  histogram.Origin = 0.;
+  histogram.Spacing = 1.;
+  histogram.Bins << 1 << 2 << 3 << 4;
+  histogram.Min = 0.;
+  histogram.Max = 4.;
+  if (!histogram.isValid())
+  {
+    std::cerr << "Line " << __LINE__
+              << " - Problem with isValid()" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // same bins
+  if (!histogram.rebin(0., 1., 4, frequencies))
+  {
+    std::cerr << "Line " << __LINE__ << " - rebin() failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const double identity[] = {1., 2., 3., 4.};
+  if (!checkFrequencies(__LINE__, frequencies, identity, 4))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // bins aligned with the base bins
+  if (!histogram.rebin(0., 2., 2, frequencies))
+  {
+    std::cerr << "Line " << __LINE__ << " - rebin() failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const double aligned[] = {3., 7.};
+  if (!checkFrequencies(__LINE__, frequencies, aligned, 2))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // base bins straddling the borders are split proportionally, the half
+  // of the first base bin below the origin is dropped
+  if (!histogram.rebin(0.5, 2., 2, frequencies))
+  {
+    std::cerr << "Line " << __LINE__ << " - rebin() failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const double straddling[] = {4., 5.5};
+  if (!checkFrequencies(__LINE__, frequencies, straddling, 2))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // base bins outside of the requested bins are ignored
+  const double empty[] = {0., 0., 0.};
+  if (!histogram.rebin(10., 1., 3, frequencies)
+      || !checkFrequencies(__LINE__, frequencies, empty, 3))
+  {
+    return EXIT_FAILURE;
+  }
+  if (!histogram.rebin(-10., 1., 3, frequencies)
+      || !checkFrequencies(__LINE__, frequencies, empty, 3))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // a visible range within the base range
+  if (!histogram.rebin(1., 1., 2, frequencies))
+  {
+    std::cerr << "Line " << __LINE__ << " - rebin() failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const double visible[] = {2., 3.};
+  if (!checkFrequencies(__LINE__, frequencies, visible, 2))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // bins narrower than the base bins need a rescan of the input
+  if (histogram.rebin(0., 0.5, 8, frequencies))
+  {
+    std::cerr << "Line " << __LINE__
+              << " - rebin() must fail for narrower bins" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // clear() resets the bins and the statistics of the whole input
+  histogram.Mean = 2.5;
+  histogram.clear();
+  if (histogram.isValid() || histogram.Mean != 0.
+      || histogram.Min != 0. || histogram.Max != 0.)
+  {
+    std::cerr << "Line " << __LINE__
+              << " - Problem with clear()" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
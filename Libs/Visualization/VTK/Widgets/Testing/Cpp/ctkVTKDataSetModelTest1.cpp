@@ -82,6 +82,28 @@ bool checkItems(int line,
   return true;
 }
 
+//-----------------------------------------------------------------------------
+/// Counts the item updates and gives access to the array modification slots
+class ctkVTKDataSetModelItemUpdateCounter : public ctkVTKDataSetModel
+{
+public:
+  ctkVTKDataSetModelItemUpdateCounter() : ItemUpdates(0) {}
+
+  void arrayModified(vtkAbstractArray* array)
+    {
+    this->onArrayModified(array);
+    }
+
+  int ItemUpdates;
+
+protected:
+  virtual void updateItemFromArray(QStandardItem* item, vtkAbstractArray* array, int location, int column)
+    {
+    ++this->ItemUpdates;
+    this->ctkVTKDataSetModel::updateItemFromArray(item, array, location, column);
+    }
+};
+
 } // end namespace
 
 //-----------------------------------------------------------------------------
@@ -406,6 +428,77 @@ int ctkVTKDataSetModelTest1(int argc, char * argv [] )
     return EXIT_FAILURE;
     }
 
+  // Adding or removing an array only changes its row, the items of the
+  // other arrays are kept
+  QList<QStandardItem*> intsItems = dataSetModel.findItems("Ints");
+  int rowCount = dataSetModel.rowCount();
+  vtkNew<vtkIntArray> intsLaterAdded2;
+  {
+    intsLaterAdded2->SetName("IntsLaterAdded2");
+    dataSet->GetCellData()->AddArray(intsLaterAdded2.GetPointer());
+    locations[intsLaterAdded2.GetPointer()] = vtkAssignAttribute::CELL_DATA;
+  }
+  if (dataSetModel.rowCount() != rowCount + 1
+      || dataSetModel.findItems("Ints") != intsItems
+      || !checkItems(__LINE__, QList<vtkAbstractArray*>() << intsLaterAdded2.GetPointer(),
+                     &dataSetModel, locations))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with model update after adding an array\n"
+                  "\tExpected row count: " << rowCount + 1 << "\n"
+                  "\tCurrent row count: " << dataSetModel.rowCount() << "\n";
+    return EXIT_FAILURE;
+    }
+  dataSet->GetCellData()->RemoveArray("Floats");
+  if (dataSetModel.rowCount() != rowCount
+      || dataSetModel.findItems("Ints") != intsItems
+      || dataSetModel.findItems("Floats").count() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with model update after removing an array\n"
+                  "\tExpected row count: " << rowCount << "\n"
+                  "\tCurrent row count: " << dataSetModel.rowCount() << "\n";
+    return EXIT_FAILURE;
+    }
+
+  // Array modifications are applied to the items once, in the next event
+  // loop iteration
+  ctkVTKDataSetModelItemUpdateCounter countingModel;
+  countingModel.setDataSet(dataSet.GetPointer());
+  ints->SetName("IntsRenamed");
+  countingModel.arrayModified(ints.GetPointer());
+  ints->SetName("IntsRenamedTwice");
+  countingModel.arrayModified(ints.GetPointer());
+  countingModel.ItemUpdates = 0;
+  if (countingModel.findItems("IntsRenamedTwice").count() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with model - Array modification applied before the event loop\n";
+    return EXIT_FAILURE;
+    }
+  QApplication::processEvents();
+  QApplication::processEvents();
+  if (countingModel.ItemUpdates != countingModel.columnCount()
+      || countingModel.findItems("IntsRenamedTwice").count() != 1
+      || countingModel.findItems("Ints").count() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with model update after modifying an array\n"
+                  "\tExpected item updates: " << countingModel.columnCount() << "\n"
+                  "\tCurrent item updates: " << countingModel.ItemUpdates << "\n";
+    return EXIT_FAILURE;
+    }
+
+  // A modification of the data set only refreshes the rows of the arrays
+  // whose modification time changed
+  ints->SetName("Ints");
+  countingModel.ItemUpdates = 0;
+  dataSet->GetPointData()->Modified();
+  if (countingModel.ItemUpdates != countingModel.columnCount()
+      || countingModel.findItems("Ints").count() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with model update after modifying the data set\n"
+                  "\tExpected item updates: " << countingModel.columnCount() << "\n"
+                  "\tCurrent item updates: " << countingModel.ItemUpdates << "\n";
+    return EXIT_FAILURE;
+    }
+
   QComboBox comboBox;
   comboBox.setModel(&dataSetModel);
   comboBox.show();
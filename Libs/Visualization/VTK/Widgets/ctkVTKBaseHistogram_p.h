@@ -0,0 +1,107 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkVTKBaseHistogram_p_h
+#define __ctkVTKBaseHistogram_p_h
+
+// Qt includes
+#include <QVector>
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+/// \ingroup Visualization_VTK_Widgets
+/// Histogram of the whole scalar range of an input, computed once per
+/// input modification at a much higher resolution than the displayed one.
+/// Histograms of a visible range are derived from it by rebinning.
+struct ctkVTKBaseHistogram
+{
+  ctkVTKBaseHistogram()
+    : Origin(0.), Spacing(1.), Min(0.), Max(0.), Mean(0.)
+  {}
+
+  bool isValid() const
+  {
+    return !this->Bins.isEmpty();
+  }
+
+  void clear()
+  {
+    this->Bins.clear();
+    this->Min = this->Max = this->Mean = 0.;
+  }
+
+  /// Distributes the base bins over \a numberOfBins bins starting at
+  /// \a origin. Returns false if the requested bins are narrower than the
+  /// base bins, a rescan of the input is needed then.
+  bool rebin(double origin, double spacing, int numberOfBins,
+             QVector<double>& frequencies) const
+  {
+    if (!this->isValid() || spacing < this->Spacing * (1. - 1e-6))
+    {
+      return false;
+    }
+    frequencies.fill(0., numberOfBins);
+    for (int k = 0; k < this->Bins.size(); ++k)
+    {
+      double count = static_cast<double>(this->Bins[k]);
+      if (count == 0.)
+      {
+        continue;
+      }
+      double begin = this->Origin + k * this->Spacing;
+      int first = static_cast<int>(std::floor((begin - origin) / spacing));
+      int last = static_cast<int>(std::floor((begin + this->Spacing - origin) / spacing));
+      if (last < 0 || first >= numberOfBins)
+      {
+        continue;
+      }
+      if (first == last)
+      {
+        frequencies[first] += count;
+        continue;
+      }
+      // the base bin straddles the border between two bins
+      double fraction = (origin + (first + 1) * spacing - begin) / this->Spacing;
+      if (first >= 0)
+      {
+        frequencies[first] += count * fraction;
+      }
+      if (first + 1 < numberOfBins)
+      {
+        frequencies[first + 1] += count * (1. - fraction);
+      }
+    }
+    return true;
+  }
+
+  double Origin;
+  double Spacing;
+  QVector<vtkIdType> Bins;
+  double Min;
+  double Max;
+  double Mean;
+};
+
+#endif
@@ -20,6 +20,10 @@
 
 // Qt includes
 #include <QDebug>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QTimer>
 
 // CTK includes
 #include "ctkVTKDataSetModel.h"
@@ -46,6 +50,18 @@ public:
   static QList<vtkAbstractArray*> attributeArrayToInsert(const ctkVTKDataSetModel::AttributeTypes& attributeType,
                                                      vtkDataSetAttributes * dataSetAttributes);
 
+  /// An array and its location (point or cell data) identify a row.
+  typedef QPair<vtkAbstractArray*, int> ArrayLocation;
+
+  /// Arrays and locations the model should list, in the order of the rows.
+  QList<ArrayLocation> arrayLocationsToInsert()const;
+  static ArrayLocation arrayLocation(QStandardItem* item);
+
+  /// Update the items of the row if the array has been modified since
+  /// the items were last updated. Only the array MTime is compared, see
+  /// ctkVTKDataSetModel::updateItemFromArray().
+  void updateRowIfModified(int row);
+
   vtkSmartPointer<vtkDataSet> DataSet;
   vtkSmartPointer<vtkPointData> DataSetPointData;
   vtkSmartPointer<vtkCellData> DataSetCellData;
@@ -53,6 +69,11 @@ public:
   bool ListenAbstractArrayModifiedEvent;
   ctkVTKDataSetModel::AttributeTypes AttributeType;
   bool IncludeNullItem;
+
+  /// Modification time of the arrays when their items were last updated
+  QHash<vtkAbstractArray*, vtkMTimeType> ArrayMTimes;
+  /// Arrays modified since the last event loop iteration
+  QSet<vtkAbstractArray*> ModifiedArrays;
 };
 
 
@@ -136,6 +157,60 @@ QList<vtkAbstractArray*> ctkVTKDataSetModelPrivate::attributeArrayToInsert(
   return attributeArraysToInsert;
 }
 
+//------------------------------------------------------------------------------
+QList<ctkVTKDataSetModelPrivate::ArrayLocation>
+ctkVTKDataSetModelPrivate::arrayLocationsToInsert()const
+{
+  QList<ArrayLocation> arrayLocations;
+  if (this->DataSet.GetPointer() == 0)
+    {
+    return arrayLocations;
+    }
+  foreach(vtkAbstractArray* attributeArray,
+    attributeArrayToInsert(this->AttributeType, this->DataSet->GetPointData()))
+    {
+    if (attributeArray)
+      {
+      arrayLocations << ArrayLocation(attributeArray, vtkAssignAttribute::POINT_DATA);
+      }
+    }
+  foreach(vtkAbstractArray* attributeArray,
+    attributeArrayToInsert(this->AttributeType, this->DataSet->GetCellData()))
+    {
+    if (attributeArray)
+      {
+      arrayLocations << ArrayLocation(attributeArray, vtkAssignAttribute::CELL_DATA);
+      }
+    }
+  return arrayLocations;
+}
+
+//------------------------------------------------------------------------------
+ctkVTKDataSetModelPrivate::ArrayLocation
+ctkVTKDataSetModelPrivate::arrayLocation(QStandardItem* item)
+{
+  return ArrayLocation(static_cast<vtkAbstractArray*>(
+                         reinterpret_cast<void *>(item->data(ctkVTK::PointerRole).toLongLong())),
+                       item->data(ctkVTK::LocationRole).toInt());
+}
+
+//------------------------------------------------------------------------------
+void ctkVTKDataSetModelPrivate::updateRowIfModified(int row)
+{
+  Q_Q(ctkVTKDataSetModel);
+  ArrayLocation arrayLocation = this->arrayLocation(q->item(row));
+  vtkAbstractArray* array = arrayLocation.first;
+  if (array->GetMTime() <= this->ArrayMTimes.value(array, 0))
+    {
+    return;
+    }
+  this->ArrayMTimes[array] = array->GetMTime();
+  for (int column = 0; column < q->columnCount(); ++column)
+    {
+    q->updateItemFromArray(q->item(row, column), array, arrayLocation.second, column);
+    }
+}
+
 //------------------------------------------------------------------------------
 // ctkVTKDataSetModel
 
@@ -318,30 +393,103 @@ void ctkVTKDataSetModel::updateDataSet()
 {
   Q_D(ctkVTKDataSetModel);
 
-  // Remove all items (except the first one, if there is a NULL item)
+  // Keep the first item if it is the NULL item
+  int firstRow = 0;
   if (d->IncludeNullItem)
     {
     if (this->rowCount()<1)
       {
       this->insertNullItem();
       }
-    else
+    firstRow = 1;
+    }
+
+  if (this->rowCount() == firstRow)
+    {
+    if (d->DataSet.GetPointer() != 0)
       {
-      this->setRowCount(1);
+      // Populate scene with nodes
+      this->populateDataSet();
       }
+    return;
     }
-  else
+
+  // Only insert, remove or move the rows of the arrays that changed: data
+  // sets with hundreds of arrays are modified at each pipeline update.
+  typedef ctkVTKDataSetModelPrivate::ArrayLocation ArrayLocation;
+  QList<ArrayLocation> arrayLocations = d->arrayLocationsToInsert();
+  QSet<ArrayLocation> expectedArrayLocations;
+  QSet<vtkAbstractArray*> expectedArrays;
+  foreach(const ArrayLocation& arrayLocation, arrayLocations)
     {
-    this->setRowCount(0);
+    expectedArrayLocations.insert(arrayLocation);
+    expectedArrays.insert(arrayLocation.first);
     }
 
-  if (d->DataSet.GetPointer() == 0)
+  // Remove the rows of the arrays that are not listed anymore, contiguous
+  // rows at once
+  QSet<ArrayLocation> currentArrayLocations;
+  int lastRowToRemove = -1;
+  for (int row = this->rowCount() - 1; row >= firstRow - 1; --row)
     {
-    return;
+    bool removeRow = false;
+    if (row >= firstRow)
+      {
+      ArrayLocation arrayLocation = d->arrayLocation(this->item(row));
+      removeRow = !expectedArrayLocations.contains(arrayLocation)
+        || currentArrayLocations.contains(arrayLocation);
+      if (removeRow)
+        {
+        if (!expectedArrays.contains(arrayLocation.first))
+          {
+          d->ArrayMTimes.remove(arrayLocation.first);
+          d->ModifiedArrays.remove(arrayLocation.first);
+          if (d->ListenAbstractArrayModifiedEvent)
+            {
+            qvtkDisconnect(arrayLocation.first, vtkCommand::ModifiedEvent,
+                           this, SLOT(onArrayModified(vtkObject*)));
+            }
+          }
+        lastRowToRemove = lastRowToRemove < 0 ? row : lastRowToRemove;
+        }
+      else
+        {
+        currentArrayLocations.insert(arrayLocation);
+        }
+      }
+    if (!removeRow && lastRowToRemove >= 0)
+      {
+      this->removeRows(row + 1, lastRowToRemove - row);
+      lastRowToRemove = -1;
+      }
     }
 
-  // Populate scene with nodes
-  this->populateDataSet();
+  // Insert the new arrays and move the rows that are not at their place
+  for (int i = 0; i < arrayLocations.count(); ++i)
+    {
+    const ArrayLocation& arrayLocation = arrayLocations[i];
+    int row = firstRow + i;
+    if (row < this->rowCount() && d->arrayLocation(this->item(row)) == arrayLocation)
+      {
+      d->updateRowIfModified(row);
+      continue;
+      }
+    if (!currentArrayLocations.contains(arrayLocation))
+      {
+      this->insertArray(arrayLocation.first, arrayLocation.second, row);
+      continue;
+      }
+    for (int currentRow = row + 1; currentRow < this->rowCount(); ++currentRow)
+      {
+      if (d->arrayLocation(this->item(currentRow)) == arrayLocation)
+        {
+        this->insertRow(row, this->takeRow(currentRow));
+        d->updateRowIfModified(row);
+        break;
+        }
+      }
+    }
+  Q_ASSERT(this->rowCount() == firstRow + arrayLocations.count());
 }
 
 //------------------------------------------------------------------------------
@@ -388,6 +536,7 @@ void ctkVTKDataSetModel
     items.append(newArrayItem);
     }
   this->insertRow(row,items);
+  d->ArrayMTimes[array] = array->GetMTime();
   // TODO: don't listen to nodes that are hidden from editors ?
   if (d->ListenAbstractArrayModifiedEvent)
     {
@@ -497,15 +646,44 @@ void ctkVTKDataSetModel::onDataSetCellDataModified(vtkObject* dataSetCellData)
 //------------------------------------------------------------------------------
 void ctkVTKDataSetModel::onArrayModified(vtkObject* modifiedArray)
 {
+  Q_D(ctkVTKDataSetModel);
   vtkAbstractArray* array = vtkAbstractArray::SafeDownCast(modifiedArray);
   Q_ASSERT(array);
-  QModelIndexList arrayIndexes = this->indexes(array);
 
-  foreach (QModelIndex index, arrayIndexes)
+  // Arrays are typically modified many times per pipeline update, the
+  // items are updated once in the next event loop iteration.
+  if (d->ModifiedArrays.isEmpty())
+    {
+    QTimer::singleShot(0, this, SLOT(updateModifiedArrayItems()));
+    }
+  d->ModifiedArrays.insert(array);
+}
+
+//------------------------------------------------------------------------------
+void ctkVTKDataSetModel::updateModifiedArrayItems()
+{
+  Q_D(ctkVTKDataSetModel);
+  if (d->ModifiedArrays.isEmpty())
+    {
+    return;
+    }
+  QSet<vtkAbstractArray*> modifiedArrays = d->ModifiedArrays;
+  d->ModifiedArrays.clear();
+
+  for (int row = 0; row < this->rowCount(); ++row)
     {
-    QStandardItem* item = this->itemFromIndex(index);
-    this->updateItemFromArray(
-      item, array, item->data(ctkVTK::LocationRole).toInt(), item->column());
+    ctkVTKDataSetModelPrivate::ArrayLocation arrayLocation =
+      d->arrayLocation(this->item(row));
+    if (!modifiedArrays.contains(arrayLocation.first))
+      {
+      continue;
+      }
+    d->ArrayMTimes[arrayLocation.first] = arrayLocation.first->GetMTime();
+    for (int column = 0; column < this->columnCount(); ++column)
+      {
+      this->updateItemFromArray(this->item(row, column), arrayLocation.first,
+                                arrayLocation.second, column);
+      }
     }
 }
 
@@ -122,6 +122,9 @@ protected Q_SLOTS:
   void onDataSetCellDataModified(vtkObject* dataSetCellData);
   void onArrayModified(vtkObject* array);
   void onItemChanged(QStandardItem * item);
+  /// Update the items of the arrays modified since the last event loop
+  /// iteration.
+  void updateModifiedArrayItems();
 
 protected:
 
@@ -129,8 +132,17 @@ protected:
 
   virtual void insertArray(vtkAbstractArray* array, int location);
   virtual void insertArray(vtkAbstractArray* array, int location, int row);
+  /// Called when a row is inserted, and for the rows whose array modification
+  /// time (vtkObject::GetMTime()) changed since their items were last updated.
+  /// Items are therefore not refreshed for array changes that do not call
+  /// Modified() (e.g. values written through GetVoidPointer()), nor for state
+  /// outside of the array; a subclass displaying such state must update its
+  /// items itself.
   virtual void updateItemFromArray(QStandardItem* item, vtkAbstractArray* array, int location, int column);
   virtual void updateArrayFromItem(vtkAbstractArray* array, QStandardItem* item);
+  /// Synchronize the rows with the arrays of the data set: only the rows
+  /// of added, removed or moved arrays are changed.
+  /// populateDataSet() is called when the model has no array row yet.
   virtual void updateDataSet();
   virtual void populateDataSet();
   virtual void insertNullItem();
@@ -23,6 +23,7 @@
 // CTK includes
 #include "ctkColorPickerButton.h"
 #include "ctkDoubleSlider.h"
+#include "ctkVTKBaseHistogram_p.h"
 #include "ctkVTKOpenGLNativeWidget.h"
 #include "ctkVTKScalarsToColorsComboBox.h"
 #include "ctkVTKScalarsToColorsUtils.h"
@@ -34,23 +35,29 @@
 #include <QCheckBox>
 #include <QDebug>
 #include <QDoubleValidator>
+#include <QElapsedTimer>
 #include <QHBoxLayout>
 #include <QIcon>
 #include <QLineEdit>
 #include <QLabel>
 #include <QMenu>
+#include <QMutex>
 #include <QPushButton>
 #include <QSpinBox>
+#include <QThread>
 #include <QTime>
+#include <QTimer>
 #include <QToolButton>
 #include <QVBoxLayout>
 #include <QWidgetAction>
 
 // VTK includes
+#include <vtkAlgorithmOutput.h>
 #include <vtkCallbackCommand.h>
 #include <vtkContextScene.h>
 #include <vtkContextView.h>
 #include <vtkControlPointsItem.h>
+#include <vtkDataArray.h>
 #include <vtkDiscretizableColorTransferFunction.h>
 #include <vtkDoubleArray.h>
 #include <vtkEventQtSlotConnect.h>
@@ -58,14 +65,232 @@
 #include <vtkIntArray.h>
 #include <vtkImageAccumulate.h>
 #include <vtkImageData.h>
+#include <vtkMath.h>
 #include <vtkPiecewiseFunction.h>
+#include <vtkPointData.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkScalarsToColors.h>
 #include <vtkTable.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 //#define DEBUG_RANGE
 
+namespace
+{
+
+/// Inputs with at most this number of scalars are histogrammed in the
+/// calling thread, larger ones in a worker thread.
+const vtkIdType SynchronousHistogramSize = 1 << 21;
+
+/// Number of scalars processed between two abort checks and
+/// progressive updates of the worker thread.
+const vtkIdType HistogramChunkSize = 1 << 20;
+
+/// Number of bins of the base histogram of floating point data and of
+/// integer data whose range is wider than this.
+const vtkIdType BaseHistogramBins = 1 << 14;
+
+// ----------------------------------------------------------------------------
+template <class T>
+void ctkVTKScalarRange(const T* values, vtkIdType begin, vtkIdType end,
+                       int step, double& min, double& max)
+{
+  for (vtkIdType i = begin; i < end; ++i)
+  {
+    double value = static_cast<double>(values[i * step]);
+    if (!vtkMath::IsFinite(value))
+    {
+      continue;
+    }
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+}
+
+// ----------------------------------------------------------------------------
+template <class T>
+void ctkVTKAccumulateScalars(const T* values, vtkIdType begin, vtkIdType end,
+                             int step, double origin, double spacing,
+                             vtkIdType* bins, vtkIdType lastBin,
+                             double& sum, vtkIdType& count)
+{
+  for (vtkIdType i = begin; i < end; ++i)
+  {
+    double value = static_cast<double>(values[i * step]);
+    if (!vtkMath::IsFinite(value))
+    {
+      continue;
+    }
+    vtkIdType bin = static_cast<vtkIdType>((value - origin) / spacing);
+    ++bins[std::max<vtkIdType>(0, std::min(bin, lastBin))];
+    sum += value;
+    ++count;
+  }
+}
+
+class ctkVTKHistogramWorker;
+
+// ----------------------------------------------------------------------------
+/// Computes the base histogram of the first component of \a scalars.
+/// When a \a worker is given, the computation can be aborted and partial
+/// results are published to the worker while the bins are accumulated.
+bool ctkVTKComputeBaseHistogram(vtkDataArray* scalars,
+                                ctkVTKBaseHistogram& histogram,
+                                ctkVTKHistogramWorker* worker);
+
+// ----------------------------------------------------------------------------
+class ctkVTKHistogramWorker : public QThread
+{
+public:
+  ctkVTKHistogramWorker(vtkDataArray* scalars)
+    : Scalars(scalars)
+    , Aborted(0)
+  {}
+
+  void abort()
+  {
+    this->Aborted.fetchAndStoreOrdered(1);
+  }
+
+  bool isAborted()
+  {
+    return this->Aborted.fetchAndAddOrdered(0) != 0;
+  }
+
+  /// Copies the histogram accumulated so far. Returns false if no bins
+  /// have been published yet.
+  bool snapshot(ctkVTKBaseHistogram& histogram)
+  {
+    QMutexLocker lock(&this->Mutex);
+    if (!this->Published.isValid())
+    {
+      return false;
+    }
+    histogram = this->Published;
+    return true;
+  }
+
+  void publish(const ctkVTKBaseHistogram& histogram)
+  {
+    QMutexLocker lock(&this->Mutex);
+    this->Published = histogram;
+  }
+
+protected:
+  virtual void run()
+  {
+    ctkVTKBaseHistogram histogram;
+    if (ctkVTKComputeBaseHistogram(this->Scalars, histogram, this))
+    {
+      this->publish(histogram);
+    }
+  }
+
+  vtkSmartPointer<vtkDataArray> Scalars;
+  QAtomicInt Aborted;
+  QMutex Mutex;
+  ctkVTKBaseHistogram Published;
+};
+
+// ----------------------------------------------------------------------------
+bool ctkVTKComputeBaseHistogram(vtkDataArray* scalars,
+                                ctkVTKBaseHistogram& histogram,
+                                ctkVTKHistogramWorker* worker)
+{
+  histogram.clear();
+  if (!scalars || !scalars->HasStandardMemoryLayout())
+  {
+    return false;
+  }
+  const vtkIdType size = scalars->GetNumberOfTuples();
+  const int step = scalars->GetNumberOfComponents();
+  void* values = scalars->GetVoidPointer(0);
+
+  // first pass: range of the finite values
+  double range[2] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+  for (vtkIdType begin = 0; begin < size; begin += HistogramChunkSize)
+  {
+    if (worker && worker->isAborted())
+    {
+      return false;
+    }
+    vtkIdType end = std::min(size, begin + HistogramChunkSize);
+    switch (scalars->GetDataType())
+    {
+      vtkTemplateMacro(ctkVTKScalarRange(static_cast<VTK_TT*>(values),
+                                         begin, end, step, range[0], range[1]));
+      default:
+        return false;
+    }
+  }
+  if (range[0] > range[1])
+  {
+    return false;
+  }
+
+  // Integer data with a moderate range gets one bin per value, everything
+  // else a fixed number of bins
+  vtkIdType numberOfBins = BaseHistogramBins;
+  double origin = range[0];
+  double spacing = (range[1] - range[0]) / numberOfBins;
+  const bool integer = scalars->GetDataType() != VTK_FLOAT
+                    && scalars->GetDataType() != VTK_DOUBLE;
+  if (integer && range[1] - range[0] < BaseHistogramBins)
+  {
+    numberOfBins = static_cast<vtkIdType>(range[1] - range[0]) + 1;
+    origin = range[0] - 0.5;
+    spacing = 1.;
+  }
+  else if (spacing <= 0.)
+  {
+    numberOfBins = 1;
+    origin = range[0] - 0.5;
+    spacing = 1.;
+  }
+
+  histogram.Origin = origin;
+  histogram.Spacing = spacing;
+  histogram.Min = range[0];
+  histogram.Max = range[1];
+  histogram.Bins.fill(0, numberOfBins);
+
+  // second pass: accumulate the bins
+  double sum = 0.;
+  vtkIdType count = 0;
+  QElapsedTimer publishTimer;
+  publishTimer.start();
+  for (vtkIdType begin = 0; begin < size; begin += HistogramChunkSize)
+  {
+    if (worker && worker->isAborted())
+    {
+      histogram.clear();
+      return false;
+    }
+    vtkIdType end = std::min(size, begin + HistogramChunkSize);
+    switch (scalars->GetDataType())
+    {
+      vtkTemplateMacro(ctkVTKAccumulateScalars(static_cast<VTK_TT*>(values),
+                                               begin, end, step, origin, spacing,
+                                               histogram.Bins.data(), numberOfBins - 1,
+                                               sum, count));
+    }
+    histogram.Mean = count ? sum / count : 0.;
+    if (worker && publishTimer.elapsed() > 50)
+    {
+      worker->publish(histogram);
+      publishTimer.restart();
+    }
+  }
+  return true;
+}
+
+} // end of anonymous namespace
+
 // ----------------------------------------------------------------------------
 class ctkVTKDiscretizableColorTransferWidgetPrivate :
   public Ui_ctkVTKDiscretizableColorTransferWidget
@@ -89,6 +314,11 @@ public:
   bool popRangesFromHistory(double* currentRange, double* visibleRange);
   void clearUndoHistory();
 
+  /// Recomputes the base histogram if the histogram input was modified,
+  /// in a worker thread for large inputs.
+  void updateBaseHistogram();
+  void abortHistogramWorker();
+  void clearBaseHistogram();
 
   ctkVTKOpenGLNativeWidget* ScalarsToColorsView;
 
@@ -97,6 +327,15 @@ public:
   vtkSmartPointer<vtkEventQtSlotConnect> eventLink;
   vtkSmartPointer<vtkImageAccumulate> histogramFilter;
 
+  /// Histogram of the whole input, the displayed histogram is derived
+  /// from it. histogramFilter only rescans the input when the visible
+  /// range needs a higher resolution.
+  ctkVTKBaseHistogram baseHistogram;
+  vtkMTimeType baseHistogramMTime;
+  ctkVTKHistogramWorker* histogramWorker;
+  QTimer* histogramProgressTimer;
+  bool dataRangeUpdatePending;
+
   ///Option part
   ctkColorPickerButton* nanButton;
   QCheckBox* discretizeCheckBox;
@@ -135,6 +374,11 @@ ctkVTKDiscretizableColorTransferWidgetPrivate
   this->dataRange[1] = VTK_DOUBLE_MIN;
   this->dataMean = 0.;
 
+  this->baseHistogramMTime = 0;
+  this->histogramWorker = CTK_NULLPTR;
+  this->histogramProgressTimer = CTK_NULLPTR;
+  this->dataRangeUpdatePending = false;
+
   this->previousOpacityValue = 0.;
 
   this->historyUpdateTime = QTime::currentTime();
@@ -215,6 +459,12 @@ void ctkVTKDiscretizableColorTransferWidgetPrivate::setupUi(QWidget* widget)
   QObject::connect(rangeSlider, SIGNAL(valuesChanged(double, double)),
     q, SLOT(onRangeSliderValueChange(double, double)));
 
+  // Show the histogram progressively while it is computed in a worker thread
+  this->histogramProgressTimer = new QTimer(q);
+  this->histogramProgressTimer->setInterval(100);
+  QObject::connect(this->histogramProgressTimer, SIGNAL(timeout()),
+    q, SLOT(onHistogramProgress()));
+
   /// Option panel menu
   QWidget* nanColorWidget = new QWidget(optionButton);
   QHBoxLayout* nanColorLayout = new QHBoxLayout(nanColorWidget);
@@ -319,6 +569,88 @@ void ctkVTKDiscretizableColorTransferWidgetPrivate::clearUndoHistory()
   this->rangesHistory.clear();
 }
 
+//-----------------------------------------------------------------------------
+void ctkVTKDiscretizableColorTransferWidgetPrivate::updateBaseHistogram()
+{
+  Q_Q(ctkVTKDiscretizableColorTransferWidget);
+
+  if (this->histogramFilter == CTK_NULLPTR
+   || this->histogramFilter->GetInputConnection(0, 0) == CTK_NULLPTR)
+  {
+    this->clearBaseHistogram();
+    return;
+  }
+
+  // The worker thread reads the scalars of the input without locking,
+  // the input must not be re-executed before the worker is done or has
+  // been aborted (see clearBaseHistogram()).
+  if (this->histogramWorker)
+  {
+    return;
+  }
+
+  vtkAlgorithmOutput* input = this->histogramFilter->GetInputConnection(0, 0);
+  input->GetProducer()->Update(input->GetIndex());
+  vtkImageData* inputImage = vtkImageData::SafeDownCast(
+    input->GetProducer()->GetOutputDataObject(input->GetIndex()));
+  vtkDataArray* scalars = inputImage ? inputImage->GetPointData()->GetScalars() : CTK_NULLPTR;
+
+  vtkMTimeType mtime = inputImage ? inputImage->GetMTime() : 0;
+  if (scalars)
+  {
+    mtime = std::max(mtime, scalars->GetMTime());
+  }
+  // the base histogram of an input is only computed once, even when it
+  // could not be computed (e.g. no finite values), in which case the
+  // visible range is always rescanned
+  if (this->baseHistogramMTime != 0 && mtime == this->baseHistogramMTime)
+  {
+    return;
+  }
+
+  this->clearBaseHistogram();
+  this->baseHistogramMTime = mtime;
+  if (!scalars)
+  {
+    return;
+  }
+
+  if (scalars->GetNumberOfTuples() <= SynchronousHistogramSize)
+  {
+    ctkVTKComputeBaseHistogram(scalars, this->baseHistogram, CTK_NULLPTR);
+    return;
+  }
+
+  this->histogramWorker = new ctkVTKHistogramWorker(scalars);
+  QObject::connect(this->histogramWorker, SIGNAL(finished()),
+                   q, SLOT(onHistogramProgress()));
+  this->histogramWorker->start(QThread::LowPriority);
+  this->histogramProgressTimer->start();
+}
+
+//-----------------------------------------------------------------------------
+void ctkVTKDiscretizableColorTransferWidgetPrivate::abortHistogramWorker()
+{
+  if (!this->histogramWorker)
+  {
+    return;
+  }
+  this->histogramProgressTimer->stop();
+  this->histogramWorker->disconnect();
+  this->histogramWorker->abort();
+  this->histogramWorker->wait();
+  delete this->histogramWorker;
+  this->histogramWorker = CTK_NULLPTR;
+}
+
+//-----------------------------------------------------------------------------
+void ctkVTKDiscretizableColorTransferWidgetPrivate::clearBaseHistogram()
+{
+  this->abortHistogramWorker();
+  this->baseHistogram.clear();
+  this->baseHistogramMTime = 0;
+}
+
 // ----------------------------------------------------------------------------
 void
 ctkVTKDiscretizableColorTransferWidgetPrivate::colorTransferFunctionModifiedCallback(
@@ -381,6 +713,8 @@ ctkVTKDiscretizableColorTransferWidget::ctkVTKDiscretizableColorTransferWidget(
 // ----------------------------------------------------------------------------
 ctkVTKDiscretizableColorTransferWidget::~ctkVTKDiscretizableColorTransferWidget()
 {
+  Q_D(ctkVTKDiscretizableColorTransferWidget);
+  d->abortHistogramWorker();
 }
 
 // ----------------------------------------------------------------------------
@@ -462,6 +796,9 @@ void ctkVTKDiscretizableColorTransferWidget::setHistogramConnection(
 {
   Q_D(ctkVTKDiscretizableColorTransferWidget);
 
+  d->clearBaseHistogram();
+  d->dataRangeUpdatePending = false;
+
   if (!input)
   {
     d->histogramFilter = CTK_NULLPTR;
@@ -479,14 +816,30 @@ void ctkVTKDiscretizableColorTransferWidget::updateHistogram(
 {
   Q_D(ctkVTKDiscretizableColorTransferWidget);
 
+  // The input may have changed: stop the worker thread before the input
+  // is updated and compute the base histogram again.
+  if (d->histogramWorker)
+  {
+    d->clearBaseHistogram();
+  }
+
   this->updateHistogram();
 
   if (updateDataRange)
   {
-    if (d->histogramFilter
-     && d->histogramFilter->GetInputConnection(0, 0))
+    if (d->histogramWorker)
+    {
+      // set when the worker thread is done
+      d->dataRangeUpdatePending = true;
+    }
+    else if (d->baseHistogram.isValid())
     {
       // get min max values from histogram
+      this->setDataRange(d->baseHistogram.Min, d->baseHistogram.Max);
+    }
+    else if (d->histogramFilter
+          && d->histogramFilter->GetInputConnection(0, 0))
+    {
       this->setDataRange(d->histogramFilter->GetMin()[0],
                          d->histogramFilter->GetMax()[0]);
     }
@@ -497,6 +850,41 @@ void ctkVTKDiscretizableColorTransferWidget::updateHistogram(
   }
 }
 
+// ----------------------------------------------------------------------------
+void ctkVTKDiscretizableColorTransferWidget::onHistogramProgress()
+{
+  Q_D(ctkVTKDiscretizableColorTransferWidget);
+
+  if (!d->histogramWorker)
+  {
+    return;
+  }
+
+  bool finished = d->histogramWorker->isFinished();
+  if (!d->histogramWorker->snapshot(d->baseHistogram) && !finished)
+  {
+    return;
+  }
+  if (finished)
+  {
+    d->histogramProgressTimer->stop();
+    delete d->histogramWorker;
+    d->histogramWorker = CTK_NULLPTR;
+  }
+
+  this->updateHistogram();
+
+  if (finished && d->dataRangeUpdatePending)
+  {
+    d->dataRangeUpdatePending = false;
+    if (d->baseHistogram.isValid())
+    {
+      this->setDataRange(d->baseHistogram.Min, d->baseHistogram.Max);
+    }
+  }
+  d->ScalarsToColorsView->GetInteractor()->Render();
+}
+
 // ----------------------------------------------------------------------------
 void ctkVTKDiscretizableColorTransferWidget::resetColorTransferFunctionRange(
     ResetCTFRange resetMode)
@@ -681,6 +1069,11 @@ void ctkVTKDiscretizableColorTransferWidget::updateHistogram()
   }
   else
   {
+    d->updateBaseHistogram();
+
+    // mean of the whole input, as computed by vtkImageAccumulate
+    d->dataMean = d->baseHistogram.Mean;
+
     double* visibleRange = d->scalarsToColorsContextItem->GetVisibleRange();
 
     int extent = d->histogramFilter->GetComponentExtent()[1];
@@ -688,16 +1081,35 @@ void ctkVTKDiscretizableColorTransferWidget::updateHistogram()
     double spacing = (visibleRange[1] - visibleRange[0] + 2 * std::numeric_limits<double>::epsilon())
         / static_cast<double>(extent + 1);
 
-    // recompute histogram in data range
-    d->histogramFilter->SetComponentOrigin(origin, 0, 0);
-    d->histogramFilter->SetComponentSpacing(spacing, 0, 0);
-    d->histogramFilter->Update();
-
-    // update data mean
-    d->dataMean = d->histogramFilter->GetMean()[0];
-
-    vtkImageData* histogram = d->histogramFilter->GetOutput();
-    vtkIdType* output = static_cast<vtkIdType*>(histogram->GetScalarPointer());
+    QVector<double> counts;
+    bool rebinned = d->baseHistogram.rebin(origin, spacing, extent + 1, counts);
+    if (!rebinned && d->histogramWorker)
+    {
+      // nothing to show before the worker thread published its first bins
+      counts.fill(0., extent + 1);
+    }
+    else if (!rebinned)
+    {
+      // the visible range needs a higher resolution than the base
+      // histogram, recompute histogram in visible range
+      d->histogramFilter->SetComponentOrigin(origin, 0, 0);
+      d->histogramFilter->SetComponentSpacing(spacing, 0, 0);
+      d->histogramFilter->Update();
+
+      // update data mean
+      if (!d->baseHistogram.isValid())
+      {
+        d->dataMean = d->histogramFilter->GetMean()[0];
+      }
+
+      vtkImageData* histogram = d->histogramFilter->GetOutput();
+      vtkIdType* output = static_cast<vtkIdType*>(histogram->GetScalarPointer());
+      counts.resize(extent + 1);
+      for (int j = 0; j < extent + 1; ++j)
+      {
+        counts[j] = static_cast<double>(*output++);
+      }
+    }
 
     // set min and max of the slider widget
     vtkDataObject* input = d->histogramFilter->GetInputAlgorithm()->GetOutputDataObject(0);
@@ -708,15 +1120,13 @@ void ctkVTKDiscretizableColorTransferWidget::updateHistogram()
 #ifdef DEBUG_RANGE
     qDebug() << "DEBUG_RANGE histo input range = " << origin
              << " " << origin + (extent + 1) * spacing;
-    qDebug() << "DEBUG_RANGE histo real range = " << *d->histogramFilter->GetMin()
-             << " " << *d->histogramFilter->GetMax();
-    int dims[3];
-    histogram->GetDimensions(dims);
+    qDebug() << "DEBUG_RANGE histo real range = " << d->baseHistogram.Min
+             << " " << d->baseHistogram.Max;
     QDebug deb = qDebug();
     deb << "DEBUG_RANGE histo = ";
-    for(vtkIdType i = 0; i < dims[0]; ++i)
+    for(int i = 0; i < counts.size(); ++i)
     {
-        deb << *(static_cast<vtkIdType*>(histogram->GetScalarPointer(i, 0, 0))) << " ";
+        deb << counts[i] << " ";
     }
 #endif
 
@@ -728,7 +1138,7 @@ void ctkVTKDiscretizableColorTransferWidget::updateHistogram()
     {
       bins->SetTuple1(j, bin);
       bin += spacing;
-      frequencies->SetTuple1(j, *output++);
+      frequencies->SetTuple1(j, vtkMath::Round(counts[j]));
     }
   }
 
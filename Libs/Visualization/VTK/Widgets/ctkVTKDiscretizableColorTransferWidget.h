@@ -128,6 +128,10 @@ protected:
   void enableCtfWidgets();
   void updateHistogram();
 
+protected slots:
+  /// Shows the histogram computed so far by the worker thread.
+  void onHistogramProgress();
+
 private:
   Q_DECLARE_PRIVATE(ctkVTKDiscretizableColorTransferWidget);
   Q_DISABLE_COPY(ctkVTKDiscretizableColorTransferWidget);
@@ -0,0 +1,335 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) 2013 University College London, Centre for Medical Image Computing
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+
+
+#include "ctkXnatFetchSubtreeTest.h"
+
+#include "ctkXnatTestServer.h"
+
+#include <QCoreApplication>
+#include <QNetworkProxy>
+#include <QTest>
+
+#include <ctkXnatDataModel.h>
+#include <ctkXnatLoginProfile.h>
+#include <ctkXnatObject.h>
+#include <ctkXnatProject.h>
+#include <ctkXnatScan.h>
+#include <ctkXnatSession.h>
+
+namespace
+{
+
+typedef QList<ctkXnatTestServer::Row> Rows;
+
+const QString ExperimentsPath = "/data/archive/experiments";
+const QString SubjectsPath = "/data/archive/projects/p1/subjects";
+
+// The columns requested by ctkXnatSession::fetchSubtree() for the scans
+const QString ScansColumns = "columns=label,subject_label,xnat:imagescandata/ID,"
+    "xnat:imagescandata/type,xnat:imagescandata/series_description,xnat:imagescandata/quality";
+
+// --------------------------------------------------------------------------
+ctkXnatTestServer::Row experimentRow(const QString& label, const QString& subjectLabel = QString())
+{
+  ctkXnatTestServer::Row row;
+  row["ID"] = "XNAT_" + label;
+  row["label"] = label;
+  if (!subjectLabel.isNull())
+  {
+    row["subject_label"] = subjectLabel;
+  }
+  return row;
+}
+
+// --------------------------------------------------------------------------
+ctkXnatTestServer::Row scanRow(const QString& id, const QString& seriesDescription)
+{
+  ctkXnatTestServer::Row row;
+  row["ID"] = id;
+  row["type"] = "T1";
+  row["series_description"] = seriesDescription;
+  row["quality"] = "usable";
+  return row;
+}
+
+// --------------------------------------------------------------------------
+ctkXnatTestServer::Row listedScanRow(const QString& subjectLabel, const QString& label,
+                                     const QString& id = QString(),
+                                     const QString& seriesDescription = QString())
+{
+  // The column names as returned by XNAT, in lower case
+  ctkXnatTestServer::Row row;
+  row["label"] = label;
+  row["subject_label"] = subjectLabel;
+  row["xnat:imagescandata/id"] = id;
+  row["xnat:imagescandata/type"] = id.isEmpty() ? QString() : QString("T1");
+  row["xnat:imagescandata/series_description"] = seriesDescription;
+  row["xnat:imagescandata/quality"] = id.isEmpty() ? QString() : QString("usable");
+  return row;
+}
+
+// --------------------------------------------------------------------------
+ctkXnatObject* child(ctkXnatObject* parent, const QString& id)
+{
+  foreach (ctkXnatObject* child, parent->children())
+  {
+    if (child->id() == id)
+    {
+      return child;
+    }
+  }
+  return NULL;
+}
+
+}
+
+class ctkXnatFetchSubtreeTestCasePrivate
+{
+public:
+  ctkXnatTestServer* Server;
+  ctkXnatSession* Session;
+};
+
+// --------------------------------------------------------------------------
+ctkXnatFetchSubtreeTestCase::ctkXnatFetchSubtreeTestCase()
+: d_ptr(new ctkXnatFetchSubtreeTestCasePrivate())
+{
+}
+
+// --------------------------------------------------------------------------
+ctkXnatFetchSubtreeTestCase::~ctkXnatFetchSubtreeTestCase()
+{
+}
+
+// --------------------------------------------------------------------------
+ctkXnatProject* ctkXnatFetchSubtreeTestCase::project()
+{
+  Q_D(ctkXnatFetchSubtreeTestCase);
+
+  ctkXnatDataModel* dataModel = d->Session->dataModel();
+  dataModel->fetch();
+  return dynamic_cast<ctkXnatProject*>(child(dataModel, "p1"));
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatFetchSubtreeTestCase::verifySubtree(ctkXnatProject* project)
+{
+  QVERIFY(project->isFetched());
+  // Two subjects and the resource folder
+  QCOMPARE(project->children().size(), 3);
+
+  ctkXnatObject* s1 = child(project, "S1");
+  QVERIFY(s1 != NULL);
+  QVERIFY(s1->isFetched());
+  QCOMPARE(s1->children().size(), 3);
+  QVERIFY(child(s1, "resources") != NULL);
+
+  ctkXnatObject* e1 = child(s1, "E1");
+  QVERIFY(e1 != NULL);
+  QCOMPARE(e1->property("ID"), QString("XNAT_E1"));
+  ctkXnatObject* e1Scans = child(e1, "scans");
+  QVERIFY(e1Scans != NULL);
+  QVERIFY(e1Scans->isFetched());
+  QCOMPARE(e1Scans->children().size(), 2);
+  ctkXnatObject* scan = child(e1Scans, "2");
+  QVERIFY(scan != NULL);
+  QCOMPARE(scan->property(ctkXnatScan::TYPE), QString("T1"));
+  QCOMPARE(scan->property(ctkXnatScan::QUALITY), QString("usable"));
+  QCOMPARE(scan->property(ctkXnatObject::LABEL), QString("t1_mprage"));
+
+  ctkXnatObject* e2Scans = child(child(s1, "E2"), "scans");
+  QVERIFY(e2Scans != NULL);
+  QCOMPARE(e2Scans->children().size(), 1);
+
+  ctkXnatObject* s2 = child(project, "S2");
+  QVERIFY(s2 != NULL);
+  QVERIFY(s2->isFetched());
+  QCOMPARE(s2->children().size(), 3);
+
+  // An image session without scans and subject variables
+  ctkXnatObject* e3 = child(s2, "E3");
+  QVERIFY(e3 != NULL);
+  QVERIFY(child(e3, "scans") == NULL);
+  QVERIFY(child(s2, "V1") != NULL);
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatFetchSubtreeTestCase::init()
+{
+  Q_D(ctkXnatFetchSubtreeTestCase);
+
+  d->Server = new ctkXnatTestServer();
+  QVERIFY(d->Server->start());
+
+  Rows projects;
+  ctkXnatTestServer::Row project;
+  project["ID"] = "p1";
+  project["name"] = "Project 1";
+  projects << project;
+  d->Server->setResultSet("/data/archive/projects", projects);
+
+  Rows subjects;
+  ctkXnatTestServer::Row subject;
+  subject["ID"] = "XNAT_S1";
+  subject["label"] = "S1";
+  subjects << subject;
+  subject["ID"] = "XNAT_S2";
+  subject["label"] = "S2";
+  subjects << subject;
+  d->Server->setResultSet(SubjectsPath, subjects);
+
+  // The responses to the per node requests
+  d->Server->setResultSet(SubjectsPath + "/S1/experiments", "xsiType=xnat:imageSessionData",
+                          Rows() << experimentRow("E1") << experimentRow("E2"));
+  d->Server->setResultSet(SubjectsPath + "/S1/experiments", "xsiType=xnat:subjectVariablesData",
+                          Rows());
+  d->Server->setResultSet(SubjectsPath + "/S2/experiments", "xsiType=xnat:imageSessionData",
+                          Rows() << experimentRow("E3"));
+  d->Server->setResultSet(SubjectsPath + "/S2/experiments", "xsiType=xnat:subjectVariablesData",
+                          Rows() << experimentRow("V1"));
+  d->Server->setResultSet(SubjectsPath + "/S1/experiments/E1/scans",
+                          Rows() << scanRow("1", "localizer") << scanRow("2", "t1_mprage"));
+  d->Server->setResultSet(SubjectsPath + "/S1/experiments/E2/scans",
+                          Rows() << scanRow("1", "localizer"));
+  d->Server->setResultSet(SubjectsPath + "/S2/experiments/E3/scans", Rows());
+
+  ctkXnatLoginProfile loginProfile;
+  loginProfile.setName("test");
+  loginProfile.setServerUrl(d->Server->url());
+  loginProfile.setUserName("test");
+  loginProfile.setPassword("test");
+
+  d->Session = new ctkXnatSession(loginProfile);
+  d->Session->setHttpNetworkProxy(QNetworkProxy(QNetworkProxy::NoProxy));
+  d->Session->open();
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatFetchSubtreeTestCase::cleanup()
+{
+  Q_D(ctkXnatFetchSubtreeTestCase);
+
+  delete d->Session;
+  d->Session = NULL;
+  delete d->Server;
+  d->Server = NULL;
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatFetchSubtreeTestCase::testFetchSubtree()
+{
+  Q_D(ctkXnatFetchSubtreeTestCase);
+
+  d->Server->setResultSet(ExperimentsPath, "xsiType=xnat:imageSessionData",
+                          Rows() << experimentRow("E1", "S1") << experimentRow("E2", "S1")
+                                 << experimentRow("E3", "S2"));
+  d->Server->setResultSet(ExperimentsPath, "xsiType=xnat:subjectVariablesData",
+                          Rows() << experimentRow("V1", "S2"));
+  d->Server->setResultSet(ExperimentsPath, ScansColumns,
+                          Rows() << listedScanRow("S1", "E1", "1", "localizer")
+                                 << listedScanRow("S1", "E1", "2", "t1_mprage")
+                                 << listedScanRow("S1", "E2", "1", "localizer")
+                                 << listedScanRow("S2", "E3"));
+
+  ctkXnatProject* project = this->project();
+  QVERIFY(project != NULL);
+  QVERIFY(project->fetchSubtree());
+  this->verifySubtree(project);
+
+  // One request per level instead of one per subject and experiment
+  QCOMPARE(d->Server->requestCount(SubjectsPath), 1);
+  QCOMPARE(d->Server->requestCount(ExperimentsPath), 3);
+  QCOMPARE(d->Server->requestCount(ExperimentsPath, "project=p1"), 3);
+  QCOMPARE(d->Server->requestCount(ExperimentsPath, ScansColumns), 1);
+  QCOMPARE(d->Server->requestCount(SubjectsPath + "/S1/experiments"), 0);
+  QCOMPARE(d->Server->requestCount(SubjectsPath + "/S1/experiments/E1/scans"), 0);
+
+  // Fetching an experiment does not list its scans again
+  ctkXnatObject* e1 = child(child(project, "S1"), "E1");
+  QVERIFY(!e1->isFetched());
+  e1->fetch();
+  QVERIFY(e1->isFetched());
+  QCOMPARE(d->Server->requestCount(SubjectsPath + "/S1/experiments/E1/scans"), 0);
+  QCOMPARE(d->Server->requestCount(SubjectsPath + "/S1/experiments/E1/reconstructions"), 1);
+  QCOMPARE(child(child(e1, "scans"), "2")->property(ctkXnatObject::LABEL), QString("t1_mprage"));
+
+  // The experiments are not listed again
+  QVERIFY(project->fetchSubtree());
+  QCOMPARE(d->Server->requestCount(ExperimentsPath, "xsiType=xnat:subjectVariablesData"), 1);
+  QCOMPARE(child(e1, "scans")->children().size(), 2);
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatFetchSubtreeTestCase::testFetchExperiments()
+{
+  Q_D(ctkXnatFetchSubtreeTestCase);
+
+  d->Server->setResultSet(ExperimentsPath, "xsiType=xnat:imageSessionData",
+                          Rows() << experimentRow("E1", "S1") << experimentRow("E2", "S1")
+                                 << experimentRow("E3", "S2"));
+  d->Server->setResultSet(ExperimentsPath, "xsiType=xnat:subjectVariablesData",
+                          Rows() << experimentRow("V1", "S2"));
+
+  ctkXnatProject* project = this->project();
+  QVERIFY(project != NULL);
+
+  // A subject fetched before keeps its experiments
+  project->fetch();
+  ctkXnatObject* s1 = child(project, "S1");
+  s1->fetch();
+  ctkXnatObject* e1 = child(s1, "E1");
+
+  QVERIFY(project->fetchSubtree(ctkXnatSession::Experiments));
+  QCOMPARE(d->Server->requestCount(ExperimentsPath), 2);
+  QCOMPARE(d->Server->requestCount(ExperimentsPath, ScansColumns), 0);
+  QVERIFY(child(s1, "E1") == e1);
+  QCOMPARE(s1->children().size(), 3);
+
+  ctkXnatObject* s2 = child(project, "S2");
+  QVERIFY(s2->isFetched());
+  QCOMPARE(s2->children().size(), 3);
+  QVERIFY(child(child(s2, "E3"), "scans") == NULL);
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatFetchSubtreeTestCase::testFetchSubtreePerNode()
+{
+  Q_D(ctkXnatFetchSubtreeTestCase);
+
+  // The server does not support the flat experiment listing
+  ctkXnatProject* project = this->project();
+  QVERIFY(project != NULL);
+  QVERIFY(!project->fetchSubtree());
+  this->verifySubtree(project);
+
+  QCOMPARE(d->Server->requestCount(SubjectsPath + "/S1/experiments"), 2);
+  QCOMPARE(d->Server->requestCount(SubjectsPath + "/S2/experiments"), 2);
+  QCOMPARE(d->Server->requestCount(SubjectsPath + "/S1/experiments/E1/scans"), 2);
+}
+
+// --------------------------------------------------------------------------
+int ctkXnatFetchSubtreeTest(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+  ctkXnatFetchSubtreeTestCase test;
+  return QTest::qExec(&test, argc, argv);
+}
@@ -0,0 +1,67 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) 2013 University College London, Centre for Medical Image Computing
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+
+
+#ifndef __CTKXNATFETCHSUBTREETEST_H
+#define __CTKXNATFETCHSUBTREETEST_H
+
+#include <QObject>
+
+class ctkXnatObject;
+class ctkXnatProject;
+class ctkXnatFetchSubtreeTestCasePrivate;
+
+class ctkXnatFetchSubtreeTestCase: public QObject
+{
+  Q_OBJECT
+
+  ctkXnatProject* project();
+
+  void verifySubtree(ctkXnatProject* project);
+
+public:
+
+  explicit ctkXnatFetchSubtreeTestCase();
+  virtual ~ctkXnatFetchSubtreeTestCase();
+
+private slots:
+
+  void init();
+
+  void cleanup();
+
+  void testFetchSubtree();
+
+  void testFetchExperiments();
+
+  void testFetchSubtreePerNode();
+
+private:
+  QScopedPointer<ctkXnatFetchSubtreeTestCasePrivate> d_ptr;
+
+  Q_DECLARE_PRIVATE(ctkXnatFetchSubtreeTestCase)
+  Q_DISABLE_COPY(ctkXnatFetchSubtreeTestCase)
+};
+
+// --------------------------------------------------------------------------
+int ctkXnatFetchSubtreeTest(int argc, char* argv[]);
+
+#endif
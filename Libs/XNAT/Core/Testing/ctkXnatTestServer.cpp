@@ -0,0 +1,186 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) 2013 University College London, Centre for Medical Image Computing
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+
+#include "ctkXnatTestServer.h"
+
+#include <QHostAddress>
+#include <QTcpSocket>
+
+// --------------------------------------------------------------------------
+ctkXnatTestServer::ctkXnatTestServer(QObject* parent)
+: QTcpServer(parent)
+{
+  this->setResponse("/data/JSESSION", "0123456789ABCDEF0123456789ABCDEF");
+  this->setResponse("/data/version", "1.6.5");
+  connect(this, SIGNAL(newConnection()), this, SLOT(acceptConnection()));
+}
+
+// --------------------------------------------------------------------------
+bool ctkXnatTestServer::start()
+{
+  return this->listen(QHostAddress::LocalHost);
+}
+
+// --------------------------------------------------------------------------
+QUrl ctkXnatTestServer::url() const
+{
+  return QUrl(QString("http://127.0.0.1:%1").arg(this->serverPort()));
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTestServer::setResponse(const QString& path, const QByteArray& body)
+{
+  this->Responses[path] = body;
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTestServer::setResponse(const QString& path, const QString& parameter,
+                                    const QByteArray& body)
+{
+  this->Responses[responseKey(path, parameter)] = body;
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTestServer::setResultSet(const QString& path, const QList<Row>& rows)
+{
+  this->setResponse(path, resultSet(rows));
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTestServer::setResultSet(const QString& path, const QString& parameter,
+                                     const QList<Row>& rows)
+{
+  this->setResponse(path, parameter, resultSet(rows));
+}
+
+// --------------------------------------------------------------------------
+QByteArray ctkXnatTestServer::resultSet(const QList<Row>& rows)
+{
+  QStringList results;
+  foreach (const Row& row, rows)
+  {
+    QStringList properties;
+    QMapIterator<QString, QString> it(row);
+    while (it.hasNext())
+    {
+      it.next();
+      properties << QString("\"%1\":\"%2\"").arg(it.key(), it.value());
+    }
+    results << "{" + properties.join(",") + "}";
+  }
+  QString body = QString("{\"ResultSet\":{\"Result\":[%1],\"totalRecords\":\"%2\"}}")
+      .arg(results.join(",")).arg(rows.size());
+  return body.toUtf8();
+}
+
+// --------------------------------------------------------------------------
+QString ctkXnatTestServer::responseKey(const QString& path, const QString& parameter)
+{
+  return path + '\n' + parameter;
+}
+
+// --------------------------------------------------------------------------
+int ctkXnatTestServer::requestCount(const QString& path) const
+{
+  return this->Requests.value(path).size();
+}
+
+// --------------------------------------------------------------------------
+int ctkXnatTestServer::requestCount(const QString& path, const QString& parameter) const
+{
+  int count = 0;
+  foreach (const QString& query, this->Requests.value(path))
+  {
+    if (query.split('&').contains(parameter))
+    {
+      ++count;
+    }
+  }
+  return count;
+}
+
+// --------------------------------------------------------------------------
+QStringList ctkXnatTestServer::requestQueries(const QString& path) const
+{
+  return this->Requests.value(path);
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTestServer::acceptConnection()
+{
+  while (QTcpSocket* socket = this->nextPendingConnection())
+  {
+    connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+  }
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTestServer::readRequest()
+{
+  QTcpSocket* socket = qobject_cast<QTcpSocket*>(this->sender());
+  QByteArray request = socket->property("request").toByteArray() + socket->readAll();
+  if (!request.contains("\r\n\r\n"))
+  {
+    socket->setProperty("request", request);
+    return;
+  }
+  socket->setProperty("request", QByteArray());
+
+  // e.g. GET /data/archive/projects?format=json HTTP/1.1
+  QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+  QString target = requestLine.size() > 1 ? QString::fromLatin1(requestLine[1]) : QString();
+  QString path = target.section('?', 0, 0);
+
+  QStringList parameters;
+  foreach (const QString& parameter, target.section('?', 1).split('&', QString::SkipEmptyParts))
+  {
+    parameters << QUrl::fromPercentEncoding(parameter.toLatin1());
+  }
+  this->Requests[path] << parameters.join("&");
+
+  QByteArray status = "200 OK";
+  QByteArray body;
+  QString key = path;
+  foreach (const QString& parameter, parameters)
+  {
+    if (this->Responses.contains(responseKey(path, parameter)))
+    {
+      key = responseKey(path, parameter);
+      break;
+    }
+  }
+  if (this->Responses.contains(key))
+  {
+    body = this->Responses[key];
+  }
+  else
+  {
+    status = "404 Not Found";
+  }
+
+  socket->write("HTTP/1.1 " + status + "\r\n"
+                "Content-Type: application/json\r\n"
+                "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                "Connection: close\r\n"
+                "\r\n" + body);
+  socket->disconnectFromHost();
+}
@@ -0,0 +1,89 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) 2013 University College London, Centre for Medical Image Computing
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+
+#ifndef __CTKXNATTESTSERVER_H
+#define __CTKXNATTESTSERVER_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QTcpServer>
+#include <QUrl>
+
+/**
+ * A local stand-in for an XNAT server. It answers the GET requests of the
+ * XNAT REST API with the responses set for their path and one of their query
+ * parameters, or else with the response set for their path alone, and with
+ * 404 for any other path. The login and version requests of
+ * ctkXnatSession::open() are answered by default.
+ */
+class ctkXnatTestServer : public QTcpServer
+{
+  Q_OBJECT
+
+public:
+
+  typedef QMap<QString, QString> Row;
+
+  explicit ctkXnatTestServer(QObject* parent = 0);
+
+  /// Listens on a free port of the local host
+  bool start();
+
+  QUrl url() const;
+
+  void setResponse(const QString& path, const QByteArray& body);
+
+  /// Sets the response to the requests for the path with the query
+  /// parameter, given as e.g. "xsiType=xnat:imageSessionData"
+  void setResponse(const QString& path, const QString& parameter, const QByteArray& body);
+
+  /// Sets a JSON result set with the given rows as the response
+  void setResultSet(const QString& path, const QList<Row>& rows);
+
+  void setResultSet(const QString& path, const QString& parameter, const QList<Row>& rows);
+
+  /// The number of requests received for the path
+  int requestCount(const QString& path) const;
+
+  /// The number of requests received for the path with the query parameter
+  int requestCount(const QString& path, const QString& parameter) const;
+
+  /// The decoded queries of the requests received for the path
+  QStringList requestQueries(const QString& path) const;
+
+private slots:
+
+  void acceptConnection();
+  void readRequest();
+
+private:
+
+  static QByteArray resultSet(const QList<Row>& rows);
+
+  static QString responseKey(const QString& path, const QString& parameter);
+
+  QMap<QString, QByteArray> Responses;
+  QMap<QString, QStringList> Requests;
+};
+
+#endif
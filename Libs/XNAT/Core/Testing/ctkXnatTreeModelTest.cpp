@@ -0,0 +1,380 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) 2013 University College London, Centre for Medical Image Computing
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+
+#include "ctkXnatTreeModelTest.h"
+
+#include "ctkXnatTestServer.h"
+
+#include <QCoreApplication>
+#include <QNetworkProxy>
+#include <QSignalSpy>
+#include <QTest>
+#include <QTime>
+
+#include <ctkXnatDataModel.h>
+#include <ctkXnatLoginProfile.h>
+#include <ctkXnatObject.h>
+#include <ctkXnatSession.h>
+#include <ctkXnatTreeModel.h>
+
+class ctkXnatTreeModelTestCasePrivate
+{
+public:
+  ctkXnatTestServer* Server;
+  ctkXnatSession* Session;
+};
+
+// --------------------------------------------------------------------------
+ctkXnatTreeModelTestCase::ctkXnatTreeModelTestCase()
+: d_ptr(new ctkXnatTreeModelTestCasePrivate())
+{
+}
+
+// --------------------------------------------------------------------------
+ctkXnatTreeModelTestCase::~ctkXnatTreeModelTestCase()
+{
+}
+
+// --------------------------------------------------------------------------
+bool ctkXnatTreeModelTestCase::waitForFetch(ctkXnatTreeModel& model, const QModelIndex& index)
+{
+  QTime time;
+  time.start();
+  while (model.isFetching(index) && time.elapsed() < 5000)
+  {
+    QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 100);
+  }
+  return !model.isFetching(index);
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTreeModelTestCase::init()
+{
+  Q_D(ctkXnatTreeModelTestCase);
+
+  d->Server = new ctkXnatTestServer();
+  QVERIFY(d->Server->start());
+
+  QList<ctkXnatTestServer::Row> projects;
+  ctkXnatTestServer::Row project;
+  project["ID"] = "p1";
+  project["name"] = "Project 1";
+  projects << project;
+  project["ID"] = "p2";
+  project["name"] = "Project 2";
+  projects << project;
+  project["ID"] = "p3";
+  project["name"] = "Project 3";
+  projects << project;
+  d->Server->setResultSet("/data/archive/projects", projects);
+
+  QList<ctkXnatTestServer::Row> subjects;
+  ctkXnatTestServer::Row subject;
+  subject["ID"] = "s1";
+  subject["label"] = "Subject 1";
+  subjects << subject;
+  subject["ID"] = "s2";
+  subject["label"] = "Subject 2";
+  subjects << subject;
+  d->Server->setResultSet("/data/archive/projects/p1/subjects", subjects);
+
+  // p2 has no subjects and no resources, the subjects of p3 cannot be listed
+  d->Server->setResultSet("/data/archive/projects/p2/subjects", QList<ctkXnatTestServer::Row>());
+  d->Server->setResultSet("/data/archive/projects/p2/resources", QList<ctkXnatTestServer::Row>());
+
+  ctkXnatLoginProfile loginProfile;
+  loginProfile.setName("test");
+  loginProfile.setServerUrl(d->Server->url());
+  loginProfile.setUserName("test");
+  loginProfile.setPassword("test");
+
+  d->Session = new ctkXnatSession(loginProfile);
+  d->Session->setHttpNetworkProxy(QNetworkProxy(QNetworkProxy::NoProxy));
+  d->Session->open();
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTreeModelTestCase::cleanup()
+{
+  Q_D(ctkXnatTreeModelTestCase);
+
+  delete d->Session;
+  d->Session = NULL;
+  delete d->Server;
+  d->Server = NULL;
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTreeModelTestCase::testFetchMore()
+{
+  Q_D(ctkXnatTreeModelTestCase);
+
+  ctkXnatTreeModel model;
+  model.addDataModel(d->Session->dataModel());
+  QModelIndex dataModelIndex = model.index(0, 0, QModelIndex());
+
+  QVERIFY(model.hasChildren(dataModelIndex));
+  QVERIFY(model.canFetchMore(dataModelIndex));
+  model.fetchMore(dataModelIndex);
+
+  // fetchMore() returns before the reply, with a placeholder row
+  QVERIFY(model.isFetching(dataModelIndex));
+  QCOMPARE(model.rowCount(dataModelIndex), 1);
+  QModelIndex placeholderIndex = model.index(0, 0, dataModelIndex);
+  QVERIFY(model.xnatObject(placeholderIndex) == NULL);
+  QVERIFY(!model.data(placeholderIndex, Qt::DisplayRole).toString().isEmpty());
+  QVERIFY(!model.hasChildren(placeholderIndex));
+  QVERIFY(!model.canFetchMore(placeholderIndex));
+  QVERIFY(!model.canFetchMore(dataModelIndex));
+  QVERIFY(!d->Session->dataModel()->isFetched());
+
+  QSignalSpy finishedSpy(&model, SIGNAL(fetchFinished(QModelIndex)));
+  QVERIFY(this->waitForFetch(model, dataModelIndex));
+  QCOMPARE(finishedSpy.count(), 1);
+
+  QVERIFY(d->Session->dataModel()->isFetched());
+  QCOMPARE(model.rowCount(dataModelIndex), 3);
+  QCOMPARE(model.data(model.index(0, 0, dataModelIndex), Qt::DisplayRole).toString(), QString("Project 1"));
+  QCOMPARE(model.data(model.index(2, 0, dataModelIndex), Qt::DisplayRole).toString(), QString("Project 3"));
+  QCOMPARE(d->Server->requestCount("/data/archive/projects"), 1);
+
+  // Subjects and the resource folder of the first project
+  QModelIndex projectIndex = model.index(0, 0, dataModelIndex);
+  QVERIFY(model.canFetchMore(projectIndex));
+  model.fetchMore(projectIndex);
+  QVERIFY(this->waitForFetch(model, projectIndex));
+  QCOMPARE(model.rowCount(projectIndex), 3);
+  QCOMPARE(model.xnatObject(model.index(0, 0, projectIndex))->id(), QString("s1"));
+  QCOMPARE(model.xnatObject(model.index(1, 0, projectIndex))->id(), QString("s2"));
+  QCOMPARE(d->Server->requestCount("/data/archive/projects/p1/subjects"), 1);
+  QVERIFY(!model.canFetchMore(projectIndex));
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTreeModelTestCase::testLeafIsNotFetchedAgain()
+{
+  Q_D(ctkXnatTreeModelTestCase);
+
+  ctkXnatTreeModel model;
+  model.addDataModel(d->Session->dataModel());
+  QModelIndex dataModelIndex = model.index(0, 0, QModelIndex());
+  model.fetchMore(dataModelIndex);
+  QVERIFY(this->waitForFetch(model, dataModelIndex));
+
+  QModelIndex projectIndex = model.index(1, 0, dataModelIndex);
+  model.fetchMore(projectIndex);
+  QVERIFY(this->waitForFetch(model, projectIndex));
+  QCOMPARE(model.rowCount(projectIndex), 1);
+
+  QModelIndex resourcesIndex = model.index(0, 0, projectIndex);
+  QVERIFY(model.hasChildren(resourcesIndex));
+  model.fetchMore(resourcesIndex);
+  QVERIFY(this->waitForFetch(model, resourcesIndex));
+
+  // Expanding the empty item again must not send another request
+  QCOMPARE(model.rowCount(resourcesIndex), 0);
+  QVERIFY(!model.hasChildren(resourcesIndex));
+  QVERIFY(!model.canFetchMore(resourcesIndex));
+  model.fetchMore(resourcesIndex);
+  QVERIFY(!model.isFetching(resourcesIndex));
+  QCoreApplication::processEvents();
+  QCOMPARE(d->Server->requestCount("/data/archive/projects/p2/resources"), 1);
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTreeModelTestCase::testCancelFetch()
+{
+  Q_D(ctkXnatTreeModelTestCase);
+
+  ctkXnatTreeModel model;
+  model.addDataModel(d->Session->dataModel());
+  QModelIndex dataModelIndex = model.index(0, 0, QModelIndex());
+  model.fetchMore(dataModelIndex);
+  QVERIFY(this->waitForFetch(model, dataModelIndex));
+
+  QSignalSpy finishedSpy(&model, SIGNAL(fetchFinished(QModelIndex)));
+  QSignalSpy insertedSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+
+  QModelIndex projectIndex = model.index(0, 0, dataModelIndex);
+  model.fetchMore(projectIndex);
+  QCOMPARE(model.rowCount(projectIndex), 1);
+
+  // e.g. the item is collapsed before the reply arrives
+  model.cancelFetch(projectIndex);
+  QVERIFY(!model.isFetching(projectIndex));
+  QCOMPARE(model.rowCount(projectIndex), 0);
+  QVERIFY(model.canFetchMore(projectIndex));
+
+  QTime time;
+  time.start();
+  while (d->Server->requestCount("/data/archive/projects/p1/subjects") == 0 && time.elapsed() < 5000)
+  {
+    QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 100);
+  }
+  QTest::qWait(100);
+
+  QCOMPARE(finishedSpy.count(), 0);
+  QCOMPARE(insertedSpy.count(), 1);
+  QCOMPARE(model.rowCount(projectIndex), 0);
+  QVERIFY(!model.xnatObject(projectIndex)->isFetched());
+
+  // The item can be fetched again
+  model.fetchMore(projectIndex);
+  QVERIFY(this->waitForFetch(model, projectIndex));
+  QCOMPARE(model.rowCount(projectIndex), 3);
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTreeModelTestCase::testFetchFailed()
+{
+  Q_D(ctkXnatTreeModelTestCase);
+
+  ctkXnatTreeModel model;
+  model.addDataModel(d->Session->dataModel());
+  QModelIndex dataModelIndex = model.index(0, 0, QModelIndex());
+  model.fetchMore(dataModelIndex);
+  QVERIFY(this->waitForFetch(model, dataModelIndex));
+
+  QSignalSpy failedSpy(&model, SIGNAL(fetchFailed(QModelIndex,QString)));
+
+  QModelIndex projectIndex = model.index(2, 0, dataModelIndex);
+  model.fetchMore(projectIndex);
+  QVERIFY(this->waitForFetch(model, projectIndex));
+
+  QCOMPARE(failedSpy.count(), 1);
+  QCOMPARE(model.rowCount(projectIndex), 0);
+  QVERIFY(!model.xnatObject(projectIndex)->isFetched());
+  QVERIFY(model.xnatObject(projectIndex)->children().isEmpty());
+  QVERIFY(model.canFetchMore(projectIndex));
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTreeModelTestCase::testPrefetch()
+{
+  Q_D(ctkXnatTreeModelTestCase);
+
+  ctkXnatTreeModel model;
+  model.setPrefetchEnabled(true);
+  model.addDataModel(d->Session->dataModel());
+  QModelIndex dataModelIndex = model.index(0, 0, QModelIndex());
+  model.fetchMore(dataModelIndex);
+  QVERIFY(this->waitForFetch(model, dataModelIndex));
+
+  // The projects are fetched in the background, without placeholders
+  QModelIndex projectIndex = model.index(0, 0, dataModelIndex);
+  QVERIFY(!model.isFetching(projectIndex));
+  QCOMPARE(model.rowCount(projectIndex), 0);
+
+  ctkXnatObject* project = model.xnatObject(projectIndex);
+  QTime time;
+  time.start();
+  while (!project->isFetched() && time.elapsed() < 5000)
+  {
+    QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 100);
+  }
+  QVERIFY(project->isFetched());
+
+  // Expanding a prefetched item inserts its rows at once
+  model.fetchMore(projectIndex);
+  QVERIFY(!model.isFetching(projectIndex));
+  QCOMPARE(model.rowCount(projectIndex), 3);
+  QCOMPARE(d->Server->requestCount("/data/archive/projects/p1/subjects"), 1);
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTreeModelTestCase::testPrefetchLimit()
+{
+  Q_D(ctkXnatTreeModelTestCase);
+
+  ctkXnatTreeModel model;
+  model.setPrefetchEnabled(true);
+  model.setPrefetchLimit(1);
+  QCOMPARE(model.prefetchLimit(), 1);
+  model.addDataModel(d->Session->dataModel());
+  QModelIndex dataModelIndex = model.index(0, 0, QModelIndex());
+  model.fetchMore(dataModelIndex);
+  QVERIFY(this->waitForFetch(model, dataModelIndex));
+
+  // The queued prefetches run one after the other, also after a failure
+  ctkXnatObject* secondProject = model.xnatObject(model.index(1, 0, dataModelIndex));
+  QTime time;
+  time.start();
+  while ((!secondProject->isFetched()
+          || d->Server->requestCount("/data/archive/projects/p3/subjects") == 0)
+         && time.elapsed() < 5000)
+  {
+    QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 100);
+  }
+  QVERIFY(model.xnatObject(model.index(0, 0, dataModelIndex))->isFetched());
+  QVERIFY(secondProject->isFetched());
+  QCOMPARE(d->Server->requestCount("/data/archive/projects/p3/subjects"), 1);
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTreeModelTestCase::testCancelQueuedPrefetches()
+{
+  Q_D(ctkXnatTreeModelTestCase);
+
+  ctkXnatTreeModel model;
+  model.setPrefetchEnabled(true);
+  model.setPrefetchLimit(1);
+  model.addDataModel(d->Session->dataModel());
+  QModelIndex dataModelIndex = model.index(0, 0, QModelIndex());
+  model.fetchMore(dataModelIndex);
+  QVERIFY(this->waitForFetch(model, dataModelIndex));
+
+  // Collapsing the item drops the prefetches which are still queued
+  model.cancelFetch(dataModelIndex);
+  QTest::qWait(200);
+
+  QCOMPARE(d->Server->requestCount("/data/archive/projects/p2/subjects"), 0);
+  QCOMPARE(d->Server->requestCount("/data/archive/projects/p3/subjects"), 0);
+  QVERIFY(!model.xnatObject(model.index(1, 0, dataModelIndex))->isFetched());
+  QVERIFY(!model.xnatObject(model.index(2, 0, dataModelIndex))->isFetched());
+}
+
+// --------------------------------------------------------------------------
+void ctkXnatTreeModelTestCase::testRefreshPlaceholder()
+{
+  Q_D(ctkXnatTreeModelTestCase);
+
+  ctkXnatTreeModel model;
+  model.addDataModel(d->Session->dataModel());
+  QModelIndex dataModelIndex = model.index(0, 0, QModelIndex());
+  model.fetchMore(dataModelIndex);
+  QVERIFY(model.isFetching(dataModelIndex));
+
+  QModelIndex placeholderIndex = model.index(0, 0, dataModelIndex);
+  QVERIFY(placeholderIndex.isValid());
+  QVERIFY(!model.xnatObject(placeholderIndex));
+  model.refresh(placeholderIndex);
+
+  QVERIFY(this->waitForFetch(model, dataModelIndex));
+  QCOMPARE(model.rowCount(dataModelIndex), 3);
+}
+
+// --------------------------------------------------------------------------
+int ctkXnatTreeModelTest(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+  ctkXnatTreeModelTestCase test;
+  return QTest::qExec(&test, argc, argv);
+}
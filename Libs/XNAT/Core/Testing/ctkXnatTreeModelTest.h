@@ -0,0 +1,74 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) 2013 University College London, Centre for Medical Image Computing
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+
+#ifndef __CTKXNATTREEMODELTEST_H
+#define __CTKXNATTREEMODELTEST_H
+
+#include <QObject>
+
+class QModelIndex;
+class ctkXnatTreeModel;
+class ctkXnatTreeModelTestCasePrivate;
+
+class ctkXnatTreeModelTestCase: public QObject
+{
+  Q_OBJECT
+
+  bool waitForFetch(ctkXnatTreeModel& model, const QModelIndex& index);
+
+public:
+
+  explicit ctkXnatTreeModelTestCase();
+  virtual ~ctkXnatTreeModelTestCase();
+
+private slots:
+
+  void init();
+
+  void cleanup();
+
+  void testFetchMore();
+
+  void testLeafIsNotFetchedAgain();
+
+  void testCancelFetch();
+
+  void testFetchFailed();
+
+  void testPrefetch();
+
+  void testPrefetchLimit();
+
+  void testCancelQueuedPrefetches();
+
+  void testRefreshPlaceholder();
+
+private:
+  QScopedPointer<ctkXnatTreeModelTestCasePrivate> d_ptr;
+
+  Q_DECLARE_PRIVATE(ctkXnatTreeModelTestCase)
+  Q_DISABLE_COPY(ctkXnatTreeModelTestCase)
+};
+
+// --------------------------------------------------------------------------
+int ctkXnatTreeModelTest(int argc, char* argv[]);
+
+#endif
@@ -160,26 +160,40 @@ void ctkXnatExperiment::reset()
 //----------------------------------------------------------------------------
 void ctkXnatExperiment::fetchImpl()
 {
-  QString scansUri = this->resourceUri() + "/scans";
   ctkXnatSession* const session = this->session();
-  QUuid scansQueryId = session->httpGet(scansUri);
 
-  QList<ctkXnatObject*> scans;
-  
-  try
-  {
-    scans = session->httpResults(scansQueryId,
-				 ctkXnatDefaultSchemaTypes::XSI_SCAN);
-  }
-  catch (const ctkException& e)
+  // The scans might have been listed already by ctkXnatSession::fetchSubtree()
+  bool scansFetched = false;
+  foreach (ctkXnatObject* child, this->children())
   {
-    qWarning() << QString(e.what());
+    if (dynamic_cast<ctkXnatScanFolder*>(child) && child->isFetched())
+    {
+      scansFetched = true;
+    }
   }
 
-  if (!scans.isEmpty())
+  if (!scansFetched)
   {
-    ctkXnatScanFolder* scanFolder = new ctkXnatScanFolder();
-    this->add(scanFolder);
+    QString scansUri = this->resourceUri() + "/scans";
+    QUuid scansQueryId = session->httpGet(scansUri);
+
+    QList<ctkXnatObject*> scans;
+
+    try
+    {
+      scans = session->httpResults(scansQueryId,
+                                   ctkXnatDefaultSchemaTypes::XSI_SCAN);
+    }
+    catch (const ctkException& e)
+    {
+      qWarning() << QString(e.what());
+    }
+
+    if (!scans.isEmpty())
+    {
+      ctkXnatScanFolder* scanFolder = new ctkXnatScanFolder();
+      this->add(scanFolder);
+    }
   }
 
   QString reconstructionsUri = this->resourceUri() + "/reconstructions";
@@ -287,6 +287,13 @@ void ctkXnatObject::setSchemaType(const QString& schemaType)
   this->setProperty(XSI_SCHEMA_TYPE, schemaType);
 }
 
+//----------------------------------------------------------------------------
+void ctkXnatObject::setFetched(bool fetched)
+{
+  Q_D(ctkXnatObject);
+  d->fetched = fetched;
+}
+
 //----------------------------------------------------------------------------
 void ctkXnatObject::fetch(bool forceFetch)
 {
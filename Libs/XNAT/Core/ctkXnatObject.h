@@ -189,6 +189,10 @@ private:
 
   void setSchemaType(const QString& schemaType);
 
+  /// Marks the children and the properties of the object as fetched, e.g. after
+  /// they have been listed in bulk by ctkXnatSession::fetchSubtree().
+  void setFetched(bool fetched);
+
   /// The implementation of the fetch mechanism, called by the fetch() function.
   virtual void fetchImpl() = 0;
 
@@ -144,6 +144,12 @@ void ctkXnatProject::reset()
   ctkXnatObject::reset();
 }
 
+//----------------------------------------------------------------------------
+bool ctkXnatProject::fetchSubtree(ctkXnatSession::SubtreeDepth depth)
+{
+  return this->session()->fetchSubtree(this, depth);
+}
+
 //----------------------------------------------------------------------------
 void ctkXnatProject::fetchImpl()
 {
@@ -26,6 +26,7 @@
 
 #include "ctkXnatObject.h"
 #include "ctkXnatDefaultSchemaTypes.h"
+#include "ctkXnatSession.h"
 
 class ctkXnatDataModel;
 class ctkXnatProjectPrivate;
@@ -60,6 +61,10 @@ public:
 
   void reset();
 
+  /// Fetches the subjects, experiments and scans of the project with a few
+  /// requests, see ctkXnatSession::fetchSubtree().
+  bool fetchSubtree(ctkXnatSession::SubtreeDepth depth = ctkXnatSession::Scans);
+
   static const QString SECONDARY_ID;
   static const QString DESCRIPTION;
   static const QString PI_FIRSTNAME;
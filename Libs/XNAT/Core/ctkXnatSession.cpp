@@ -33,6 +33,7 @@
 #include "ctkXnatReconstruction.h"
 #include "ctkXnatResource.h"
 #include "ctkXnatScan.h"
+#include "ctkXnatScanFolder.h"
 #include "ctkXnatSubject.h"
 
 #include <QCryptographicHash>
@@ -40,8 +41,11 @@
 #include <QTimer>
 #include <QDebug>
 #include <QDir>
+#include <QPair>
 #include <QScopedPointer>
+#include <QSharedPointer>
 #include <QStringBuilder>
+#include <QStringList>
 #include <QNetworkCookie>
 
 #include <ctkXnatAPI_p.h>
@@ -55,6 +59,46 @@ static const char* HEADER_COOKIE = "Cookie";
 static QString SERVER_VERSION = "version";
 static QString SESSION_EXPIRATION_DATE = "expires";
 
+//----------------------------------------------------------------------------
+// An object fetched by ctkXnatSession::fetchAsync().
+//
+// ctkXnatObject::fetch() is run in passes which do not block: the requests
+// sent by the fetchImpl() of the object are recorded and their results are
+// empty until the replies arrive. A pass which misses results is undone and
+// repeated when the replies are there. Identical requests are only sent once,
+// so the last pass is answered from the recorded replies.
+struct ctkXnatFetchJob
+{
+  typedef QPair<qRestAPI::ErrorType, QString> Error;
+
+  ctkXnatFetchJob()
+    : object(0)
+    , incomplete(false)
+  {
+  }
+
+  QUuid id;
+  ctkXnatObject* object;
+
+  // The children of the object before the fetch
+  QList<ctkXnatObject*> previousChildren;
+
+  // Query ids of the sent requests, by request
+  QHash<QString, QUuid> queries;
+
+  QList<QUuid> pendingQueries;
+  QMap<QUuid, QSharedPointer<qRestResult> > results;
+  QMap<QUuid, Error> errors;
+
+  // Set during a pass if a result was not available yet
+  bool incomplete;
+
+  bool isQuery(const QUuid& queryId) const
+  {
+    return pendingQueries.contains(queryId) || results.contains(queryId) || errors.contains(queryId);
+  }
+};
+
 //----------------------------------------------------------------------------
 class ctkXnatSessionPrivate
 {
@@ -82,10 +126,27 @@ public:
   // "updateExpirationDate" is called the first time.
   int timeOutPeriod;
 
+  // Running fetches by fetch id and by the id of their pending queries
+  QMap<QUuid, ctkXnatFetchJob*> fetchJobs;
+  QMap<QUuid, ctkXnatFetchJob*> fetchJobsByQuery;
+
+  // The fetch whose pass is running, if any
+  ctkXnatFetchJob* currentFetchJob;
+
+  // Fetches whose next pass is due, and finished queries which have not been
+  // processed yet. They are processed from the event loop.
+  QList<QUuid> readyFetches;
+  QList<QUuid> finishedQueries;
+  bool processFetchesScheduled;
+
+  // Queries of canceled fetches whose results must be discarded
+  QList<QUuid> abandonedQueries;
+
   ctkXnatSessionPrivate(const ctkXnatLoginProfile& loginProfile, ctkXnatSession* q);
   ~ctkXnatSessionPrivate();
 
   void throwXnatException(const QString& msg);
+  void throwXnatException(const QString& msg, qRestAPI::ErrorType error, const QString& errorString);
 
   void createConnections();
   void setDefaultHttpHeaders();
@@ -96,6 +157,30 @@ public:
   void close();
 
   static QList<ctkXnatObject*> results(qRestResult* restResult, QString schemaType);
+
+  static QString requestKey(const QString& resource,
+                            const ctkXnatSession::UrlParameters& parameters,
+                            const ctkXnatSession::HttpRawHeaders& rawHeaders);
+
+  QUuid fetchJobGet(const QString& resource,
+                    const ctkXnatSession::UrlParameters& parameters,
+                    const ctkXnatSession::HttpRawHeaders& rawHeaders);
+  QList<ctkXnatObject*> fetchJobResults(const QUuid& uuid, const QString& schemaType);
+
+  void scheduleFetches();
+  void takeFetchResult(ctkXnatFetchJob* job, const QUuid& queryId);
+  void runFetchJob(ctkXnatFetchJob* job);
+  void undoFetchPass(ctkXnatFetchJob* job);
+  void removeFetchJob(ctkXnatFetchJob* job);
+
+  static QString columnValue(const QVariantMap& row, const QString& column);
+  static QString propertyValue(const ctkXnatObject* object, const QString& column);
+  static ctkXnatObject* scanFolder(ctkXnatObject* experiment);
+
+  QList<ctkXnatObject*> listExperiments(ctkXnatProject* project, const QString& schemaType,
+                                        const QStringList& columns);
+  bool fetchExperiments(ctkXnatProject* project);
+  bool fetchScans(ctkXnatProject* project);
 };
 
 //----------------------------------------------------------------------------
@@ -108,6 +193,8 @@ ctkXnatSessionPrivate::ctkXnatSessionPrivate(const ctkXnatLoginProfile& loginPro
   , timer(new QTimer(q))
   , timeOutWarningPeriod (840000)
   , timeOutPeriod(60000)
+  , currentFetchJob(0)
+  , processFetchesScheduled(false)
 {
   // TODO This is a workaround for connecting to sites with self-signed
   // certificate. Should be replaced with something more clever.
@@ -119,19 +206,27 @@ ctkXnatSessionPrivate::ctkXnatSessionPrivate(const ctkXnatLoginProfile& loginPro
 //----------------------------------------------------------------------------
 ctkXnatSessionPrivate::~ctkXnatSessionPrivate()
 {
+  qDeleteAll(fetchJobs);
 }
 
 //----------------------------------------------------------------------------
 void ctkXnatSessionPrivate::throwXnatException(const QString& msg)
+{
+  this->throwXnatException(msg, xnat->error(), xnat->errorString());
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatSessionPrivate::throwXnatException(const QString& msg, qRestAPI::ErrorType error,
+                                               const QString& errorString)
 {
   QString errorMsg = msg.trimmed();
   if (!errorMsg.isEmpty())
   {
     errorMsg.append(' ');
   }
-  errorMsg.append(xnat->errorString());
+  errorMsg.append(errorString);
 
-  switch (xnat->error())
+  switch (error)
   {
   case qRestAPI::TimeoutError:
     throw ctkXnatTimeoutException(errorMsg);
@@ -243,6 +338,14 @@ QDateTime ctkXnatSessionPrivate::updateExpirationDate(qRestResult* restResult)
 //----------------------------------------------------------------------------
 void ctkXnatSessionPrivate::close()
 {
+  // The objects of the running fetches are deleted with the data model
+  foreach (ctkXnatFetchJob* job, fetchJobs.values())
+  {
+    QUuid fetchId = job->id;
+    this->removeFetchJob(job);
+    emit q->fetchFailed(fetchId, "Session closed.");
+  }
+
   sessionProperties.clear();
   sessionId.clear();
   this->setDefaultHttpHeaders();
@@ -329,6 +432,428 @@ QList<ctkXnatObject*> ctkXnatSessionPrivate::results(qRestResult* restResult, QS
   return results;
 }
 
+//----------------------------------------------------------------------------
+QString ctkXnatSessionPrivate::requestKey(const QString& resource,
+                                          const ctkXnatSession::UrlParameters& parameters,
+                                          const ctkXnatSession::HttpRawHeaders& rawHeaders)
+{
+  QString key = resource;
+  QMapIterator<QString, QString> itParameters(parameters);
+  while (itParameters.hasNext())
+  {
+    itParameters.next();
+    key += '\n' + itParameters.key() + '=' + itParameters.value();
+  }
+  QMapIterator<QByteArray, QByteArray> itRawHeaders(rawHeaders);
+  while (itRawHeaders.hasNext())
+  {
+    itRawHeaders.next();
+    key += '\n' + QString::fromLatin1(itRawHeaders.key()) + ": " + QString::fromLatin1(itRawHeaders.value());
+  }
+  return key;
+}
+
+//----------------------------------------------------------------------------
+QUuid ctkXnatSessionPrivate::fetchJobGet(const QString& resource,
+                                         const ctkXnatSession::UrlParameters& parameters,
+                                         const ctkXnatSession::HttpRawHeaders& rawHeaders)
+{
+  ctkXnatFetchJob* job = currentFetchJob;
+  QString key = requestKey(resource, parameters, rawHeaders);
+  QUuid queryId = job->queries.value(key);
+  if (queryId.isNull())
+  {
+    queryId = xnat->get(resource, parameters, rawHeaders);
+    job->queries.insert(key, queryId);
+    job->pendingQueries.push_back(queryId);
+    fetchJobsByQuery.insert(queryId, job);
+  }
+  return queryId;
+}
+
+//----------------------------------------------------------------------------
+QList<ctkXnatObject*> ctkXnatSessionPrivate::fetchJobResults(const QUuid& uuid, const QString& schemaType)
+{
+  ctkXnatFetchJob* job = currentFetchJob;
+  if (job->results.contains(uuid))
+  {
+    return results(job->results[uuid].data(), schemaType);
+  }
+  if (job->errors.contains(uuid))
+  {
+    const ctkXnatFetchJob::Error& error = job->errors[uuid];
+    this->throwXnatException("Http request failed.", error.first, error.second);
+  }
+  // The reply has not arrived yet, the pass is repeated when it is there
+  job->incomplete = true;
+  return QList<ctkXnatObject*>();
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatSessionPrivate::takeFetchResult(ctkXnatFetchJob* job, const QUuid& queryId)
+{
+  qRestResult* restResult = xnat->takeResult(queryId);
+  if (restResult)
+  {
+    job->results.insert(queryId, QSharedPointer<qRestResult>(restResult));
+    return;
+  }
+
+  // takeResult() deletes the result of a failed query and only exposes its
+  // error until the next failing call, so it is stored with the query here,
+  // before any other request (e.g. of a fetch pass) can replace it.
+  ctkXnatFetchJob::Error error(xnat->error(), xnat->errorString());
+  if (error.second.isEmpty())
+  {
+    error = ctkXnatFetchJob::Error(qRestAPI::UnknownUuidError,
+                                   QString("No result for query %1.").arg(queryId.toString()));
+  }
+  job->errors.insert(queryId, error);
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatSessionPrivate::scheduleFetches()
+{
+  if (!processFetchesScheduled)
+  {
+    processFetchesScheduled = true;
+    QTimer::singleShot(0, q, SLOT(processFetches()));
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatSessionPrivate::runFetchJob(ctkXnatFetchJob* job)
+{
+  QUuid fetchId = job->id;
+  QString error;
+
+  job->incomplete = false;
+  currentFetchJob = job;
+  try
+  {
+    job->object->fetch();
+  }
+  catch (const ctkException& e)
+  {
+    error = e.message();
+    if (error.isEmpty())
+    {
+      error = "Fetching the object failed.";
+    }
+  }
+  currentFetchJob = 0;
+
+  // The session was closed by an authentication error
+  if (!fetchJobs.contains(fetchId))
+  {
+    return;
+  }
+
+  if (!error.isNull())
+  {
+    this->undoFetchPass(job);
+    this->removeFetchJob(job);
+    emit q->fetchFailed(fetchId, error);
+  }
+  else if (job->incomplete)
+  {
+    this->undoFetchPass(job);
+  }
+  else
+  {
+    this->removeFetchJob(job);
+    emit q->fetchFinished(fetchId);
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatSessionPrivate::undoFetchPass(ctkXnatFetchJob* job)
+{
+  ctkXnatObject* object = job->object;
+  QList<ctkXnatObject*> children = object->children();
+
+  // Not the overridden reset(), which does not clear the children
+  // of every kind of object
+  object->ctkXnatObject::reset();
+
+  foreach (ctkXnatObject* child, job->previousChildren)
+  {
+    object->add(child);
+  }
+  foreach (ctkXnatObject* child, children)
+  {
+    if (!job->previousChildren.contains(child))
+    {
+      delete child;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatSessionPrivate::removeFetchJob(ctkXnatFetchJob* job)
+{
+  fetchJobs.remove(job->id);
+  readyFetches.removeAll(job->id);
+  foreach (const QUuid& queryId, job->pendingQueries)
+  {
+    fetchJobsByQuery.remove(queryId);
+    abandonedQueries.push_back(queryId);
+  }
+  delete job;
+}
+
+//----------------------------------------------------------------------------
+QString ctkXnatSessionPrivate::columnValue(const QVariantMap& row, const QString& column)
+{
+  // XNAT does not always return the column names of a listing in the
+  // case in which they were requested
+  QMapIterator<QString, QVariant> it(row);
+  while (it.hasNext())
+  {
+    it.next();
+    if (it.key().compare(column, Qt::CaseInsensitive) == 0)
+    {
+      return it.value().toString();
+    }
+  }
+  return QString();
+}
+
+//----------------------------------------------------------------------------
+QString ctkXnatSessionPrivate::propertyValue(const ctkXnatObject* object, const QString& column)
+{
+  QMapIterator<QString, QString> it(object->properties());
+  while (it.hasNext())
+  {
+    it.next();
+    if (it.key().compare(column, Qt::CaseInsensitive) == 0)
+    {
+      return it.value();
+    }
+  }
+  return QString();
+}
+
+//----------------------------------------------------------------------------
+ctkXnatObject* ctkXnatSessionPrivate::scanFolder(ctkXnatObject* experiment)
+{
+  foreach (ctkXnatObject* child, experiment->children())
+  {
+    if (dynamic_cast<ctkXnatScanFolder*>(child))
+    {
+      return child;
+    }
+  }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+QList<ctkXnatObject*> ctkXnatSessionPrivate::listExperiments(ctkXnatProject* project,
+                                                             const QString& schemaType,
+                                                             const QStringList& columns)
+{
+  ctkXnatSession::UrlParameters parameters;
+  parameters.insert("project", project->id());
+  parameters.insert(ctkXnatObject::XSI_SCHEMA_TYPE, schemaType);
+  parameters.insert("columns", columns.join(","));
+  QUuid queryId = q->httpGet("/data/archive/experiments", parameters);
+  return q->httpResults(queryId, ctkXnatDefaultSchemaTypes::XSI_EXPERIMENT);
+}
+
+//----------------------------------------------------------------------------
+bool ctkXnatSessionPrivate::fetchExperiments(ctkXnatProject* project)
+{
+  // The subjects are identified by their label, see ctkXnatProject::fetchImpl()
+  QMap<QString, ctkXnatObject*> subjects;
+  foreach (ctkXnatObject* child, project->children())
+  {
+    if (dynamic_cast<ctkXnatSubject*>(child) && !child->isFetched())
+    {
+      subjects.insert(child->id(), child);
+    }
+  }
+  if (subjects.isEmpty())
+  {
+    return true;
+  }
+
+  // The same columns as ctkXnatSubject::fetchImpl() requests, and the
+  // label of the subject of each experiment
+  QStringList columns;
+  columns << ctkXnatObject::ID << ctkXnatObject::LABEL << ctkXnatObject::XSI_SCHEMA_TYPE
+          << ctkXnatSubject::INSERT_DATE << ctkXnatSubject::INSERT_USER << ctkXnatObject::URI;
+  QStringList imageSessionColumns = columns;
+  imageSessionColumns << ctkXnatExperiment::DATE_OF_ACQUISITION
+                      << ctkXnatExperiment::TIME_OF_ACQUISITION
+                      << ctkXnatExperiment::SCANNER_TYPE
+                      << ctkXnatExperiment::IMAGE_MODALITY;
+  columns << "subject_label";
+  imageSessionColumns << "subject_label";
+
+  QList<ctkXnatObject*> experiments;
+  try
+  {
+    experiments = this->listExperiments(project, ctkXnatDefaultSchemaTypes::XSI_IMAGE_SESSION_DATA,
+                                        imageSessionColumns);
+    experiments << this->listExperiments(project, ctkXnatDefaultSchemaTypes::XSI_SUBJECT_VARIABLE_DATA,
+                                         columns);
+  }
+  catch (const ctkException& e)
+  {
+    qWarning() << "Listing the experiments of project" << project->id()
+               << "failed, falling back to fetching them per subject:" << e.what();
+    qDeleteAll(experiments);
+    return false;
+  }
+
+  foreach (ctkXnatObject* experiment, experiments)
+  {
+    if (!experiment->properties().keys().contains("subject_label", Qt::CaseInsensitive))
+    {
+      qWarning() << "The experiment listing of the server does not relate experiments to"
+                 << "subjects, falling back to fetching them per subject.";
+      qDeleteAll(experiments);
+      return false;
+    }
+  }
+
+  foreach (ctkXnatObject* experiment, experiments)
+  {
+    ctkXnatObject* subject = subjects.value(propertyValue(experiment, "subject_label"));
+    if (!subject)
+    {
+      // The subject had already been fetched
+      delete experiment;
+      continue;
+    }
+
+    QString label = experiment->name();
+    if (!label.isEmpty())
+    {
+      experiment->setId(label);
+    }
+    subject->add(experiment);
+  }
+
+  foreach (ctkXnatObject* subject, subjects)
+  {
+    subject->fetchResources();
+    subject->setFetched(true);
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool ctkXnatSessionPrivate::fetchScans(ctkXnatProject* project)
+{
+  // The experiments whose scans have not been fetched yet, by the labels
+  // of their subject and their own label
+  QMap<QString, ctkXnatObject*> experiments;
+  foreach (ctkXnatObject* subject, project->children())
+  {
+    if (!dynamic_cast<ctkXnatSubject*>(subject))
+    {
+      continue;
+    }
+    foreach (ctkXnatObject* experiment, subject->children())
+    {
+      // A fetched experiment without a scan folder has no scans
+      ctkXnatObject* scans = scanFolder(experiment);
+      if (dynamic_cast<ctkXnatExperiment*>(experiment)
+          && (scans ? !scans->isFetched() : !experiment->isFetched()))
+      {
+        experiments.insert(subject->id() + '/' + experiment->id(), experiment);
+      }
+    }
+  }
+  if (experiments.isEmpty())
+  {
+    return true;
+  }
+
+  // One row per scan, and one without scan columns per image session
+  // without scans
+  const QString scanColumn = "xnat:imagescandata/";
+  QStringList columns;
+  columns << ctkXnatObject::LABEL << "subject_label"
+          << scanColumn + ctkXnatObject::ID
+          << scanColumn + ctkXnatScan::TYPE
+          << scanColumn + ctkXnatScan::SERIES_DESCRIPTION
+          << scanColumn + ctkXnatScan::QUALITY;
+
+  ctkXnatSession::UrlParameters parameters;
+  parameters.insert("project", project->id());
+  parameters.insert(ctkXnatObject::XSI_SCHEMA_TYPE, ctkXnatDefaultSchemaTypes::XSI_IMAGE_SESSION_DATA);
+  parameters.insert("columns", columns.join(","));
+
+  QList<QVariantMap> rows;
+  try
+  {
+    rows = q->httpSync(q->httpGet("/data/archive/experiments", parameters));
+  }
+  catch (const ctkException& e)
+  {
+    qWarning() << "Listing the scans of project" << project->id()
+               << "failed, falling back to fetching them per experiment:" << e.what();
+    return false;
+  }
+
+  foreach (const QVariantMap& row, rows)
+  {
+    if (!row.keys().contains(scanColumn + ctkXnatObject::ID, Qt::CaseInsensitive))
+    {
+      qWarning() << "The experiment listing of the server does not contain the scans,"
+                 << "falling back to fetching them per experiment.";
+      return false;
+    }
+  }
+
+  QList<ctkXnatObject*> scanFolders;
+  foreach (const QVariantMap& row, rows)
+  {
+    QString scanId = columnValue(row, scanColumn + ctkXnatObject::ID);
+    ctkXnatObject* experiment = experiments.value(columnValue(row, "subject_label") + '/'
+                                                  + columnValue(row, ctkXnatObject::LABEL));
+    if (scanId.isEmpty() || !experiment)
+    {
+      continue;
+    }
+
+    ctkXnatObject* scans = scanFolder(experiment);
+    if (!scans)
+    {
+      scans = new ctkXnatScanFolder();
+      experiment->add(scans);
+    }
+    if (!scanFolders.contains(scans))
+    {
+      scanFolders.push_back(scans);
+    }
+
+    ctkXnatObject* scan = new ctkXnatScan();
+    QString description;
+    QStringList properties;
+    properties << ctkXnatObject::ID << ctkXnatScan::TYPE
+               << ctkXnatScan::SERIES_DESCRIPTION << ctkXnatScan::QUALITY;
+    foreach (const QString& property, properties)
+    {
+      QString value = columnValue(row, scanColumn + property);
+      scan->setProperty(property, value);
+      description.append(property + QString("\t::\t") + value + "\n");
+    }
+    // As in ctkXnatScanFolder::fetchImpl()
+    scan->setProperty(ctkXnatObject::LABEL, scan->property(ctkXnatScan::SERIES_DESCRIPTION));
+    scan->setDescription(description);
+    scans->add(scan);
+  }
+
+  foreach (ctkXnatObject* scans, scanFolders)
+  {
+    scans->setFetched(true);
+  }
+  return true;
+}
+
 
 //----------------------------------------------------------------------------
 // ctkXnatSession class
@@ -354,6 +879,8 @@ ctkXnatSession::ctkXnatSession(const ctkXnatLoginProfile& loginProfile)
 //  QObject::connect(d->xnat.data(), SIGNAL(uploadFinished()), this, SIGNAL(uploadFinished()));
   QObject::connect(d->xnat.data(), SIGNAL(progress(QUuid,double)),
           this, SIGNAL(progress(QUuid,double)));
+  QObject::connect(d->xnat.data(), SIGNAL(finished(QUuid)),
+          this, SLOT(requestFinished(QUuid)));
 //  QObject::connect(d->xnat.data(), SIGNAL(progress(QUuid,double)),
 //          this, SLOT(onProgress(QUuid,double)));
 
@@ -535,6 +1062,10 @@ QUuid ctkXnatSession::httpGet(const QString& resource, const ctkXnatSession::Url
   Q_D(ctkXnatSession);
   d->checkSession();
   d->timer->start(d->timeOutWarningPeriod);
+  if (d->currentFetchJob)
+  {
+    return d->fetchJobGet(resource, parameters, rawHeaders);
+  }
   return d->xnat->get(resource, parameters, rawHeaders);
 }
 
@@ -544,6 +1075,11 @@ QList<ctkXnatObject*> ctkXnatSession::httpResults(const QUuid& uuid, const QStri
   Q_D(ctkXnatSession);
   d->checkSession();
 
+  if (d->currentFetchJob && d->currentFetchJob->isQuery(uuid))
+  {
+    return d->fetchJobResults(uuid, schemaType);
+  }
+
   QScopedPointer<qRestResult> restResult(d->xnat->takeResult(uuid));
   if (restResult == NULL)
   {
@@ -716,6 +1252,154 @@ void ctkXnatSession::upload(ctkXnatFile *xnatFile,
   }
 }
 
+//----------------------------------------------------------------------------
+bool ctkXnatSession::fetchSubtree(ctkXnatProject* project, SubtreeDepth depth)
+{
+  Q_D(ctkXnatSession);
+  d->checkSession();
+
+  // The subjects are listed with a single request anyway
+  project->fetch();
+
+  bool bulk = true;
+  if (depth >= Experiments && !d->fetchExperiments(project))
+  {
+    bulk = false;
+    foreach (ctkXnatObject* subject, project->children())
+    {
+      if (dynamic_cast<ctkXnatSubject*>(subject))
+      {
+        subject->fetch();
+      }
+    }
+  }
+
+  if (depth >= Scans && !d->fetchScans(project))
+  {
+    bulk = false;
+    foreach (ctkXnatObject* subject, project->children())
+    {
+      if (!dynamic_cast<ctkXnatSubject*>(subject))
+      {
+        continue;
+      }
+      foreach (ctkXnatObject* experiment, subject->children())
+      {
+        if (!dynamic_cast<ctkXnatExperiment*>(experiment))
+        {
+          continue;
+        }
+        experiment->fetch();
+        if (ctkXnatObject* scans = d->scanFolder(experiment))
+        {
+          scans->fetch();
+        }
+      }
+    }
+  }
+  return bulk;
+}
+
+//----------------------------------------------------------------------------
+QUuid ctkXnatSession::fetchAsync(ctkXnatObject* object)
+{
+  Q_D(ctkXnatSession);
+  d->checkSession();
+
+  ctkXnatFetchJob* job = new ctkXnatFetchJob();
+  job->id = QUuid::createUuid();
+  job->object = object;
+  job->previousChildren = object->children();
+  d->fetchJobs.insert(job->id, job);
+
+  // The first pass is run from the event loop, so that the signals are
+  // never emitted before the caller knows the id
+  d->readyFetches.push_back(job->id);
+  d->scheduleFetches();
+
+  return job->id;
+}
+
+//----------------------------------------------------------------------------
+bool ctkXnatSession::cancelFetch(const QUuid& fetchId)
+{
+  Q_D(ctkXnatSession);
+  ctkXnatFetchJob* job = d->fetchJobs.value(fetchId);
+  if (!job)
+  {
+    return false;
+  }
+  d->removeFetchJob(job);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool ctkXnatSession::isFetching(const QUuid& fetchId) const
+{
+  Q_D(const ctkXnatSession);
+  return d->fetchJobs.contains(fetchId);
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatSession::requestFinished(const QUuid& queryId)
+{
+  Q_D(ctkXnatSession);
+
+  // The result is taken from the event loop, after the API has finished
+  // processing the reply
+  if (d->fetchJobsByQuery.contains(queryId) || d->abandonedQueries.contains(queryId))
+  {
+    d->finishedQueries.push_back(queryId);
+    d->scheduleFetches();
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatSession::processFetches()
+{
+  Q_D(ctkXnatSession);
+  d->processFetchesScheduled = false;
+
+  foreach (const QUuid& queryId, d->finishedQueries)
+  {
+    if (d->abandonedQueries.removeOne(queryId))
+    {
+      delete d->xnat->takeResult(queryId);
+      continue;
+    }
+
+    ctkXnatFetchJob* job = d->fetchJobsByQuery.take(queryId);
+    if (!job)
+    {
+      continue;
+    }
+    job->pendingQueries.removeOne(queryId);
+
+    d->takeFetchResult(job, queryId);
+
+    if (job->pendingQueries.isEmpty() && !d->readyFetches.contains(job->id))
+    {
+      d->readyFetches.push_back(job->id);
+    }
+  }
+  d->finishedQueries.clear();
+
+  if (!d->readyFetches.isEmpty())
+  {
+    d->timer->start(d->timeOutWarningPeriod);
+  }
+
+  // Passes may finish fetches, which are then removed from the list
+  while (!d->readyFetches.isEmpty())
+  {
+    ctkXnatFetchJob* job = d->fetchJobs.value(d->readyFetches.takeFirst());
+    if (job)
+    {
+      d->runFetchJob(job);
+    }
+  }
+}
+
 //----------------------------------------------------------------------------
 void ctkXnatSession::processResult(QUuid queryId, QList<QVariantMap> parameters)
 {
@@ -40,6 +40,7 @@ class ctkXnatFile;
 class ctkXnatLoginProfile;
 class ctkXnatDataModel;
 class ctkXnatObject;
+class ctkXnatProject;
 class ctkXnatResource;
 
 /**
@@ -57,6 +58,14 @@ public:
   typedef QMap<QString, QString> UrlParameters;
   typedef QMap<QByteArray, QByteArray> HttpRawHeaders;
 
+  /// The levels of the data hierarchy below a project fetched by fetchSubtree()
+  enum SubtreeDepth
+  {
+    Subjects = 1,
+    Experiments,
+    Scans
+  };
+
   ctkXnatSession(const ctkXnatLoginProfile& loginProfile);
   ~ctkXnatSession();
 
@@ -262,6 +271,87 @@ public:
    */
   QUuid httpHead(const QString& resourceUri);
 
+  /**
+   * @brief Fetches several levels of the data hierarchy below a project at once.
+   *
+   * Instead of one request per subject and experiment, the flat experiment
+   * listing of XNAT is queried for the whole project, with the columns that
+   * relate the rows to their subjects and experiments:
+   *
+   * - the subjects are fetched by ctkXnatObject::fetch() of the project,
+   * - the experiments of all subjects are listed with two requests,
+   * - the scans of all image sessions are listed with one request.
+   *
+   * The project and its subjects are fetched afterwards, as if
+   * ctkXnatObject::fetch() was called for them. The experiments get scan
+   * folders with their scans, which are fetched as well. The experiments
+   * themselves stay unfetched, since their reconstructions and assessors are
+   * not listed, but fetching them does not list their scans again. Subjects
+   * and scan folders which had already been fetched are left as they are.
+   *
+   * If the server does not support a listing, the level is fetched node by
+   * node with ctkXnatObject::fetch().
+   *
+   * @param project The project to fetch.
+   * @param depth The deepest level to fetch.
+   *
+   * @throws ctkXnatInvalidSessionException if the session is closed.
+   * @return \c true if the levels were listed in bulk, \c false if they were
+   *         fetched node by node.
+   */
+  bool fetchSubtree(ctkXnatProject* project, SubtreeDepth depth = Scans);
+
+  /**
+   * @brief Fetches the children and the properties of an object without blocking.
+   *
+   * The requests of ctkXnatObject::fetch() are sent at once and the object is
+   * fetched when all replies have arrived. Requests which depend on earlier
+   * replies are sent as soon as these replies are available. Until then the
+   * object stays unfetched, its children are not changed.
+   *
+   * Either fetchFinished() or fetchFailed() is emitted with the returned id,
+   * always after this method returned.
+   *
+   * @param object The object to fetch. It must belong to this session and
+   *        must not be deleted while the fetch is running.
+   *
+   * @throws ctkXnatInvalidSessionException if the session is closed.
+   * @return The id of the fetch.
+   */
+  QUuid fetchAsync(ctkXnatObject* object);
+
+  /**
+   * @brief Cancels a fetch started by fetchAsync().
+   *
+   * No signal is emitted for a canceled fetch and the object is left
+   * unfetched. Replies which are still in transit are discarded.
+   *
+   * @param fetchId The id of the fetch.
+   * @return \c true if the fetch was still running, \c false otherwise.
+   */
+  bool cancelFetch(const QUuid& fetchId);
+
+  /**
+   * @brief Tells if a fetch started by fetchAsync() is still running.
+   */
+  bool isFetching(const QUuid& fetchId) const;
+
+  /**
+   * @brief Signals that a fetch started by fetchAsync() has finished.
+   * @param fetchId The id of the fetch.
+   */
+  Q_SIGNAL void fetchFinished(const QUuid& fetchId);
+
+  /**
+   * @brief Signals that a fetch started by fetchAsync() has failed.
+   *
+   * The object is left unfetched, so that the fetch can be repeated.
+   *
+   * @param fetchId The id of the fetch.
+   * @param error The description of the error.
+   */
+  Q_SIGNAL void fetchFailed(const QUuid& fetchId, const QString& error);
+
   /**
    * @brief Signals that the session was re-newed.
    * @param expirationDate The new session expiration date.
@@ -303,6 +393,8 @@ private:
   Q_DECLARE_PRIVATE(ctkXnatSession)
   Q_DISABLE_COPY(ctkXnatSession)
   Q_SLOT void emitTimeOut();
+  Q_SLOT void requestFinished(const QUuid& queryId);
+  Q_SLOT void processFetches();
 };
 
 #endif
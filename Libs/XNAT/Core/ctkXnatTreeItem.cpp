@@ -57,6 +57,14 @@ void ctkXnatTreeItem::appendChild(ctkXnatTreeItem* item)
   item->m_ParentItem = this;
 }
 
+//----------------------------------------------------------------------------
+ctkXnatTreeItem* ctkXnatTreeItem::takeChild(int row)
+{
+  ctkXnatTreeItem* item = m_ChildItems.takeAt(row);
+  item->m_ParentItem = 0;
+  return item;
+}
+
 //----------------------------------------------------------------------------
 void ctkXnatTreeItem::removeChildren()
 {
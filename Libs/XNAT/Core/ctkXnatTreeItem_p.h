@@ -28,6 +28,8 @@
 #include <QVariant>
 
 
+/// A tree item without an xnat object is the placeholder of the children of its
+/// parent while they are fetched.
 class ctkXnatTreeItem
 {
 public:
@@ -39,6 +41,7 @@ public:
   ctkXnatObject* xnatObject() const;
 
   void appendChild(ctkXnatTreeItem* child);
+  ctkXnatTreeItem* takeChild(int row);
   void removeChildren();
 
   ctkXnatTreeItem* child(int row);
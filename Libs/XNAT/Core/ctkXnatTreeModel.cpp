@@ -23,9 +23,12 @@
 
 #include "ctkXnatDataModel.h"
 #include "ctkXnatObject.h"
+#include "ctkXnatSession.h"
 #include "ctkXnatTreeItem_p.h"
 
+#include <QHash>
 #include <QList>
+#include <QMap>
 
 class ctkXnatTreeModelPrivate
 {
@@ -33,6 +36,8 @@ public:
 
   ctkXnatTreeModelPrivate()
     : m_RootItem(new ctkXnatTreeItem())
+    , m_PrefetchEnabled(false)
+    , m_PrefetchLimit(4)
   {
   }
 
@@ -41,8 +46,99 @@ public:
     return static_cast<ctkXnatTreeItem*>(index.internalPointer());
   }
 
+  QModelIndex indexOf(const ctkXnatTreeModel* model, ctkXnatTreeItem* item) const
+  {
+    if (item == m_RootItem.data())
+    {
+      return QModelIndex();
+    }
+    return model->index(item->row(), 0, this->indexOf(model, item->parent()));
+  }
+
+  static ctkXnatSession* session(const ctkXnatObject* xnatObject)
+  {
+    while (xnatObject->parent())
+    {
+      xnatObject = xnatObject->parent();
+    }
+    const ctkXnatDataModel* dataModel = dynamic_cast<const ctkXnatDataModel*>(xnatObject);
+    return dataModel ? dataModel->session() : 0;
+  }
+
+  bool isPrefetching(ctkXnatTreeItem* item) const
+  {
+    return m_FetchIds.contains(item) && m_Prefetches.contains(m_FetchIds[item]);
+  }
+
+  void startFetch(ctkXnatTreeItem* item, bool prefetch)
+  {
+    ctkXnatSession* session = this->session(item->xnatObject());
+    if (!session)
+    {
+      return;
+    }
+    QUuid fetchId = session->fetchAsync(item->xnatObject());
+    m_Fetches.insert(fetchId, item);
+    m_FetchIds.insert(item, fetchId);
+    if (prefetch)
+    {
+      m_Prefetches.push_back(fetchId);
+    }
+  }
+
+  // Starts queued prefetches until the limit of running prefetches is reached
+  void startPrefetches()
+  {
+    while (m_Prefetches.size() < m_PrefetchLimit && !m_PrefetchQueue.isEmpty())
+    {
+      ctkXnatTreeItem* item = m_PrefetchQueue.takeFirst();
+      if (!item->xnatObject()->isFetched() && !m_FetchIds.contains(item))
+      {
+        this->startFetch(item, true);
+      }
+    }
+  }
+
+  void cancelFetch(ctkXnatTreeItem* item)
+  {
+    QUuid fetchId = m_FetchIds.take(item);
+    m_Fetches.remove(fetchId);
+    m_Prefetches.removeOne(fetchId);
+    ctkXnatSession* session = this->session(item->xnatObject());
+    if (session)
+    {
+      session->cancelFetch(fetchId);
+    }
+  }
+
+  // Cancels the fetches of the item and of its descendants
+  void cancelFetches(ctkXnatTreeItem* item)
+  {
+    m_PrefetchQueue.removeAll(item);
+    if (m_FetchIds.contains(item))
+    {
+      this->cancelFetch(item);
+    }
+    for (int i = 0; i < item->childCount(); ++i)
+    {
+      this->cancelFetches(item->child(i));
+    }
+  }
+
   QScopedPointer<ctkXnatTreeItem> m_RootItem;
 
+  // Running fetches by fetch id and by item
+  QMap<QUuid, ctkXnatTreeItem*> m_Fetches;
+  QHash<ctkXnatTreeItem*, QUuid> m_FetchIds;
+
+  // Fetches started in the background, their items have no placeholder
+  QList<QUuid> m_Prefetches;
+
+  // Items waiting for a prefetch, in the order of their rows
+  QList<ctkXnatTreeItem*> m_PrefetchQueue;
+
+  bool m_PrefetchEnabled;
+  int m_PrefetchLimit;
 };
 
 //----------------------------------------------------------------------------
@@ -70,7 +166,14 @@ QVariant ctkXnatTreeModel::data(const QModelIndex& index, int role) const
   {
     return QVariant(int(Qt::AlignTop | Qt::AlignLeft));
   }
-  else if (role == Qt::DisplayRole)
+
+  if (!this->xnatObject(index))
+  {
+    // placeholder of the children which are being fetched
+    return role == Qt::DisplayRole ? QVariant(tr("Loading...")) : QVariant();
+  }
+
+  if (role == Qt::DisplayRole)
   {
     ctkXnatObject* xnatObject = this->xnatObject(index);
 
@@ -182,7 +285,13 @@ bool ctkXnatTreeModel::hasChildren(const QModelIndex& index) const
   }
 
   ctkXnatTreeItem* item = d->itemAt(index);
-  return item->xnatObject() || !item->xnatObject()->isFetched() || !item->xnatObject()->children().isEmpty();
+  if (item->childCount() > 0)
+  {
+    return true;
+  }
+
+  ctkXnatObject* xnatObject = item->xnatObject();
+  return xnatObject && (!xnatObject->isFetched() || !xnatObject->children().isEmpty());
 }
 
 //----------------------------------------------------------------------------
@@ -195,34 +304,220 @@ bool ctkXnatTreeModel::canFetchMore(const QModelIndex& index) const
 
   Q_D(const ctkXnatTreeModel);
   ctkXnatTreeItem* item = d->itemAt(index);
-  return !(item->childCount() > 0);
+
+  // The placeholder counts as a child while the item is being fetched
+  ctkXnatObject* xnatObject = item->xnatObject();
+  if (!xnatObject || item->childCount() > 0)
+  {
+    return false;
+  }
+
+  // Fetched objects without children are leaves, they are not fetched again
+  return !xnatObject->isFetched() || !xnatObject->children().isEmpty();
 }
 
 //----------------------------------------------------------------------------
 void ctkXnatTreeModel::fetchMore(const QModelIndex& index)
 {
-  if (!index.isValid())
+  if (!this->canFetchMore(index))
   {
     return;
   }
 
-  Q_D(const ctkXnatTreeModel);
+  Q_D(ctkXnatTreeModel);
   ctkXnatTreeItem* item = d->itemAt(index);
 
-  ctkXnatObject* xnatObject = item->xnatObject();
+  if (item->xnatObject()->isFetched())
+  {
+    this->insertChildItems(index);
+    return;
+  }
+
+  // A running prefetch gets a placeholder, otherwise a fetch is started
+  if (d->isPrefetching(item))
+  {
+    d->m_Prefetches.removeOne(d->m_FetchIds[item]);
+    d->startPrefetches();
+  }
+  else
+  {
+    d->m_PrefetchQueue.removeAll(item);
+    d->startFetch(item, false);
+    if (!d->m_FetchIds.contains(item))
+    {
+      return;
+    }
+  }
+
+  beginInsertRows(index, 0, 0);
+  item->appendChild(new ctkXnatTreeItem());
+  endInsertRows();
+}
+
+//----------------------------------------------------------------------------
+bool ctkXnatTreeModel::isFetching(const QModelIndex& parent) const
+{
+  if (!parent.isValid())
+  {
+    return false;
+  }
+
+  Q_D(const ctkXnatTreeModel);
+  ctkXnatTreeItem* item = d->itemAt(parent);
+  return d->m_FetchIds.contains(item) && !d->isPrefetching(item);
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatTreeModel::setPrefetchEnabled(bool enabled)
+{
+  Q_D(ctkXnatTreeModel);
+  d->m_PrefetchEnabled = enabled;
+}
+
+//----------------------------------------------------------------------------
+bool ctkXnatTreeModel::isPrefetchEnabled() const
+{
+  Q_D(const ctkXnatTreeModel);
+  return d->m_PrefetchEnabled;
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatTreeModel::setPrefetchLimit(int limit)
+{
+  Q_D(ctkXnatTreeModel);
+  d->m_PrefetchLimit = qMax(1, limit);
+  d->startPrefetches();
+}
+
+//----------------------------------------------------------------------------
+int ctkXnatTreeModel::prefetchLimit() const
+{
+  Q_D(const ctkXnatTreeModel);
+  return d->m_PrefetchLimit;
+}
 
-  xnatObject->fetch();
+//----------------------------------------------------------------------------
+void ctkXnatTreeModel::cancelFetch(const QModelIndex& parent)
+{
+  if (!parent.isValid())
+  {
+    return;
+  }
 
-  QList<ctkXnatObject*> children = xnatObject->children();
-  if (!children.isEmpty())
+  Q_D(ctkXnatTreeModel);
+  ctkXnatTreeItem* item = d->itemAt(parent);
+
+  for (int i = 0; i < item->childCount(); ++i)
   {
-    beginInsertRows(index, 0, children.size() - 1);
-    foreach (ctkXnatObject* child, children)
+    ctkXnatTreeItem* childItem = item->child(i);
+    d->m_PrefetchQueue.removeAll(childItem);
+    if (d->isPrefetching(childItem))
     {
-      item->appendChild(new ctkXnatTreeItem(child, item));
+      d->cancelFetch(childItem);
     }
-    endInsertRows();
   }
+
+  if (this->isFetching(parent))
+  {
+    d->cancelFetch(item);
+    this->removePlaceholder(parent);
+  }
+
+  d->startPrefetches();
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatTreeModel::insertChildItems(const QModelIndex& parent)
+{
+  Q_D(ctkXnatTreeModel);
+  ctkXnatTreeItem* item = d->itemAt(parent);
+
+  QList<ctkXnatObject*> children = item->xnatObject()->children();
+  if (children.isEmpty())
+  {
+    return;
+  }
+
+  beginInsertRows(parent, 0, children.size() - 1);
+  foreach (ctkXnatObject* child, children)
+  {
+    item->appendChild(new ctkXnatTreeItem(child, item));
+  }
+  endInsertRows();
+
+  // Only a few prefetches run at a time, the others are queued. The rows
+  // at the top, which are visible first, are prefetched first.
+  if (d->m_PrefetchEnabled)
+  {
+    for (int i = 0; i < item->childCount(); ++i)
+    {
+      ctkXnatTreeItem* childItem = item->child(i);
+      if (!childItem->xnatObject()->isFetched())
+      {
+        d->m_PrefetchQueue.push_back(childItem);
+      }
+    }
+    d->startPrefetches();
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatTreeModel::removePlaceholder(const QModelIndex& parent)
+{
+  Q_D(ctkXnatTreeModel);
+  ctkXnatTreeItem* item = d->itemAt(parent);
+
+  beginRemoveRows(parent, 0, 0);
+  delete item->takeChild(0);
+  endRemoveRows();
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatTreeModel::onFetchFinished(const QUuid& fetchId)
+{
+  Q_D(ctkXnatTreeModel);
+  ctkXnatTreeItem* item = d->m_Fetches.take(fetchId);
+  if (!item)
+  {
+    return;
+  }
+  d->m_FetchIds.remove(item);
+
+  QModelIndex index = d->indexOf(this, item);
+  if (d->m_Prefetches.removeOne(fetchId))
+  {
+    // The rows are inserted when the item is expanded, but whether the
+    // item has children is known now
+    emit dataChanged(index, index);
+    d->startPrefetches();
+    return;
+  }
+
+  this->removePlaceholder(index);
+  this->insertChildItems(index);
+  emit fetchFinished(index);
+}
+
+//----------------------------------------------------------------------------
+void ctkXnatTreeModel::onFetchFailed(const QUuid& fetchId, const QString& error)
+{
+  Q_D(ctkXnatTreeModel);
+  ctkXnatTreeItem* item = d->m_Fetches.take(fetchId);
+  if (!item)
+  {
+    return;
+  }
+  d->m_FetchIds.remove(item);
+
+  if (d->m_Prefetches.removeOne(fetchId))
+  {
+    d->startPrefetches();
+    return;
+  }
+
+  QModelIndex index = d->indexOf(this, item);
+  this->removePlaceholder(index);
+  emit fetchFailed(index, error);
 }
 
 //----------------------------------------------------------------------------
@@ -233,11 +528,22 @@ void ctkXnatTreeModel::refresh(const QModelIndex& parent)
     return;
   }
 
-  Q_D(const ctkXnatTreeModel);
+  Q_D(ctkXnatTreeModel);
 
   ctkXnatTreeItem* item = d->itemAt(parent);
 
+  // The placeholder of the children which are being fetched
   ctkXnatObject* xnatObject = item->xnatObject();
+  if (!xnatObject)
+  {
+    return;
+  }
+
+  // Items whose children are being fetched do not have rows to refresh yet
+  if (this->isFetching(parent))
+  {
+    return;
+  }
 
   // Do this just for xnatObjects that are already fetched.
   // Otherwise we would retrieve all data from XNAT
@@ -268,6 +574,8 @@ void ctkXnatTreeModel::refresh(const QModelIndex& parent)
         // -> remove it from the treeview
         if (!childItemObject->exists())
         {
+          d->cancelFetches(item->child(i));
+          d->startPrefetches();
           beginRemoveRows(parent, item->child(i)->row(), item->child(i)->row());
           item->remove(childItemObject);
           xnatObject->remove(child);
@@ -320,13 +628,27 @@ void ctkXnatTreeModel::addDataModel(ctkXnatDataModel* dataModel)
 {
   Q_D(ctkXnatTreeModel);
   d->m_RootItem->appendChild(new ctkXnatTreeItem(dataModel, d->m_RootItem.data()));
+
+  ctkXnatSession* session = dataModel->session();
+  connect(session, SIGNAL(fetchFinished(QUuid)), this, SLOT(onFetchFinished(QUuid)),
+          Qt::UniqueConnection);
+  connect(session, SIGNAL(fetchFailed(QUuid,QString)), this, SLOT(onFetchFailed(QUuid,QString)),
+          Qt::UniqueConnection);
 }
 
 //----------------------------------------------------------------------------
 void ctkXnatTreeModel::removeDataModel(ctkXnatDataModel* dataModel)
 {
   Q_D(ctkXnatTreeModel);
+  for (int i = 0; i < d->m_RootItem->childCount(); ++i)
+  {
+    if (d->m_RootItem->child(i)->xnatObject() == dataModel)
+    {
+      d->cancelFetches(d->m_RootItem->child(i));
+    }
+  }
   d->m_RootItem->remove(dataModel);
+  d->startPrefetches();
 }
 
 //----------------------------------------------------------------------------
@@ -25,6 +25,7 @@
 #include "ctkXNATCoreExport.h"
 
 #include <QAbstractItemModel>
+#include <QUuid>
 
 class ctkXnatObject;
 class ctkXnatDataModel;
@@ -32,6 +33,11 @@ class ctkXnatTreeModelPrivate;
 
 /**
  * @ingroup XNAT_Core
+ *
+ * The children of an item are fetched from the server without blocking.
+ * fetchMore() inserts a placeholder row, which is replaced by the children
+ * when the replies have arrived. Items which turned out to have no children
+ * are not fetched again.
  */
 class CTK_XNAT_CORE_EXPORT ctkXnatTreeModel : public QAbstractItemModel
 {
@@ -67,8 +73,62 @@ public:
 
   void addChildNode(const QModelIndex& index, ctkXnatObject *child);
 
+  /**
+   * @brief Tells if the children of an item are being fetched.
+   *
+   * The item has a placeholder row during the fetch.
+   */
+  bool isFetching(const QModelIndex& parent) const;
+
+  /**
+   * @brief Enables fetching the next level of the tree in the background.
+   *
+   * If enabled, the children of the rows inserted by fetchMore() are fetched
+   * as well, so that they can be expanded without waiting. At most
+   * prefetchLimit() of them are fetched at a time. Disabled by default.
+   */
+  void setPrefetchEnabled(bool enabled);
+  bool isPrefetchEnabled() const;
+
+  /**
+   * @brief Sets the number of prefetches which may run at the same time.
+   *
+   * The other rows wait in a queue and are prefetched from the top, so the
+   * rows which are visible first are prefetched first. The queued prefetches
+   * of the children of an item are dropped by cancelFetch(). Defaults to 4.
+   */
+  void setPrefetchLimit(int limit);
+  int prefetchLimit() const;
+
+  /**
+   * @brief Cancels fetching the children of an item.
+   *
+   * Removes the placeholder row of the item and cancels the running and
+   * queued prefetches of its children. Can be connected to
+   * QTreeView::collapsed().
+   */
+  Q_SLOT void cancelFetch(const QModelIndex& parent);
+
+  /**
+   * @brief Signals that the children of an item have been inserted.
+   */
+  Q_SIGNAL void fetchFinished(const QModelIndex& parent);
+
+  /**
+   * @brief Signals that the children of an item could not be fetched.
+   *
+   * The placeholder row is removed and the item can be fetched again.
+   */
+  Q_SIGNAL void fetchFailed(const QModelIndex& parent, const QString& error);
+
 private:
 
+  void insertChildItems(const QModelIndex& parent);
+  void removePlaceholder(const QModelIndex& parent);
+
+  Q_SLOT void onFetchFinished(const QUuid& fetchId);
+  Q_SLOT void onFetchFailed(const QUuid& fetchId, const QString& error);
+
   const QScopedPointer<ctkXnatTreeModelPrivate> d_ptr;
 
   Q_DECLARE_PRIVATE(ctkXnatTreeModel)
@@ -22,6 +22,7 @@
 
 #include "ctkCMEventDispatcher_p.h"
 
+#include <ctkPluginConstants.h>
 #include <service/log/ctkLogService.h>
 #include <service/cm/ctkConfigurationListener.h>
 
@@ -108,10 +109,18 @@ void ctkCMEventDispatcher::dispatchEvent(ctkConfigurationEvent::Type type, const
 
   foreach (ctkServiceReference ref, refs)
   {
-    queue.put(new _DispatchEventRunnable(&tracker, log, event, ref));
+    // Events are delivered in order to each listener, but a slow
+    // listener does not delay the delivery to other listeners.
+    QString key = QString::number(ref.getProperty(ctkPluginConstants::SERVICE_ID).toLongLong());
+    queue.put(key, new _DispatchEventRunnable(&tracker, log, event, ref));
   }
 }
 
+ctkCMTaskQueueMetrics ctkCMEventDispatcher::getQueueMetrics() const
+{
+  return queue.getMetrics();
+}
+
 ctkConfigurationEvent ctkCMEventDispatcher::createConfigurationEvent(ctkConfigurationEvent::Type type, const QString& factoryPid, const QString& pid)
 {
   if (!configAdminReference)
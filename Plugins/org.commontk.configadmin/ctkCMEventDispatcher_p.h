@@ -50,6 +50,8 @@ public:
 
   void dispatchEvent(ctkConfigurationEvent::Type type, const QString& factoryPid, const QString& pid);
 
+  ctkCMTaskQueueMetrics getQueueMetrics() const;
+
 private:
 
   QMutex mutex;
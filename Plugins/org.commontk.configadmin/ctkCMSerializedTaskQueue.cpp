@@ -20,64 +20,149 @@
 =============================================================================*/
 
 
+
 #include "ctkCMSerializedTaskQueue_p.h"
 
 #include <QRunnable>
-#include <QDebug>
+#include <QThread>
 
 const int ctkCMSerializedTaskQueue::MAX_WAIT = 5000;
+const int ctkCMSerializedTaskQueue::MAX_BATCH = 16;
 
-ctkCMSerializedTaskQueue::ctkCMSerializedTaskQueue(const QString& queueName)
+class ctkCMSerializedTaskQueue::Runner : public QRunnable
 {
-  thread.setObjectName(queueName);
-  moveToThread(&thread);
-  connect(&thread, SIGNAL(started()), SLOT(runTasks()));
-}
 
-ctkCMSerializedTaskQueue::~ctkCMSerializedTaskQueue()
-{
-  thread.quit();
-  waitForTask.wakeAll();
-  thread.wait();
-}
+public:
 
-void ctkCMSerializedTaskQueue::put(QRunnable* newTask)
-{
+  Runner(ctkCMSerializedTaskQueue* queue, const QString& key)
+    : queue(queue), key(key)
   {
-    QMutexLocker lock(&mutex);
-    tasks.push_back(newTask);
   }
-  if (!thread.isRunning())
+
+  void run()
   {
-    thread.start();
+    queue->runTasks(key);
   }
-  else
+
+private:
+
+  ctkCMSerializedTaskQueue* const queue;
+  const QString key;
+};
+
+ctkCMSerializedTaskQueue::ctkCMSerializedTaskQueue(const QString& queueName, int maxThreadCount)
+{
+  pool.setObjectName(queueName);
+  pool.setMaxThreadCount(maxThreadCount > 0 ? maxThreadCount : qMax(2, QThread::idealThreadCount()));
+  // idle threads are released after the same time the former single queue thread waited
+  pool.setExpiryTimeout(MAX_WAIT);
+}
+
+ctkCMSerializedTaskQueue::~ctkCMSerializedTaskQueue()
+{
   {
-    waitForTask.wakeAll();
+    QMutexLocker lock(&mutex);
+    QHash<QString, QList<Task> >::Iterator end = tasks.end();
+    for (QHash<QString, QList<Task> >::Iterator it = tasks.begin(); it != end; ++it)
+    {
+      foreach (const Task& task, it.value())
+      {
+        delete task.runnable;
+      }
+      it.value().clear();
+    }
+    metrics.pendingTasks = 0;
   }
+  pool.waitForDone();
 }
 
-void ctkCMSerializedTaskQueue::runTasks() {
-  QRunnable* task = nextTask(MAX_WAIT);
-  while (task != 0)
+void ctkCMSerializedTaskQueue::put(const QString& key, QRunnable* newTask, bool replaceable)
+{
+  put(key, key, newTask, replaceable);
+}
+
+void ctkCMSerializedTaskQueue::put(const QString& key, const QString& subKey,
+                                   QRunnable* newTask, bool replaceable)
+{
+  Task task = { newTask, subKey, replaceable };
   {
-    task->run();
-    delete task;
-    task = nextTask(MAX_WAIT);
+    QMutexLocker lock(&mutex);
+    QHash<QString, QList<Task> >::Iterator it = tasks.find(key);
+    if (it != tasks.end())
+    {
+      QList<Task>& keyTasks = it.value();
+      if (replaceable)
+      {
+        // The newer task supersedes the last pending one of the sub-key,
+        // unless a task which must be run, e.g. a delete, came after it
+        for (int i = keyTasks.size() - 1; i >= 0; --i)
+        {
+          if (keyTasks[i].subKey != subKey)
+            continue;
+          if (keyTasks[i].replaceable)
+          {
+            delete keyTasks[i].runnable;
+            keyTasks[i].runnable = newTask;
+            ++metrics.coalescedTasks;
+            return;
+          }
+          break;
+        }
+      }
+
+      keyTasks.push_back(task);
+      metrics.maxPendingTasks = qMax(metrics.maxPendingTasks, ++metrics.pendingTasks);
+      // a runner is already scheduled for this key
+      return;
+    }
+
+    tasks[key].push_back(task);
+    metrics.maxPendingTasks = qMax(metrics.maxPendingTasks, ++metrics.pendingTasks);
   }
+  pool.start(new Runner(this, key));
 }
 
-QRunnable* ctkCMSerializedTaskQueue::nextTask(int maxWait)
+void ctkCMSerializedTaskQueue::put(QRunnable* newTask)
+{
+  put(QString(), newTask);
+}
+
+ctkCMTaskQueueMetrics ctkCMSerializedTaskQueue::getMetrics() const
 {
   QMutexLocker lock(&mutex);
-  if (tasks.isEmpty())
+  ctkCMTaskQueueMetrics result = metrics;
+  result.activeKeys = tasks.size();
+  return result;
+}
+
+void ctkCMSerializedTaskQueue::runTasks(const QString& key)
+{
+  for (int i = 0; ; ++i)
   {
-    waitForTask.wait(&mutex, maxWait);
-    if (tasks.isEmpty())
+    QRunnable* task = 0;
     {
-      thread.quit();
-      return 0;
+      QMutexLocker lock(&mutex);
+      QList<Task>& keyTasks = tasks[key];
+      if (keyTasks.isEmpty())
+      {
+        tasks.remove(key);
+        return;
+      }
+      if (i == MAX_BATCH)
+      {
+        // Give other keys a chance if all threads are busy. The key stays
+        // in the hash, so ordering is kept until the new runner starts.
+        pool.start(new Runner(this, key));
+        return;
+      }
+      task = keyTasks.takeFirst().runnable;
+      --metrics.pendingTasks;
     }
+
+    task->run();
+    delete task;
+
+    QMutexLocker lock(&mutex);
+    ++metrics.executedTasks;
   }
-  return tasks.takeFirst();
 }
@@ -20,45 +20,118 @@
 =============================================================================*/
 
 
+
 #ifndef CTKCMSERIALIZEDTASKQUEUE_P_H
 #define CTKCMSERIALIZEDTASKQUEUE_P_H
 
+#include <QHash>
 #include <QList>
-#include <QThread>
-#include <QWaitCondition>
 #include <QMutex>
+#include <QString>
+#include <QThreadPool>
 
 class QRunnable;
 
 /**
- * ctkCMSerializedTaskQueue is a utility class that will allow asynchronous but serialized execution of tasks
+ * Queue depth metrics of a ctkCMSerializedTaskQueue.
  */
-class ctkCMSerializedTaskQueue : public QObject
+struct ctkCMTaskQueueMetrics
+{
+  ctkCMTaskQueueMetrics()
+    : pendingTasks(0), maxPendingTasks(0), activeKeys(0),
+      executedTasks(0), coalescedTasks(0)
+  {}
+
+  /** Number of tasks waiting to be run */
+  int pendingTasks;
+  /** High-water mark of pendingTasks */
+  int maxPendingTasks;
+  /** Number of keys with pending or running tasks */
+  int activeKeys;
+  /** Number of tasks which have been run */
+  qint64 executedTasks;
+  /** Number of tasks which have been dropped because a newer task replaced them */
+  qint64 coalescedTasks;
+};
+
+/**
+ * ctkCMSerializedTaskQueue is a utility class that will allow asynchronous but serialized execution of tasks.
+ * <p>
+ * Tasks are serialized per key, usually a PID. Tasks with different keys run concurrently
+ * on a bounded thread pool, so that a slow task does not delay the tasks of other keys.
+ */
+class ctkCMSerializedTaskQueue
 {
-  Q_OBJECT
 
 public:
 
-  ctkCMSerializedTaskQueue(const QString& queueName);
+  /**
+   * @param queueName The name of the queue.
+   * @param maxThreadCount The maximum number of tasks running concurrently.
+   *        If less than one, QThread::idealThreadCount() is used, but at least two.
+   */
+  ctkCMSerializedTaskQueue(const QString& queueName, int maxThreadCount = 0);
   ~ctkCMSerializedTaskQueue();
 
+  /**
+   * Queue a task which is run after all tasks previously queued for the same key.
+   * The queue takes ownership of the task.
+   *
+   * @param key The key of the task.
+   * @param newTask The task to run.
+   * @param replaceable If <code>true</code>, the task supersedes the last task
+   *        queued for the same key if that one is replaceable too and has not
+   *        been started yet. The superseded task is deleted without being run.
+   */
+  void put(const QString& key, QRunnable* newTask, bool replaceable = false);
+
+  /**
+   * Queue a task which is run after all tasks previously queued for the same key.
+   * The queue takes ownership of the task.
+   *
+   * @param key The key of the task, e.g. the PID of a ctkManagedServiceFactory.
+   * @param subKey What the task acts on within the key, e.g. the PID of a
+   *        factory configuration.
+   * @param newTask The task to run.
+   * @param replaceable If <code>true</code>, the task supersedes the last task
+   *        queued for the same key and sub-key if that one is replaceable too
+   *        and has not been started yet. The superseded task is deleted without
+   *        being run, the new task takes its place in the queue.
+   */
+  void put(const QString& key, const QString& subKey, QRunnable* newTask, bool replaceable = false);
+
+  /**
+   * Queue a task which is run after all tasks previously queued with this method.
+   */
   void put(QRunnable* newTask);
 
-protected Q_SLOTS:
-
-  void runTasks();
+  ctkCMTaskQueueMetrics getMetrics() const;
 
-protected:
+private:
 
-  QRunnable* nextTask(int maxWait);
+  class Runner;
+  friend class Runner;
 
-private:
+  struct Task
+  {
+    QRunnable* runnable;
+    QString subKey;
+    bool replaceable;
+  };
 
   static const int MAX_WAIT; // = 5000
-  QList<QRunnable*> tasks;
-  QThread thread;
-  QMutex mutex;
-  QWaitCondition waitForTask;
+  static const int MAX_BATCH; // = 16
+
+  mutable QMutex mutex;
+  /** Keys which have a runner scheduled or running, with their pending tasks */
+  QHash<QString, QList<Task> > tasks;
+  ctkCMTaskQueueMetrics metrics;
+
+  QThreadPool pool;
+
+  void runTasks(const QString& key);
+
+  Q_DISABLE_COPY(ctkCMSerializedTaskQueue)
 };
 
 #endif // CTKCMSERIALIZEDTASKQUEUE_P_H
@@ -55,6 +55,28 @@ void ctkConfigurationAdminFactory::stop()
   managedServiceFactoryTracker.close();
   eventDispatcher.stop();
   pluginManager.stop();
+
+  ctkCMTaskQueueMetrics metrics = getUpdateQueueMetrics();
+  CTK_DEBUG(logService) << "Configuration updates: " << metrics.executedTasks << " delivered, "
+                        << metrics.coalescedTasks << " superseded, at most "
+                        << metrics.maxPendingTasks << " pending";
+}
+
+ctkCMTaskQueueMetrics ctkConfigurationAdminFactory::getUpdateQueueMetrics() const
+{
+  ctkCMTaskQueueMetrics metrics = managedServiceTracker.getQueueMetrics();
+  ctkCMTaskQueueMetrics factoryMetrics = managedServiceFactoryTracker.getQueueMetrics();
+  metrics.pendingTasks += factoryMetrics.pendingTasks;
+  metrics.maxPendingTasks += factoryMetrics.maxPendingTasks;
+  metrics.activeKeys += factoryMetrics.activeKeys;
+  metrics.executedTasks += factoryMetrics.executedTasks;
+  metrics.coalescedTasks += factoryMetrics.coalescedTasks;
+  return metrics;
+}
+
+ctkCMTaskQueueMetrics ctkConfigurationAdminFactory::getEventQueueMetrics() const
+{
+  return eventDispatcher.getQueueMetrics();
 }
 
 QObject* ctkConfigurationAdminFactory::getService(QSharedPointer<ctkPlugin> plugin,
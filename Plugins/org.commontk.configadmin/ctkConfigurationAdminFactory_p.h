@@ -70,6 +70,17 @@ public:
 
   void modifyConfiguration(const ctkServiceReference& reference, ctkDictionary& properties);
 
+  /**
+   * Queue depth metrics of the ctkManagedService and ctkManagedServiceFactory
+   * update queues, summed up.
+   */
+  ctkCMTaskQueueMetrics getUpdateQueueMetrics() const;
+
+  /**
+   * Queue depth metrics of the ctkConfigurationListener event queue.
+   */
+  ctkCMTaskQueueMetrics getEventQueueMetrics() const;
+
 public Q_SLOTS:
 
   void pluginChanged(const ctkPluginEvent& event);
@@ -97,7 +97,7 @@ void ctkManagedServiceFactoryTracker::notifyDeleted(ctkConfigurationImpl* config
   ctkServiceReference reference = getManagedServiceFactoryReference(factoryPid);
   if (reference && config->bind(reference.getPlugin()))
   {
-    asynchDeleted(getManagedServiceFactory(factoryPid), config->getPid(false));
+    asynchDeleted(getManagedServiceFactory(factoryPid), factoryPid, config->getPid(false));
   }
 }
 
@@ -110,7 +110,7 @@ void ctkManagedServiceFactoryTracker::notifyUpdated(ctkConfigurationImpl* config
   {
     ctkDictionary properties = config->getProperties();
     configurationAdminFactory->modifyConfiguration(reference, properties);
-    asynchUpdated(getManagedServiceFactory(factoryPid), config->getPid(), properties);
+    asynchUpdated(getManagedServiceFactory(factoryPid), factoryPid, config->getPid(), properties);
   }
 }
 
@@ -133,7 +133,7 @@ void ctkManagedServiceFactoryTracker::addManagedServiceFactory(
       {
         ctkDictionary properties = config->getProperties();
         configurationAdminFactory->modifyConfiguration(reference, properties);
-        asynchUpdated(service, config->getPid(), properties);
+        asynchUpdated(service, factoryPid, config->getPid(), properties);
       }
       else
       {
@@ -236,9 +236,11 @@ private:
   ctkLogService* const log;
 };
 
-void ctkManagedServiceFactoryTracker::asynchDeleted(ctkManagedServiceFactory* service, const QString& pid)
+void ctkManagedServiceFactoryTracker::asynchDeleted(ctkManagedServiceFactory* service,
+                                                    const QString& factoryPid, const QString& pid)
 {
-  queue.put(new _AsynchDeleteRunnable(service, pid, configurationAdminFactory->getLogService()));
+  // Serialized with all calls to the same factory, but never superseded
+  queue.put(factoryPid, pid, new _AsynchDeleteRunnable(service, pid, configurationAdminFactory->getLogService()));
 }
 
 class _AsynchFactoryUpdateRunnable : public QRunnable
@@ -277,8 +279,17 @@ private:
   ctkLogService* const log;
 };
 
-void ctkManagedServiceFactoryTracker::asynchUpdated(ctkManagedServiceFactory* service, const QString& pid,
+void ctkManagedServiceFactoryTracker::asynchUpdated(ctkManagedServiceFactory* service,
+                                                    const QString& factoryPid, const QString& pid,
                                                     const ctkDictionary& properties)
 {
-  queue.put(new _AsynchFactoryUpdateRunnable(service, pid, properties, configurationAdminFactory->getLogService()));
+  // A factory is never called concurrently, so updates are serialized per
+  // factory PID. A queued update of a configuration PID which has not been
+  // delivered yet is superseded by a newer one.
+  queue.put(factoryPid, pid, new _AsynchFactoryUpdateRunnable(service, pid, properties, configurationAdminFactory->getLogService()), true);
+}
+
+ctkCMTaskQueueMetrics ctkManagedServiceFactoryTracker::getQueueMetrics() const
+{
+  return queue.getMetrics();
 }
@@ -51,6 +51,8 @@ public:
   void notifyDeleted(ctkConfigurationImpl* config);
   void notifyUpdated(ctkConfigurationImpl* config);
 
+  ctkCMTaskQueueMetrics getQueueMetrics() const;
+
 private:
 
   ctkPluginContext* context;
@@ -85,10 +87,11 @@ private:
 
   QString getPidForManagedServiceFactory(ctkManagedServiceFactory* service) const;
 
-  void asynchDeleted(ctkManagedServiceFactory* service, const QString& pid);
+  void asynchDeleted(ctkManagedServiceFactory* service, const QString& factoryPid,
+                     const QString& pid);
 
-  void asynchUpdated(ctkManagedServiceFactory* service, const QString& pid,
-                     const ctkDictionary& properties);
+  void asynchUpdated(ctkManagedServiceFactory* service, const QString& factoryPid,
+                     const QString& pid, const ctkDictionary& properties);
 };
 
 #endif // CTKMANAGEDSERVICEFACTORYTRACKER_P_H
@@ -91,7 +91,7 @@ void ctkManagedServiceTracker::notifyDeleted(ctkConfigurationImpl* config)
   QString pid = config->getPid(false);
   ctkServiceReference reference = getManagedServiceReference(pid);
   if (reference && config->bind(reference.getPlugin()))
-    asynchUpdated(getManagedService(pid), ctkDictionary());
+    asynchUpdated(pid, getManagedService(pid), ctkDictionary());
 }
 
 void ctkManagedServiceTracker::notifyUpdated(ctkConfigurationImpl* config) {
@@ -102,7 +102,7 @@ void ctkManagedServiceTracker::notifyUpdated(ctkConfigurationImpl* config) {
   {
     ctkDictionary properties = config->getProperties();
     configurationAdminFactory->modifyConfiguration(reference, properties);
-    asynchUpdated(getManagedService(pid), properties);
+    asynchUpdated(pid, getManagedService(pid), properties);
   }
 }
 
@@ -113,7 +113,7 @@ void ctkManagedServiceTracker::addManagedService(const ctkServiceReference& refe
   ctkConfigurationImplPtr config = configurationStore->findConfiguration(pid);
   if (config.isNull() && trackManagedService(pid, reference, service))
   {
-    asynchUpdated(service, ctkDictionary());
+    asynchUpdated(pid, service, ctkDictionary());
   }
   else
   {
@@ -128,13 +128,13 @@ void ctkManagedServiceTracker::addManagedService(const ctkServiceReference& refe
       }
       else if (config->isDeleted())
       {
-        asynchUpdated(service, ctkDictionary());
+        asynchUpdated(pid, service, ctkDictionary());
       }
       else if (config->bind(reference.getPlugin()))
       {
         ctkDictionary properties = config->getProperties();
         configurationAdminFactory->modifyConfiguration(reference, properties);
-        asynchUpdated(service, properties);
+        asynchUpdated(pid, service, properties);
       }
       else
       {
@@ -247,7 +247,15 @@ private:
   ctkLogService * const log;
 };
 
-void ctkManagedServiceTracker::asynchUpdated(ctkManagedService* service, const ctkDictionary& properties)
+void ctkManagedServiceTracker::asynchUpdated(const QString& pid, ctkManagedService* service,
+                                             const ctkDictionary& properties)
 {
-  queue.put(new _AsynchUpdateRunnable(service, properties, configurationAdminFactory->getLogService()));
+  // Updates are serialized per PID. A queued update which has not been
+  // delivered yet is superseded by a newer one.
+  queue.put(pid, new _AsynchUpdateRunnable(service, properties, configurationAdminFactory->getLogService()), true);
+}
+
+ctkCMTaskQueueMetrics ctkManagedServiceTracker::getQueueMetrics() const
+{
+  return queue.getMetrics();
 }
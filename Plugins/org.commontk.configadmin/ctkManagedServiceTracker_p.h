@@ -51,6 +51,8 @@ public:
   void notifyDeleted(ctkConfigurationImpl* config);
   void notifyUpdated(ctkConfigurationImpl* config);
 
+  ctkCMTaskQueueMetrics getQueueMetrics() const;
+
 private:
 
   ctkPluginContext* context;
@@ -81,7 +83,7 @@ private:
 
   QString getPidForManagedService(ctkManagedService* service) const;
 
-  void asynchUpdated(ctkManagedService* service, const ctkDictionary& properties);
+  void asynchUpdated(const QString& pid, ctkManagedService* service, const ctkDictionary& properties);
 };
 
 #endif // CTKMANAGEDSERVICETRACKER_P_H
@@ -0,0 +1,251 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+// Qt includes
+#include <QElapsedTimer>
+#include <QStringList>
+
+// CTK includes
+#include <ctkDicomAvailableDataHelper.h>
+#include <ctkDicomObjectLocatorCache.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+const int NumberOfPatients = 10;
+const int NumberOfStudies = 10;  // per patient
+const int NumberOfSeries = 10;   // per study
+const int NumberOfObjects = 30;  // per series
+
+QString patientID(int p)
+{
+  return QString("PAT%1").arg(p);
+}
+QString studyUID(int p, int s)
+{
+  return QString("1.2.826.0.1.3680043.2.1125.%1.%2").arg(p).arg(s);
+}
+QString seriesUID(int p, int s, int r)
+{
+  return QString("%1.%2").arg(studyUID(p, s)).arg(r);
+}
+QString descriptorUUID(int p, int s, int r, int o)
+{
+  return QString("{%1.%2}").arg(seriesUID(p, s, r)).arg(o);
+}
+}
+
+//----------------------------------------------------------------------------
+int ctkDicomAvailableDataHelperTest1(int argc, char* argv[])
+{
+  Q_UNUSED(argc);
+  Q_UNUSED(argv);
+
+  using namespace ctkDicomAvailableDataHelper;
+
+  ctkDicomAppHosting::AvailableData data;
+  ctkDicomAvailableDataAccessor accessor(data);
+  ctkDicomObjectLocatorCache cache;
+
+  //----------------------------------------------------------------------------
+  // Populate: NumberOfPatients * ... * NumberOfObjects descriptors
+  QElapsedTimer timer;
+  timer.start();
+  int descriptorCount = 0;
+  for (int p = 0; p < NumberOfPatients; ++p)
+    {
+    ctkDicomAppHosting::Patient patient;
+    patient.id = patientID(p);
+    for (int s = 0; s < NumberOfStudies; ++s)
+      {
+      ctkDicomAppHosting::Study study;
+      study.studyUID = studyUID(p, s);
+      for (int r = 0; r < NumberOfSeries; ++r)
+        {
+        ctkDicomAppHosting::Series series;
+        series.seriesUID = seriesUID(p, s, r);
+        for (int o = 0; o < NumberOfObjects; ++o)
+          {
+          ctkDicomAppHosting::ObjectDescriptor objectDescriptor;
+          objectDescriptor.descriptorUUID = descriptorUUID(p, s, r, o);
+          objectDescriptor.mimeType = "application/dicom";
+          accessor.addObjectDescriptor(patient, study, series, objectDescriptor);
+
+          ctkDicomAppHosting::ObjectLocator locator;
+          locator.locator = objectDescriptor.descriptorUUID;
+          locator.source = objectDescriptor.descriptorUUID;
+          locator.URI = QString("file:///tmp/%1.dcm").arg(descriptorCount);
+          cache.insert(objectDescriptor.descriptorUUID, locator);
+          ++descriptorCount;
+          }
+        }
+      }
+    }
+  std::cout << "Added " << descriptorCount << " object descriptors in "
+            << timer.elapsed() << " ms" << std::endl;
+
+  if (data.patients.count() != NumberOfPatients
+      || data.patients[0].studies.count() != NumberOfStudies
+      || data.patients[0].studies[0].series.count() != NumberOfSeries
+      || data.patients[0].studies[0].series[0].objectDescriptors.count() != NumberOfObjects)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with addObjectDescriptor() method"
+              << " - unexpected hierarchy" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //----------------------------------------------------------------------------
+  // Lookups
+  timer.restart();
+  for (int p = 0; p < NumberOfPatients; ++p)
+    {
+    ctkDicomAppHosting::Patient patient;
+    patient.id = patientID(p);
+    if (accessor.getPatient(patient) == NULL)
+      {
+      std::cerr << "Line " << __LINE__ << " - Problem with getPatient() method" << std::endl;
+      return EXIT_FAILURE;
+      }
+    for (int s = 0; s < NumberOfStudies; ++s)
+      {
+      ctkDicomAppHosting::Study* study = accessor.getStudy(studyUID(p, s));
+      if (study == NULL || study->studyUID != studyUID(p, s))
+        {
+        std::cerr << "Line " << __LINE__ << " - Problem with getStudy() method" << std::endl;
+        return EXIT_FAILURE;
+        }
+      for (int r = 0; r < NumberOfSeries; ++r)
+        {
+        ctkDicomAppHosting::Series* series = accessor.getSeries(seriesUID(p, s, r));
+        if (series == NULL || series->seriesUID != seriesUID(p, s, r))
+          {
+          std::cerr << "Line " << __LINE__ << " - Problem with getSeries() method" << std::endl;
+          return EXIT_FAILURE;
+          }
+        for (int o = 0; o < NumberOfObjects; ++o)
+          {
+          QString uuid = descriptorUUID(p, s, r, o);
+          ctkDicomAppHosting::ObjectDescriptor* objectDescriptor =
+            accessor.getObjectDescriptor(uuid);
+          if (objectDescriptor == NULL || objectDescriptor->descriptorUUID != uuid)
+            {
+            std::cerr << "Line " << __LINE__ << " - Problem with getObjectDescriptor() method"
+                      << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+  std::cout << "Looked up " << descriptorCount << " object descriptors in "
+            << timer.elapsed() << " ms" << std::endl;
+
+  if (accessor.getStudy("1.2.3") != NULL
+      || accessor.getSeries("1.2.3") != NULL
+      || accessor.getObjectDescriptor("{unknown}") != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with lookup of unknown UIDs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //----------------------------------------------------------------------------
+  // Direct modifications of the available data invalidate the index
+  data.patients.removeFirst();
+  if (accessor.getStudy(studyUID(0, 0)) != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with getStudy() method"
+              << " - removed study still found" << std::endl;
+    return EXIT_FAILURE;
+    }
+  ctkDicomAppHosting::Study* movedStudy = accessor.getStudy(studyUID(1, 0));
+  if (movedStudy == NULL || movedStudy != &data.patients[0].studies[0])
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with getStudy() method"
+              << " - stale index" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkDicomAppHosting::Series extraSeries;
+  extraSeries.seriesUID = "1.2.3.4";
+  data.patients[0].studies[0].series.append(extraSeries);
+  accessor.update();
+  if (accessor.getSeries("1.2.3.4") != &data.patients[0].studies[0].series.last())
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with update() method" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //----------------------------------------------------------------------------
+  // isCached of a small and a large available data against all cached
+  // locators. The timings are only reported, the former linear scan of the
+  // cache keys took several seconds for the large one.
+  ctkDicomAppHosting::AvailableData smallData;
+  ctkDicomAvailableDataAccessor smallAccessor(smallData);
+  ctkDicomAppHosting::Patient patient;
+  patient.id = patientID(1);
+  ctkDicomAppHosting::Study study;
+  study.studyUID = studyUID(1, 0);
+  ctkDicomAppHosting::Series series;
+  series.seriesUID = seriesUID(1, 0, 0);
+  for (int o = 0; o < NumberOfObjects; ++o)
+    {
+    ctkDicomAppHosting::ObjectDescriptor objectDescriptor;
+    objectDescriptor.descriptorUUID = descriptorUUID(1, 0, 0, o);
+    smallAccessor.addObjectDescriptor(patient, study, series, objectDescriptor);
+    }
+
+  const int repeat = 100;
+  timer.restart();
+  for (int i = 0; i < repeat; ++i)
+    {
+    if (!cache.isCached(smallData))
+      {
+      std::cerr << "Line " << __LINE__ << " - Problem with isCached() method" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  qint64 smallElapsed = timer.elapsed();
+
+  timer.restart();
+  if (!cache.isCached(data))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with isCached() method" << std::endl;
+    return EXIT_FAILURE;
+    }
+  qint64 largeElapsed = timer.elapsed();
+  std::cout << "isCached: " << repeat << " x " << NumberOfObjects << " descriptors in "
+            << smallElapsed << " ms, " << descriptorCount - NumberOfObjects * NumberOfSeries
+            * NumberOfStudies << " descriptors in " << largeElapsed << " ms" << std::endl;
+
+  data.objectDescriptors.append(ctkDicomAppHosting::ObjectDescriptor());
+  data.objectDescriptors.last().descriptorUUID = "{not-cached}";
+  if (cache.isCached(data))
+    {
+    std::cerr << "Line " << __LINE__ << " - Problem with isCached() method"
+              << " - unknown descriptor reported as cached" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
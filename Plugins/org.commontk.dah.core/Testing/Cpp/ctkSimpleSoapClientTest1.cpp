@@ -0,0 +1,160 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QList>
+
+// CTK includes
+#include <ctkSimpleSoapClient.h>
+#include <ctkSimpleSoapServer.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+//----------------------------------------------------------------------------
+/// Answers each request with its first argument, and counts the TCP
+/// connections the client opened.
+class ctkSimpleSoapEchoServer : public ctkSimpleSoapServer
+{
+  Q_OBJECT
+
+public:
+  ctkSimpleSoapEchoServer() : ConnectionCount(0)
+  {
+    connect(this, SIGNAL(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)),
+            this, SLOT(echo(QtSoapMessage,QtSoapMessage*)));
+  }
+
+  int ConnectionCount;
+
+protected Q_SLOTS:
+  void echo(const QtSoapMessage& message, QtSoapMessage* reply)
+  {
+    reply->setMethod(message.method().name().name() + "Response");
+    reply->addMethodArgument(new QtSoapSimpleType(QtSoapQName("return"),
+                                                  message.method()[0].value().toString()));
+  }
+
+protected:
+#if (QT_VERSION < 0x50000)
+  virtual void incomingConnection(int socketDescriptor)
+#else
+  virtual void incomingConnection(qintptr socketDescriptor)
+#endif
+  {
+    ++this->ConnectionCount;
+    this->ctkSimpleSoapServer::incomingConnection(socketDescriptor);
+  }
+};
+
+//----------------------------------------------------------------------------
+int ctkSimpleSoapClientTest1(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  ctkSimpleSoapEchoServer server;
+  if (!server.listen(QHostAddress::LocalHost))
+    {
+    std::cerr << "Line " << __LINE__ << " - Could not listen: "
+              << qPrintable(server.errorString()) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ctkSimpleSoapClient client(server.serverPort(), "/IHostService");
+  const int iterations = 200;
+
+  //----------------------------------------------------------------------------
+  // Blocking round trips, over a single persistent connection
+  QElapsedTimer timer;
+  timer.start();
+  for (int i = 0; i < iterations; ++i)
+    {
+    QString text = QString("ping %1").arg(i);
+    const QtSoapType& result = client.submitSoapRequest("Echo",
+      new QtSoapSimpleType(QtSoapQName("text"), text));
+    if (result.value().toString() != text)
+      {
+      std::cerr << "Line " << __LINE__ << " - Unexpected response: \""
+                << qPrintable(result.value().toString()) << "\" instead of \""
+                << qPrintable(text) << "\"" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  double blockingLatency = static_cast<double>(timer.elapsed()) / iterations;
+  std::cout << "Blocking round trip latency: " << blockingLatency << " ms" << std::endl;
+
+  if (server.ConnectionCount != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - The connection was not kept alive: "
+              << server.ConnectionCount << " connections" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  //----------------------------------------------------------------------------
+  // Concurrent (pipelined) requests
+  timer.restart();
+  QList<QFuture<QtSoapMessage> > futures;
+  for (int i = 0; i < iterations; ++i)
+    {
+    futures << client.submitSoapRequestAsync("Echo",
+      new QtSoapSimpleType(QtSoapQName("text"), QString("async %1").arg(i)));
+    }
+  for (int i = 0; i < iterations; ++i)
+    {
+    while (!futures[i].isFinished())
+      {
+      QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+      }
+    const QtSoapMessage& response = futures[i].result();
+    if (response.isFault() ||
+        response.returnValue().value().toString() != QString("async %1").arg(i))
+      {
+      std::cerr << "Line " << __LINE__ << " - Unexpected asynchronous response "
+                << i << ": " << qPrintable(response.toXmlString()) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  double asynchronousLatency = static_cast<double>(timer.elapsed()) / iterations;
+  std::cout << "Asynchronous request time: " << asynchronousLatency << " ms"
+            << " (" << server.ConnectionCount << " connections)" << std::endl;
+
+  //----------------------------------------------------------------------------
+  // A failed request completes its future with a fault
+  ctkSimpleSoapClient unreachableClient(1, "/IHostService");
+  QFuture<QtSoapMessage> failed = unreachableClient.submitSoapRequestAsync("Echo", 0);
+  while (!failed.isFinished())
+    {
+    QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+  if (!failed.result().isFault())
+    {
+    std::cerr << "Line " << __LINE__ << " - Unreachable server did not fault" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+#include "moc_ctkSimpleSoapClientTest1.cpp"
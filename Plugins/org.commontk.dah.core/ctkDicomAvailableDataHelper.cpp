@@ -30,6 +30,24 @@
 
 namespace ctkDicomAvailableDataHelper {
 
+//------------------------------------------------------------------------------
+namespace
+{
+/// Position of an item in the nested lists of the available data. The
+/// levels below the item are -1 (e.g. a patient level object descriptor
+/// has a Study index of -1).
+struct ctkDicomAvailableDataLocation
+{
+  ctkDicomAvailableDataLocation()
+    : Patient(-1), Study(-1), Series(-1), Descriptor(-1) {}
+  int Patient;
+  int Study;
+  int Series;
+  int Descriptor;
+};
+typedef QHash<QString, ctkDicomAvailableDataLocation> ctkDicomAvailableDataIndex;
+}
+
 //------------------------------------------------------------------------------
 class ctkDicomAvailableDataAccessorPrivate
 {
@@ -38,11 +56,324 @@ protected:
   
 public:
   ctkDicomAvailableDataAccessorPrivate(ctkDicomAppHosting::AvailableData& availableData) : 
-      m_AvailableData(availableData) { };
+      m_AvailableData(availableData) { this->buildIndex(); };
+
+  void buildIndex() const;
+  void indexDescriptors(const ctkDicomAppHosting::ArrayOfObjectDescriptors& descriptors,
+                        ctkDicomAvailableDataLocation location) const;
+
+  /// Items at a location, NULL if the location is out of range
+  ctkDicomAppHosting::Patient* patient(const ctkDicomAvailableDataLocation& location) const;
+  ctkDicomAppHosting::Study* study(const ctkDicomAvailableDataLocation& location) const;
+  ctkDicomAppHosting::Series* series(const ctkDicomAvailableDataLocation& location) const;
+  ctkDicomAppHosting::ArrayOfObjectDescriptors* descriptors(const ctkDicomAvailableDataLocation& location) const;
+  ctkDicomAppHosting::ObjectDescriptor* descriptor(const ctkDicomAvailableDataLocation& location) const;
+
+  /// Indexed lookups. An index entry which does not match the data anymore
+  /// (the data has been modified directly) triggers a rebuild of the index.
+  ctkDicomAppHosting::Patient* findPatient(const QString& patientID,
+                                           ctkDicomAvailableDataLocation* location = 0) const;
+  ctkDicomAppHosting::Study* findStudy(const QString& studyUID,
+                                       ctkDicomAvailableDataLocation* location = 0) const;
+  ctkDicomAppHosting::Series* findSeries(const QString& seriesUID,
+                                         ctkDicomAvailableDataLocation* location = 0) const;
+
+  /// Find the series of the study of the patient
+  void find(const QString& patientID, const QString& studyUID, const QString& seriesUID,
+            ctkDicomAvailableDataLocation& location,
+            ctkDicomAppHosting::Patient*& patientResult,
+            ctkDicomAppHosting::Study*& studyResult,
+            ctkDicomAppHosting::Series*& seriesResult) const;
 
   ctkDicomAppHosting::AvailableData& m_AvailableData;
+
+  /// The first item with a given ID/UID is indexed, as the former linear
+  /// searches returned the first match.
+  mutable ctkDicomAvailableDataIndex PatientIndex;
+  mutable ctkDicomAvailableDataIndex StudyIndex;
+  mutable ctkDicomAvailableDataIndex SeriesIndex;
+  mutable ctkDicomAvailableDataIndex DescriptorIndex;
 };
 
+//----------------------------------------------------------------------------
+// ctkDicomAvailableDataAccessorPrivate methods
+
+//----------------------------------------------------------------------------
+void ctkDicomAvailableDataAccessorPrivate::buildIndex() const
+{
+  this->PatientIndex.clear();
+  this->StudyIndex.clear();
+  this->SeriesIndex.clear();
+  this->DescriptorIndex.clear();
+
+  ctkDicomAvailableDataLocation location;
+  this->indexDescriptors(m_AvailableData.objectDescriptors, location);
+  for (location.Patient = 0; location.Patient < m_AvailableData.patients.count(); ++location.Patient)
+    {
+    const ctkDicomAppHosting::Patient& patient = m_AvailableData.patients.at(location.Patient);
+    location.Study = -1;
+    location.Series = -1;
+    if (!this->PatientIndex.contains(patient.id))
+      {
+      this->PatientIndex.insert(patient.id, location);
+      }
+    this->indexDescriptors(patient.objectDescriptors, location);
+    for (location.Study = 0; location.Study < patient.studies.count(); ++location.Study)
+      {
+      const ctkDicomAppHosting::Study& study = patient.studies.at(location.Study);
+      location.Series = -1;
+      if (!this->StudyIndex.contains(study.studyUID))
+        {
+        this->StudyIndex.insert(study.studyUID, location);
+        }
+      this->indexDescriptors(study.objectDescriptors, location);
+      for (location.Series = 0; location.Series < study.series.count(); ++location.Series)
+        {
+        const ctkDicomAppHosting::Series& series = study.series.at(location.Series);
+        if (!this->SeriesIndex.contains(series.seriesUID))
+          {
+          this->SeriesIndex.insert(series.seriesUID, location);
+          }
+        this->indexDescriptors(series.objectDescriptors, location);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void ctkDicomAvailableDataAccessorPrivate::indexDescriptors(
+  const ctkDicomAppHosting::ArrayOfObjectDescriptors& descriptors,
+  ctkDicomAvailableDataLocation location) const
+{
+  for (location.Descriptor = 0; location.Descriptor < descriptors.count(); ++location.Descriptor)
+    {
+    const QString& uuid = descriptors.at(location.Descriptor).descriptorUUID;
+    if (!this->DescriptorIndex.contains(uuid))
+      {
+      this->DescriptorIndex.insert(uuid, location);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+ctkDicomAppHosting::Patient* ctkDicomAvailableDataAccessorPrivate::patient(
+  const ctkDicomAvailableDataLocation& location) const
+{
+  if (location.Patient < 0 || location.Patient >= m_AvailableData.patients.count())
+    {
+    return NULL;
+    }
+  return &m_AvailableData.patients[location.Patient];
+}
+
+//----------------------------------------------------------------------------
+ctkDicomAppHosting::Study* ctkDicomAvailableDataAccessorPrivate::study(
+  const ctkDicomAvailableDataLocation& location) const
+{
+  ctkDicomAppHosting::Patient* patient = this->patient(location);
+  if (!patient || location.Study < 0 || location.Study >= patient->studies.count())
+    {
+    return NULL;
+    }
+  return &patient->studies[location.Study];
+}
+
+//----------------------------------------------------------------------------
+ctkDicomAppHosting::Series* ctkDicomAvailableDataAccessorPrivate::series(
+  const ctkDicomAvailableDataLocation& location) const
+{
+  ctkDicomAppHosting::Study* study = this->study(location);
+  if (!study || location.Series < 0 || location.Series >= study->series.count())
+    {
+    return NULL;
+    }
+  return &study->series[location.Series];
+}
+
+//----------------------------------------------------------------------------
+ctkDicomAppHosting::ArrayOfObjectDescriptors* ctkDicomAvailableDataAccessorPrivate::descriptors(
+  const ctkDicomAvailableDataLocation& location) const
+{
+  if (location.Patient < 0)
+    {
+    return &m_AvailableData.objectDescriptors;
+    }
+  if (location.Study < 0)
+    {
+    ctkDicomAppHosting::Patient* patient = this->patient(location);
+    return patient ? &patient->objectDescriptors : NULL;
+    }
+  if (location.Series < 0)
+    {
+    ctkDicomAppHosting::Study* study = this->study(location);
+    return study ? &study->objectDescriptors : NULL;
+    }
+  ctkDicomAppHosting::Series* series = this->series(location);
+  return series ? &series->objectDescriptors : NULL;
+}
+
+//----------------------------------------------------------------------------
+ctkDicomAppHosting::ObjectDescriptor* ctkDicomAvailableDataAccessorPrivate::descriptor(
+  const ctkDicomAvailableDataLocation& location) const
+{
+  ctkDicomAppHosting::ArrayOfObjectDescriptors* descriptors = this->descriptors(location);
+  if (!descriptors || location.Descriptor < 0 || location.Descriptor >= descriptors->count())
+    {
+    return NULL;
+    }
+  return &(*descriptors)[location.Descriptor];
+}
+
+//----------------------------------------------------------------------------
+ctkDicomAppHosting::Patient* ctkDicomAvailableDataAccessorPrivate::findPatient(
+  const QString& patientID, ctkDicomAvailableDataLocation* location) const
+{
+  ctkDicomAvailableDataIndex::const_iterator it = this->PatientIndex.constFind(patientID);
+  if (it == this->PatientIndex.constEnd())
+    {
+    return NULL;
+    }
+  ctkDicomAppHosting::Patient* patient = this->patient(it.value());
+  if (!patient || patient->id != patientID)
+    {
+    this->buildIndex();
+    it = this->PatientIndex.constFind(patientID);
+    if (it == this->PatientIndex.constEnd())
+      {
+      return NULL;
+      }
+    patient = this->patient(it.value());
+    }
+  if (location)
+    {
+    *location = it.value();
+    }
+  return patient;
+}
+
+//----------------------------------------------------------------------------
+ctkDicomAppHosting::Study* ctkDicomAvailableDataAccessorPrivate::findStudy(
+  const QString& studyUID, ctkDicomAvailableDataLocation* location) const
+{
+  ctkDicomAvailableDataIndex::const_iterator it = this->StudyIndex.constFind(studyUID);
+  if (it == this->StudyIndex.constEnd())
+    {
+    return NULL;
+    }
+  ctkDicomAppHosting::Study* study = this->study(it.value());
+  if (!study || study->studyUID != studyUID)
+    {
+    this->buildIndex();
+    it = this->StudyIndex.constFind(studyUID);
+    if (it == this->StudyIndex.constEnd())
+      {
+      return NULL;
+      }
+    study = this->study(it.value());
+    }
+  if (location)
+    {
+    *location = it.value();
+    }
+  return study;
+}
+
+//----------------------------------------------------------------------------
+ctkDicomAppHosting::Series* ctkDicomAvailableDataAccessorPrivate::findSeries(
+  const QString& seriesUID, ctkDicomAvailableDataLocation* location) const
+{
+  ctkDicomAvailableDataIndex::const_iterator it = this->SeriesIndex.constFind(seriesUID);
+  if (it == this->SeriesIndex.constEnd())
+    {
+    return NULL;
+    }
+  ctkDicomAppHosting::Series* series = this->series(it.value());
+  if (!series || series->seriesUID != seriesUID)
+    {
+    this->buildIndex();
+    it = this->SeriesIndex.constFind(seriesUID);
+    if (it == this->SeriesIndex.constEnd())
+      {
+      return NULL;
+      }
+    series = this->series(it.value());
+    }
+  if (location)
+    {
+    *location = it.value();
+    }
+  return series;
+}
+
+//----------------------------------------------------------------------------
+void ctkDicomAvailableDataAccessorPrivate::find(const QString& patientID,
+                                                const QString& studyUID,
+                                                const QString& seriesUID,
+                                                ctkDicomAvailableDataLocation& location,
+                                                ctkDicomAppHosting::Patient*& patientResult,
+                                                ctkDicomAppHosting::Study*& studyResult,
+                                                ctkDicomAppHosting::Series*& seriesResult) const
+{
+  location = ctkDicomAvailableDataLocation();
+  patientResult = this->findPatient(patientID, &location);
+  studyResult = NULL;
+  seriesResult = NULL;
+  if (!patientResult)
+    {
+    return;
+    }
+
+  // The index holds the first study with this UID: if it belongs to
+  // another patient, look in this patient only
+  ctkDicomAvailableDataLocation studyLocation;
+  studyResult = this->findStudy(studyUID, &studyLocation);
+  if (studyResult && studyLocation.Patient != location.Patient)
+    {
+    studyResult = NULL;
+    for (int i = 0; i < patientResult->studies.count(); ++i)
+      {
+      if (patientResult->studies[i].studyUID == studyUID)
+        {
+        studyResult = &patientResult->studies[i];
+        location.Study = i;
+        break;
+        }
+      }
+    }
+  else if (studyResult)
+    {
+    location.Study = studyLocation.Study;
+    }
+  if (!studyResult)
+    {
+    return;
+    }
+
+  ctkDicomAvailableDataLocation seriesLocation;
+  seriesResult = this->findSeries(seriesUID, &seriesLocation);
+  if (seriesResult && (seriesLocation.Patient != location.Patient ||
+                       seriesLocation.Study != location.Study))
+    {
+    seriesResult = NULL;
+    for (int i = 0; i < studyResult->series.count(); ++i)
+      {
+      if (studyResult->series[i].seriesUID == seriesUID)
+        {
+        seriesResult = &studyResult->series[i];
+        location.Series = i;
+        break;
+        }
+      }
+    }
+  else if (seriesResult)
+    {
+    location.Series = seriesLocation.Series;
+    }
+}
+
+//----------------------------------------------------------------------------
+// ctkDicomAvailableDataAccessor methods
+
 //----------------------------------------------------------------------------
 ctkDicomAvailableDataAccessor::ctkDicomAvailableDataAccessor(ctkDicomAppHosting::AvailableData& ad)
   : d_ptr(new ctkDicomAvailableDataAccessorPrivate(ad))
@@ -51,58 +382,63 @@ ctkDicomAvailableDataAccessor::ctkDicomAvailableDataAccessor(ctkDicomAppHosting:
 
 ctkDicomAvailableDataAccessor::~ctkDicomAvailableDataAccessor() {};
 
+//----------------------------------------------------------------------------
+ctkDicomAppHosting::AvailableData& ctkDicomAvailableDataAccessor::availableData() const
+{
+  const Q_D(ctkDicomAvailableDataAccessor);
+  return d->m_AvailableData;
+}
+
+//----------------------------------------------------------------------------
+void ctkDicomAvailableDataAccessor::update()
+{
+  Q_D(ctkDicomAvailableDataAccessor);
+  d->buildIndex();
+}
+
 //----------------------------------------------------------------------------
 ctkDicomAppHosting::Patient* ctkDicomAvailableDataAccessor::getPatient(const ctkDicomAppHosting::Patient& patient) const
 {
   const Q_D(ctkDicomAvailableDataAccessor);
-  ctkDicomAppHosting::AvailableData & ad(d->m_AvailableData);
-  for (QList<ctkDicomAppHosting::Patient>::Iterator pit = ad.patients.begin();
-    pit < ad.patients.end(); pit++)
-    {
-      if(pit->id==patient.id)
-        return &(*pit);
-    }
-  return NULL;
+  return d->findPatient(patient.id);
 }
 
 //----------------------------------------------------------------------------
 ctkDicomAppHosting::Study* ctkDicomAvailableDataAccessor::getStudy(const QString& studyUID) const
 {
   const Q_D(ctkDicomAvailableDataAccessor);
-  ctkDicomAppHosting::AvailableData & ad(d->m_AvailableData);
-  for (QList<ctkDicomAppHosting::Patient>::Iterator pit = ad.patients.begin();
-    pit < ad.patients.end(); pit++)
-    {
-    for (QList<ctkDicomAppHosting::Study>::Iterator sit = pit->studies.begin();
-      sit < pit->studies.end(); sit++)
-      {
-          if(sit->studyUID==studyUID)
-            return &(*sit);
-      }
-    }
-  return NULL;
+  return d->findStudy(studyUID);
 }
 
 //----------------------------------------------------------------------------
 ctkDicomAppHosting::Series* ctkDicomAvailableDataAccessor::getSeries(const QString& seriesUID) const
 {
   const Q_D(ctkDicomAvailableDataAccessor);
-  ctkDicomAppHosting::AvailableData & ad(d->m_AvailableData);
-  for (QList<ctkDicomAppHosting::Patient>::Iterator pit = ad.patients.begin();
-    pit < ad.patients.end(); pit++)
+  return d->findSeries(seriesUID);
+}
+
+//----------------------------------------------------------------------------
+ctkDicomAppHosting::ObjectDescriptor* ctkDicomAvailableDataAccessor::getObjectDescriptor(
+  const QString& descriptorUUID) const
+{
+  const Q_D(ctkDicomAvailableDataAccessor);
+  ctkDicomAvailableDataIndex::const_iterator it = d->DescriptorIndex.constFind(descriptorUUID);
+  if (it == d->DescriptorIndex.constEnd())
+    {
+    return NULL;
+    }
+  ctkDicomAppHosting::ObjectDescriptor* descriptor = d->descriptor(it.value());
+  if (!descriptor || descriptor->descriptorUUID != descriptorUUID)
     {
-    for (QList<ctkDicomAppHosting::Study>::Iterator sit = pit->studies.begin();
-      sit < pit->studies.end(); sit++)
+    d->buildIndex();
+    it = d->DescriptorIndex.constFind(descriptorUUID);
+    if (it == d->DescriptorIndex.constEnd())
       {
-      for (QList<ctkDicomAppHosting::Series>::Iterator seit = sit->series.begin();
-        seit < sit->series.end(); seit++)
-        {
-          if(seit->seriesUID==seriesUID)
-            return &(*seit);
-        }
+      return NULL;
       }
+    descriptor = d->descriptor(it.value());
     }
-  return NULL;
+  return descriptor;
 }
 
 //----------------------------------------------------------------------------
@@ -114,41 +450,84 @@ void ctkDicomAvailableDataAccessor::find(const ctkDicomAppHosting::Patient& pati
                                          ctkDicomAppHosting::Series*& seriesResult) const
 {
   const Q_D(ctkDicomAvailableDataAccessor);
-  ctkDicomAppHosting::AvailableData & ad(d->m_AvailableData);
-  patientResult=NULL;
-  studyResult=NULL;
-  seriesResult=NULL;
-  for (QList<ctkDicomAppHosting::Patient>::Iterator pit = ad.patients.begin();
-    pit < ad.patients.end(); pit++)
-    {
-    if(pit->id==patient.id)
+  ctkDicomAvailableDataLocation location;
+  d->find(patient.id, studyUID, seriesUID, location, patientResult, studyResult, seriesResult);
+}
+
+//----------------------------------------------------------------------------
+void ctkDicomAvailableDataAccessor::addObjectDescriptor(
+  const ctkDicomAppHosting::ObjectDescriptor& objectDescriptor)
+{
+  Q_D(ctkDicomAvailableDataAccessor);
+  d->m_AvailableData.objectDescriptors.append(objectDescriptor);
+  ctkDicomAvailableDataLocation location;
+  location.Descriptor = d->m_AvailableData.objectDescriptors.count() - 1;
+  if (!d->DescriptorIndex.contains(objectDescriptor.descriptorUUID))
+    {
+    d->DescriptorIndex.insert(objectDescriptor.descriptorUUID, location);
+    }
+}
+
+//----------------------------------------------------------------------------
+void ctkDicomAvailableDataAccessor::addObjectDescriptor(
+  const ctkDicomAppHosting::Patient& patient,
+  const ctkDicomAppHosting::Study& study,
+  const ctkDicomAppHosting::Series& series,
+  const ctkDicomAppHosting::ObjectDescriptor& objectDescriptor)
+{
+  Q_D(ctkDicomAvailableDataAccessor);
+  ctkDicomAppHosting::Patient* ppatient;
+  ctkDicomAppHosting::Study* pstudy;
+  ctkDicomAppHosting::Series* pseries;
+  ctkDicomAvailableDataLocation location;
+  d->find(patient.id, study.studyUID, series.seriesUID, location, ppatient, pstudy, pseries);
+
+  if (ppatient == NULL)
+    {
+    ctkDicomAppHosting::Patient newPatient = patient;
+    newPatient.objectDescriptors.clear();
+    newPatient.studies.clear();
+    d->m_AvailableData.patients.append(newPatient);
+    location.Patient = d->m_AvailableData.patients.count() - 1;
+    d->PatientIndex.insert(patient.id, location);
+    ppatient = &d->m_AvailableData.patients.last();
+    }
+  if (pstudy == NULL)
+    {
+    ctkDicomAppHosting::Study newStudy = study;
+    newStudy.objectDescriptors.clear();
+    newStudy.series.clear();
+    ppatient->studies.append(newStudy);
+    location.Study = ppatient->studies.count() - 1;
+    if (!d->StudyIndex.contains(study.studyUID))
       {
-      patientResult = &(*pit);
-      for (QList<ctkDicomAppHosting::Study>::Iterator sit = pit->studies.begin();
-        sit < pit->studies.end(); sit++)
-        {
-        if(sit->studyUID==studyUID)
-          {
-          studyResult = &(*sit);
-          for (QList<ctkDicomAppHosting::Series>::Iterator seit = sit->series.begin();
-            seit < sit->series.end(); seit++)
-            {
-            if(seit->seriesUID==seriesUID)
-              {
-              seriesResult=&(*seit);
-              return;
-              }
-            }
-            return;
-          }
-        }
-      return;
+      d->StudyIndex.insert(study.studyUID, location);
       }
+    pstudy = &ppatient->studies.last();
+    }
+  if (pseries == NULL)
+    {
+    ctkDicomAppHosting::Series newSeries = series;
+    newSeries.objectDescriptors.clear();
+    pstudy->series.append(newSeries);
+    location.Series = pstudy->series.count() - 1;
+    if (!d->SeriesIndex.contains(series.seriesUID))
+      {
+      d->SeriesIndex.insert(series.seriesUID, location);
+      }
+    pseries = &pstudy->series.last();
+    }
+
+  pseries->objectDescriptors.append(objectDescriptor);
+  location.Descriptor = pseries->objectDescriptors.count() - 1;
+  if (!d->DescriptorIndex.contains(objectDescriptor.descriptorUUID))
+    {
+    d->DescriptorIndex.insert(objectDescriptor.descriptorUUID, location);
     }
 }
 
 //----------------------------------------------------------------------------
-bool addNonDICOMToAvailableData(ctkDicomAppHosting::AvailableData& data, 
+bool addNonDICOMToAvailableData(ctkDicomAvailableDataAccessor& accessor,
                         ctkDicomObjectLocatorCache* objectLocatorCache, 
                         long length, 
                         long offset, 
@@ -189,7 +568,7 @@ bool addNonDICOMToAvailableData(ctkDicomAppHosting::AvailableData& data,
   //ctkDicomAppHosting::Study* pstudy;
   //ctkDicomAppHosting::Series* pseries;
 
-  data.objectDescriptors.append(objectDescriptor);
+  accessor.addObjectDescriptor(objectDescriptor);
 
   ctkDicomAppHosting::ObjectLocator locator;
   locator.locator = objectDescriptor.descriptorUUID;
@@ -210,6 +589,18 @@ bool addToAvailableData(ctkDicomAppHosting::AvailableData& data,
                         long length, 
                         long offset, 
                         const QString& uri)
+{
+  ctkDicomAvailableDataAccessor accessor(data);
+  return addToAvailableData(accessor, objectLocatorCache, dataset, length, offset, uri);
+}
+
+//----------------------------------------------------------------------------
+bool addToAvailableData(ctkDicomAvailableDataAccessor& accessor,
+                        ctkDicomObjectLocatorCache* objectLocatorCache,
+                        const ctkDICOMItem& dataset,
+                        long length,
+                        long offset,
+                        const QString& uri)
 {
   if(objectLocatorCache == NULL)
     return false;
@@ -238,38 +629,7 @@ bool addToAvailableData(ctkDicomAppHosting::AvailableData& data,
   
 
 
-  ctkDicomAppHosting::Patient* ppatient;
-  ctkDicomAppHosting::Study* pstudy;
-  ctkDicomAppHosting::Series* pseries;
-  
-  ctkDicomAvailableDataAccessor(data).find(patient, study.studyUID, series.seriesUID,
-    ppatient, pstudy, pseries);
-
-  if(pseries==NULL)
-  {
-    series.objectDescriptors.append(objectDescriptor);
-    if(pstudy==NULL)
-    {
-      study.series.append(series);
-      if(ppatient==NULL)
-      {
-        patient.studies.append(study);
-        data.patients.append(patient);
-      }
-      else
-      {
-        ppatient->studies.append(study);
-      }
-    }
-    else
-    {
-      pstudy->series.append(series);
-    }
-  }
-  else
-  {
-    pseries->objectDescriptors.append(objectDescriptor);
-  }
+  accessor.addObjectDescriptor(patient, study, series, objectDescriptor);
 
   ctkDicomAppHosting::ObjectLocator locator;
   locator.locator = objectDescriptor.descriptorUUID;
@@ -287,6 +647,15 @@ bool addToAvailableData(ctkDicomAppHosting::AvailableData& data,
 bool addToAvailableData(ctkDicomAppHosting::AvailableData& data,
                         ctkDicomObjectLocatorCache* objectLocatorCache, 
                         const QString& filename)
+{
+  ctkDicomAvailableDataAccessor accessor(data);
+  return addToAvailableData(accessor, objectLocatorCache, filename);
+}
+
+//----------------------------------------------------------------------------
+bool addToAvailableData(ctkDicomAvailableDataAccessor& accessor,
+                        ctkDicomObjectLocatorCache* objectLocatorCache,
+                        const QString& filename)
 {
   QFileInfo fileinfo(filename);
   qDebug() << filename << " " << fileinfo.exists();
@@ -302,13 +671,13 @@ bool addToAvailableData(ctkDicomAppHosting::AvailableData& data,
        (ext.compare("nrrd") ==0) )
   {
   	  qDebug() << "adding Non DICOM File";
-      return addNonDICOMToAvailableData(data, objectLocatorCache, fileinfo.size(), 0, uri);
+      return addNonDICOMToAvailableData(accessor, objectLocatorCache, fileinfo.size(), 0, uri);
   }
   //this could be a DICOM file then
   ctkDICOMItem ctkdataset;
   ctkdataset.InitializeFromFile(filename, EXS_Unknown, EGL_noChange, 400);
 
-  return addToAvailableData(data, objectLocatorCache, ctkdataset, fileinfo.size(), 0, uri);
+  return addToAvailableData(accessor, objectLocatorCache, ctkdataset, fileinfo.size(), 0, uri);
 
 }
 
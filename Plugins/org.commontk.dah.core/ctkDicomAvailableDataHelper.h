@@ -39,12 +39,29 @@ namespace ctkDicomAvailableDataHelper {
 
 //----------------------------------------------------------------------------
 class ctkDicomAvailableDataAccessorPrivate;
+
+/**
+ * \brief Indexed access to the patients, studies, series and object
+ * descriptors of an available data structure.
+ *
+ * The accessor indexes the available data by patient ID, study UID,
+ * series UID and descriptor UUID when constructed, so that lookups do not
+ * scan the nested lists. The index is kept up to date for the objects added
+ * with addObjectDescriptor(). If the available data is modified directly,
+ * update() must be called (an index entry which does not match the data
+ * anymore is detected and triggers an update as well).
+ */
 class org_commontk_dah_core_EXPORT ctkDicomAvailableDataAccessor : public QObject
 {
 public:
   ctkDicomAvailableDataAccessor(ctkDicomAppHosting::AvailableData& ad);
   virtual ~ctkDicomAvailableDataAccessor();
-  
+
+  ctkDicomAppHosting::AvailableData& availableData() const;
+
+  /// Rebuild the index from the available data.
+  void update();
+
   /**
    * Method used to retrieve information about a specific patient, giving a patient struct with the ID field already 
    * defined.
@@ -64,6 +81,25 @@ public:
    */
   ctkDicomAppHosting::Series* getSeries(const QString& seriesUID) const;
 
+  /**
+   * Method used to retrieve an object descriptor (at any level), giving its UUID.
+   * \return the object descriptor if present inside available data, otherwise return NULL.
+   */
+  ctkDicomAppHosting::ObjectDescriptor* getObjectDescriptor(const QString& descriptorUUID) const;
+
+  /**
+   * Append the object descriptor to the series \a series of the study \a study
+   * of the patient \a patient. The patient, study or series are added first if
+   * they are not present yet (without their child items).
+   */
+  void addObjectDescriptor(const ctkDicomAppHosting::Patient& patient,
+                           const ctkDicomAppHosting::Study& study,
+                           const ctkDicomAppHosting::Series& series,
+                           const ctkDicomAppHosting::ObjectDescriptor& objectDescriptor);
+
+  /// Append a top level object descriptor (not related to a patient).
+  void addObjectDescriptor(const ctkDicomAppHosting::ObjectDescriptor& objectDescriptor);
+
   void find(const ctkDicomAppHosting::Patient& patient, 
                                          const QString& studyUID, 
                                          const QString& seriesUID,
@@ -91,6 +127,23 @@ bool org_commontk_dah_core_EXPORT addToAvailableData(ctkDicomAppHosting::Availab
                         ctkDicomObjectLocatorCache* objectLocatorCache, 
                         const QString& filename);
 
+//----------------------------------------------------------------------------
+/**
+ * Same as above, for adding many files to the available data of
+ * \a accessor without indexing it again for each of them.
+ */
+bool org_commontk_dah_core_EXPORT addToAvailableData(ctkDicomAvailableDataAccessor& accessor,
+                        ctkDicomObjectLocatorCache* objectLocatorCache,
+                        const ctkDICOMItem& dataset,
+                        long length,
+                        long offset,
+                        const QString& uri);
+
+//----------------------------------------------------------------------------
+bool org_commontk_dah_core_EXPORT addToAvailableData(ctkDicomAvailableDataAccessor& accessor,
+                        ctkDicomObjectLocatorCache* objectLocatorCache,
+                        const QString& filename);
+
 //----------------------------------------------------------------------------
 bool org_commontk_dah_core_EXPORT addNonDICOMToAvailableData(ctkDicomAppHosting::AvailableData& data, 
                         ctkDicomObjectLocatorCache* objectLocatorCache, 
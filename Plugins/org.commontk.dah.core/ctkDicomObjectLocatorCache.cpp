@@ -87,7 +87,8 @@ bool ctkDicomObjectLocatorCache::isCached(const ctkDicomAppHosting::AvailableDat
 {
   Q_D(const ctkDicomObjectLocatorCache);
   bool hasCachedData = false;
-  QList<QString> uuids = d->ObjectLocatorMap.keys();
+  // Hash lookups: isCached is linear in the number of descriptors
+  const QHash<QString, ObjectLocatorCacheItem>& uuids = d->ObjectLocatorMap;
   // Loop over top level object descriptors
   foreach(const ctkDicomAppHosting::ObjectDescriptor& objectDescriptor, availableData.objectDescriptors)
     {
@@ -161,15 +162,14 @@ void ctkDicomObjectLocatorCache::insert(const QString& objectUuid,
                                         bool temporary)
 {
   Q_D(ctkDicomObjectLocatorCache);
-  ObjectLocatorCacheItem item;
-  d->find(objectUuid, item);
-  if(d->ObjectLocatorMap.contains(objectUuid))
+  QHash<QString, ObjectLocatorCacheItem>::iterator it = d->ObjectLocatorMap.find(objectUuid);
+  if (it != d->ObjectLocatorMap.end())
     {
-    Q_ASSERT(objectLocator == item.ObjectLocator); // ObjectLocator are expected to match
-    item.RefCount++;
-    d->ObjectLocatorMap.insert(objectUuid, item);
+    Q_ASSERT(objectLocator == it.value().ObjectLocator); // ObjectLocator are expected to match
+    it.value().RefCount++;
     return;
     }
+  ObjectLocatorCacheItem item;
   item.ObjectLocator = objectLocator;
   d->ObjectLocatorMap.insert(objectUuid, item);
 
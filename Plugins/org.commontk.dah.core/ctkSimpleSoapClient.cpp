@@ -25,16 +25,26 @@
 
 #include <QApplication>
 #include <QCursor>
+#include <QEventLoop>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QNetworkAccessManager>
 #include <QNetworkReply>
-#include <QtSoapHttpTransport>
+#include <QNetworkRequest>
+#include <QUrl>
 
 //----------------------------------------------------------------------------
 class ctkSimpleSoapClientPrivate
 {
 public:
 
-  QEventLoop BlockingLoop;
-  QtSoapHttpTransport Http;
+  /// Keeps the connections to the host alive between requests
+  QNetworkAccessManager Network;
+  QHash<QNetworkReply*, QFutureInterface<QtSoapMessage> > PendingRequests;
+
+  /// Response of the last blocking request
+  QtSoapMessage Response;
 
   int Port;
   QString Path;
@@ -49,56 +59,75 @@ ctkSimpleSoapClient::ctkSimpleSoapClient(int port, QString path)
   d->Port = port;
   d->Path = path;
 
-  connect(&d->Http, SIGNAL(responseReady()), this, SLOT(responseReady()));
-
-  d->Http.setHost("127.0.0.1", false, port);
+  connect(&d->Network, SIGNAL(finished(QNetworkReply*)), this, SLOT(responseReady(QNetworkReply*)));
 }
 
 //----------------------------------------------------------------------------
 ctkSimpleSoapClient::~ctkSimpleSoapClient()
 {
-
+  Q_D(ctkSimpleSoapClient);
+  // Do not leave any future pending forever
+  foreach (QNetworkReply* reply, d->PendingRequests.keys())
+    {
+    QFutureInterface<QtSoapMessage> futureInterface = d->PendingRequests.take(reply);
+    reply->disconnect();
+    reply->abort();
+    futureInterface.reportCanceled();
+    futureInterface.reportFinished();
+    }
 }
 
 //----------------------------------------------------------------------------
-void ctkSimpleSoapClient::responseReady()
+void ctkSimpleSoapClient::responseReady(QNetworkReply* reply)
 {
   Q_D(ctkSimpleSoapClient);
-  d->BlockingLoop.exit();
+  reply->deleteLater();
+  if (!d->PendingRequests.contains(reply))
+    {
+    return;
+    }
+  QFutureInterface<QtSoapMessage> futureInterface = d->PendingRequests.take(reply);
+
+  QtSoapMessage response;
+  // SOAP faults come with an HTTP error status, but a valid body
+  QByteArray body = reply->readAll();
+  if (body.isEmpty() || !response.setContent(body))
+    {
+    response.clear();
+    response.setFaultCode(QtSoapMessage::Client);
+    response.setFaultString(reply->error() != QNetworkReply::NoError ?
+                            reply->errorString() : QString("Invalid SOAP response"));
+    }
+
+  futureInterface.reportResult(response);
+  futureInterface.reportFinished();
 }
 
 //----------------------------------------------------------------------------
-const QtSoapType & ctkSimpleSoapClient::submitSoapRequest(const QString& methodName,
-                                                   QtSoapType* soapType )
+QFuture<QtSoapMessage> ctkSimpleSoapClient::submitSoapRequestAsync(const QString& methodName,
+                                                                 QtSoapType* soapType)
 {
   QList<QtSoapType*> list;
   if(soapType != NULL)
     {
     list.append(soapType);
     }
-    return submitSoapRequest(methodName,list);
+  return submitSoapRequestAsync(methodName,list);
 }
 
 //----------------------------------------------------------------------------
-const QtSoapType & ctkSimpleSoapClient::submitSoapRequest(const QString& methodName,
-                                                   const QList<QtSoapType*>& soapTypes )
+QFuture<QtSoapMessage> ctkSimpleSoapClient::submitSoapRequestAsync(const QString& methodName,
+                                                                 const QList<QtSoapType*>& soapTypes)
 {
   Q_D(ctkSimpleSoapClient);
 
-  /*QString action="\"";
-  //action.append(methodName);
-  action.append("\"");
-  d->Http.setAction(action);*/
   QString action = "http://dicom.nema.org/PS3.19/IHostService/" + methodName;
 
-  d->Http.setAction(action);
-
   CTK_SOAP_LOG( << "Submitting action " << action
                 << " method " << methodName
                 << " to path " << d->Path );
 
   QtSoapMessage request;
-  //request.setMethod(QtSoapQName(methodName,"http://wg23.dicom.nema.org/"));
   request.setMethod(QtSoapQName(methodName,"http://dicom.nema.org/PS3.19" + d->Path ));
   if(!soapTypes.isEmpty())
     {
@@ -113,19 +142,68 @@ const QtSoapType & ctkSimpleSoapClient::submitSoapRequest(const QString& methodN
   CTK_SOAP_LOG_LOWLEVEL( << "Submitting request " << methodName);
   CTK_SOAP_LOG_LOWLEVEL( << request.toXmlString());
 
-  d->Http.submitRequest(request, d->Path);;
+  QUrl url;
+  url.setScheme("http");
+  url.setHost("127.0.0.1");
+  url.setPort(d->Port);
+  url.setPath(d->Path);
+
+  QNetworkRequest networkRequest(url);
+  networkRequest.setHeader(QNetworkRequest::ContentTypeHeader, QLatin1String("text/xml;charset=utf-8"));
+  networkRequest.setRawHeader("SOAPAction", action.toLatin1());
+  networkRequest.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+
+  QFutureInterface<QtSoapMessage> futureInterface;
+  futureInterface.reportStarted();
+  QNetworkReply* reply = d->Network.post(networkRequest, request.toXmlString().toUtf8());
+  d->PendingRequests.insert(reply, futureInterface);
 
   CTK_SOAP_LOG_LOWLEVEL( << "Submitted request " << methodName);
 
-  QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+  return futureInterface.future();
+}
+
+//----------------------------------------------------------------------------
+const QtSoapType & ctkSimpleSoapClient::submitSoapRequest(const QString& methodName,
+                                                   QtSoapType* soapType )
+{
+  QList<QtSoapType*> list;
+  if(soapType != NULL)
+    {
+    list.append(soapType);
+    }
+    return submitSoapRequest(methodName,list);
+}
 
-  d->BlockingLoop.exec(QEventLoop::ExcludeUserInputEvents | QEventLoop::WaitForMoreEvents);
+//----------------------------------------------------------------------------
+const QtSoapType & ctkSimpleSoapClient::submitSoapRequest(const QString& methodName,
+                                                   const QList<QtSoapType*>& soapTypes )
+{
+  Q_D(ctkSimpleSoapClient);
 
-  QApplication::restoreOverrideCursor();
+  QFuture<QtSoapMessage> future = submitSoapRequestAsync(methodName, soapTypes);
+  if (!future.isFinished())
+    {
+    // A local event loop, so that blocking requests can be nested
+    QEventLoop blockingLoop;
+    QFutureWatcher<QtSoapMessage> watcher;
+    connect(&watcher, SIGNAL(finished()), &blockingLoop, SLOT(quit()));
+    watcher.setFuture(future);
+
+    bool hasGui = qobject_cast<QApplication*>(QCoreApplication::instance()) != 0;
+    if (hasGui)
+      {
+      QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+      }
+    blockingLoop.exec(QEventLoop::ExcludeUserInputEvents | QEventLoop::WaitForMoreEvents);
+    if (hasGui)
+      {
+      QApplication::restoreOverrideCursor();
+      }
+    }
 
-  //qDebug() << "Reply error: " << reply->errorString();
-  //qDebug() << reply->readAll();
-  const QtSoapMessage& response = d->Http.getResponse();
+  d->Response = future.isCanceled() ? QtSoapMessage() : future.result();
+  const QtSoapMessage& response = d->Response;
 
   CTK_SOAP_LOG( << "Got Response." );
 
@@ -22,15 +22,29 @@
 #ifndef CTKSIMPLESOAPCLIENT_H
 #define CTKSIMPLESOAPCLIENT_H
 
+#include <QFuture>
 #include <QObject>
 #include <QScopedPointer>
 
-#include <QtSoapType>
+#include <qtsoap.h>
 
 #include <org_commontk_dah_core_Export.h>
 
+class QNetworkReply;
 class ctkSimpleSoapClientPrivate;
 
+/**
+ * SOAP client of a DICOM App Hosting (host or hosted application) service.
+ *
+ * The requests are sent over persistent (keep-alive) HTTP/1.1 connections
+ * to 127.0.0.1, with pipelining allowed. submitSoapRequestAsync() returns a
+ * future of the response message, which is a fault message if the request
+ * failed. The client must be used from the thread it lives in, and the
+ * futures are only completed while this thread runs its event loop.
+ *
+ * submitSoapRequest() is the blocking version: it runs a local event loop
+ * (excluding user input events) until the response arrives.
+ */
 class org_commontk_dah_core_EXPORT ctkSimpleSoapClient : public QObject
 {
   Q_OBJECT
@@ -39,12 +53,17 @@ public:
   ctkSimpleSoapClient(int port, QString path);
   virtual ~ctkSimpleSoapClient();
 
+  /// The ownership of the soap types is transferred to the request.
+  QFuture<QtSoapMessage> submitSoapRequestAsync(const QString& methodName, const QList<QtSoapType*>& soapTypes);
+  QFuture<QtSoapMessage> submitSoapRequestAsync(const QString& methodName, QtSoapType* soapType);
+
+  /// The returned value is valid until the next blocking request.
   const QtSoapType & submitSoapRequest(const QString& methodName, const QList<QtSoapType*>& soapTypes);
   const QtSoapType & submitSoapRequest(const QString& methodName, QtSoapType* soapType);
 
 private Q_SLOTS:
 
-  void responseReady();
+  void responseReady(QNetworkReply* reply);
 
 private:
 
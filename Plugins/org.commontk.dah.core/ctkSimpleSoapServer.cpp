@@ -22,7 +22,7 @@
 
 #include "ctkSimpleSoapServer.h"
 
-#include "ctkSoapConnectionRunnable_p.h"
+#include "ctkSoapConnection_p.h"
 
 //----------------------------------------------------------------------------
 ctkSimpleSoapServer::ctkSimpleSoapServer(QObject *parent) :
@@ -39,15 +39,18 @@ void ctkSimpleSoapServer::incomingConnection(qintptr socketDescriptor)
 #endif
 {
   qDebug() << "New incoming connection";
-  ctkSoapConnectionRunnable* runnable = new ctkSoapConnectionRunnable(socketDescriptor);
-
-  connect(runnable, SIGNAL(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)),
-          this, SIGNAL(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)),
-          Qt::BlockingQueuedConnection);
-
-  connect(runnable, SIGNAL(incomingWSDLMessage(QString,QString*)),
-          this, SIGNAL(incomingWSDLMessage(QString,QString*)),
-          Qt::BlockingQueuedConnection);
-
-  QThreadPool::globalInstance()->start(runnable);
+  // The connection is served from the event loop of this thread: the
+  // messages are dispatched without any thread handoff.
+  ctkSoapConnection* connection = new ctkSoapConnection(socketDescriptor, this);
+  if (!connection->isValid())
+    {
+    delete connection;
+    return;
+    }
+
+  connect(connection, SIGNAL(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)),
+          this, SIGNAL(incomingSoapMessage(QtSoapMessage,QtSoapMessage*)));
+
+  connect(connection, SIGNAL(incomingWSDLMessage(QString,QString*)),
+          this, SIGNAL(incomingWSDLMessage(QString,QString*)));
 }
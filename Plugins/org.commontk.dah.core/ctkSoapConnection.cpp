@@ -0,0 +1,239 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+// Qt includes
+#include <QStringList>
+
+// CTK includes
+#include "ctkSoapConnection_p.h"
+#include "ctkSoapLog.h"
+
+namespace
+{
+/// Requests with larger headers are rejected
+const int MaximumHeaderSize = 64 * 1024;
+}
+
+//----------------------------------------------------------------------------
+ctkSoapConnection::ctkSoapConnection(int socketDescriptor, QObject* parent)
+  : QObject(parent), state(ReadingHeaders), contentLength(0), keepAlive(true),
+    processing(false), closed(false)
+{
+  if (!socket.setSocketDescriptor(socketDescriptor))
+    {
+    qCritical() << "ctkSoapConnection: invalid socket descriptor" << socket.errorString();
+    closed = true;
+    return;
+    }
+  connect(&socket, SIGNAL(readyRead()), this, SLOT(readClient()));
+  connect(&socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+}
+
+//----------------------------------------------------------------------------
+ctkSoapConnection::~ctkSoapConnection()
+{
+
+}
+
+//----------------------------------------------------------------------------
+bool ctkSoapConnection::isValid() const
+{
+  return !closed;
+}
+
+//----------------------------------------------------------------------------
+void ctkSoapConnection::readClient()
+{
+  buffer.append(socket.readAll());
+  processBuffer();
+}
+
+//----------------------------------------------------------------------------
+void ctkSoapConnection::disconnected()
+{
+  closed = true;
+  // Deleting the connection while a handler runs would pull the rug
+  // from under processBuffer()
+  if (!processing)
+    {
+    deleteLater();
+    }
+}
+
+//----------------------------------------------------------------------------
+void ctkSoapConnection::processBuffer()
+{
+  if (processing)
+    {
+    return;
+    }
+  processing = true;
+  while (!closed)
+    {
+    if (state == ReadingHeaders)
+      {
+      if (!parseHeaders())
+        {
+        break;
+        }
+      state = ReadingBody;
+      }
+    if (buffer.size() < contentLength)
+      {
+      break;
+      }
+    QByteArray body = buffer.left(contentLength);
+    buffer.remove(0, contentLength);
+    state = ReadingHeaders;
+
+    processRequest(body);
+
+    if (!keepAlive)
+      {
+      socket.disconnectFromHost();
+      break;
+      }
+    }
+  processing = false;
+  if (closed)
+    {
+    deleteLater();
+    }
+}
+
+//----------------------------------------------------------------------------
+bool ctkSoapConnection::parseHeaders()
+{
+  // Tolerate bare LF line endings
+  int headerEnd = buffer.indexOf("\r\n\r\n");
+  int separatorSize = 4;
+  int lfHeaderEnd = buffer.indexOf("\n\n");
+  if (lfHeaderEnd >= 0 && (headerEnd < 0 || lfHeaderEnd < headerEnd))
+    {
+    headerEnd = lfHeaderEnd;
+    separatorSize = 2;
+    }
+  if (headerEnd < 0)
+    {
+    if (buffer.size() > MaximumHeaderSize)
+      {
+      qCritical() << "ctkSoapConnection: request headers too large";
+      writeResponse("413 Request Entity Too Large", QByteArray());
+      buffer.clear();
+      closed = true;
+      socket.disconnectFromHost();
+      }
+    return false;
+    }
+
+  QStringList lines = QString::fromLatin1(buffer.left(headerEnd)).split('\n');
+  buffer.remove(0, headerEnd + separatorSize);
+
+  requestLine = lines.takeFirst().trimmed();
+  CTK_SOAP_LOG_LOWLEVEL( << requestLine );
+  contentLength = 0;
+  // Connections are persistent by default in HTTP/1.1 only
+  keepAlive = requestLine.endsWith("HTTP/1.1");
+  foreach (const QString& line, lines)
+    {
+    QString name = line.section(':', 0, 0).trimmed().toLower();
+    QString value = line.section(':', 1).trimmed();
+    if (name == "content-length")
+      {
+      contentLength = qMax(0, value.toInt());
+      }
+    else if (name == "connection")
+      {
+      keepAlive = value.compare("keep-alive", Qt::CaseInsensitive) == 0 ||
+                  (keepAlive && value.compare("close", Qt::CaseInsensitive) != 0);
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void ctkSoapConnection::processRequest(const QByteArray& body)
+{
+  QString requestPath = requestLine.section(' ', 1, 1);
+  QString content;
+  if (requestPath.endsWith("?wsdl") || requestPath.endsWith("?xsd=1"))
+    {
+    QString requestType = requestPath.mid(requestPath.lastIndexOf('?'));
+    emit incomingWSDLMessage(requestType, &content);
+    writeResponse("200 OK", content.toUtf8());
+    return;
+    }
+
+  if (body.trimmed().isEmpty())
+    {
+    writeResponse("200 OK", QByteArray());
+    return;
+    }
+
+  CTK_SOAP_LOG_LOWLEVEL( << body );
+  QtSoapMessage msg;
+  if (!msg.setContent(body))
+    {
+    qCritical() << "QtSoap import failed:" << msg.errorString();
+    QtSoapMessage fault;
+    fault.setFaultCode(QtSoapMessage::Client);
+    fault.setFaultString(msg.errorString());
+    writeResponse("500 Internal Server Error", fault.toXmlString().toUtf8());
+    return;
+    }
+
+  QtSoapMessage reply;
+  CTK_SOAP_LOG(<< "###################" << msg.toXmlString());
+  emit incomingSoapMessage(msg, &reply);
+  if (closed)
+    {
+    return;
+    }
+
+  if (reply.isFault())
+    {
+    qCritical() << "QtSoap reply faulty";
+    writeResponse("500 Internal Server Error", reply.toXmlString().toUtf8());
+    return;
+    }
+
+  CTK_SOAP_LOG_LOWLEVEL( << "SOAP reply:" );
+  writeResponse("200 OK", reply.toXmlString().toUtf8());
+}
+
+//----------------------------------------------------------------------------
+void ctkSoapConnection::writeResponse(const QByteArray& status, const QByteArray& content)
+{
+  QByteArray block;
+  block.append("HTTP/1.1 ").append(status).append("\r\n");
+  block.append("Content-Type: text/xml;charset=utf-8\r\n");
+  block.append("Content-Length: ").append(QByteArray::number(content.size())).append("\r\n");
+  if (!keepAlive)
+    {
+    block.append("Connection: close\r\n");
+    }
+  block.append("\r\n");
+  block.append(content);
+
+  CTK_SOAP_LOG_LOWLEVEL( << block );
+
+  socket.write(block);
+}
@@ -0,0 +1,88 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKSOAPCONNECTION_P_H
+#define CTKSOAPCONNECTION_P_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QTcpSocket>
+
+#include <qtsoap.h>
+
+/**
+ * Server side of a SOAP connection.
+ *
+ * The HTTP requests are parsed incrementally as bytes arrive (readyRead), in
+ * the thread of the server: no thread is blocked per connection. The
+ * connection is kept alive between requests (HTTP/1.1), and pipelined
+ * requests are answered in order, one at a time.
+ */
+class ctkSoapConnection : public QObject
+{
+  Q_OBJECT
+
+public:
+
+  ctkSoapConnection(int socketDescriptor, QObject* parent = 0);
+  virtual ~ctkSoapConnection();
+
+  bool isValid() const;
+
+Q_SIGNALS:
+
+  void incomingSoapMessage(const QtSoapMessage& message, QtSoapMessage* reply);
+  void incomingWSDLMessage(const QString& message, QString* reply);
+
+protected Q_SLOTS:
+
+  void readClient();
+  void disconnected();
+
+private:
+
+  /// Parse (and answer) the complete requests of the buffer
+  void processBuffer();
+  bool parseHeaders();
+  void processRequest(const QByteArray& body);
+  void writeResponse(const QByteArray& status, const QByteArray& content);
+
+  QTcpSocket socket;
+  QByteArray buffer;
+
+  enum State
+  {
+    ReadingHeaders,
+    ReadingBody
+  };
+  State state;
+  QString requestLine;
+  int contentLength;
+  bool keepAlive;
+
+  /// Set while a request is being answered: the handlers may run a nested
+  /// event loop, during which new bytes are only buffered.
+  bool processing;
+  bool closed;
+};
+
+#endif // CTKSOAPCONNECTION_P_H
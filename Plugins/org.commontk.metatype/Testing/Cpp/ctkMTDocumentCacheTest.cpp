@@ -0,0 +1,244 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkMTDocumentCache_p.h"
+#include "ctkAttributeDefinitionImpl_p.h"
+
+#include <ctkPluginConstants.h>
+#include <ctkPluginFramework.h>
+#include <ctkPluginFrameworkFactory.h>
+
+#include "ctkTest.h"
+
+#include <QCoreApplication>
+#include <QDir>
+
+//-----------------------------------------------------------------------------
+class ctkMTDocumentCacheTester : public QObject
+{
+  Q_OBJECT
+
+private Q_SLOTS:
+
+  void initTestCase();
+  void cleanupTestCase();
+
+  void init();
+  void cleanup();
+
+  void testHit();
+  void testEmptyDocument();
+  void testMissAfterDocumentChange();
+  void testMissAfterRemove();
+  void testCorruptFile();
+
+private:
+
+  QHash<QString, ctkObjectClassDefinitionImplPtr> createDefinitions() const;
+  static bool removeDirectory(const QString& path);
+
+  QString storageDirectory;
+  QString cacheDirectory;
+  QScopedPointer<ctkPluginFrameworkFactory> fwFactory;
+  QSharedPointer<ctkPlugin> plugin;
+
+  QByteArray document;
+};
+
+//-----------------------------------------------------------------------------
+void ctkMTDocumentCacheTester::initTestCase()
+{
+  storageDirectory = QDir::temp().absoluteFilePath(
+        QString("ctkMTDocumentCacheTest-%1").arg(QCoreApplication::applicationPid()));
+
+  ctkProperties fwProps;
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE, storageDirectory + "/fwstorage");
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN, ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT);
+  fwFactory.reset(new ctkPluginFrameworkFactory(fwProps));
+  QSharedPointer<ctkPluginFramework> framework = fwFactory->getFramework();
+  framework->init();
+  plugin = framework;
+
+  document = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+             "<metatype:MetaData xmlns:metatype=\"http://www.osgi.org/xmlns/metatype/v1.2.0\">\n"
+             "  <OCD id=\"org.commontk.metatype.test.ocd\" name=\"Test OCD\"/>\n"
+             "</metatype:MetaData>\n";
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTDocumentCacheTester::cleanupTestCase()
+{
+  plugin.clear();
+  fwFactory.reset();
+  removeDirectory(storageDirectory);
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTDocumentCacheTester::init()
+{
+  cacheDirectory = storageDirectory + "/documents";
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTDocumentCacheTester::cleanup()
+{
+  removeDirectory(cacheDirectory);
+}
+
+//-----------------------------------------------------------------------------
+QHash<QString, ctkObjectClassDefinitionImplPtr> ctkMTDocumentCacheTester::createDefinitions() const
+{
+  ctkObjectClassDefinitionImplPtr ocd(
+        new ctkObjectClassDefinitionImpl("Test OCD", "A test OCD", "org.commontk.metatype.test.ocd",
+                                         QString(), QString()));
+  ctkAttributeDefinitionImplPtr ad(
+        new ctkAttributeDefinitionImpl("testAttribute", "Test attribute", "A test attribute",
+                                       QVariant::String, 0, QVariant(), QVariant(), true,
+                                       QString(), QString(), NULL));
+  ad->setDefaultValue(QStringList() << "default", false);
+  ocd->addAttributeDefinition(ad, true);
+
+  QHash<QString, ctkObjectClassDefinitionImplPtr> pidToOCD;
+  pidToOCD.insert("org.commontk.metatype.test.pid", ocd);
+  return pidToOCD;
+}
+
+//-----------------------------------------------------------------------------
+bool ctkMTDocumentCacheTester::removeDirectory(const QString& path)
+{
+  QDir dir(path);
+  if (!dir.exists()) return true;
+  foreach(const QFileInfo& info, dir.entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot))
+  {
+    if (info.isDir())
+    {
+      removeDirectory(info.absoluteFilePath());
+    }
+    else
+    {
+      QFile::remove(info.absoluteFilePath());
+    }
+  }
+  return dir.rmdir(path);
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTDocumentCacheTester::testHit()
+{
+  ctkMTDocumentCache cache(cacheDirectory, NULL);
+  QVERIFY(QDir(cacheDirectory).exists());
+
+  QHash<QString, ctkObjectClassDefinitionImplPtr> pidToOCD;
+  QVERIFY(!cache.load(plugin, document, pidToOCD));
+  QVERIFY(pidToOCD.isEmpty());
+
+  cache.store(plugin, document, createDefinitions());
+  QVERIFY(cache.load(plugin, document, pidToOCD));
+
+  // a cache on the same directory, e.g. after a restart, hits as well
+  ctkMTDocumentCache restartedCache(cacheDirectory, NULL);
+  QHash<QString, ctkObjectClassDefinitionImplPtr> restartedPidToOCD;
+  QVERIFY(restartedCache.load(plugin, document, restartedPidToOCD));
+  QCOMPARE(restartedPidToOCD.keys(), pidToOCD.keys());
+
+  QCOMPARE(pidToOCD.size(), 1);
+  ctkObjectClassDefinitionImplPtr ocd = pidToOCD.value("org.commontk.metatype.test.pid");
+  QVERIFY(ocd);
+  QCOMPARE(ocd->getID(), QString("org.commontk.metatype.test.ocd"));
+  QCOMPARE(ocd->getName(), QString("Test OCD"));
+  QCOMPARE(ocd->getDescription(), QString("A test OCD"));
+
+  QList<ctkAttributeDefinitionPtr> required = ocd->getAttributeDefinitions(ctkObjectClassDefinition::REQUIRED);
+  QCOMPARE(required.size(), 1);
+  QCOMPARE(required.front()->getID(), QString("testAttribute"));
+  QCOMPARE(required.front()->getName(), QString("Test attribute"));
+  QCOMPARE(required.front()->getType(), static_cast<int>(QVariant::String));
+  QCOMPARE(required.front()->getDefaultValue(), QStringList() << "default");
+  QVERIFY(ocd->getAttributeDefinitions(ctkObjectClassDefinition::OPTIONAL).isEmpty());
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTDocumentCacheTester::testEmptyDocument()
+{
+  // documents without definitions are cached too
+  ctkMTDocumentCache cache(cacheDirectory, NULL);
+  QHash<QString, ctkObjectClassDefinitionImplPtr> pidToOCD = createDefinitions();
+  cache.store(plugin, document, QHash<QString, ctkObjectClassDefinitionImplPtr>());
+  QVERIFY(cache.load(plugin, document, pidToOCD));
+  QVERIFY(pidToOCD.isEmpty());
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTDocumentCacheTester::testMissAfterDocumentChange()
+{
+  ctkMTDocumentCache cache(cacheDirectory, NULL);
+  cache.store(plugin, document, createDefinitions());
+
+  // the document of an updated plugin differs from the cached one
+  QByteArray changedDocument = document;
+  changedDocument.replace("Test OCD", "Changed OCD");
+
+  QHash<QString, ctkObjectClassDefinitionImplPtr> pidToOCD;
+  QVERIFY(!cache.load(plugin, changedDocument, pidToOCD));
+  QVERIFY(pidToOCD.isEmpty());
+  QVERIFY(cache.load(plugin, document, pidToOCD));
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTDocumentCacheTester::testMissAfterRemove()
+{
+  // the entries of a plugin are removed when it is updated or uninstalled
+  ctkMTDocumentCache cache(cacheDirectory, NULL);
+  cache.store(plugin, document, createDefinitions());
+
+  cache.remove(plugin->getPluginId() + 1);
+  QHash<QString, ctkObjectClassDefinitionImplPtr> pidToOCD;
+  QVERIFY(cache.load(plugin, document, pidToOCD));
+
+  cache.remove(plugin->getPluginId());
+  pidToOCD.clear();
+  QVERIFY(!cache.load(plugin, document, pidToOCD));
+  QVERIFY(pidToOCD.isEmpty());
+  QVERIFY(QDir(cacheDirectory).entryList(QDir::Files).isEmpty());
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTDocumentCacheTester::testCorruptFile()
+{
+  ctkMTDocumentCache cache(cacheDirectory, NULL);
+  cache.store(plugin, document, createDefinitions());
+
+  QStringList files = QDir(cacheDirectory).entryList(QDir::Files);
+  QCOMPARE(files.size(), 1);
+  QFile file(QDir(cacheDirectory).absoluteFilePath(files.front()));
+  QVERIFY(file.open(QIODevice::ReadWrite));
+  file.resize(file.size() / 2);
+  file.close();
+
+  QHash<QString, ctkObjectClassDefinitionImplPtr> pidToOCD;
+  QVERIFY(!cache.load(plugin, document, pidToOCD));
+  QVERIFY(pidToOCD.isEmpty());
+}
+
+// ----------------------------------------------------------------------------
+CTK_TEST_MAIN(ctkMTDocumentCacheTest)
+#include "moc_ctkMTDocumentCacheTest.cpp"
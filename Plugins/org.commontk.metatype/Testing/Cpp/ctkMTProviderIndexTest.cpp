@@ -0,0 +1,251 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#include "ctkMTProviderIndex_p.h"
+
+#include <ctkPluginConstants.h>
+#include <ctkPluginContext.h>
+#include <ctkPluginFramework.h>
+#include <ctkPluginFrameworkFactory.h>
+#include <ctkServiceRegistration.h>
+#include <service/cm/ctkManagedService.h>
+
+#include "ctkTest.h"
+
+#include <QCoreApplication>
+#include <QDir>
+
+//-----------------------------------------------------------------------------
+class ctkMTTestProvider : public QObject, public ctkMetaTypeProvider
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkMetaTypeProvider)
+
+public:
+
+  ctkObjectClassDefinitionPtr getObjectClassDefinition(const QString& /*id*/, const QLocale& /*locale*/)
+  {
+    return ctkObjectClassDefinitionPtr();
+  }
+
+  QList<QLocale> getLocales() const
+  {
+    return QList<QLocale>();
+  }
+};
+
+//-----------------------------------------------------------------------------
+class ctkMTTestManagedService : public ctkMTTestProvider, public ctkManagedService
+{
+  Q_OBJECT
+  Q_INTERFACES(ctkManagedService)
+
+public:
+
+  void updated(const ctkDictionary& /*properties*/) {}
+};
+
+//-----------------------------------------------------------------------------
+class ctkMTProviderIndexTester : public QObject
+{
+  Q_OBJECT
+
+private Q_SLOTS:
+
+  void initTestCase();
+  void cleanupTestCase();
+
+  void init();
+  void cleanup();
+
+  void testAddRemove();
+  void testRanking();
+  void testModified();
+  void testManagedService();
+
+private:
+
+  static QString filter();
+
+  QString storageDirectory;
+  QScopedPointer<ctkPluginFrameworkFactory> fwFactory;
+  ctkPluginContext* context;
+  long pluginId;
+  ctkMTProviderIndex* index;
+};
+
+//-----------------------------------------------------------------------------
+QString ctkMTProviderIndexTester::filter()
+{
+  // the filter of the metatype plugin activator
+  return QString("(|(&(") + ctkPluginConstants::OBJECTCLASS
+      + "=" + qobject_interface_iid<ctkManagedService*>() + "*)("
+      + ctkPluginConstants::SERVICE_PID + "=*))(&("
+      + ctkPluginConstants::OBJECTCLASS + '='
+      + qobject_interface_iid<ctkMetaTypeProvider*>() + ")(|("
+      + ctkMetaTypeProvider::METATYPE_PID + "=*)("
+      + ctkMetaTypeProvider::METATYPE_FACTORY_PID + "=*))))";
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTProviderIndexTester::initTestCase()
+{
+  storageDirectory = QDir::temp().absoluteFilePath(
+        QString("ctkMTProviderIndexTest-%1").arg(QCoreApplication::applicationPid()));
+
+  ctkProperties fwProps;
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE, storageDirectory);
+  fwProps.insert(ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN, ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT);
+  fwFactory.reset(new ctkPluginFrameworkFactory(fwProps));
+  QSharedPointer<ctkPluginFramework> framework = fwFactory->getFramework();
+  framework->start();
+  context = framework->getPluginContext();
+  pluginId = framework->getPluginId();
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTProviderIndexTester::cleanupTestCase()
+{
+  QSharedPointer<ctkPluginFramework> framework = fwFactory->getFramework();
+  framework->stop();
+  framework->waitForStop(5000);
+  fwFactory.reset();
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTProviderIndexTester::init()
+{
+  index = new ctkMTProviderIndex(context, ctkLDAPSearchFilter(filter()), NULL);
+  index->open();
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTProviderIndexTester::cleanup()
+{
+  index->close();
+  delete index;
+  index = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTProviderIndexTester::testAddRemove()
+{
+  QVERIFY(index->getPids(pluginId, false).isEmpty());
+  QVERIFY(index->getPids(pluginId, true).isEmpty());
+
+  ctkMTTestProvider provider;
+  ctkDictionary props;
+  props.insert(ctkMetaTypeProvider::METATYPE_PID, QStringList() << "pid1" << "pid2");
+  props.insert(ctkMetaTypeProvider::METATYPE_FACTORY_PID, "factoryPid");
+  ctkServiceRegistration registration = context->registerService<ctkMetaTypeProvider>(&provider, props);
+
+  // added
+  QStringList pids = index->getPids(pluginId, false);
+  pids.sort();
+  QCOMPARE(pids, QStringList() << "pid1" << "pid2");
+  QCOMPARE(index->getPids(pluginId, true), QStringList() << "factoryPid");
+  QVERIFY(index->getProvider(pluginId, "pid1") == &provider);
+  QVERIFY(index->getProvider(pluginId, "pid2") == &provider);
+  QVERIFY(index->getProvider(pluginId, "factoryPid") == &provider);
+  QVERIFY(index->getProvider(pluginId, "unknownPid") == NULL);
+  QVERIFY(index->getProvider(pluginId + 1, "pid1") == NULL);
+  QCOMPARE(index->getProviders(pluginId).size(), 1);
+
+  // removed
+  registration.unregister();
+  QVERIFY(index->getPids(pluginId, false).isEmpty());
+  QVERIFY(index->getPids(pluginId, true).isEmpty());
+  QVERIFY(index->getProvider(pluginId, "pid1") == NULL);
+  QVERIFY(index->getProvider(pluginId, "factoryPid") == NULL);
+  QVERIFY(index->getProviders(pluginId).isEmpty());
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTProviderIndexTester::testRanking()
+{
+  ctkMTTestProvider lowProvider;
+  ctkDictionary props;
+  props.insert(ctkMetaTypeProvider::METATYPE_PID, "sharedPid");
+  ctkServiceRegistration lowRegistration = context->registerService<ctkMetaTypeProvider>(&lowProvider, props);
+
+  ctkMTTestProvider highProvider;
+  props.insert(ctkMetaTypeProvider::METATYPE_PID, QStringList() << "sharedPid" << "highPid");
+  props.insert(ctkPluginConstants::SERVICE_RANKING, 10);
+  ctkServiceRegistration highRegistration = context->registerService<ctkMetaTypeProvider>(&highProvider, props);
+
+  // the highest ranked provider of a PID wins
+  QVERIFY(index->getProvider(pluginId, "sharedPid") == &highProvider);
+  QVERIFY(index->getProvider(pluginId, "highPid") == &highProvider);
+  QCOMPARE(index->getProviders(pluginId).size(), 2);
+
+  // the other provider takes over after the removal
+  highRegistration.unregister();
+  QVERIFY(index->getProvider(pluginId, "sharedPid") == &lowProvider);
+  QVERIFY(index->getProvider(pluginId, "highPid") == NULL);
+  QCOMPARE(index->getPids(pluginId, false), QStringList() << "sharedPid");
+
+  lowRegistration.unregister();
+  QVERIFY(index->getProvider(pluginId, "sharedPid") == NULL);
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTProviderIndexTester::testModified()
+{
+  ctkMTTestProvider provider;
+  ctkDictionary props;
+  props.insert(ctkMetaTypeProvider::METATYPE_PID, "oldPid");
+  ctkServiceRegistration registration = context->registerService<ctkMetaTypeProvider>(&provider, props);
+  QVERIFY(index->getProvider(pluginId, "oldPid") == &provider);
+
+  props.insert(ctkMetaTypeProvider::METATYPE_PID, "newPid");
+  registration.setProperties(props);
+  QVERIFY(index->getProvider(pluginId, "oldPid") == NULL);
+  QVERIFY(index->getProvider(pluginId, "newPid") == &provider);
+
+  registration.unregister();
+  QVERIFY(index->getProvider(pluginId, "newPid") == NULL);
+}
+
+//-----------------------------------------------------------------------------
+void ctkMTProviderIndexTester::testManagedService()
+{
+  // the service PID of a managed service which is a provider is indexed
+  ctkMTTestManagedService service;
+  ctkDictionary props;
+  props.insert(ctkPluginConstants::SERVICE_PID, "managedPid");
+  ctkServiceRegistration registration = context->registerService(
+        QStringList() << qobject_interface_iid<ctkManagedService*>()
+                      << qobject_interface_iid<ctkMetaTypeProvider*>(),
+        &service, props);
+
+  QCOMPARE(index->getPids(pluginId, false), QStringList() << "managedPid");
+  QVERIFY(index->getPids(pluginId, true).isEmpty());
+  QVERIFY(index->getProvider(pluginId, "managedPid") == &service);
+
+  registration.unregister();
+  QVERIFY(index->getPids(pluginId, false).isEmpty());
+  QVERIFY(index->getProvider(pluginId, "managedPid") == NULL);
+}
+
+// ----------------------------------------------------------------------------
+CTK_TEST_MAIN(ctkMTProviderIndexTest)
+#include "moc_ctkMTProviderIndexTest.cpp"
@@ -26,6 +26,7 @@
 
 #include <service/log/ctkLogService.h>
 #include <QCoreApplication>
+#include <QDataStream>
 
 const QChar ctkAttributeDefinitionImpl::SEPARATE = ',';
 const QChar ctkAttributeDefinitionImpl::CONTROL = '\\';
@@ -369,3 +370,30 @@ QStringList ctkAttributeDefinitionImpl::tokenizeValues(const QString& values) co
   }
   return result;
 }
+
+void ctkAttributeDefinitionImpl::write(QDataStream& out) const
+{
+  out << _id << _name << _description << qint32(_dataType) << qint32(_cardinality)
+      << _minValue << _maxValue << _isRequired
+      << _locElem.getLocalizationBase() << _locElem.getContext()
+      << _defaults << _values << _labels;
+}
+
+QSharedPointer<ctkAttributeDefinitionImpl> ctkAttributeDefinitionImpl::read(QDataStream& in, ctkLogService* logger)
+{
+  QString id, name, description, localization, context;
+  qint32 dataType = 0;
+  qint32 cardinality = 0;
+  QVariant minValue, maxValue;
+  bool isRequired = false;
+  in >> id >> name >> description >> dataType >> cardinality
+     >> minValue >> maxValue >> isRequired >> localization >> context;
+
+  QSharedPointer<ctkAttributeDefinitionImpl> ad(
+        new ctkAttributeDefinitionImpl(id, name, description, dataType, cardinality,
+                                       minValue, maxValue, isRequired, localization,
+                                       context, logger));
+  // The values have been validated before they were written
+  in >> ad->_defaults >> ad->_values >> ad->_labels;
+  return ad;
+}
@@ -31,6 +31,7 @@
 #include <QVariant>
 
 struct ctkLogService;
+class QDataStream;
 
 /**
  * Implementation of ctkAttributeDefintion
@@ -183,6 +184,16 @@ public:
    */
   QString validate(const QString& value) const;
 
+  /**
+   * Method to write the unlocalized state of this AD to a data stream.
+   */
+  void write(QDataStream& out) const;
+
+  /**
+   * Method to read an AD previously written by write().
+   */
+  static QSharedPointer<ctkAttributeDefinitionImpl> read(QDataStream& in, ctkLogService* logger);
+
 private:
 
   /**
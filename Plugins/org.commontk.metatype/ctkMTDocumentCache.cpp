@@ -0,0 +1,139 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+
+#include "ctkMTDocumentCache_p.h"
+
+#include <ctkPlugin.h>
+#include <service/log/ctkLogService.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+
+const quint32 ctkMTDocumentCache::MAGIC = 0x43544d54;
+const quint32 ctkMTDocumentCache::FORMAT_VERSION = 1;
+const QString ctkMTDocumentCache::FILE_EXT = ".ocd";
+
+ctkMTDocumentCache::ctkMTDocumentCache(const QString& directory, ctkLogService* logger)
+  : _directory(directory), logger(logger)
+{
+  if (!_directory.exists())
+  {
+    QDir().mkpath(_directory.absolutePath());
+  }
+}
+
+bool ctkMTDocumentCache::load(const QSharedPointer<ctkPlugin>& plugin, const QByteArray& document,
+                              QHash<QString, ctkObjectClassDefinitionImplPtr>& pidToOCD) const
+{
+  QFile file(getFilePath(plugin, document));
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_4_6);
+  quint32 magic = 0;
+  quint32 version = 0;
+  in >> magic >> version;
+  if (magic != MAGIC || version != FORMAT_VERSION)
+  {
+    return false;
+  }
+
+  QHash<QString, ctkObjectClassDefinitionImplPtr> result;
+  qint32 count = 0;
+  in >> count;
+  for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+  {
+    QString pid;
+    in >> pid;
+    result.insert(pid, ctkObjectClassDefinitionImpl::read(in, plugin, logger));
+  }
+
+  if (in.status() != QDataStream::Ok)
+  {
+    CTK_DEBUG(logger) << "Ignoring corrupt metatype cache file " << file.fileName();
+    return false;
+  }
+
+  pidToOCD = result;
+  return true;
+}
+
+void ctkMTDocumentCache::store(const QSharedPointer<ctkPlugin>& plugin, const QByteArray& document,
+                               const QHash<QString, ctkObjectClassDefinitionImplPtr>& pidToOCD) const
+{
+  QString filePath = getFilePath(plugin, document);
+
+  // Write to a temporary file first, so that concurrent or interrupted
+  // writes never leave a truncated cache file behind.
+  QFile file(filePath + ".tmp");
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    CTK_DEBUG(logger) << "Cannot write metatype cache file " << file.fileName();
+    return;
+  }
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_4_6);
+  out << MAGIC << FORMAT_VERSION << qint32(pidToOCD.size());
+  QHash<QString, ctkObjectClassDefinitionImplPtr>::ConstIterator end(pidToOCD.end());
+  for (QHash<QString, ctkObjectClassDefinitionImplPtr>::ConstIterator it(pidToOCD.begin()); it != end; ++it)
+  {
+    out << it.key();
+    it.value()->write(out);
+  }
+  file.close();
+
+  if (out.status() != QDataStream::Ok || file.error() != QFile::NoError)
+  {
+    file.remove();
+    return;
+  }
+  QFile::remove(filePath);
+  if (!file.rename(filePath))
+  {
+    file.remove();
+  }
+}
+
+void ctkMTDocumentCache::remove(long pluginId) const
+{
+  QStringList files = _directory.entryList(QStringList(QString("%1_*").arg(pluginId)), QDir::Files);
+  foreach (QString fileName, files)
+  {
+    QFile::remove(_directory.absoluteFilePath(fileName));
+  }
+}
+
+QString ctkMTDocumentCache::getFilePath(const QSharedPointer<ctkPlugin>& plugin, const QByteArray& document) const
+{
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(plugin->getSymbolicName().toUtf8());
+  hash.addData(plugin->getVersion().toString().toUtf8());
+  hash.addData(document);
+  return _directory.absoluteFilePath(QString("%1_%2%3").arg(plugin->getPluginId())
+                                     .arg(QString(hash.result().toHex())).arg(FILE_EXT));
+}
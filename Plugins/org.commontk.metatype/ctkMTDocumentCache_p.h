@@ -0,0 +1,98 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+
+#ifndef CTKMTDOCUMENTCACHE_P_H
+#define CTKMTDOCUMENTCACHE_P_H
+
+#include "ctkObjectClassDefinitionImpl_p.h"
+
+#include <QDir>
+#include <QHash>
+
+struct ctkLogService;
+
+/**
+ * Caches the object class definitions parsed from the metatype documents
+ * of plugins in the data storage area of the metatype plugin.
+ * <p>
+ * Entries are keyed by plugin id, symbolic name, version and the SHA-1 hash
+ * of the document content. Documents which do not contain any object class
+ * definitions are cached too, so that they are not parsed again either.
+ */
+class ctkMTDocumentCache
+{
+
+private:
+
+  static const quint32 MAGIC; // = 0x43544d54
+  static const quint32 FORMAT_VERSION; // = 1
+  static const QString FILE_EXT; // = ".ocd"
+
+  const QDir _directory;
+  ctkLogService* const logger;
+
+public:
+
+  /**
+   * Constructor of class ctkMTDocumentCache.
+   *
+   * @param directory The directory to store the cache files in. It is created
+   *        if it does not exist.
+   * @param logger The <code>ctkLogService</code> to use for logging messages.
+   */
+  ctkMTDocumentCache(const QString& directory, ctkLogService* logger);
+
+  /**
+   * Look up the object class definitions of a document.
+   *
+   * @param plugin The plugin containing the document.
+   * @param document The content of the document.
+   * @param pidToOCD Receives the cached object class definitions.
+   * @return <code>true</code> if the document was found in the cache.
+   */
+  bool load(const QSharedPointer<ctkPlugin>& plugin, const QByteArray& document,
+            QHash<QString, ctkObjectClassDefinitionImplPtr>& pidToOCD) const;
+
+  /**
+   * Store the object class definitions parsed from a document.
+   *
+   * @param plugin The plugin containing the document.
+   * @param document The content of the document.
+   * @param pidToOCD The object class definitions parsed from the document,
+   *        may be empty.
+   */
+  void store(const QSharedPointer<ctkPlugin>& plugin, const QByteArray& document,
+             const QHash<QString, ctkObjectClassDefinitionImplPtr>& pidToOCD) const;
+
+  /**
+   * Remove all cached documents of the plugin with the given id.
+   */
+  void remove(long pluginId) const;
+
+private:
+
+  QString getFilePath(const QSharedPointer<ctkPlugin>& plugin, const QByteArray& document) const;
+
+};
+
+#endif // CTKMTDOCUMENTCACHE_P_H
@@ -49,6 +49,11 @@ public:
   QString getLocalized(const QString& key) const;
 
   QString getLocalizationBase() const;
+
+  /**
+   * Method to get the translation context of this element.
+   */
+  QString getContext() const;
 };
 
 #endif // CTKMTLOCALIZATIONELEMENT_P_H
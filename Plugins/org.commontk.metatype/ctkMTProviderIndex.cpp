@@ -0,0 +1,203 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+
+#include "ctkMTProviderIndex_p.h"
+
+#include "ctkMTMsg_p.h"
+
+#include <service/cm/ctkManagedService.h>
+#include <service/cm/ctkManagedServiceFactory.h>
+#include <service/log/ctkLogService.h>
+
+#include <QCoreApplication>
+#include <QtAlgorithms>
+
+ctkMTProviderIndex::ctkMTProviderIndex(ctkPluginContext* context, const ctkLDAPSearchFilter& filter,
+                                       ctkLogService* log)
+  : ctkServiceTracker<>(context, filter), log(log)
+{
+
+}
+
+QStringList ctkMTProviderIndex::getPids(long pluginId, bool factory) const
+{
+  QMutexLocker lock(&mutex);
+  QHash<long, PluginProviders>::ConstIterator it = plugins.find(pluginId);
+  if (it == plugins.end())
+  {
+    return QStringList();
+  }
+  return factory ? it->factoryPids.keys() : it->pids.keys();
+}
+
+ctkMetaTypeProvider* ctkMTProviderIndex::getProvider(long pluginId, const QString& pid) const
+{
+  QMutexLocker lock(&mutex);
+  QHash<long, PluginProviders>::ConstIterator it = plugins.find(pluginId);
+  if (it == plugins.end())
+  {
+    return 0;
+  }
+  ctkMetaTypeProvider* provider = it->pids.value(pid);
+  return provider ? provider : it->factoryPids.value(pid);
+}
+
+QList<ctkMetaTypeProvider*> ctkMTProviderIndex::getProviders(long pluginId) const
+{
+  QMutexLocker lock(&mutex);
+  QList<ctkMetaTypeProvider*> result;
+  QHash<long, PluginProviders>::ConstIterator it = plugins.find(pluginId);
+  if (it == plugins.end())
+  {
+    return result;
+  }
+  foreach (const Provider& provider, it->services)
+  {
+    if (!result.contains(provider.provider))
+    {
+      result.push_back(provider.provider);
+    }
+  }
+  return result;
+}
+
+QObject* ctkMTProviderIndex::addingService(const ctkServiceReference& reference)
+{
+  QObject* service = ctkServiceTracker<>::addingService(reference);
+  index(reference, service);
+  return service;
+}
+
+void ctkMTProviderIndex::modifiedService(const ctkServiceReference& reference, QObject* service)
+{
+  index(reference, service);
+}
+
+void ctkMTProviderIndex::removedService(const ctkServiceReference& reference, QObject* service)
+{
+  unindex(reference);
+  ctkServiceTracker<>::removedService(reference, service);
+}
+
+void ctkMTProviderIndex::index(const ctkServiceReference& reference, QObject* service)
+{
+  // If the service is not a ctkMetaTypeProvider, we're not interested in it.
+  ctkMetaTypeProvider* metatypeService = qobject_cast<ctkMetaTypeProvider*>(service);
+  if (metatypeService == 0)
+  {
+    return;
+  }
+
+  Provider provider;
+  provider.provider = metatypeService;
+  // Include the METATYPE_PID, if present, to return as part of getPids(). Also, include the
+  // METATYPE_FACTORY_PID, if present, to return as part of getFactoryPids().
+  // The filter ensures at least one of these properties was set for a standalone ctkMetaTypeProvider.
+  provider.pids = getStringProperty(reference, ctkMetaTypeProvider::METATYPE_PID);
+  provider.factoryPids = getStringProperty(reference, ctkMetaTypeProvider::METATYPE_FACTORY_PID);
+  // If the service is a ctkManagedService, include the SERVICE_PID to return as part of getPids().
+  // The filter ensures the SERVICE_PID property was set.
+  if (qobject_cast<ctkManagedService*>(service))
+  {
+    provider.pids << getStringProperty(reference, ctkPluginConstants::SERVICE_PID);
+  }
+  // If the service is a ctkManagedServiceFactory, include the SERVICE_PID to return as part of getFactoryPids().
+  // The filter ensures the SERVICE_PID property was set.
+  else if (qobject_cast<ctkManagedServiceFactory*>(service))
+  {
+    provider.factoryPids << getStringProperty(reference, ctkPluginConstants::SERVICE_PID);
+  }
+
+  QMutexLocker lock(&mutex);
+  PluginProviders& providers = plugins[reference.getPlugin()->getPluginId()];
+  providers.services.insert(reference, provider);
+  reindex(providers);
+}
+
+void ctkMTProviderIndex::unindex(const ctkServiceReference& reference)
+{
+  QSharedPointer<ctkPlugin> plugin = reference.getPlugin();
+  QMutexLocker lock(&mutex);
+  // The plugin is not available anymore if the service has been
+  // unregistered, search for the reference instead.
+  QHash<long, PluginProviders>::Iterator it = plugin ? plugins.find(plugin->getPluginId())
+                                                     : plugins.begin();
+  for (; it != plugins.end(); ++it)
+  {
+    if (it->services.remove(reference))
+    {
+      if (it->services.isEmpty())
+      {
+        plugins.erase(it);
+      }
+      else
+      {
+        reindex(*it);
+      }
+      return;
+    }
+  }
+}
+
+void ctkMTProviderIndex::reindex(PluginProviders& providers)
+{
+  providers.pids.clear();
+  providers.factoryPids.clear();
+  // Insert in ascending ranking order, so that the highest ranked
+  // provider of a PID wins. The ranking of a service may change,
+  // hence the references are sorted here instead of keeping a QMap.
+  QList<ctkServiceReference> references = providers.services.keys();
+  qSort(references);
+  foreach (const ctkServiceReference& reference, references)
+  {
+    const Provider& provider = providers.services[reference];
+    foreach (const QString& pid, provider.pids)
+    {
+      providers.pids.insert(pid, provider.provider);
+    }
+    foreach (const QString& pid, provider.factoryPids)
+    {
+      providers.factoryPids.insert(pid, provider.provider);
+    }
+  }
+}
+
+QStringList ctkMTProviderIndex::getStringProperty(const ctkServiceReference& reference, const QString& name) const
+{
+  QVariant value = reference.getProperty(name);
+
+  // Don't log a warning if the value is null. The filter guarantees at least one of the necessary properties
+  // is there. If others are not, this method will get called with value equal to null.
+  if (value.isNull())
+    return QStringList();
+
+  if (value.canConvert<QStringList>())
+  {
+    return value.toStringList();
+  }
+
+  QSharedPointer<ctkPlugin> plugin = reference.getPlugin();
+  CTK_WARN(log) << QCoreApplication::translate(ctkMTMsg::CONTEXT, ctkMTMsg::INVALID_PID_METATYPE_PROVIDER_IGNORED)
+                   .arg(plugin->getSymbolicName()).arg(plugin->getPluginId()).arg(name). arg(value.toString());
+  return QStringList();
+}
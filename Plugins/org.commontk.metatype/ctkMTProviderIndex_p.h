@@ -0,0 +1,110 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+
+#ifndef CTKMTPROVIDERINDEX_P_H
+#define CTKMTPROVIDERINDEX_P_H
+
+#include <service/metatype/ctkMetaTypeProvider.h>
+
+#include <ctkServiceTracker.h>
+
+#include <QMutex>
+
+struct ctkLogService;
+
+/**
+ * Tracks all ctkManagedService, ctkManagedServiceFactory and
+ * ctkMetaTypeProvider services and indexes the ctkMetaTypeProvider
+ * instances among them by plugin and PID.
+ * <p>
+ * The index is updated from the tracker callbacks, so that queries
+ * do not need to inspect all tracked services.
+ */
+class ctkMTProviderIndex : public ctkServiceTracker<>
+{
+
+private:
+
+  struct Provider
+  {
+    ctkMetaTypeProvider* provider;
+    QStringList pids;
+    QStringList factoryPids;
+  };
+
+  struct PluginProviders
+  {
+    QHash<ctkServiceReference, Provider> services;
+    QHash<QString, ctkMetaTypeProvider*> pids;
+    QHash<QString, ctkMetaTypeProvider*> factoryPids;
+  };
+
+  ctkLogService* const log;
+
+  mutable QMutex mutex;
+  QHash<long, PluginProviders> plugins;
+
+public:
+
+  /**
+   * Constructs a ctkMTProviderIndex.
+   *
+   * @param context The ctkPluginContext of the ctkMetaTypeService implementation.
+   * @param filter The filter matching the services to track.
+   * @param log The <code>ctkLogService</code> to use for logging messages.
+   */
+  ctkMTProviderIndex(ctkPluginContext* context, const ctkLDAPSearchFilter& filter, ctkLogService* log);
+
+  /**
+   * Returns the PIDs or factory PIDs provided by the plugin with the given id.
+   */
+  QStringList getPids(long pluginId, bool factory) const;
+
+  /**
+   * Returns the provider for the PID or factory PID of the plugin with the
+   * given id or <code>0</code> if there is none.
+   */
+  ctkMetaTypeProvider* getProvider(long pluginId, const QString& pid) const;
+
+  /**
+   * Returns all providers registered by the plugin with the given id.
+   */
+  QList<ctkMetaTypeProvider*> getProviders(long pluginId) const;
+
+protected:
+
+  QObject* addingService(const ctkServiceReference& reference);
+  void modifiedService(const ctkServiceReference& reference, QObject* service);
+  void removedService(const ctkServiceReference& reference, QObject* service);
+
+private:
+
+  void index(const ctkServiceReference& reference, QObject* service);
+  void unindex(const ctkServiceReference& reference);
+  void reindex(PluginProviders& providers);
+
+  QStringList getStringProperty(const ctkServiceReference& reference, const QString& name) const;
+
+};
+
+#endif // CTKMTPROVIDERINDEX_P_H
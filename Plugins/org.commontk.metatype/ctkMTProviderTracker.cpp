@@ -20,50 +20,15 @@
 =============================================================================*/
 
 
-#include "ctkMTProviderTracker_p.h"
-
-#include "ctkMTMsg_p.h"
-
-#include <service/cm/ctkManagedService.h>
-#include <service/cm/ctkManagedServiceFactory.h>
-#include <service/log/ctkLogService.h>
-
-#include <QCoreApplication>
-
-class ctkMTProviderTracker::MetaTypeProviderWrapper
-{
-public:
-
-  ctkMetaTypeProvider* provider;
-  QString pid;
-  bool factory;
 
-  MetaTypeProviderWrapper(ctkMetaTypeProvider* provider, const QString& pid, bool factory)
-    : provider(provider), pid(pid), factory(factory)
-  {
-
-  }
+#include "ctkMTProviderTracker_p.h"
 
-  bool operator==(const MetaTypeProviderWrapper& o) const
-  {
-    if (this == &o)
-      return true;
-    return provider == o.provider && pid == o.pid && factory == o.factory;
-  }
+#include "ctkMTProviderIndex_p.h"
 
-};
+#include <ctkPlugin.h>
 
-uint qHash(const ctkMTProviderTracker::MetaTypeProviderWrapper wrapper)
-{
-  uint result = 17;
-  result = 31 * result + qHash(wrapper.provider);
-  result = 31 * result + qHash(wrapper.pid);
-  result = 31 * result + (wrapper.factory ? 1 : 0);
-  return result;
-}
-
-ctkMTProviderTracker::ctkMTProviderTracker(const QSharedPointer<ctkPlugin>& plugin, ctkLogService* log, ctkServiceTracker<>* tracker)
-  : _plugin(plugin), log(log), _tracker(tracker)
+ctkMTProviderTracker::ctkMTProviderTracker(const QSharedPointer<ctkPlugin>& plugin, const ctkMTProviderIndex* index)
+  : _plugin(plugin), _index(index)
 {
 
 }
@@ -90,16 +55,10 @@ ctkObjectClassDefinitionPtr ctkMTProviderTracker::getObjectClassDefinition(const
     return ctkObjectClassDefinitionPtr(); // return none if not active
   }
 
-  QSet<MetaTypeProviderWrapper> wrappers = getMetaTypeProviders();
-  QSet<MetaTypeProviderWrapper>::ConstIterator end = wrappers.end();
-  for (QSet<MetaTypeProviderWrapper>::ConstIterator it = wrappers.begin();
-       it != end; ++it)
+  if (ctkMetaTypeProvider* provider = _index->getProvider(_plugin->getPluginId(), id))
   {
-    if (id == (*it).pid)
-    {
-      // found a matching pid now call the actual provider
-      return (*it).provider->getObjectClassDefinition(id, locale);
-    }
+    // found a matching pid now call the actual provider
+    return provider->getObjectClassDefinition(id, locale);
   }
   return ctkObjectClassDefinitionPtr();
 }
@@ -111,14 +70,11 @@ QList<QLocale> ctkMTProviderTracker::getLocales() const
     return QList<QLocale>(); // return none if not active
   }
 
-  QSet<MetaTypeProviderWrapper> wrappers = getMetaTypeProviders();
   QList<QLocale> locales;
   // collect all the unique locales from all providers we found
-  QSet<MetaTypeProviderWrapper>::ConstIterator end = wrappers.end();
-  for (QSet<MetaTypeProviderWrapper>::ConstIterator it = wrappers.begin();
-       it != end; ++it)
+  foreach (ctkMetaTypeProvider* provider, _index->getProviders(_plugin->getPluginId()))
   {
-    QList<QLocale> wrappedLocales = (*it).provider->getLocales();
+    QList<QLocale> wrappedLocales = provider->getLocales();
     if (wrappedLocales.isEmpty())
       continue;
     for (int j = 0; j < wrappedLocales.size(); j++)
@@ -135,85 +91,6 @@ QStringList ctkMTProviderTracker::getPids(bool factory) const
     return QStringList(); // return none if not active
   }
 
-  QSet<MetaTypeProviderWrapper> wrappers = getMetaTypeProviders();
-  QStringList results;
-  QSet<MetaTypeProviderWrapper>::ConstIterator end = wrappers.end();
-  for (QSet<MetaTypeProviderWrapper>::ConstIterator it = wrappers.begin();
-       it != end; ++it)
-  {
-    // return only the correct type of pids (regular or factory)
-    if (factory == (*it).factory)
-      results.push_back((*it).pid);
-  }
-  return results;
-}
-
-QSet<ctkMTProviderTracker::MetaTypeProviderWrapper> ctkMTProviderTracker::getMetaTypeProviders() const
-{
-  QMap<ctkServiceReference, QObject*> services = _tracker->getTracked();
-  if (services.isEmpty())
-  {
-    return QSet<MetaTypeProviderWrapper>();
-  }
-  QList<ctkServiceReference> serviceReferences = services.keys();
-  QSet<MetaTypeProviderWrapper> result;
-  foreach (ctkServiceReference serviceReference, serviceReferences)
-  {
-    if (serviceReference.getPlugin() == _plugin)
-    {
-      QObject* service = services.value(serviceReference);
-      // If the service is not a ctkMetaTypeProvider, we're not interested in it.
-      if (ctkMetaTypeProvider* metatypeService = qobject_cast<ctkMetaTypeProvider*>(service))
-      {
-        // Include the METATYPE_PID, if present, to return as part of getPids(). Also, include the
-        // METATYPE_FACTORY_PID, if present, to return as part of getFactoryPids().
-        // The filter ensures at least one of these properties was set for a standalone ctkMetaTypeProvider.
-        addMetaTypeProviderWrappers(ctkMetaTypeProvider::METATYPE_PID, serviceReference, metatypeService, false, result);
-        addMetaTypeProviderWrappers(ctkMetaTypeProvider::METATYPE_FACTORY_PID, serviceReference, metatypeService, true, result);
-        // If the service is a ctkManagedService, include the SERVICE_PID to return as part of getPids().
-        // The filter ensures the SERVICE_PID property was set.
-        if (qobject_cast<ctkManagedService*>(service))
-        {
-          addMetaTypeProviderWrappers(ctkPluginConstants::SERVICE_PID, serviceReference, metatypeService, false, result);
-        }
-        // If the service is a ctkManagedServiceFactory, include the SERVICE_PID to return as part of getFactoryPids().
-        // The filter ensures the SERVICE_PID property was set.
-        else if (qobject_cast<ctkManagedServiceFactory*>(service))
-        {
-          addMetaTypeProviderWrappers(ctkPluginConstants::SERVICE_PID, serviceReference, metatypeService, true, result);
-        }
-      }
-    }
-  }
-  return result;
+  // return only the correct type of pids (regular or factory)
+  return _index->getPids(_plugin->getPluginId(), factory);
 }
-
-void ctkMTProviderTracker::addMetaTypeProviderWrappers(const QString& servicePropertyName,
-                                                       const ctkServiceReference& serviceReference,
-                                                       ctkMetaTypeProvider* service, bool factory,
-                                                       QSet<MetaTypeProviderWrapper>& wrappers) const
-{
-  QStringList pids = getStringProperty(servicePropertyName, serviceReference.getProperty(servicePropertyName));
-  foreach (QString pid, pids)
-  {
-    wrappers.insert(MetaTypeProviderWrapper(service, pid, factory));
-  }
-}
-
-QStringList ctkMTProviderTracker::getStringProperty(const QString& name, const QVariant& value) const
-{
-  // Don't log a warning if the value is null. The filter guarantees at least one of the necessary properties
-  // is there. If others are not, this method will get called with value equal to null.
-  if (value.isNull())
-    return QStringList();
-
-  if (value.canConvert<QStringList>())
-  {
-    return value.toStringList();
-  }
-
-  CTK_WARN(log) << QCoreApplication::translate(ctkMTMsg::CONTEXT, ctkMTMsg::INVALID_PID_METATYPE_PROVIDER_IGNORED)
-                   .arg(_plugin->getSymbolicName()).arg(_plugin->getPluginId()).arg(name). arg(value.toString());
-  return QStringList();
-}
-
@@ -20,12 +20,13 @@
 =============================================================================*/
 
 
+
 #ifndef CTKMTPROVIDERTRACKER_P_H
 #define CTKMTPROVIDERTRACKER_P_H
 
 #include <service/metatype/ctkMetaTypeInformation.h>
 
-#include <ctkServiceTracker.h>
+class ctkMTProviderIndex;
 
 class ctkMTProviderTracker : public ctkMetaTypeInformation
 {
@@ -33,23 +34,17 @@ class ctkMTProviderTracker : public ctkMetaTypeInformation
 private:
 
   const QSharedPointer<ctkPlugin> _plugin;
-  ctkLogService* const log;
-  ctkServiceTracker<>* _tracker;
+  const ctkMTProviderIndex* const _index;
 
 public:
 
-  // this is a simple class just used to temporarily store information about a provider
-  // it is public because qHash() needs access to it
-  class MetaTypeProviderWrapper;
-
   /**
    * Constructs a ctkMTProviderTracker which tracks all ctkMetaTypeProviders
    * registered by the specified plugin.
-   * @param context The ctkPluginContext of the ctkMetaTypeService implementation
    * @param plugin The plugin to track all ctkMetaTypeProviders for.
-   * @param log The <code>ctkLogService</code> to use for logging messages.
+   * @param index The index of all tracked ctkMetaTypeProviders by plugin and PID.
    */
-  ctkMTProviderTracker(const QSharedPointer<ctkPlugin>& plugin, ctkLogService* log, ctkServiceTracker<>* tracker);
+  ctkMTProviderTracker(const QSharedPointer<ctkPlugin>& plugin, const ctkMTProviderIndex* index);
 
   QStringList getPids() const;
   QStringList getFactoryPids() const;
@@ -61,15 +56,6 @@ private:
 
   QStringList getPids(bool factory) const;
 
-  QSet<MetaTypeProviderWrapper> getMetaTypeProviders() const;
-
-  void addMetaTypeProviderWrappers(const QString& servicePropertyName,
-                                   const ctkServiceReference& serviceReference,
-                                   ctkMetaTypeProvider* service, bool factory,
-                                   QSet<MetaTypeProviderWrapper>& wrappers) const;
-
-  QStringList getStringProperty(const QString& name, const QVariant& value) const;
-
 };
 
 #endif // CTKMTPROVIDERTRACKER_P_H
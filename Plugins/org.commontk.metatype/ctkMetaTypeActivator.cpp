@@ -21,7 +21,9 @@
 
 
 #include "ctkMetaTypeActivator_p.h"
+#include "ctkMTDocumentCache_p.h"
 #include "ctkMTLogTracker_p.h"
+#include "ctkMTProviderIndex_p.h"
 #include "ctkMetaTypeServiceImpl_p.h"
 #include "ctkMTMsg_p.h"
 
@@ -47,7 +49,7 @@ QString ctkMetaTypeActivator::FILTER()
 const QString ctkMetaTypeActivator::SERVICE_PID = "org.commontk.metatype.impl.MetaType";
 
 ctkMetaTypeActivator::ctkMetaTypeActivator()
-  : metaTypeProviderTracker(0), metaTypeService(0)
+  : metaTypeProviderTracker(0), documentCache(0), metaTypeService(0)
 {
 }
 
@@ -55,6 +57,7 @@ ctkMetaTypeActivator::~ctkMetaTypeActivator()
 {
   delete metaTypeProviderTracker;
   delete metaTypeService;
+  delete documentCache;
   delete logTracker;
   logTracker = 0;
 }
@@ -63,17 +66,20 @@ void ctkMetaTypeActivator::start(ctkPluginContext* context)
 {
   delete metaTypeProviderTracker;
   delete metaTypeService;
+  delete documentCache;
   delete logTracker;
 
   ctkMTLogTracker* lsTracker = 0;
   logFileFallback.open(stdout, QIODevice::WriteOnly);
   ctkLDAPSearchFilter filter(FILTER());
-  ctkServiceTracker<>* mtpTracker = 0;
+  ctkMTProviderIndex* mtpTracker = 0;
 
   {
     QMutexLocker l(&mutex);
     lsTracker = logTracker = new ctkMTLogTracker(context, &logFileFallback);
-    mtpTracker = metaTypeProviderTracker = new ctkServiceTracker<>(context, filter);
+    mtpTracker = metaTypeProviderTracker = new ctkMTProviderIndex(context, filter, lsTracker);
+    // Parsed metatype documents are kept in the plugin storage area
+    documentCache = new ctkMTDocumentCache(context->getDataFile("documents").absoluteFilePath(), lsTracker);
   }
   // Do this first to make logging available as early as possible.
   lsTracker->open();
@@ -86,7 +92,7 @@ void ctkMetaTypeActivator::start(ctkPluginContext* context)
   properties.insert(ctkPluginConstants::SERVICE_VENDOR, "CommonTK");
   properties.insert(ctkPluginConstants::SERVICE_DESCRIPTION, ctkMTMsg::SERVICE_DESCRIPTION);
   properties.insert(ctkPluginConstants::SERVICE_PID, SERVICE_PID);
-  metaTypeService = new ctkMetaTypeServiceImpl(lsTracker, mtpTracker);
+  metaTypeService = new ctkMetaTypeServiceImpl(lsTracker, mtpTracker, documentCache);
   context->connectPluginListener(metaTypeService, SLOT(pluginChanged(ctkPluginEvent)), Qt::DirectConnection);
   metaTypeServiceRegistration = context->registerService<ctkMetaTypeService>(metaTypeService, properties);
 }
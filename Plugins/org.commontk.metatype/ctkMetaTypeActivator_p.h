@@ -28,7 +28,9 @@
 #include <service/log/ctkLogService.h>
 #include <ctkServiceTracker.h>
 
+class ctkMTDocumentCache;
 class ctkMTLogTracker;
+class ctkMTProviderIndex;
 class ctkMetaTypeServiceImpl;
 
 class ctkMetaTypeActivator :
@@ -64,10 +66,12 @@ private:
   static const QString SERVICE_PID; // = "org.commontk.metatype.impl.MetaType"
 
   // Could be ctkManagedService, ctkManagedServiceFactory, or ctkMetaTypeProvider.
-  // The tracker tracks all services regardless of the plugin. Services are
-  // filtered by plugin later in the ctkMTProviderTracker class. It may
-  // therefore be shared among multiple instances of that class.
-  ctkServiceTracker<>* metaTypeProviderTracker;
+  // The tracker tracks all services regardless of the plugin and indexes
+  // them by plugin and PID. It is shared among all instances of the
+  // ctkMTProviderTracker class.
+  ctkMTProviderIndex* metaTypeProviderTracker;
+
+  ctkMTDocumentCache* documentCache;
 
   ctkMetaTypeServiceImpl* metaTypeService;
   ctkServiceRegistration metaTypeServiceRegistration;
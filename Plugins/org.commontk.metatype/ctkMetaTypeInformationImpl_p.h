@@ -47,7 +47,8 @@ public:
   /**
    * Constructor of class ctkMetaTypeInformationImpl.
    */
-  ctkMetaTypeInformationImpl(const QSharedPointer<ctkPlugin>& plugin, ctkLogService* logger);
+  ctkMetaTypeInformationImpl(const QSharedPointer<ctkPlugin>& plugin, ctkLogService* logger,
+                             const ctkMTDocumentCache* cache = 0);
 
   /*
    * @see ctkMetaTypeInformation#getPids()
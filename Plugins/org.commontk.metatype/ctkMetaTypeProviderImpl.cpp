@@ -26,6 +26,7 @@
 #include "ctkAttributeDefinitionImpl_p.h"
 #include "ctkMTMsg_p.h"
 #include "ctkMTDataParser_p.h"
+#include "ctkMTDocumentCache_p.h"
 
 #include <ctkPluginConstants.h>
 #include <ctkException.h>
@@ -47,8 +48,9 @@ const QChar ctkMetaTypeProviderImpl::DIRECTORY_SEP = '/';
 
 
 ctkMetaTypeProviderImpl::ctkMetaTypeProviderImpl(
-  const QSharedPointer<ctkPlugin>& plugin, ctkLogService* logger)
-  : _plugin(plugin), logger(logger), _isThereMeta(false)
+  const QSharedPointer<ctkPlugin>& plugin, ctkLogService* logger,
+  const ctkMTDocumentCache* cache)
+  : _plugin(plugin), logger(logger), _cache(cache), _isThereMeta(false)
 {
   // read all plugin's metadata files and build internal data structures
   _isThereMeta = readMetaFiles(plugin);
@@ -157,7 +159,11 @@ bool ctkMetaTypeProviderImpl::readMetaFiles(const QSharedPointer<ctkPlugin>& plu
 
     QHash<QString, ctkObjectClassDefinitionImplPtr> pidToOCD;
     QByteArray resourceContent = plugin->getResource(ctkMetaTypeService::METATYPE_DOCUMENTS_LOCATION + "/" + fileName);
-    if (!resourceContent.isEmpty())
+    if (!resourceContent.isEmpty() && _cache && _cache->load(plugin, resourceContent, pidToOCD))
+    {
+      _isMetaDataFile = !pidToOCD.isEmpty();
+    }
+    else if (!resourceContent.isEmpty())
     {
       QBuffer metaData(&resourceContent);
       try
@@ -178,27 +184,36 @@ bool ctkMetaTypeProviderImpl::readMetaFiles(const QSharedPointer<ctkPlugin>& plu
         _isMetaDataFile = false;
       }
 
-      if (_isMetaDataFile && !pidToOCD.isEmpty())
+      if (!_isMetaDataFile)
       {
-        // We got some OCDs now.
-        QHash<QString, ctkObjectClassDefinitionImplPtr>::ConstIterator end(pidToOCD.end());
-        for (QHash<QString, ctkObjectClassDefinitionImplPtr>::ConstIterator it(pidToOCD.begin()); it != end; ++it)
-        {
-          QString pid = it.key();
-          ctkObjectClassDefinitionImplPtr ocd = it.value();
-          if (ocd->getType() == ctkObjectClassDefinitionImpl::PID)
-          {
-            isThereMetaHere = true;
-            _allPidOCDs.insert(pid, ocd);
-          }
-          else
-          {
-            isThereMetaHere = true;
-            _allFPidOCDs.insert(pid, ocd);
-          }
-        } // End of for
+        pidToOCD.clear();
+      }
+      if (_cache)
+      {
+        _cache->store(plugin, resourceContent, pidToOCD);
       }
     } // End of if(!resourceContent.isEmpty())
+
+    if (_isMetaDataFile)
+    {
+      // We got some OCDs now.
+      QHash<QString, ctkObjectClassDefinitionImplPtr>::ConstIterator end(pidToOCD.end());
+      for (QHash<QString, ctkObjectClassDefinitionImplPtr>::ConstIterator it(pidToOCD.begin()); it != end; ++it)
+      {
+        QString pid = it.key();
+        ctkObjectClassDefinitionImplPtr ocd = it.value();
+        if (ocd->getType() == ctkObjectClassDefinitionImpl::PID)
+        {
+          isThereMetaHere = true;
+          _allPidOCDs.insert(pid, ocd);
+        }
+        else
+        {
+          isThereMetaHere = true;
+          _allFPidOCDs.insert(pid, ocd);
+        }
+      } // End of for
+    }
   } // End of foreach
 
   return isThereMetaHere;
@@ -28,6 +28,7 @@
 class ctkPlugin;
 struct ctkLogService;
 class ctkObjectClassDefinitionImpl;
+class ctkMTDocumentCache;
 
 /**
  * Implementation of ctkMetaTypeProvider
@@ -55,6 +56,8 @@ protected:
 
   ctkLogService* logger;
 
+  const ctkMTDocumentCache* const _cache;
+
 private:
 
   mutable QList<QLocale> _locales;
@@ -66,8 +69,11 @@ public:
 
   /**
    * Constructor of class MetaTypeProviderImpl.
+   *
+   * @param cache The cache of parsed metatype documents, may be <code>0</code>.
    */
-  ctkMetaTypeProviderImpl(const QSharedPointer<ctkPlugin>& plugin, ctkLogService* logger);
+  ctkMetaTypeProviderImpl(const QSharedPointer<ctkPlugin>& plugin, ctkLogService* logger,
+                          const ctkMTDocumentCache* cache = 0);
 
   /*
    * @see ctkMetaTypeProvider#getObjectClassDefinition(const QString&, const QLocale&)
@@ -87,6 +93,7 @@ private:
    * <p> - Pass the XML Parser the location for the plugin's METADATA.XML file
    * <p> - Handle the callbacks from the parser and build the appropriate
    * MetaType objects - ObjectClassDefinitions & AttributeDefinitions
+   * <p> Documents which have been parsed before are read from the cache.
    *
    * @param plugin The plugin object for which the metadata should be read
    * @return void
@@ -23,14 +23,17 @@
 #include "ctkMetaTypeServiceImpl_p.h"
 
 #include "ctkMetaTypeInformationImpl_p.h"
+#include "ctkMTDocumentCache_p.h"
 #include "ctkMTProviderTracker_p.h"
 #include "ctkObjectClassDefinitionImpl_p.h"
 #include "ctkAttributeDefinitionImpl_p.h"
 
+#include <ctkPlugin.h>
 #include <service/log/ctkLogService.h>
 
-ctkMetaTypeServiceImpl::ctkMetaTypeServiceImpl(ctkLogService* logger, ctkServiceTracker<>* metaTypeProviderTracker)
-  : logger(logger), metaTypeProviderTracker(metaTypeProviderTracker)
+ctkMetaTypeServiceImpl::ctkMetaTypeServiceImpl(ctkLogService* logger, ctkMTProviderIndex* metaTypeProviderIndex,
+                                               ctkMTDocumentCache* documentCache)
+  : logger(logger), metaTypeProviderIndex(metaTypeProviderIndex), documentCache(documentCache)
 {
 }
 
@@ -59,12 +62,12 @@ ctkMetaTypeInformationPtr ctkMetaTypeServiceImpl::getMetaTypeProvider(const QSha
       return _mtps.value(pID);
     }
 
-    ctkMetaTypeInformationImpl* impl = new ctkMetaTypeInformationImpl(p, logger);
+    ctkMetaTypeInformationImpl* impl = new ctkMetaTypeInformationImpl(p, logger, documentCache);
     ctkMetaTypeInformation* mti = impl;
     if (!impl->_isThereMeta)
     {
       delete impl;
-      mti = new ctkMTProviderTracker(p, logger, metaTypeProviderTracker);
+      mti = new ctkMTProviderTracker(p, metaTypeProviderIndex);
     }
     ctkMetaTypeInformationPtr mtiPtr(mti);
     _mtps.insert(pID, mtiPtr);
@@ -81,8 +84,13 @@ void ctkMetaTypeServiceImpl::pluginChanged(const ctkPluginEvent& event)
   {
     case ctkPluginEvent::UPDATED:
     case ctkPluginEvent::UNINSTALLED:
+    {
+      QMutexLocker lock(&_mtpsMutex);
       _mtps.remove(pID);
+      // cached documents of the previous plugin version are stale now
+      documentCache->remove(pID);
       break;
+    }
     default :
       break;
   }
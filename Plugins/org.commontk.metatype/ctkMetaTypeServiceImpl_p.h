@@ -24,10 +24,14 @@
 #define CTKMETATYPESERVICEIMPL_P_H
 
 #include <service/metatype/ctkMetaTypeService.h>
-#include <ctkServiceTracker.h>
+#include <ctkPluginEvent.h>
 
+#include <QMutex>
 #include <QObject>
 
+class ctkMTDocumentCache;
+class ctkMTProviderIndex;
+
 /**
  * Implementation of ctkMetaTypeService
  */
@@ -42,14 +46,16 @@ private:
   QHash<long, ctkMetaTypeInformationPtr> _mtps;
 
   ctkLogService* const logger;
-  ctkServiceTracker<>* metaTypeProviderTracker;
+  ctkMTProviderIndex* metaTypeProviderIndex;
+  ctkMTDocumentCache* documentCache;
 
 public:
 
   /**
    * Constructor of class ctkMetaTypeServiceImpl.
    */
-  ctkMetaTypeServiceImpl(ctkLogService* logger, ctkServiceTracker<>* metaTypeProviderTracker);
+  ctkMetaTypeServiceImpl(ctkLogService* logger, ctkMTProviderIndex* metaTypeProviderIndex,
+                         ctkMTDocumentCache* documentCache);
 
   /*
    * @see ctkMetaTypeService#getMetaTypeInformation()
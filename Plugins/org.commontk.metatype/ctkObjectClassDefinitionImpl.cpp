@@ -27,6 +27,8 @@
 #include <ctkPlugin.h>
 #include <ctkPluginConstants.h>
 
+#include <QDataStream>
+
 const int ctkObjectClassDefinitionImpl::PID = 0;
 const int ctkObjectClassDefinitionImpl::FPID = 1;
 const QChar ctkObjectClassDefinitionImpl::LOCALE_SEP = '_';
@@ -174,3 +176,49 @@ QString ctkObjectClassDefinitionImpl::getLocalization() const
   return _locElem.getLocalizationBase();
 }
 
+void ctkObjectClassDefinitionImpl::write(QDataStream& out) const
+{
+  out << _name << _id << _description << _locElem.getLocalizationBase() << _locElem.getContext()
+      << qint32(_type) << static_cast<bool>(_icon) << _icon.getIconName() << qint32(_icon.getIconSize());
+
+  out << qint32(_required.size());
+  foreach(ctkAttributeDefinitionImplPtr impl, _required)
+  {
+    impl->write(out);
+  }
+  out << qint32(_optional.size());
+  foreach(ctkAttributeDefinitionImplPtr impl, _optional)
+  {
+    impl->write(out);
+  }
+}
+
+QSharedPointer<ctkObjectClassDefinitionImpl> ctkObjectClassDefinitionImpl::read(
+  QDataStream& in, const QSharedPointer<ctkPlugin>& plugin, ctkLogService* logger)
+{
+  QString name, id, description, localization, context, iconName;
+  qint32 type = 0;
+  bool hasIcon = false;
+  qint32 iconSize = -1;
+  in >> name >> id >> description >> localization >> context >> type >> hasIcon >> iconName >> iconSize;
+
+  ctkObjectClassDefinitionImplPtr ocd(
+        new ctkObjectClassDefinitionImpl(name, description, id, localization, context, type));
+  if (hasIcon)
+  {
+    ocd->setIcon(ctkMTIcon(iconName, iconSize, plugin));
+  }
+
+  qint32 count = 0;
+  in >> count;
+  for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+  {
+    ocd->addAttributeDefinition(ctkAttributeDefinitionImpl::read(in, logger), true);
+  }
+  in >> count;
+  for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+  {
+    ocd->addAttributeDefinition(ctkAttributeDefinitionImpl::read(in, logger), false);
+  }
+  return ocd;
+}
@@ -30,6 +30,8 @@
 #include "ctkMTLocalizationElement_p.h"
 
 class ctkAttributeDefinitionImpl;
+struct ctkLogService;
+class QDataStream;
 
 /**
  * Implementation of ObjectClassDefinition
@@ -129,6 +131,18 @@ public:
 
   QString getLocalization() const;
 
+  /**
+   * Method to write the unlocalized state of this OCD and all its ADs
+   * to a data stream.
+   */
+  void write(QDataStream& out) const;
+
+  /**
+   * Method to read an OCD previously written by write().
+   */
+  static QSharedPointer<ctkObjectClassDefinitionImpl> read(QDataStream& in, const QSharedPointer<ctkPlugin>& plugin,
+                                                           ctkLogService* logger);
+
 };
 
 typedef QSharedPointer<ctkObjectClassDefinitionImpl> ctkObjectClassDefinitionImplPtr;